@@ -0,0 +1,124 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @class BoundedQueue
+ * @brief Cola acotada sin bloqueos para varios productores y consumidores.
+ *
+ * Implementa el esquema de D. Vyukov: un arreglo circular de celdas, cada
+ * una con un número de secuencia atómico que indica si está libre para
+ * escribir o lista para leer. Productores y consumidores solo compiten
+ * con un compare-and-swap sobre su propio contador, sin mutex.
+ *
+ * La capacidad se redondea a la siguiente potencia de dos. Cuando la cola
+ * está llena, @ref tryPush devuelve false en lugar de esperar; quien
+ * produce decide si descarta el elemento o reintenta (contrapresión).
+ *
+ * @tparam T Tipo almacenado; debe ser copiable y construible por defecto.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    /**
+     * @brief Crea la cola con al menos @p capacity posiciones.
+     */
+    explicit BoundedQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * @brief Intenta encolar un elemento.
+     * @return false si la cola está llena.
+     */
+    bool tryPush(const T &value)
+    {
+        std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & mask];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // llena
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Intenta desencolar un elemento.
+     * @return false si la cola está vacía.
+     */
+    bool tryPop(T &value)
+    {
+        std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[pos & mask];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.data;
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // vacía
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** @brief Número de posiciones de la cola. */
+    std::size_t capacity() const { return mask + 1; }
+
+    /**
+     * @brief Ocupación aproximada (exacta solo si nadie está operando).
+     */
+    std::size_t sizeApprox() const
+    {
+        const std::size_t head = dequeuePos.load(std::memory_order_relaxed);
+        const std::size_t tail = enqueuePos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    /** @brief Celda del arreglo circular. */
+    struct Cell {
+        std::atomic<std::size_t> sequence;  ///< Estado de la celda (libre / ocupada).
+        T data;                             ///< Valor almacenado.
+    };
+
+    std::unique_ptr<Cell[]> cells;                      ///< Arreglo circular.
+    std::size_t mask = 0;                               ///< Capacidad - 1.
+    alignas(64) std::atomic<std::size_t> enqueuePos{0}; ///< Próxima posición de escritura.
+    alignas(64) std::atomic<std::size_t> dequeuePos{0}; ///< Próxima posición de lectura.
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,174 @@
+#ifndef DATABASEMAINTENANCE_H
+#define DATABASEMAINTENANCE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+/**
+ * @struct MaintenanceRun
+ * @brief Resultado de una porción de mantenimiento.
+ */
+struct MaintenanceRun {
+    int task = 0;               ///< DatabaseMaintenance::Task ejecutada.
+    QDateTime startedAt;        ///< Inicio de la porción.
+    qint64 durationNs = 0;      ///< Duración de la porción.
+    qint64 reclaimedBytes = 0;  ///< Espacio devuelto (páginas libres quitadas o WAL truncado).
+    bool ok = true;             ///< false si falló o la base estaba ocupada.
+    bool finished = true;       ///< false si queda trabajo para otra porción.
+    QString detail;             ///< Descripción breve de lo hecho.
+};
+
+Q_DECLARE_METATYPE(MaintenanceRun)
+
+/**
+ * @class DatabaseMaintenance
+ * @brief Planificador de mantenimiento de la base en tiempo ocioso.
+ *
+ * Con el uso, "inventario.db" acumula páginas libres de los borrados, las
+ * estadísticas del planificador de consultas envejecen y el archivo WAL
+ * crece si nadie lo vuelve a volcar sobre la base. Este planificador
+ * ejecuta tres tareas:
+ *
+ * - @ref Optimize: `PRAGMA optimize` con `analysis_limit`, que ejecuta un
+ *   ANALYZE acotado solo sobre las tablas que lo necesitan.
+ * - @ref IncrementalVacuum: `PRAGMA incremental_vacuum` en pasos pequeños
+ *   hasta agotar el presupuesto de la porción. Requiere
+ *   `auto_vacuum = INCREMENTAL`; en una base creada sin él no hace nada.
+ * - @ref Checkpoint: `wal_checkpoint(PASSIVE)`, que no espera a nadie, y
+ *   `TRUNCATE` para dejar el WAL en cero cuando ya está todo volcado.
+ *
+ * Convertir una base vieja a `auto_vacuum = INCREMENTAL` exige un VACUUM
+ * completo, que reescribe todo el archivo y bloquea a los escritores
+ * mientras dura. Por eso no se programa nunca: es un paso fuera de línea
+ * (@ref EnableAutoVacuum), que solo corre si se pide con @ref runNow.
+ *
+ * Las tareas corren en un hilo propio con su propia conexión, así que
+ * nunca bloquean la interfaz. Solo se lanzan cuando no hubo actividad
+ * durante @ref setIdleDelay milisegundos (teclado, ratón o
+ * @ref noteActivity), una porción a la vez y cada una acotada por
+ * @ref setSliceBudget. Si la base está ocupada, la porción se abandona
+ * enseguida (la conexión espera poco por el bloqueo) y se reintenta en
+ * el siguiente momento ocioso.
+ *
+ * Cada porción queda registrada en @ref history y se anuncia con
+ * @ref taskFinished.
+ */
+class DatabaseMaintenance : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Tareas de mantenimiento.
+     */
+    enum Task {
+        Optimize = 0,       ///< PRAGMA optimize / ANALYZE acotado.
+        IncrementalVacuum,  ///< Devolver páginas libres al sistema.
+        Checkpoint,         ///< Volcar y truncar el WAL.
+        EnableAutoVacuum,   ///< Convertir a auto_vacuum incremental (VACUUM completo; solo con runNow).
+        TaskCount
+    };
+
+    /**
+     * @brief Crea el planificador (detenido).
+     * @param databasePath Archivo SQLite a mantener.
+     * @param parent Objeto padre opcional.
+     */
+    explicit DatabaseMaintenance(const QString &databasePath, QObject *parent = nullptr);
+    ~DatabaseMaintenance() override;
+
+    /**
+     * @brief Arranca el hilo de mantenimiento y empieza a vigilar la inactividad.
+     */
+    void start();
+
+    /**
+     * @brief Detiene el planificador; espera a que termine la porción en curso.
+     */
+    void stop();
+
+    /** @brief Milisegundos sin actividad antes de empezar a mantener (10000). */
+    void setIdleDelay(int ms);
+
+    /** @brief Tiempo máximo de cada porción, en milisegundos (50). */
+    void setSliceBudget(int ms);
+
+    /** @brief Cada cuánto se repite una tarea, en segundos. */
+    void setInterval(Task task, int seconds);
+
+    /**
+     * @brief Ejecuta una tarea en cuanto el hilo esté libre, sin esperar inactividad.
+     */
+    void runNow(Task task);
+
+    /** @brief Hay una porción ejecutándose. */
+    bool isBusy() const;
+
+    /** @brief Porciones ejecutadas, de la más antigua a la más reciente. */
+    QList<MaintenanceRun> history() const;
+
+    /** @brief Nombre legible de una tarea. */
+    static QString taskName(int task);
+
+public slots:
+    /**
+     * @brief Marca actividad: aplaza el mantenimiento otro @ref setIdleDelay.
+     */
+    void noteActivity();
+
+signals:
+    /**
+     * @brief Se emite al terminar cada porción.
+     */
+    void taskFinished(const MaintenanceRun &run);
+
+protected:
+    /**
+     * @brief Toma el teclado y el ratón de la aplicación como actividad.
+     */
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void tick();    ///< Decide si toca lanzar una porción.
+
+private:
+    /**
+     * @brief Lanza una porción de @p task en el hilo de mantenimiento.
+     */
+    void dispatch(Task task);
+
+    /**
+     * @brief Registra el resultado de una porción (hilo principal).
+     */
+    void finishSlice(const MaintenanceRun &run);
+
+    /**
+     * @brief Indica si a @p task le toca ejecutarse.
+     */
+    bool isDue(Task task) const;
+
+    QString path;                       ///< Archivo de la base.
+    QString connection;                 ///< Nombre de la conexión del hilo.
+    QThread thread;                     ///< Hilo de mantenimiento.
+    QObject *worker = nullptr;          ///< Contexto que vive en @ref thread.
+    QTimer timer;                       ///< Revisión periódica de inactividad.
+    QElapsedTimer idle;                 ///< Tiempo desde la última actividad.
+
+    int idleDelayMs = 10000;
+    int sliceBudgetMs = 50;
+    qint64 intervalMs[TaskCount];       ///< Periodo de cada tarea.
+    QElapsedTimer lastRun[TaskCount];   ///< Última porción terminada de cada tarea.
+    bool pending[TaskCount] = {};       ///< Tarea sin terminar o pedida con runNow.
+    bool forced[TaskCount] = {};        ///< Pedida con runNow (no espera inactividad).
+    bool failed[TaskCount] = {};        ///< La última porción de la tarea falló.
+    bool busy = false;
+
+    QList<MaintenanceRun> runs;         ///< Historial acotado.
+};
+
+#endif // DATABASEMAINTENANCE_H
@@ -3,6 +3,21 @@
 
 #include <QSqlDatabase>
 
+struct sqlite3;
+
+/**
+ * @struct FlushStats
+ * @brief Volcados a disco del modo en memoria.
+ */
+struct FlushStats {
+    qint64 flushes = 0;     ///< Volcados hechos.
+    qint64 skipped = 0;     ///< Volcados omitidos porque no hubo cambios.
+    qint64 failures = 0;    ///< Volcados que fallaron (la copia en disco quedó como estaba).
+    qint64 steps = 0;       ///< Pasos de copia ejecutados.
+    qint64 totalNs = 0;     ///< Tiempo total dentro de los pasos.
+    qint64 maxNs = 0;       ///< Paso más largo (lo que se retiene el hilo principal de una vez).
+};
+
 /**
  * @class DatabaseManager
  * @brief Clase encargada de gestionar la conexión con la base de datos.
@@ -12,8 +27,19 @@
  * por la aplicación. El método estático @ref getDatabase retorna una
  * referencia a dicha conexión evitando crear múltiples instancias.
  *
+ * Además de la conexión principal (usada para escribir), administra una
+ * segunda conexión de solo lectura (@ref getReadDatabase) pensada para
+ * consultas largas como exportaciones o reportes. Como la base se abre
+ * en modo WAL, los lectores trabajan sobre una instantánea consistente
+ * sin bloquear a los escritores.
+ *
  * Se utiliza QSqlDatabase para manejar la apertura y configuración de
  * la base de datos según lo requiera Qt.
+ *
+ * Opcionalmente (@ref setInMemory) la base principal vive en memoria: se
+ * carga desde "inventario.db" al abrirla y se vuelca de nuevo al archivo
+ * cada cierto intervalo y al cerrar la aplicación. Lo que se puede perder
+ * ante un corte queda acotado por ese intervalo.
  */
 class DatabaseManager
 {
@@ -28,7 +54,110 @@ public:
      */
     static QSqlDatabase getDatabase();
 
+    /**
+     * @brief Obtiene la conexión de solo lectura para consultas largas.
+     *
+     * Se abre sobre el mismo archivo que @ref getDatabase, pero con una
+     * conexión independiente y en modo solo lectura. Las lecturas hechas
+     * dentro de una transacción ven una instantánea fija de la base.
+     *
+     * @return Conexión de lectura, o una conexión inválida si no se pudo abrir.
+     */
+    static QSqlDatabase getReadDatabase();
+
+    /**
+     * @brief Reemplaza el contenido de una conexión abierta con el de otro archivo.
+     *
+     * Usa la API de copia en línea de SQLite (sqlite3_backup) para copiar
+     * página por página el archivo @p sourcePath sobre la base "main" de
+     * @p target. La copia se confirma de forma atómica: quien lea la base
+     * verá el contenido anterior o el nuevo, nunca una mezcla. El costo
+     * depende del tamaño en páginas del archivo origen, no del número de
+     * sentencias SQL.
+     *
+     * No debe haber consultas activas sobre @p target durante la copia.
+     *
+     * @param target Conexión destino (abierta, driver QSQLITE).
+     * @param sourcePath Archivo SQLite a copiar.
+     * @return true si la copia terminó y fue confirmada.
+     */
+    static bool restoreFrom(QSqlDatabase target, const QString &sourcePath);
+
+    /**
+     * @brief Obtiene el manejador nativo sqlite3* de una conexión Qt.
+     *
+     * Permite usar la API de SQLite directamente (copias, sentencias
+     * preparadas sin pasar por QVariant) sobre una conexión ya abierta,
+     * dentro de sus mismas transacciones.
+     *
+     * @param database Conexión abierta con el driver QSQLITE.
+     * @return Manejador nativo, o nullptr si la conexión no es SQLite.
+     */
+    static sqlite3 *nativeHandle(const QSqlDatabase &database);
+
+    /**
+     * @brief Copia la base "main" de una conexión abierta sobre un archivo.
+     *
+     * Es la operación inversa de @ref restoreFrom: usa sqlite3_backup en un
+     * único paso, que sobre el destino es una sola transacción. Si falla,
+     * el archivo queda como estaba.
+     *
+     * @param source Conexión origen (abierta, driver QSQLITE).
+     * @param targetPath Archivo destino; se crea si no existe.
+     * @return true si la copia fue confirmada.
+     */
+    static bool saveTo(QSqlDatabase source, const QString &targetPath);
+
+    /**
+     * @brief Activa o desactiva el modo en memoria.
+     *
+     * Debe llamarse antes del primer @ref getDatabase. En este modo no hay
+     * conexión de lectura aparte (@ref getReadDatabase devuelve una
+     * conexión inválida y las lecturas usan la principal) y las demás
+     * estaciones solo ven los cambios después de cada volcado, que además
+     * reemplaza el archivo completo: es un modo para una sola estación
+     * (demostraciones, pruebas, kioscos).
+     *
+     * @param enabled true para trabajar en memoria.
+     * @param flushIntervalMs Periodo de volcado a disco, en milisegundos;
+     *        es la ventana máxima de pérdida ante un corte.
+     */
+    static void setInMemory(bool enabled, int flushIntervalMs = 30000);
+
+    /** @brief Indica si la base principal está en memoria. */
+    static bool isInMemory();
+
+    /**
+     * @brief Vuelca la base en memoria a "inventario.db" hasta terminar.
+     *
+     * Lo llama el cierre de la aplicación; se puede invocar a mano. Copia
+     * de a pasos acotados sin volver al bucle de eventos y, si había un
+     * volcado por pasos en curso (@ref flushInSteps), lo completa. Si no
+     * hubo cambios desde el último volcado no hace nada.
+     *
+     * @return true si el archivo quedó al día.
+     */
+    static bool flushToDisk();
+
+    /**
+     * @brief Empieza un volcado que avanza un paso acotado por vuelta del bucle de eventos.
+     *
+     * Lo llama el temporizador de volcado. Las escrituras que la aplicación
+     * hace entre paso y paso se reflejan en la copia sin reiniciarla; el
+     * archivo se confirma de una vez al terminar. Si ya hay un volcado en
+     * curso o no hubo cambios, no hace nada.
+     */
+    static void flushInSteps();
+
+    /** @brief Contadores de los volcados a disco. */
+    static FlushStats flushStats();
+
 private:
+    /**
+     * @brief Carga la base en memoria desde el archivo y programa sus volcados.
+     */
+    static void openInMemory();
+
     /**
      * @brief Instancia estática de la base de datos administrada.
      *
@@ -36,6 +165,13 @@ private:
      * aplicación. Es configurada en @ref getDatabase.
      */
     static QSqlDatabase db;
+
+    /**
+     * @brief Conexión secundaria de solo lectura.
+     *
+     * Es configurada en @ref getReadDatabase.
+     */
+    static QSqlDatabase readDb;
 };
 
 #endif // DATABASEMANAGER_H
@@ -0,0 +1,139 @@
+#ifndef DEPLETIONFORECAST_H
+#define DEPLETIONFORECAST_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <vector>
+
+class InventoryManager;
+
+/**
+ * @struct ForecastRow
+ * @brief Pronóstico de un ítem.
+ */
+struct ForecastRow {
+    int id = 0;
+    int cantidad = 0;           ///< Existencias actuales.
+    float perDay = 0;           ///< Consumo estimado, en unidades por día.
+    float daysLeft = 0;         ///< Días hasta agotarse al ritmo actual (infinito si no se consume).
+
+    /** @brief Fecha estimada en que se agota, o inválida si no se consume. */
+    QDate depletionDate(const QDate &today) const;
+};
+
+/**
+ * @struct ForecastStats
+ * @brief Tamaño y costo del último pronóstico.
+ */
+struct ForecastStats {
+    qint64 items = 0;           ///< Ítems pronosticados.
+    qint64 changes = 0;         ///< Consumos de la ventana usados.
+    qint64 loadNs = 0;          ///< Lectura de ítems e historial.
+    qint64 computeNs = 0;       ///< Cálculo (@ref DepletionForecast::compute).
+};
+
+/**
+ * @class DepletionForecast
+ * @brief Ritmo de consumo y fecha de agotamiento de cada ítem.
+ *
+ * El consumo sale del historial de existencias (InventoryManager lo
+ * registra para toda escritura): cada movimiento negativo de los últimos
+ * @ref setWindow días pesa según su antigüedad, con vida media
+ * @ref setHalfLife, de modo que el ritmo sigue los cambios de demanda sin
+ * saltar con un solo día atípico. Las reposiciones no cuentan como consumo.
+ *
+ * Los datos se guardan por columnas (un vector por campo, con el índice
+ * del ítem ya resuelto) y @ref compute los recorre en tres pasadas
+ * planas: peso de cada consumo, acumulación por ítem y días restantes.
+ * Las pasadas primera y tercera no tienen dependencias entre iteraciones,
+ * así que el compilador las vectoriza; el peso sale de una tabla por día
+ * en lugar de una exponencial por consumo.
+ */
+class DepletionForecast
+{
+public:
+    /**
+     * @brief Ventana de historial considerada, en días (90 por defecto).
+     */
+    void setWindow(int days);
+
+    /**
+     * @brief Vida media del peso de un consumo, en días (14 por defecto).
+     */
+    void setHalfLife(double days);
+
+    /**
+     * @brief Carga ítems y consumos de la ventana desde la base.
+     * @param manager Capa de datos (usa su conexión de lectura).
+     * @param now Instante del pronóstico.
+     * @return false si alguna lectura falló.
+     */
+    bool load(InventoryManager &manager, const QDateTime &now = QDateTime::currentDateTime());
+
+    /**
+     * @brief Carga manual: vacía los datos y fija el instante del pronóstico.
+     */
+    void reset(const QDateTime &now, int expectedItems = 0, int expectedChanges = 0);
+
+    /** @brief Agrega un ítem con sus existencias actuales. */
+    void addItem(int id, int cantidad);
+
+    /**
+     * @brief Agrega un movimiento de un ítem ya agregado.
+     * @param ts Marca de tiempo en segundos UTC.
+     * @param delta Cambio de cantidad; solo cuentan los negativos.
+     */
+    void addChange(int id, qint64 ts, int delta);
+
+    /**
+     * @brief Calcula ritmo y días restantes de todos los ítems.
+     */
+    void compute();
+
+    /** @brief Ítems cargados. */
+    int size() const { return int(ids.size()); }
+
+    /** @brief Pronóstico del ítem en la posición @p index (orden de carga). */
+    ForecastRow row(int index) const;
+
+    /**
+     * @brief Ítems que se agotan dentro de @p days días, los más urgentes primero.
+     * @param limit Máximo de filas (0 = todas).
+     */
+    QList<ForecastRow> runsOutWithin(double days, int limit = 0) const;
+
+    /** @brief Fecha del pronóstico. */
+    QDateTime now() const { return QDateTime::fromSecsSinceEpoch(nowTs); }
+
+    /** @brief Tamaño y costo del último pronóstico. */
+    ForecastStats stats() const { return current; }
+
+private:
+    /** @brief Posición de un ID, o -1 si no se cargó. */
+    int indexOf(int id) const;
+
+    int windowDays = 90;
+    double halfLifeDays = 14.0;
+    qint64 nowTs = 0;
+
+    // Ítems, por columnas (en el orden de addItem)
+    std::vector<int> ids;
+    std::vector<float> quantities;
+    std::vector<float> perDay;
+    std::vector<float> daysLeft;
+
+    // ID -> posición: directo si los IDs son densos, por hash si no
+    std::vector<int> denseIndex;
+    QHash<int, int> sparseIndex;
+
+    // Consumos de la ventana, por columnas
+    std::vector<int> changeItem;        ///< Posición del ítem.
+    std::vector<quint16> changeDay;     ///< Antigüedad en días enteros.
+    std::vector<float> changeUsed;      ///< Unidades consumidas (positivo).
+    std::vector<float> contribution;    ///< Consumo ponderado (intermedio de compute).
+
+    ForecastStats current;
+};
+
+#endif // DEPLETIONFORECAST_H
@@ -0,0 +1,102 @@
+#ifndef FACETCOUNTS_H
+#define FACETCOUNTS_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+
+#include "InventoryManager.h"
+
+/**
+ * @class FacetCounts
+ * @brief Conteos por tipo, ubicación y fecha de adquisición, mantenidos en memoria.
+ *
+ * Guarda cuántos ítems hay por cada combinación (tipo, ubicación, fecha)
+ * y la combinación vigente de cada ID. Se alimenta con las mismas señales
+ * que el modelo de la tabla (InventoryManager::itemsChanged e
+ * inventoryReset): cada cambio mueve un ítem de una celda a otra, sin
+ * volver a leer la tabla. Los cambios solo de cantidad no lo alteran.
+ *
+ * Los conteos de una faceta respetan la selección de las demás (por
+ * ejemplo, los tipos que hay en la ubicación elegida), pero no la
+ * búsqueda por texto.
+ */
+class FacetCounts : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor (sin ítems).
+     * @param parent Objeto padre opcional.
+     */
+    explicit FacetCounts(QObject *parent = nullptr);
+
+    /**
+     * @brief Conteo por tipo, con las demás facetas de @p filter aplicadas.
+     * @return Pares (tipo, ítems) ordenados por tipo; incluye los que quedan en 0.
+     */
+    QList<QPair<QString, int>> tipoCounts(const FacetFilter &filter) const;
+
+    /**
+     * @brief Conteo por ubicación, con las demás facetas de @p filter aplicadas.
+     * @return Pares (ubicación, ítems) ordenados por ubicación; incluye los que quedan en 0.
+     */
+    QList<QPair<QString, int>> ubicacionCounts(const FacetFilter &filter) const;
+
+    /**
+     * @brief Número de ítems que pasan todas las facetas de @p filter.
+     */
+    int matchCount(const FacetFilter &filter) const;
+
+public slots:
+    /**
+     * @brief Recalcula los conteos desde cero (recarga de la tabla).
+     */
+    void setItems(const QList<InventoryItem> &items);
+
+    /**
+     * @brief Toma los conteos armados en otro hilo (intercambia contenedores).
+     */
+    void adopt(FacetCounts &built);
+
+    /**
+     * @brief Aplica filas nuevas, modificadas o borradas.
+     * Firma compatible con InventoryManager::itemsChanged.
+     */
+    void applyChanges(const QList<InventoryItem> &rows, const QList<int> &removedIds);
+
+signals:
+    /**
+     * @brief Algún conteo cambió (no se emite por cambios solo de cantidad).
+     */
+    void countsChanged();
+
+private:
+    /** @brief Valores de faceta de un ítem. */
+    struct Key {
+        QString tipo;
+        QString ubicacion;
+        QString fecha;
+
+        bool operator==(const Key &other) const
+        {
+            return tipo == other.tipo && ubicacion == other.ubicacion && fecha == other.fecha;
+        }
+    };
+
+    using DateCounts = QMap<QString, int>;                  ///< Fecha -> ítems.
+    using LocationCells = QHash<QString, DateCounts>;       ///< Ubicación -> fechas.
+
+    void add(const Key &key);
+    void remove(const Key &key);
+    static int countDates(const DateCounts &dates, const FacetFilter &filter);
+
+    QHash<QString, LocationCells> cells;    ///< Tipo -> ubicación -> fecha -> ítems.
+    QHash<int, Key> keyById;                ///< Valores vigentes de cada ID.
+};
+
+#endif // FACETCOUNTS_H
@@ -0,0 +1,119 @@
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <vector>
+
+#include "InventoryManager.h"
+
+/**
+ * @brief Resultado de una búsqueda aproximada.
+ */
+struct FuzzyMatch {
+    int id = 0;             ///< ID del ítem.
+    int distance = 0;       ///< Ediciones necesarias para encontrar el texto buscado en el nombre.
+    double score = 0.0;     ///< Similitud entre 0 y 1 (1 = aparece tal cual).
+};
+
+/**
+ * @class FuzzyIndex
+ * @brief Índice de trigramas en memoria para buscar nombres con errores de tipeo.
+ *
+ * Cada nombre se pliega como las claves de búsqueda
+ * (InventoryManager::foldSearchText) y se descompone en trigramas; el
+ * índice invertido guarda, por trigrama, las posiciones de los nombres
+ * que lo contienen. Una búsqueda:
+ *
+ * 1. Cuenta cuántos trigramas comparte cada nombre con el texto buscado
+ *    recorriendo solo las listas de esos trigramas, y descarta los que
+ *    comparten menos de los que puede destruir el número de errores
+ *    admitido (cada edición altera como mucho tres trigramas).
+ * 2. Verifica los candidatos con la distancia de edición bit-paralela de
+ *    Myers (el texto buscado puede aparecer en cualquier parte del
+ *    nombre), que procesa un carácter del nombre por operación de 64 bits.
+ * 3. Ordena por distancia, trigramas compartidos y longitud del nombre.
+ *
+ * El índice se mantiene con las mismas señales que el modelo de la tabla
+ * (InventoryManager::itemsChanged e inventoryReset): los cambios solo de
+ * cantidad no lo tocan, y las filas borradas se marcan y se compactan
+ * cuando son mayoría.
+ *
+ * No es seguro usarlo desde varios hilos a la vez: @ref search reutiliza
+ * un arreglo de contadores interno.
+ */
+class FuzzyIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor del índice (vacío).
+     * @param parent Objeto padre opcional.
+     */
+    explicit FuzzyIndex(QObject *parent = nullptr);
+
+    /**
+     * @brief Busca nombres parecidos al texto indicado.
+     *
+     * @param text Texto escrito por el usuario (p. ej. "2N3940").
+     * @param limit Máximo de resultados.
+     * @return Coincidencias ordenadas de la más a la menos parecida.
+     */
+    QList<FuzzyMatch> search(const QString &text, int limit = 100) const;
+
+    /**
+     * @brief Número de ítems indexados.
+     */
+    int size() const;
+
+    /**
+     * @brief Duración de la última búsqueda, en nanosegundos.
+     */
+    qint64 lastSearchNs() const;
+
+public slots:
+    /**
+     * @brief Reconstruye el índice completo (recarga de la tabla).
+     * @param items Todas las filas del inventario.
+     */
+    void setItems(const QList<InventoryItem> &items);
+
+    /**
+     * @brief Toma el contenido de un índice armado en otro hilo.
+     *
+     * Solo intercambia contenedores, así que es instantáneo aunque el
+     * índice tenga millones de nombres. @p built queda con el contenido
+     * anterior de este índice.
+     */
+    void adopt(FuzzyIndex &built);
+
+    /**
+     * @brief Aplica filas nuevas, modificadas o borradas.
+     * Firma compatible con InventoryManager::itemsChanged.
+     */
+    void applyChanges(const QList<InventoryItem> &rows, const QList<int> &removedIds);
+
+private:
+    /** @brief Nombre indexado; id 0 marca una posición borrada. */
+    struct Entry {
+        int id;
+        QString name;
+    };
+
+    void insertEntry(int id, const QString &name);
+    void removeEntry(int id);
+    void compact();
+
+    std::vector<Entry> entries;                         ///< Posición -> nombre plegado.
+    QHash<int, quint32> slotById;                       ///< ID -> posición vigente.
+    QHash<quint64, std::vector<quint32>> postings;      ///< Trigrama -> posiciones.
+    int deadCount = 0;                                  ///< Posiciones borradas sin compactar.
+
+    mutable std::vector<quint16> counts;                ///< Trigramas compartidos por posición (búsqueda).
+    mutable qint64 lastNs = 0;
+};
+
+#endif // FUZZYINDEX_H
@@ -0,0 +1,42 @@
+#ifndef INVENTORYFILTERPROXY_H
+#define INVENTORYFILTERPROXY_H
+
+#include <QSortFilterProxyModel>
+
+/**
+ * @class InventoryFilterProxy
+ * @brief Proxy de la tabla: delega el ordenamiento al modelo fuente.
+ *
+ * La búsqueda por texto, la aproximada y las facetas no se filtran aquí
+ * sino en el modelo (InventoryModel::setSearch, setRankedIds y
+ * setFacetFilter), dentro de las consultas que leen cada página: así el
+ * filtro abarca toda la tabla y no solo las filas ya cargadas, y la vista
+ * sigue pidiendo páginas mientras haya filas que lo pasen.
+ *
+ * El ordenamiento por columna (clic en la cabecera) tampoco se hace aquí:
+ * se delega al modelo fuente, que lo resuelve en SQL.
+ */
+class InventoryFilterProxy : public QSortFilterProxyModel
+{
+public:
+    /**
+     * @brief Constructor del proxy.
+     * @param parent Objeto padre opcional según la jerarquía Qt.
+     */
+    explicit InventoryFilterProxy(QObject *parent = nullptr)
+        : QSortFilterProxyModel(parent) {}
+
+    /**
+     * @brief Ordena por columna delegando en el modelo fuente (ORDER BY en SQL).
+     * El proxy conserva el orden de las filas del modelo.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override
+    {
+        QSortFilterProxyModel::sort(-1);
+        if (column >= 0) {
+            sourceModel()->sort(column, order);
+        }
+    }
+};
+
+#endif // INVENTORYFILTERPROXY_H
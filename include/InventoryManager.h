@@ -3,7 +3,17 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QVariant>
 #include <QSqlDatabase>
+#include <QStringView>
+#include <QDateTime>
+#include <functional>
+#include <memory>
+
+#include "QueryDiagnostics.h"
+
+class InventoryShards;
 
 /*
  * Estructura que representa un ítem dentro del inventario.
@@ -19,6 +29,177 @@ struct InventoryItem {
     QString fechaAdquisicion;   // Fecha en que se adquirió el ítem
 };
 
+/*
+ * Vista de solo lectura de una fila, para recorrer la tabla sin copiarla.
+ * Los textos apuntan directamente al búfer de la sentencia SQLite y solo
+ * son válidos durante la llamada al visitante; para conservar la fila
+ * se copia con toItem().
+ */
+struct InventoryRowView {
+    int id;
+    QStringView nombre;
+    QStringView tipo;
+    int cantidad;
+    QStringView ubicacion;
+    QStringView fechaAdquisicion;
+
+    InventoryItem toItem() const
+    {
+        return {id, nombre.toString(), tipo.toString(), cantidad,
+                ubicacion.toString(), fechaAdquisicion.toString()};
+    }
+};
+
+/*
+ * Contadores de latencia de las búsquedas por ID.
+ * Cada camino (índice en memoria, SELECT individual y SELECT por lote)
+ * acumula el número de llamadas y el tiempo total en nanosegundos, de
+ * modo que la latencia media de cada uno es totalNs / llamadas.
+ */
+struct LookupStats {
+    qint64 indexLookups = 0;    // getItemById resueltos desde el índice
+    qint64 indexNs = 0;
+    qint64 sqlLookups = 0;      // getItemById resueltos con un SELECT
+    qint64 sqlNs = 0;
+    qint64 batchLookups = 0;    // llamadas a getItemsByIds
+    qint64 batchIds = 0;        // IDs pedidos en total en esas llamadas
+    qint64 batchNs = 0;
+};
+
+/*
+ * Contadores del planificador de escrituras. Cada escritura se confirma
+ * en una transacción BEGIN IMMEDIATE; si otra estación tiene el bloqueo
+ * se reintenta con espera exponencial aleatoria. lockWaitNs es el tiempo
+ * hasta obtener el bloqueo (incluidas las esperas entre intentos) y
+ * transactionNs el tiempo con el bloqueo tomado.
+ */
+struct WriteStats {
+    qint64 transactions = 0;    // Transacciones confirmadas
+    qint64 operations = 0;      // Escrituras confirmadas (un lote en cola cuenta como una)
+    qint64 retries = 0;         // Intentos repetidos por base bloqueada
+    qint64 failures = 0;        // Escrituras no confirmadas (bloqueo agotado o error)
+    qint64 lockWaitNs = 0;
+    qint64 maxLockWaitNs = 0;
+    qint64 transactionNs = 0;
+};
+
+/*
+ * Historial de existencias. Cada cambio de cantidad (alta, movimiento o
+ * baja) queda como un delta en inventario_historial y cada tanto se
+ * guarda una foto completa de las cantidades (inventario_fotos). Los
+ * tamaños son los que ocupan en disco según dbstat, o -1 si SQLite no
+ * lo expone.
+ */
+struct HistoryStats {
+    qint64 changes = 0;             // Deltas registrados
+    qint64 keyframes = 0;           // Fotos guardadas
+    qint64 keyframeRows = 0;        // Filas de todas las fotos
+    qint64 deltaBytes = -1;         // Espacio de los deltas
+    qint64 keyframeBytes = -1;      // Espacio de las fotos
+    qint64 lastReplayed = 0;        // Deltas aplicados en la última reconstrucción
+    qint64 lastReconstructNs = 0;   // Duración de la última reconstrucción
+
+    double bytesPerChange() const
+    {
+        return changes > 0 && deltaBytes >= 0 ? double(deltaBytes) / changes : 0.0;
+    }
+};
+
+/*
+ * Estado de stock de un ítem respecto de su punto de reorden: agotado
+ * (cantidad 0 o menos), bajo (por debajo del punto) o suficiente.
+ */
+enum class StockStatus : quint8 { Ok = 0, Low, Out };
+
+/*
+ * Puntos de reorden: cantidad por debajo de la cual un ítem se considera
+ * bajo de stock. Vale el del ítem si tiene uno; si no, el de su tipo; si
+ * tampoco, el general (fallback).
+ */
+struct ReorderPoints {
+    int fallback = 5;
+    QHash<int, int> byItem;         // ID -> punto propio del ítem
+    QHash<QString, int> byTipo;     // Tipo -> punto del tipo
+
+    int pointFor(int id, const QString &tipo) const
+    {
+        const auto item = byItem.constFind(id);
+        if (item != byItem.constEnd()) {
+            return item.value();
+        }
+        const auto type = byTipo.constFind(tipo);
+        return type != byTipo.constEnd() ? type.value() : fallback;
+    }
+
+    StockStatus statusOf(const InventoryItem &it) const
+    {
+        if (it.cantidad <= 0) {
+            return StockStatus::Out;
+        }
+        return it.cantidad < pointFor(it.id, it.tipo) ? StockStatus::Low : StockStatus::Ok;
+    }
+};
+
+/*
+ * Selección de facetas. Un campo vacío no filtra. Las fechas usan el
+ * formato de la tabla ("yyyy-MM-dd"), que se ordena igual como texto
+ * que como fecha; el rango incluye ambos extremos.
+ */
+struct FacetFilter {
+    QString tipo;
+    QString ubicacion;
+    QString desde;
+    QString hasta;
+
+    bool isEmpty() const
+    {
+        return tipo.isEmpty() && ubicacion.isEmpty() && desde.isEmpty() && hasta.isEmpty();
+    }
+
+    bool matches(const QString &itemTipo, const QString &itemUbicacion, const QString &fecha) const
+    {
+        return (tipo.isEmpty() || itemTipo == tipo)
+               && (ubicacion.isEmpty() || itemUbicacion == ubicacion)
+               && (desde.isEmpty() || fecha >= desde)
+               && (hasta.isEmpty() || fecha <= hasta);
+    }
+};
+
+/*
+ * Filtro de las filas que trae fetchPage: facetas y, si no está vacío,
+ * el texto buscado (con las mismas reglas que searchItems). Ambos se
+ * resuelven en el WHERE de la consulta, de modo que cada página trae
+ * solo filas que pasan el filtro, estén donde estén en la tabla.
+ */
+struct PageFilter {
+    FacetFilter facets;
+    QString search;
+
+    bool isEmpty() const
+    {
+        return facets.isEmpty() && search.trimmed().isEmpty();
+    }
+};
+
+/*
+ * Identidad estable de una fila entre sedes: la sede donde se creó y el
+ * ID que tuvo allí. El ID local no sirve para esto, porque cada sede
+ * numera sus filas por su cuenta; las creadas en esta base son
+ * (siteId(), id) y las traídas de otra sede conservan su origen.
+ */
+struct RowOrigin {
+    qint64 sede = 0;
+    int id = 0;
+
+    bool operator==(const RowOrigin &other) const { return sede == other.sede && id == other.id; }
+    bool operator!=(const RowOrigin &other) const { return !(*this == other); }
+};
+
+inline size_t qHash(const RowOrigin &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.sede, key.id);
+}
+
 /*
  * Clase InventoryManager
  * ----------------------
@@ -37,6 +218,7 @@ public:
      */
     explicit InventoryManager(QSqlDatabase database,
                               QObject *parent = nullptr);
+    ~InventoryManager() override;
 
     /*
      * Crea la tabla del inventario si no existe.
@@ -69,6 +251,27 @@ public:
      */
     QList<InventoryItem> getAllItems();
 
+    /*
+     * Visitante de filas: recibe cada fila como vista (válida solo
+     * durante la llamada) y devuelve false para detener el recorrido.
+     */
+    using RowVisitor = std::function<bool(const InventoryRowView &)>;
+
+    /*
+     * Recorre todos los ítems sin construir una lista ni un objeto por
+     * fila: cada vista apunta al texto que SQLite ya tiene en memoria.
+     * Usa la conexión de lectura, dentro de una instantánea. Retorna
+     * false si la consulta falló (no si el visitante se detuvo).
+     */
+    bool forEachItem(const RowVisitor &visit);
+
+    /*
+     * Como forEachItem, pero solo hasta limit filas con ID mayor que
+     * afterId, en orden de ID: recorre la tabla por tramos acotados
+     * (paginación por clave), cada uno en su propia instantánea.
+     */
+    bool forEachItemAfter(int afterId, int limit, const RowVisitor &visit);
+
     /*
      * Actualiza un ítem completo según su ID.
      */
@@ -85,8 +288,475 @@ public:
      */
     InventoryItem getItemById(int id);
 
+    /*
+     * Devuelve los ítems correspondientes a una ráfaga de IDs usando una
+     * sola consulta (o el índice en memoria, si está activo). El resultado
+     * respeta el orden de los IDs pedidos; los que no existen se omiten.
+     */
+    QList<InventoryItem> getItemsByIds(const QList<int> &ids);
+
+    /*
+     * Activa o desactiva el índice en memoria ID -> fila. Mientras está
+     * activo, el registro de cambios lo mantiene al día (escrituras propias
+     * y externas) y las búsquedas por ID no tocan SQLite.
+     */
+    void setIdIndexEnabled(bool enabled);
+    bool isIdIndexEnabled() const;
+
+    /*
+     * Contadores de latencia de las búsquedas por ID.
+     */
+    LookupStats lookupStats() const;
+    void resetLookupStats();
+
+    /*
+     * Diagnóstico de consultas (desactivado por defecto). Activado, cada
+     * sentencia distinta que ejecuta el gestor (incluidas las páginas del
+     * modelo y la búsqueda) guarda su EXPLAIN QUERY PLAN la primera vez, y
+     * acumula tiempo y filas recorridas; ver QueryDiagnostics::report().
+     */
+    QueryDiagnostics &queryDiagnostics();
+
+    /*
+     * Bases de otras sedes adjuntas como fragmentos de solo lectura.
+     * Búsqueda, stock bajo y agregados se reparten en paralelo (un hilo y
+     * una conexión por sede) y se unen etiquetados con la sede; ver
+     * InventoryShards. Se crea vacío la primera vez que se pide.
+     */
+    InventoryShards &shards();
+
+    /*
+     * Contadores del planificador de escrituras (esperas por bloqueo,
+     * reintentos, transacciones y fallos).
+     */
+    WriteStats writeStats() const;
+    void resetWriteStats();
+
+    /*
+     * Encola movimientos de stock. Se suman por ID con los que ya están
+     * en cola y se confirman juntos en la próxima transacción (al volver
+     * al bucle de eventos, con flushWrites o con cualquier otra escritura).
+     * Si la base sigue bloqueada, se reintentan más tarde.
+     */
+    void queueQuantityDeltas(const QHash<int, int> &deltas);
+    bool flushWrites();
+
+    /*
+     * Ejecuta varias escrituras (llamadas a addItem, updateItem, ...) en
+     * una sola transacción. Cada una corre en su propio SAVEPOINT, así que
+     * una que falla no deshace las demás; results recibe el resultado de
+     * cada una. Retorna false si la transacción no se pudo confirmar (en
+     * ese caso todas cuentan como fallidas).
+     */
+    using WriteOp = std::function<bool()>;
+    bool writeBatch(const QList<WriteOp> &ops, QList<bool> *results = nullptr);
+
+    /*
+     * Ejecuta op (que puede hacer muchas escrituras) como una sola unidad:
+     * si op retorna false, todo lo que escribió se deshace. Pensado para
+     * trabajos largos que se cancelan a mitad de camino (ver JobQueue).
+     * Si la base estaba bloqueada al confirmar, op se vuelve a ejecutar.
+     */
+    bool writeAtomically(const WriteOp &op);
+
+    /*
+     * Escritura de la interfaz que no debe fallar porque otra estación
+     * tenga tomada la base: se intenta enseguida (junto con lo demás en
+     * cola) y, mientras la base siga bloqueada, queda en cola y se
+     * reintenta con un temporizador, como los movimientos de stock. done
+     * recibe el resultado cuando se confirma o falla por otro motivo. op
+     * se ejecuta más tarde, así que debe ser dueña de sus datos.
+     */
+    using WriteDone = std::function<void(bool ok)>;
+    void queueWrite(const WriteOp &op, const WriteDone &done = {});
+    int queuedWrites() const;
+
+    /*
+     * Escrituras de este proceso que esperan ahora mismo el bloqueo de
+     * escritura. Los trabajos por lotes (JobQueue) les ceden el turno
+     * entre un lote y el siguiente.
+     */
+    static int waitingWriters();
+
+    /*
+     * ID asignado por SQLite en el último addItem exitoso.
+     */
+    int lastAddedId() const;
+
+    /*
+     * Historial de existencias: el inventario tal como estaba en un
+     * momento dado. Parte de la última foto anterior a "when" y aplica
+     * solo los deltas posteriores a ella, sin repasar todo el historial.
+     * Las columnas que no son la cantidad se toman de la fila actual (un
+     * ítem borrado desde entonces solo trae ID y cantidad). Retorna una
+     * lista vacía si "when" es anterior al inicio del historial.
+     */
+    QList<InventoryItem> inventoryAt(const QDateTime &when);
+
+    /*
+     * Cantidad de un ítem en un momento dado, o -1 si no existía.
+     */
+    int quantityAt(int id, const QDateTime &when);
+
+    /*
+     * Fecha de la primera foto (desde cuándo hay historial).
+     */
+    QDateTime historyStart();
+
+    /*
+     * Guarda ya una foto de las cantidades. Normalmente no hace falta:
+     * se toma sola cuando los deltas desde la última superan al número
+     * de ítems, de modo que el historial ocupa a lo sumo el doble de los
+     * deltas y una reconstrucción nunca repasa más deltas que ítems.
+     */
+    bool takeKeyframe();
+
+    /*
+     * Tamaño del historial y costo de la última reconstrucción.
+     */
+    HistoryStats historyStats();
+
+    /*
+     * Recorre los movimientos de cantidad del historial (no las altas ni
+     * las bajas) registrados desde "since", en el orden en que ocurrieron.
+     * Usa la conexión de lectura, dentro de una instantánea.
+     */
+    using ChangeVisitor = std::function<void(int id, qint64 ts, int delta)>;
+    bool forEachQuantityChange(const QDateTime &since, const ChangeVisitor &visit);
+
+    /*
+     * Inserta varios ítems dentro de una sola transacción.
+     * Si alguno falla, no se guarda ninguno.
+     */
+    bool addItems(const QList<InventoryItem> &items);
+
+    /*
+     * Inserta o actualiza filas conservando su ID (por ejemplo, al traer
+     * filas de otra sede). Todo en una sola transacción.
+     */
+    bool putItems(const QList<InventoryItem> &items);
+
+    /*
+     * Sincronización entre sedes. siteId es la identidad de esta base
+     * (tabla inventario_sede, creada con el esquema; 0 si no la tiene).
+     * itemOrigins devuelve el origen de las filas traídas de otra sede
+     * (ID local -> origen); las demás son (siteId(), id). importItems
+     * inserta filas de otra sede con un ID nuevo y guarda su origen.
+     * syncedDigests y setSyncedDigests leen y actualizan el resumen de
+     * cada fila en la última sincronización con la sede peer.
+     */
+    qint64 siteId();
+    QHash<int, RowOrigin> itemOrigins();
+    bool importItems(const QList<InventoryItem> &items, const QList<RowOrigin> &origins);
+    QHash<RowOrigin, quint64> syncedDigests(qint64 peer);
+    bool setSyncedDigests(qint64 peer, const QHash<RowOrigin, quint64> &digests,
+                          const QList<RowOrigin> &forget = {});
+
+    /*
+     * Da a esta base una identidad de sede nueva (por ejemplo, a la copia
+     * de la base de otra sede). Las filas que ya tenía conservan su
+     * origen anterior.
+     */
+    bool renewSiteId();
+
+    /*
+     * Reemplaza todo el contenido de la tabla por la lista recibida.
+     * El borrado y las inserciones se confirman juntos, de modo que
+     * ningún lector ve la tabla a medio restaurar.
+     */
+    bool replaceAllItems(const QList<InventoryItem> &items);
+
+    /*
+     * Restaura los ítems (y sus claves de búsqueda) desde una base
+     * plantilla ya construida, copiando sus páginas sobre la base en uso
+     * en un solo paso atómico. El historial, sus fotos y los puntos de
+     * reorden por tipo se conservan; el historial registra la restauración
+     * como una sola marca de reemplazo más una foto nueva, y los puntos de
+     * cada ítem se van con él. No debe llamarse dentro de otra transacción.
+     */
+    bool restoreFromTemplate(const QString &templatePath);
+
+    /*
+     * Construye una base plantilla con la tabla inventario y los ítems
+     * indicados. Se escribe en un archivo temporal y se renombra al
+     * final, para que nunca quede una plantilla a medio escribir.
+     */
+    static bool buildTemplate(const QString &templatePath,
+                              const QList<InventoryItem> &items);
+
+    /*
+     * Suma a la cantidad de cada ítem el delta indicado (ID -> delta),
+     * todo en una sola transacción. La cantidad nunca baja de cero.
+     * Los IDs inexistentes se ignoran.
+     */
+    bool applyQuantityDeltas(const QHash<int, int> &deltas);
+
+    /*
+     * Operaciones masivas sobre una selección de IDs. Cada una se ejecuta
+     * como una sola transacción: se aplica a todos los IDs o a ninguno.
+     */
+    bool removeItems(const QList<int> &ids);
+    bool adjustQuantities(const QList<int> &ids, int delta);
+    bool relocateItems(const QList<int> &ids, const QString &ubicacion);
+
+    /*
+     * Devuelve los ítems cuya cantidad es menor al umbral indicado.
+     * Se ejecuta sobre la conexión de lectura, si existe.
+     */
+    QList<InventoryItem> getLowStockItems(int threshold);
+
+    /*
+     * Igual que getLowStockItems, pero visitando las filas sin copiarlas.
+     */
+    bool forEachLowStockItem(int threshold, const RowVisitor &visit);
+
+    /*
+     * Puntos de reorden guardados en la base (inventario_reorden por ítem,
+     * inventario_reorden_tipos por tipo) más el general, que no se guarda.
+     * setReorderPoints fija el punto de varios ítems en una transacción;
+     * con point < 0 lo quita y vuelven a usar el de su tipo. Lo mismo
+     * setTypeReorderPoint para un tipo. Cada cambio emite
+     * reorderPointsChanged.
+     */
+    ReorderPoints reorderPoints();
+    bool setReorderPoints(const QList<int> &ids, int point);
+    bool setTypeReorderPoint(const QString &tipo, int point);
+    void setDefaultReorderPoint(int point);
+    int defaultReorderPoint() const { return reorderFallback; }
+
+    /*
+     * Visita los ítems por debajo de su punto de reorden, de menor a mayor
+     * cantidad. Se ejecuta sobre la conexión de lectura, si existe.
+     */
+    bool forEachBelowReorderPoint(const RowVisitor &visit);
+
+    /*
+     * Lee una página de la tabla ordenada en SQL por la columna indicada
+     * (0-5, en el orden de la tabla) y, a igual valor, por ID. after es la
+     * última fila de la página anterior, o nullptr para la primera. La
+     * página siguiente se busca por rango sobre el índice de la columna
+     * (paginación por clave, sin OFFSET), así que cuesta lo mismo al
+     * principio que al final de la tabla. Con filter, solo se cuentan y
+     * devuelven las filas que lo pasan.
+     */
+    QList<InventoryItem> fetchPage(int column,
+                                   Qt::SortOrder order,
+                                   const InventoryItem *after,
+                                   int limit,
+                                   const PageFilter &filter = PageFilter());
+
+    /*
+     * De los IDs indicados, los que pasan el filtro (en el orden de ids).
+     * Permite saber si una fila que cambió entra o sale de la vista
+     * filtrada sin volver a leer las páginas.
+     */
+    QList<int> filterIds(const QList<int> &ids, const PageFilter &filter);
+
+    /*
+     * Compara dos ítems con el mismo criterio que fetchPage en orden
+     * ascendente (<0, 0 o >0). Permite ubicar un cambio dentro de las
+     * filas ya cargadas sin volver a consultar.
+     */
+    static int compareForSort(const InventoryItem &a, const InventoryItem &b, int column);
+
+    /*
+     * Búsqueda sin distinguir tildes ni mayúsculas ("cajon" encuentra
+     * "Cajón A1"). Cada palabra del texto debe ser prefijo de alguna
+     * palabra del nombre, tipo, ubicación, fecha o ID. Se resuelve con
+     * las claves plegadas guardadas al escribir, por rangos de índice.
+     * Retorna los IDs que coinciden.
+     */
+    QList<int> searchItems(const QString &text);
+
+    /*
+     * Pliega un texto como se guardan las claves de búsqueda:
+     * sin marcas diacríticas y en minúsculas (plegado de Unicode).
+     */
+    static QString foldSearchText(const QString &text);
+
+    /*
+     * Asigna una conexión de solo lectura para las consultas largas
+     * (exportaciones, agregados, revisión de stock bajo). Cada una de
+     * esas consultas corre en su propia transacción de lectura y ve una
+     * instantánea consistente, sin bloquear las escrituras.
+     */
+    void setReadDatabase(QSqlDatabase database);
+
+    /*
+     * Detecta cambios confirmados por otras conexiones (otras estaciones
+     * sobre el mismo archivo) con PRAGMA data_version y, si los hay, lee
+     * solo las filas afectadas y emite itemsChanged. Es barata: pensada
+     * para llamarse periódicamente desde un temporizador.
+     * Retorna true si había cambios externos.
+     */
+    bool pollExternalChanges();
+
+    /*
+     * Arranque diferido: deferChangeTracking deja de revisar el registro
+     * de cambios (las escrituras se confirman igual, pero no emiten
+     * señales) hasta startChangeTracking, que retoma desde fromSeq (una
+     * changePosition leída antes de cargar los datos) y emite de una vez
+     * los cambios posteriores; con -1 empieza desde la posición actual.
+     * createTable empieza el seguimiento, salvo que esté diferido.
+     */
+    void deferChangeTracking();
+    void startChangeTracking(qint64 fromSeq = -1);
+    qint64 changePosition();
+
+signals:
+    /*
+     * Filas que cambiaron desde la última revisión (propias o externas):
+     * rows trae el contenido vigente de las insertadas o modificadas y
+     * removedIds los IDs que ya no existen.
+     */
+    void itemsChanged(const QList<InventoryItem> &rows, const QList<int> &removedIds);
+
+    /*
+     * La tabla se reemplazó completa o hubo demasiados cambios para
+     * aplicarlos uno a uno: quien muestre datos debe recargarlos.
+     */
+    void inventoryReset();
+
+    /*
+     * Un lote de movimientos en cola falló por un error distinto de base
+     * bloqueada y se descartó; items es el número de IDs afectados.
+     */
+    void queuedWritesFailed(int items);
+
+    /*
+     * Cambió el número de escrituras de queueWrite que esperan a que se
+     * libere la base (0 cuando se confirmaron todas).
+     */
+    void queuedWritesChanged(int writes);
+
+    /*
+     * Cambió algún punto de reorden (de un ítem, de un tipo o el general).
+     */
+    void reorderPointsChanged();
+
 private:
-    QSqlDatabase db;    // Conexión activa a la base de datos SQLite
+    /*
+     * Qué hacer tras confirmar una escritura: nada (esquema, claves),
+     * revisar el registro de cambios o avisar que todo cambió. Van de
+     * menor a mayor: una llamada anidada puede pedir más que la de afuera.
+     */
+    enum class AfterWrite { Nothing, SyncChanges, ResetTracking };
+
+    /*
+     * Planificador de escrituras: ejecuta op (sin transacción propia)
+     * junto con los movimientos en cola, en una transacción BEGIN
+     * IMMEDIATE con reintentos acotados. Ver la implementación.
+     */
+    bool runWrite(const WriteOp &op, AfterWrite after = AfterWrite::SyncChanges);
+    bool runIsolated(const WriteOp &op);
+    bool execControl(const QString &sql, bool *busy = nullptr);
+    bool execLockControl(const QString &sql, bool *busy);
+    bool writeQuantityDeltas(const QHash<int, int> &deltas);
+    void mergePendingDeltas(const QHash<int, int> &deltas);
+    void scheduleFlush(int delayMs);
+
+    /*
+     * Conexión a usar para lecturas largas: la de solo lectura si está
+     * disponible, o la principal en caso contrario.
+     */
+    QSqlDatabase readerDatabase() const;
+
+    /*
+     * Recorre "SELECT <columnas> FROM inventario <suffix>" en la conexión
+     * de lectura, dentro de una instantánea, pasando cada fila como vista.
+     */
+    bool visitRows(const QString &suffix,
+                   const QVariantList &params,
+                   const RowVisitor &visit);
+
+    /*
+     * Ejecuta "SELECT <columnas> FROM inventario <suffix>" en connection
+     * y entrega cada fila ya materializada, leída con la API nativa (sin
+     * un QVariant por celda) siempre que el controlador la exponga.
+     */
+    using ItemSink = std::function<void(InventoryItem &&)>;
+    bool selectItems(QSqlDatabase connection,
+                     const QString &suffix,
+                     const QVariantList &params,
+                     const ItemSink &take);
+
+    /*
+     * Inserta los ítems usando la conexión principal, sin abrir
+     * ni confirmar transacción (lo hace quien llama). Si ids no es nulo,
+     * recibe el ID asignado a cada uno.
+     */
+    bool insertItems(const QList<InventoryItem> &items, QList<int> *ids = nullptr);
+
+    /*
+     * Claves de búsqueda (tabla inventario_claves): writeSearchKeys
+     * reescribe las de los ítems dados dentro de la transacción en curso;
+     * rebuildSearchKeys las regenera todas.
+     */
+    bool writeSearchKeys(const QList<InventoryItem> &items);
+    bool rebuildSearchKeys();
+
+    /*
+     * Ejecuta "<sql> WHERE id IN (...)" por bloques de IDs dentro de la
+     * transacción en curso. Los valores de binds van antes de los IDs.
+     */
+    bool execForIds(const QString &sql,
+                    const QVariantList &binds,
+                    const QList<int> &ids);
+
+    /*
+     * Carga el índice en memoria con todas las filas de la tabla.
+     */
+    void rebuildIdIndex();
+
+    /*
+     * Lee las filas de los IDs indicados directamente de la base.
+     */
+    QList<InventoryItem> fetchItems(const QList<int> &ids);
+
+    /*
+     * Seguimiento del registro de cambios (tabla inventario_cambios):
+     * syncChanges procesa las entradas nuevas y emite las señales;
+     * resetChangeTracking salta al final y emite inventoryReset;
+     * markTableReplaced deja la marca de tabla reemplazada.
+     */
+    void syncChanges();
+    void resetChangeTracking();
+    bool markTableReplaced(qint64 previousSeq);
+    qint64 maxChangeSeq();
+    qint64 dataVersion();
+
+    /*
+     * Historial: toma una foto si los deltas pendientes ya lo justifican;
+     * replayHistory reconstruye las cantidades (de todos los ítems, o solo
+     * de onlyId si es distinto de cero) en el instante ts.
+     */
+    void maybeTakeKeyframe();
+    bool replayHistory(qint64 ts, int onlyId, QHash<int, int> &quantities);
+
+    QSqlDatabase db;        // Conexión activa a la base de datos SQLite
+    QSqlDatabase readDb;    // Conexión opcional de solo lectura (instantáneas)
+
+    bool idIndexEnabled = false;            // Índice en memoria activo
+    QHash<int, InventoryItem> idIndex;      // ID -> fila (solo si está activo)
+    LookupStats stats;                      // Latencias de búsqueda por ID
+    QueryDiagnostics diagnostics;           // Planes y costo por sentencia (modo diagnóstico)
+    std::unique_ptr<InventoryShards> siteShards; // Sedes adjuntas (se crea al primer uso)
+
+    WriteStats wstats;                      // Contadores del planificador de escrituras
+    QHash<int, int> pendingDeltas;          // Movimientos en cola (ID -> delta acumulado)
+    QList<QPair<WriteOp, WriteDone>> pendingOps; // Escrituras de queueWrite en espera, en orden
+    bool flushScheduled = false;            // Hay un vaciado de la cola programado
+    bool inWrite = false;                   // Dentro de una transacción de runWrite
+    AfterWrite nestedAfter = AfterWrite::Nothing; // Lo más fuerte pedido por llamadas anidadas
+    int statementBusyMs = 0;                // busy_timeout de la conexión para las demás sentencias
+    int lastInsertedId = 0;                 // ID del último addItem exitoso
+
+    HistoryStats hstats;                    // Costo de la última reconstrucción del historial
+    int reorderFallback = 5;                // Punto de reorden general
+
+    qint64 lastChangeSeq = 0;               // Última entrada procesada del registro de cambios
+    qint64 lastDataVersion = 0;             // Último PRAGMA data_version observado
+    bool trackingDeferred = false;          // Seguimiento de cambios en pausa (arranque diferido)
 };
 
 #endif // INVENTORYMANAGER_H
@@ -0,0 +1,166 @@
+#ifndef INVENTORYMODEL_H
+#define INVENTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+#include "InventoryManager.h"
+
+/**
+ * @class InventoryModel
+ * @brief Modelo de tabla del inventario, paginado y ordenado en SQL.
+ *
+ * Las filas se leen por páginas con InventoryManager::fetchPage en el
+ * orden elegido (clic en la cabecera → @ref sort → `ORDER BY` sobre un
+ * índice). La vista pide la página siguiente al llegar al final
+ * (canFetchMore / fetchMore) y cada página continúa desde la última fila
+ * cargada, de modo que la primera página aparece en el mismo tiempo sea
+ * cual sea el tamaño de la tabla.
+ *
+ * La búsqueda y las facetas se resuelven en esas mismas consultas
+ * (@ref setSearch, @ref setFacetFilter): cada página trae solo filas que
+ * pasan el filtro, estén donde estén en la tabla, así que una coincidencia
+ * lejana aparece igual que una cercana. La búsqueda aproximada
+ * (@ref setRankedIds) ya trae una lista corta de IDs: se cargan completos,
+ * en orden de relevancia hasta que se ordene por una columna.
+ *
+ * Los cambios notificados por InventoryManager::itemsChanged se aplican
+ * con @ref applyChanges sobre las filas ya cargadas, en su posición según
+ * el orden vigente: la vista conserva la selección y el desplazamiento, y
+ * no hace falta volver a leer. Las filas que caen más allá de lo cargado
+ * llegarán con la página que les corresponda; las que dejan de pasar el
+ * filtro se quitan.
+ *
+ * Cada fila cargada lleva además su estado de stock (StockStatus),
+ * calculado al cargarla o cambiarla con los puntos de reorden vigentes y
+ * expuesto en @ref StockStatusRole: al pintar solo se lee ese valor, sin
+ * comparar cantidades ni buscar puntos por ítem o tipo.
+ *
+ * Columnas: ID, Nombre, Tipo, Cantidad, Ubicación, Fecha Adquisición.
+ */
+class InventoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Roles propios del modelo.
+     */
+    enum Role {
+        StockStatusRole = Qt::UserRole + 1  ///< Estado de stock de la fila (int de StockStatus), en cualquier columna.
+    };
+
+    /**
+     * @brief Constructor del modelo (vacío hasta @ref reload).
+     * @param manager Origen de las páginas.
+     * @param parent Objeto padre opcional.
+     */
+    explicit InventoryModel(InventoryManager &manager, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /**
+     * @brief Cambia el orden y vuelve a la primera página (ordenada en SQL).
+     * En modo aproximado deja el orden de relevancia y ordena los IDs encontrados.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * @brief Descarta lo cargado y lee la primera página con el orden y el filtro vigentes.
+     */
+    void reload();
+
+    /**
+     * @brief Muestra solo los ítems que coinciden con el texto (vacío: todos).
+     *
+     * Mismas reglas que InventoryManager::searchItems. Sale del modo
+     * aproximado y vuelve a la primera página.
+     */
+    void setSearch(const QString &text);
+
+    /**
+     * @brief Muestra solo estos IDs, en este orden (búsqueda aproximada).
+     *
+     * Se respetan las facetas vigentes. Si los IDs son los mismos que ya
+     * se muestran, no se vuelve a leer.
+     */
+    void setRankedIds(const QList<int> &ids);
+
+    /**
+     * @brief Cambia la selección de facetas y vuelve a la primera página.
+     */
+    void setFacetFilter(const FacetFilter &facets);
+
+    /**
+     * @brief Aplica un conjunto de cambios sin recargar el modelo.
+     *
+     * @param rows Filas nuevas o modificadas, con su contenido vigente.
+     * @param removedIds IDs que deben desaparecer de la tabla.
+     */
+    void applyChanges(const QList<InventoryItem> &rows, const QList<int> &removedIds);
+
+    /**
+     * @brief ID del ítem mostrado en una fila.
+     * @return ID, o 0 si la fila no existe.
+     */
+    int idAt(int row) const;
+
+    /**
+     * @brief Fila en la que se muestra un ID.
+     * @return Número de fila, o -1 si el ID no está cargado.
+     */
+    int rowOfId(int id) const;
+
+    /**
+     * @brief Estado de stock de una fila (Ok si la fila no existe).
+     */
+    StockStatus statusAt(int row) const;
+
+public slots:
+    /**
+     * @brief Vuelve a leer los puntos de reorden y recalcula el estado de las filas cargadas.
+     */
+    void refreshReorderPoints();
+
+private:
+    /** @brief true si @p a va antes que @p b con el orden vigente. */
+    bool before(const InventoryItem &a, const InventoryItem &b) const;
+
+    /** @brief IDs de @p rows que pasan el filtro vigente. */
+    QSet<int> acceptedIds(const QList<InventoryItem> &rows);
+
+    /** @brief true si @p it cae dentro del tramo ya cargado. */
+    bool withinLoaded(const InventoryItem &it) const;
+
+    /** @brief Reconstruye @ref rowById después de insertar o borrar filas. */
+    void rebuildRowIndex() const;
+
+    /** @brief Recalcula @ref statuses para todas las filas cargadas. */
+    void rebuildStatuses();
+
+    InventoryManager &manager;      ///< Origen de las páginas.
+    QList<InventoryItem> items;     ///< Filas cargadas, en el orden vigente.
+    mutable QHash<int, int> rowById; ///< ID -> posición en @ref items.
+    mutable bool rowIndexDirty = false; ///< Se insertaron o quitaron filas sin actualizar @ref rowById.
+    QList<StockStatus> statuses;    ///< Estado de stock de cada fila, en paralelo a @ref items.
+    ReorderPoints points;           ///< Puntos de reorden con los que se calculó @ref statuses.
+    int sortColumn = 0;             ///< Columna de ordenamiento (0-5).
+    Qt::SortOrder sortOrder = Qt::DescendingOrder;
+    bool complete = false;          ///< Ya no quedan páginas por leer.
+    PageFilter filter;              ///< Búsqueda y facetas, resueltas en cada página.
+    bool ranked = false;            ///< Modo aproximado: solo los IDs de @ref rankOf.
+    bool rankOrder = false;         ///< Modo aproximado, aún en orden de relevancia.
+    QList<int> rankedIds;           ///< IDs del modo aproximado, del más al menos parecido.
+    QHash<int, int> rankOf;         ///< ID -> posición en @ref rankedIds.
+};
+
+#endif // INVENTORYMODEL_H
@@ -0,0 +1,165 @@
+#ifndef INVENTORYPROTOCOL_H
+#define INVENTORYPROTOCOL_H
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QString>
+#include <QStringView>
+#include <type_traits>
+
+#include "InventorySchema.h"
+
+/**
+ * @namespace InventoryProtocol
+ * @brief Protocolo de texto entre InventoryServer y sus clientes.
+ *
+ * Cada mensaje es una línea terminada en `\n` con campos separados por
+ * tabulaciones. Los textos van en UTF-8 con `\\`, tabulación, salto de
+ * línea y retorno de carro escapados (`\\\\`, `\\t`, `\\n`, `\\r`).
+ *
+ * Solicitud: `<id> <OPERACIÓN> <argumentos...>`, donde el id lo elige el
+ * cliente y se devuelve en la respuesta. Operaciones:
+ *
+ * | Operación | Argumentos                                   | Respuesta          |
+ * |-----------|----------------------------------------------|--------------------|
+ * | PING      |                                              | OK                 |
+ * | ADD       | nombre tipo cantidad ubicacion fecha         | OK id              |
+ * | UPDATE    | id nombre tipo cantidad ubicacion fecha      | OK                 |
+ * | QTY       | id cantidad                                  | OK                 |
+ * | DEL       | id                                           | OK                 |
+ * | GET       | id                                           | ROW, OK 1          |
+ * | FIND      | texto                                        | ROW..., OK n       |
+ * | EXPORT    |                                              | ROW..., OK n       |
+ * | METRICS   |                                              | OK informe         |
+ *
+ * Respuestas: `<id> OK [valor]`, `<id> ERR <mensaje>` o, antes del OK de
+ * las lecturas, una línea `<id> ROW <columnas>` por fila en el orden de
+ * InventorySchema.
+ *
+ * Un cliente puede enviar muchas solicitudes sin esperar (encadenamiento):
+ * el servidor responde a cada conexión en el mismo orden en que recibió
+ * sus solicitudes.
+ */
+namespace InventoryProtocol {
+
+/**
+ * @brief Puerto TCP por defecto del servidor.
+ */
+inline constexpr quint16 kDefaultPort = 47820;
+
+/**
+ * @brief Longitud máxima de una línea; una conexión que la supera se cierra.
+ */
+inline constexpr int kMaxLineLength = 64 * 1024;
+
+/**
+ * @brief Texto a campo: UTF-8 con separadores escapados.
+ */
+inline QByteArray escape(QStringView text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray out;
+    out.reserve(utf8.size());
+    for (char c : utf8) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        default: out += c; break;
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Campo a texto (inversa de @ref escape).
+ */
+inline QString unescape(const QByteArray &field)
+{
+    if (!field.contains('\\')) {
+        return QString::fromUtf8(field);
+    }
+    QByteArray out;
+    out.reserve(field.size());
+    for (int i = 0; i < field.size(); i++) {
+        char c = field.at(i);
+        if (c == '\\' && i + 1 < field.size()) {
+            const char next = field.at(++i);
+            c = next == 't' ? '\t' : next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+        }
+        out += c;
+    }
+    return QString::fromUtf8(out);
+}
+
+/**
+ * @brief Arma una línea: `<id>\t<verbo>\t<campos...>\n`.
+ */
+inline QByteArray line(const QByteArray &requestId, const QByteArray &verb,
+                       const QByteArrayList &fields = {})
+{
+    QByteArray out = requestId + '\t' + verb;
+    for (const QByteArray &field : fields) {
+        out += '\t';
+        out += field;
+    }
+    out += '\n';
+    return out;
+}
+
+/**
+ * @brief Separa una línea recibida (sin el `\n`) en campos.
+ */
+inline QByteArrayList fields(QByteArray received)
+{
+    if (received.endsWith('\n')) {
+        received.chop(1);
+    }
+    if (received.endsWith('\r')) {
+        received.chop(1);
+    }
+    return received.split('\t');
+}
+
+/**
+ * @brief Columnas de una fila como campos, en el orden del esquema.
+ */
+template <typename Row>
+inline QByteArrayList rowFields(const Row &row)
+{
+    QByteArrayList out;
+    out.reserve(InventorySchema::ColumnCount);
+    InventorySchema::forEachColumn([&](auto, const auto &def) {
+        const auto &value = InventorySchema::field(row, def);
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, int>) {
+            out.append(QByteArray::number(value));
+        } else {
+            out.append(escape(value));
+        }
+    });
+    return out;
+}
+
+/**
+ * @brief Fila a partir de los campos de una línea ROW.
+ *
+ * @param parts Campos de la línea completa.
+ * @param first Posición de la primera columna (2: después de id y ROW).
+ */
+inline InventoryItem itemFromFields(const QByteArrayList &parts, int first = 2)
+{
+    return InventorySchema::decode([&](int column, auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        const QByteArray field = parts.value(first + column);
+        if constexpr (std::is_same_v<T, int>) {
+            return field.toInt();
+        } else {
+            return unescape(field);
+        }
+    });
+}
+
+} // namespace InventoryProtocol
+
+#endif // INVENTORYPROTOCOL_H
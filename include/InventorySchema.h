@@ -0,0 +1,342 @@
+#ifndef INVENTORYSCHEMA_H
+#define INVENTORYSCHEMA_H
+
+#include <QSqlQuery>
+#include <QString>
+#include <QStringView>
+#include <QStringList>
+#include <QVariant>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "InventoryManager.h"
+
+/**
+ * @namespace InventorySchema
+ * @brief Descripción única de la fila del inventario.
+ *
+ * La tabla `inventario`, el modelo de la vista y el reporte CSV usan las
+ * mismas columnas en el mismo orden. Ese orden y el tipo de cada columna
+ * se declaran una sola vez en @ref kColumns (constexpr). Todo lo demás se
+ * genera a partir de ahí: el texto SQL (SELECT, INSERT, UPDATE), el
+ * enlace de parámetros, el decodificador tipado de filas, las cabeceras
+ * de la tabla y el formato del CSV. Agregar o reordenar una columna
+ * consiste en tocar @ref Column y @ref kColumns; los `static_assert`
+ * verifican que ambos coincidan.
+ */
+namespace InventorySchema {
+
+/**
+ * @brief Posición de cada columna (en SQL, en el modelo y en el CSV).
+ */
+enum Column : int {
+    Id = 0,
+    Nombre,
+    Tipo,
+    Cantidad,
+    Ubicacion,
+    FechaAdquisicion,
+    ColumnCount
+};
+
+/**
+ * @brief Descripción de una columna cuyo valor es de tipo @p T.
+ *
+ * En InventoryRowView las columnas de texto son QStringView; las
+ * enteras conservan su tipo.
+ */
+template <typename T>
+struct ColumnDef {
+    using Type = T;
+    using ViewType = std::conditional_t<std::is_same_v<T, QString>, QStringView, T>;
+
+    const char *name;                   ///< Nombre en SQL.
+    const char *header;                 ///< Título en la tabla.
+    const char *csvHeader;              ///< Título en el CSV.
+    T InventoryItem::*member;           ///< Campo de InventoryItem.
+    ViewType InventoryRowView::*view;   ///< Campo de InventoryRowView.
+    bool nocase;                        ///< Se ordena con COLLATE NOCASE.
+};
+
+/**
+ * @brief Columnas de la fila, en orden.
+ */
+inline constexpr auto kColumns = std::make_tuple(
+    ColumnDef<int>{"id", "ID", "ID",
+                   &InventoryItem::id, &InventoryRowView::id, false},
+    ColumnDef<QString>{"nombre", "Nombre", "Nombre",
+                       &InventoryItem::nombre, &InventoryRowView::nombre, true},
+    ColumnDef<QString>{"tipo", "Tipo", "Tipo",
+                       &InventoryItem::tipo, &InventoryRowView::tipo, true},
+    ColumnDef<int>{"cantidad", "Cantidad", "Cantidad",
+                   &InventoryItem::cantidad, &InventoryRowView::cantidad, false},
+    ColumnDef<QString>{"ubicacion", "Ubicación", "Ubicacion",
+                       &InventoryItem::ubicacion, &InventoryRowView::ubicacion, true},
+    ColumnDef<QString>{"fechaAdquisicion", "Fecha Adquisición", "FechaAdquisicion",
+                       &InventoryItem::fechaAdquisicion, &InventoryRowView::fechaAdquisicion, false}
+);
+
+static_assert(std::tuple_size_v<std::decay_t<decltype(kColumns)>> == ColumnCount,
+              "kColumns y Column deben tener las mismas columnas");
+static_assert(std::get<Id>(kColumns).member == &InventoryItem::id,
+              "la columna 0 debe ser el ID (clave de la tabla)");
+static_assert(std::get<Cantidad>(kColumns).member == &InventoryItem::cantidad,
+              "Column::Cantidad no coincide con kColumns");
+static_assert(std::get<Tipo>(kColumns).member == &InventoryItem::tipo
+                  && std::get<Ubicacion>(kColumns).member == &InventoryItem::ubicacion
+                  && std::get<FechaAdquisicion>(kColumns).member == &InventoryItem::fechaAdquisicion,
+              "Column no coincide con kColumns");
+
+namespace detail {
+template <typename F, std::size_t... I>
+inline void forEachColumn(F &&f, std::index_sequence<I...>)
+{
+    (f(std::integral_constant<int, int(I)>(), std::get<I>(kColumns)), ...);
+}
+} // namespace detail
+
+/**
+ * @brief Llama a f(índice, columna) para cada columna, en orden.
+ *
+ * El índice es un std::integral_constant, de modo que f puede usarlo en
+ * tiempo de compilación (`decltype(index)::value`). Se expande en
+ * línea: no hay bucle ni despacho por columna en tiempo de ejecución.
+ */
+template <typename F>
+inline void forEachColumn(F &&f)
+{
+    detail::forEachColumn(std::forward<F>(f), std::make_index_sequence<ColumnCount>());
+}
+
+/**
+ * @brief Nombre SQL de una columna (vacío si no existe).
+ */
+inline QString name(int column)
+{
+    QString result;
+    forEachColumn([&](auto index, const auto &def) {
+        if (index == column) {
+            result = QString::fromLatin1(def.name);
+        }
+    });
+    return result;
+}
+
+/**
+ * @brief Título de una columna en la tabla.
+ */
+inline QString header(int column)
+{
+    QString result;
+    forEachColumn([&](auto index, const auto &def) {
+        if (index == column) {
+            result = QString::fromUtf8(def.header);
+        }
+    });
+    return result;
+}
+
+/**
+ * @brief Indica si la columna se ordena con COLLATE NOCASE.
+ */
+inline bool isNocase(int column)
+{
+    bool result = false;
+    forEachColumn([&](auto index, const auto &def) {
+        if (index == column) {
+            result = def.nocase;
+        }
+    });
+    return result;
+}
+
+/**
+ * @brief Valor de una columna de un ítem, para la vista o para enlazar en SQL.
+ */
+inline QVariant value(const InventoryItem &it, int column)
+{
+    QVariant result;
+    forEachColumn([&](auto index, const auto &def) {
+        if (index == column) {
+            result = QVariant::fromValue(it.*def.member);
+        }
+    });
+    return result;
+}
+
+/**
+ * @brief Lista de columnas para SQL ("id, nombre, ...").
+ * @param withId false para omitir el ID (INSERT, UPDATE).
+ */
+inline QString columnList(bool withId = true)
+{
+    QStringList names;
+    forEachColumn([&](auto index, const auto &def) {
+        if (withId || index != Id) {
+            names.append(QString::fromLatin1(def.name));
+        }
+    });
+    return names.join(", ");
+}
+
+/**
+ * @brief "SELECT <todas las columnas> FROM inventario", en el orden de @ref Column.
+ */
+inline const QString &selectSql()
+{
+    static const QString sql = "SELECT " + columnList() + " FROM inventario";
+    return sql;
+}
+
+/**
+ * @brief INSERT de todas las columnas salvo el ID (lo asigna SQLite).
+ */
+inline const QString &insertSql()
+{
+    static const QString sql = [] {
+        QString placeholders = QString("?, ").repeated(ColumnCount - 1);
+        placeholders.chop(2);
+        return "INSERT INTO inventario (" + columnList(false) + ") VALUES (" + placeholders + ")";
+    }();
+    return sql;
+}
+
+/**
+ * @brief UPDATE de todas las columnas salvo el ID, con "WHERE id = ?" al final.
+ */
+inline const QString &updateSql()
+{
+    static const QString sql = [] {
+        QStringList sets;
+        forEachColumn([&](auto index, const auto &def) {
+            if (index != Id) {
+                sets.append(QString::fromLatin1(def.name) + " = ?");
+            }
+        });
+        return "UPDATE inventario SET " + sets.join(", ") + " WHERE id = ?";
+    }();
+    return sql;
+}
+
+/**
+ * @brief INSERT con ID explícito que, si el ID ya existe, actualiza la fila.
+ *
+ * Se enlaza el ID y después @ref bindItem. Al ser un UPSERT (y no
+ * INSERT OR REPLACE) disparan los triggers de inserción o de
+ * actualización, según corresponda.
+ */
+inline const QString &upsertSql()
+{
+    static const QString sql = [] {
+        QStringList sets;
+        forEachColumn([&](auto index, const auto &def) {
+            if (index != Id) {
+                const QString name = QString::fromLatin1(def.name);
+                sets.append(name + " = excluded." + name);
+            }
+        });
+        const QString placeholders = QString("?, ").repeated(ColumnCount - 1) + "?";
+        return "INSERT INTO inventario (" + columnList() + ") VALUES (" + placeholders
+               + ") ON CONFLICT (id) DO UPDATE SET " + sets.join(", ");
+    }();
+    return sql;
+}
+
+/**
+ * @brief Enlaza los campos de un ítem (salvo el ID) en el orden de insertSql/updateSql.
+ */
+inline void bindItem(QSqlQuery &query, const InventoryItem &it)
+{
+    forEachColumn([&](auto index, const auto &def) {
+        if constexpr (decltype(index)::value != Id) {
+            query.addBindValue(it.*def.member);
+        }
+    });
+}
+
+/**
+ * @brief Decodificador tipado de una fila en el orden de @ref selectSql.
+ *
+ * @p read recibe el índice de la columna y un puntero nulo del tipo del
+ * campo (int* o QString*) y devuelve el valor ya tipado; cada origen de
+ * filas (QSqlQuery, sentencia nativa de SQLite) aporta su lector. El
+ * despacho por tipo se resuelve al compilar.
+ */
+template <typename Reader>
+inline InventoryItem decode(Reader &&read)
+{
+    InventoryItem it;
+    forEachColumn([&](auto index, const auto &def) {
+        using T = typename std::decay_t<decltype(def)>::Type;
+        it.*def.member = read(int(index), static_cast<T *>(nullptr));
+    });
+    return it;
+}
+
+/**
+ * @brief Decodificador de una fila a una vista sin copias.
+ *
+ * Igual que @ref decode, pero @p read recibe un puntero nulo del tipo de
+ * la vista (int* o QStringView*) y las columnas de texto pueden apuntar
+ * al búfer del origen.
+ */
+template <typename Reader>
+inline InventoryRowView decodeView(Reader &&read)
+{
+    InventoryRowView view;
+    forEachColumn([&](auto index, const auto &def) {
+        using V = typename std::decay_t<decltype(def)>::ViewType;
+        view.*def.view = read(int(index), static_cast<V *>(nullptr));
+    });
+    return view;
+}
+
+/**
+ * @brief Vista sobre un ítem ya materializado (válida mientras viva @p it).
+ */
+inline InventoryRowView viewOf(const InventoryItem &it)
+{
+    InventoryRowView view;
+    forEachColumn([&](auto, const auto &def) {
+        view.*def.view = it.*def.member;
+    });
+    return view;
+}
+
+/**
+ * @brief Campo de una columna en un ítem o en una vista.
+ *
+ * Permite escribir una sola vez el código que recorre columnas (por
+ * ejemplo, el reporte CSV) para ambos tipos de fila.
+ */
+template <typename Def>
+inline const typename Def::Type &field(const InventoryItem &it, const Def &def)
+{
+    return it.*def.member;
+}
+
+template <typename Def>
+inline const typename Def::ViewType &field(const InventoryRowView &view, const Def &def)
+{
+    return view.*def.view;
+}
+
+/**
+ * @brief Decodifica la fila actual de un QSqlQuery que ejecutó @ref selectSql.
+ */
+inline InventoryItem fromQuery(const QSqlQuery &query)
+{
+    return decode([&](int column, auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if constexpr (std::is_same_v<T, int>) {
+            return query.value(column).toInt();
+        } else {
+            return query.value(column).toString();
+        }
+    });
+}
+
+} // namespace InventorySchema
+
+#endif // INVENTORYSCHEMA_H
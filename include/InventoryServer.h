@@ -0,0 +1,200 @@
+#ifndef INVENTORYSERVER_H
+#define INVENTORYSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <array>
+#include <functional>
+
+class InventoryManager;
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @struct EndpointStats
+ * @brief Latencia de una operación del servidor, desde que llega la
+ *        solicitud hasta que su respuesta queda escrita.
+ *
+ * El histograma tiene cuatro cubetas por cada potencia de dos de
+ * nanosegundos (error menor al 25 %), suficiente para percentiles.
+ */
+struct EndpointStats {
+    QByteArray name;                    ///< Operación (ADD, GET...).
+    qint64 requests = 0;                ///< Solicitudes respondidas.
+    qint64 errors = 0;                  ///< Respondidas con ERR.
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+    std::array<qint64, 256> histogram{};
+
+    /** @brief Percentil @p p (0..1) aproximado, en nanosegundos. */
+    qint64 percentileNs(double p) const;
+};
+
+/**
+ * @struct ServerStats
+ * @brief Contadores generales del servidor.
+ */
+struct ServerStats {
+    int connections = 0;        ///< Clientes conectados ahora.
+    qint64 accepted = 0;        ///< Conexiones aceptadas.
+    qint64 requests = 0;        ///< Solicitudes recibidas.
+    qint64 protocolErrors = 0;  ///< Líneas inválidas o demasiado largas.
+    qint64 batches = 0;         ///< Transacciones de escritura confirmadas o intentadas.
+    qint64 batchedWrites = 0;   ///< Escrituras agrupadas en esas transacciones.
+    int maxBatch = 0;           ///< Lote más grande.
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+};
+
+/**
+ * @class InventoryServer
+ * @brief Servidor TCP que expone InventoryManager a varios clientes.
+ *
+ * Un solo proceso es dueño de la base y atiende a todas las estaciones con
+ * el protocolo de líneas de InventoryProtocol, en lugar de que cada una
+ * abra el archivo SQLite y compita por el bloqueo de escritura.
+ *
+ * Las lecturas (GET, FIND) se responden en cuanto llegan. EXPORT se
+ * escribe por tramos, a medida que el cliente lee (ver @ref continueExport),
+ * sin ocupar el hilo ni armar la tabla en memoria. Las
+ * escrituras (ADD, UPDATE, QTY, DEL) de todos los clientes se acumulan
+ * durante una ventana corta y se confirman juntas con
+ * InventoryManager::writeBatch: una transacción por lote, cada escritura
+ * aislada en su SAVEPOINT. Si un cliente pide una lectura mientras tiene
+ * escrituras en espera, el lote se confirma antes, de modo que cada
+ * cliente lee lo que escribió y recibe las respuestas en orden.
+ *
+ * Por cada operación se mide la latencia (incluida la espera del lote) en
+ * @ref endpointStats; @ref report la resume en texto.
+ *
+ * El servidor no autentica: por defecto conviene escuchar solo en
+ * localhost o en una red de confianza.
+ */
+class InventoryServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Operaciones del protocolo.
+     */
+    enum Endpoint {
+        Ping = 0,
+        Add,
+        Update,
+        Quantity,
+        Remove,
+        Get,
+        Find,
+        Export,
+        Metrics,
+        EndpointCount
+    };
+
+    /**
+     * @brief Crea el servidor (sin escuchar todavía).
+     * @param manager Capa de datos a exponer.
+     * @param batchWindowMs Ventana de agrupación de escrituras, en ms.
+     * @param maxBatch Escrituras a partir de las cuales el lote se confirma sin esperar.
+     * @param parent Objeto padre opcional.
+     */
+    explicit InventoryServer(InventoryManager &manager,
+                             int batchWindowMs = 2,
+                             int maxBatch = 256,
+                             QObject *parent = nullptr);
+    ~InventoryServer() override;
+
+    /**
+     * @brief Empieza a aceptar conexiones.
+     * @param address Dirección de escucha (localhost por defecto).
+     * @param port Puerto; 0 elige uno libre (ver @ref port).
+     * @return true si quedó escuchando.
+     */
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 0);
+
+    /** @brief Puerto en el que escucha. */
+    quint16 port() const;
+
+    /** @brief Latencias por operación. */
+    QList<EndpointStats> endpointStats() const;
+
+    /** @brief Contadores generales. */
+    ServerStats stats() const;
+
+    /** @brief Reinicia latencias y contadores (no las conexiones). */
+    void resetStats();
+
+    /** @brief Informe de texto: una línea por operación usada. */
+    QString report() const;
+
+    /** @brief Nombre de una operación en el protocolo. */
+    static QByteArray endpointName(int endpoint);
+
+public slots:
+    /**
+     * @brief Confirma ya las escrituras en espera.
+     */
+    void flushWrites();
+
+private slots:
+    void onNewConnection();     ///< Acepta clientes nuevos.
+
+private:
+    /**
+     * @brief Escritura en espera del próximo lote.
+     */
+    struct PendingWrite {
+        QPointer<QTcpSocket> socket;
+        QByteArray requestId;
+        int endpoint = Ping;
+        qint64 arrivalNs = 0;
+        std::function<bool(PendingWrite &)> op;
+        int resultId = 0;           ///< ID asignado (ADD).
+    };
+
+    /** @brief Procesa todas las líneas completas de un cliente. */
+    void readClient(QTcpSocket *socket);
+
+    /** @brief Interpreta y atiende una solicitud. */
+    void handleLine(QTcpSocket *socket, const QByteArray &received, qint64 arrivalNs);
+
+    /** @brief Encola una escritura y programa (o fuerza) el lote. */
+    void queueWrite(PendingWrite write);
+
+    /**
+     * @brief Exportación en curso de un cliente.
+     */
+    struct ExportState {
+        QByteArray requestId;
+        qint64 arrivalNs = 0;
+        int lastId = 0;             ///< Último ID enviado.
+        qint64 rows = 0;            ///< Filas enviadas.
+    };
+
+    /**
+     * @brief Envía tramos de la exportación mientras el cliente los vaya leyendo.
+     */
+    void continueExport(QTcpSocket *socket);
+
+    /** @brief Escribe una respuesta y registra su latencia. */
+    void respond(QTcpSocket *socket, const QByteArray &data, int endpoint, qint64 arrivalNs, bool ok);
+
+    InventoryManager &manager;
+    QTcpServer *server = nullptr;
+    QElapsedTimer clock;                        ///< Reloj común de las latencias.
+    QTimer batchTimer;                          ///< Cierra la ventana de agrupación.
+    int maxBatchSize = 256;
+    QList<PendingWrite> pending;                ///< Escrituras del lote en curso.
+    QHash<QTcpSocket *, int> pendingBySocket;   ///< Escrituras en espera por cliente.
+    QHash<QTcpSocket *, ExportState> exports;   ///< Exportaciones en curso por cliente.
+    std::array<EndpointStats, EndpointCount> endpoints;
+    ServerStats counters;
+};
+
+#endif // INVENTORYSERVER_H
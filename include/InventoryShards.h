@@ -0,0 +1,162 @@
+#ifndef INVENTORYSHARDS_H
+#define INVENTORYSHARDS_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "InventoryManager.h"
+
+/**
+ * @struct SiteItem
+ * @brief Ítem encontrado en una sede.
+ */
+struct SiteItem {
+    QString site;           ///< Sede de la que viene la fila.
+    InventoryItem item;     ///< Fila tal como está en la base de esa sede.
+};
+
+/**
+ * @struct SiteTotals
+ * @brief Agregados de una sede.
+ */
+struct SiteTotals {
+    QString site;
+    bool ok = false;            ///< false si la sede falló o no respondió a tiempo.
+    qint64 items = 0;           ///< Filas del inventario.
+    qint64 units = 0;           ///< Suma de cantidades.
+    qint64 lowStock = 0;        ///< Filas por debajo del umbral pedido.
+    qint64 elapsedNs = 0;       ///< Tiempo de la consulta en esa sede.
+};
+
+/**
+ * @struct ShardStats
+ * @brief Contadores de una sede.
+ */
+struct ShardStats {
+    QString site;
+    QString path;
+    qint64 queries = 0;     ///< Consultas respondidas.
+    qint64 failures = 0;    ///< Consultas que fallaron.
+    qint64 timeouts = 0;    ///< Consultas que no respondieron dentro del plazo.
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+};
+
+/**
+ * @struct FanOutStats
+ * @brief Tiempos de la última consulta repartida entre las sedes.
+ *
+ * Con las sedes en paralelo, @ref wallNs queda cerca de @ref slowestNs y
+ * no de @ref sumNs (lo que costaría consultarlas una tras otra).
+ */
+struct FanOutStats {
+    int shards = 0;             ///< Sedes consultadas.
+    int failed = 0;             ///< Sedes sin resultado (error o plazo vencido).
+    qint64 wallNs = 0;          ///< Tiempo total visto por quien consulta.
+    qint64 slowestNs = 0;       ///< Sede más lenta.
+    qint64 sumNs = 0;           ///< Suma de los tiempos de todas las sedes.
+};
+
+/**
+ * @class InventoryShards
+ * @brief Consulta varias bases de sede ("inventario.db" de cada sitio) a la vez.
+ *
+ * Cada sede se adjunta con @ref attach y recibe su propio hilo, su propia
+ * conexión de solo lectura y su propio InventoryManager, de modo que la
+ * búsqueda, el stock bajo y los agregados usan exactamente el mismo SQL
+ * (claves plegadas, índices) que la base local.
+ *
+ * Una consulta se reparte a todas las sedes al mismo tiempo y quien llama
+ * espera a que respondan todas o a que venza @ref setTimeout. El tiempo
+ * total queda acotado por la sede más lenta, no por la suma. Los
+ * resultados se unen etiquetados con la sede; una sede que falla o no
+ * responde se omite (se anota en @ref shardStats y @ref lastFanOut) sin
+ * perder las demás.
+ *
+ * Las bases de sede se abren en solo lectura: deben tener el esquema al
+ * día (haber sido abiertas alguna vez por la aplicación). El objeto se
+ * usa desde un solo hilo, normalmente el principal.
+ */
+class InventoryShards : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InventoryShards(QObject *parent = nullptr);
+    ~InventoryShards() override;
+
+    /**
+     * @brief Adjunta la base de una sede.
+     *
+     * @param site Nombre de la sede (etiqueta de sus resultados).
+     * @param path Archivo SQLite de la sede.
+     * @return false si la sede ya existe o el archivo no se pudo abrir.
+     */
+    bool attach(const QString &site, const QString &path);
+
+    /**
+     * @brief Cierra la sede indicada (espera su consulta en curso).
+     */
+    bool detach(const QString &site);
+
+    /** @brief Sedes adjuntas, en orden de adjunción. */
+    QStringList sites() const;
+
+    /**
+     * @brief Plazo de espera de cada consulta repartida.
+     * @param ms Milisegundos (10000 por defecto).
+     */
+    void setTimeout(int ms);
+
+    /**
+     * @brief Búsqueda por prefijos (InventoryManager::searchItems) en todas las sedes.
+     * @return Filas de cada sede, agrupadas por sede y ordenadas por ID.
+     */
+    QList<SiteItem> search(const QString &text);
+
+    /**
+     * @brief Ítems con cantidad menor al umbral en todas las sedes.
+     * @return Filas ordenadas por cantidad (de menor a mayor).
+     */
+    QList<SiteItem> lowStock(int threshold);
+
+    /**
+     * @brief Filas, unidades y stock bajo de cada sede.
+     */
+    QList<SiteTotals> totals(int lowStockThreshold);
+
+    /** @brief Contadores por sede. */
+    QList<ShardStats> shardStats() const;
+
+    /** @brief Tiempos de la última consulta repartida. */
+    FanOutStats lastFanOut() const;
+
+private:
+    struct Shard;
+    struct Reply;
+
+    /**
+     * @brief Consulta de una sede: corre en su hilo, sobre su InventoryManager.
+     */
+    using ShardQuery = std::function<bool(InventoryManager &, QSqlDatabase, Reply &)>;
+
+    /**
+     * @brief Lanza @p query en todas las sedes y espera sus respuestas.
+     * @return Una respuesta por sede, en orden de adjunción.
+     */
+    QList<Reply> fanOut(const ShardQuery &query);
+
+    /** @brief Cierra la conexión y el hilo de una sede. */
+    void close(Shard &shard);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    int timeoutMs = 10000;
+    FanOutStats last;
+};
+
+#endif // INVENTORYSHARDS_H
@@ -0,0 +1,247 @@
+#ifndef INVENTORYSYNC_H
+#define INVENTORYSYNC_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <functional>
+
+#include "InventoryManager.h"
+
+/**
+ * @struct DigestNode
+ * @brief Resumen de una hoja o un nodo: suma de los resúmenes de sus filas.
+ */
+struct DigestNode {
+    quint64 digest = 0;     ///< Suma (módulo 2^64) de los resúmenes de fila.
+    qint64 rows = 0;        ///< Filas del rango.
+
+    bool operator==(const DigestNode &other) const
+    {
+        return digest == other.digest && rows == other.rows;
+    }
+    bool operator!=(const DigestNode &other) const { return !(*this == other); }
+};
+
+/**
+ * @struct SyncRow
+ * @brief Lo que cada lado aporta de una fila para compararla.
+ */
+struct SyncRow {
+    RowOrigin key;          ///< Identidad de la fila entre sedes.
+    int id = 0;             ///< ID en esta base.
+    quint64 digest = 0;     ///< Resumen de la identidad y del contenido.
+};
+
+/**
+ * @struct DigestTree
+ * @brief Árbol de resúmenes (tipo Merkle) sobre las identidades de las filas.
+ *
+ * Cada fila cae en la hoja que indica el hash de su identidad (sede de
+ * origen e ID allí), no su ID local: la misma fila cae en la misma hoja
+ * en las dos sedes aunque cada una le haya dado otro ID. Cada nodo
+ * interno resume @ref fanout nodos del nivel de abajo. Como el resumen de
+ * un nodo es la suma de los de sus filas, no depende del orden del
+ * recorrido.
+ */
+struct DigestTree {
+    int fanout = 16;                        ///< Hijos por nodo interno.
+    QVector<QVector<DigestNode>> levels;    ///< levels[0] son las hojas; el último nivel, la raíz.
+    QVector<QVector<SyncRow>> rows;         ///< Filas de cada hoja.
+
+    /** @brief Filas de toda la tabla. */
+    qint64 rowCount() const { return levels.isEmpty() || levels.last().isEmpty() ? 0 : levels.last().first().rows; }
+
+    /**
+     * @brief Calcula los niveles superiores a partir de las hojas.
+     *
+     * Dos árboles con el mismo número de hojas tienen la misma forma y se
+     * comparan nodo a nodo.
+     */
+    void seal();
+};
+
+/**
+ * @struct SyncStats
+ * @brief Costo y resultado de una comparación (y de su fusión).
+ */
+struct SyncStats {
+    qint64 localRows = 0;
+    qint64 remoteRows = 0;
+    qint64 buildNs = 0;             ///< Construcción de los dos árboles.
+    qint64 diffNs = 0;              ///< Descenso por los árboles y comparación de hojas.
+    int leaves = 0;                 ///< Hojas de cada árbol.
+    int levels = 0;                 ///< Niveles de cada árbol.
+    qint64 digestsCompared = 0;     ///< Nodos pedidos al otro lado durante el descenso.
+    int differingLeaves = 0;        ///< Hojas con diferencias.
+    qint64 rowsFetched = 0;         ///< Filas del otro lado leídas para comparar.
+    qint64 rowBytes = 0;            ///< Tamaño aproximado de esas filas (texto UTF-16 y enteros).
+    int onlyLocal = 0;              ///< Filas que solo están en la base local.
+    int onlyRemote = 0;             ///< Filas que solo están en la otra base.
+    int changed = 0;                ///< Filas que cambiaron en las dos bases (conflictos).
+    int changedRemote = 0;          ///< Filas que solo cambiaron en la otra base.
+    int removedRemote = 0;          ///< Filas que la otra base borró y aquí no cambiaron.
+    int changedLocal = 0;           ///< Filas que solo cambiaron (o se borraron) aquí.
+    qint64 mergeNs = 0;
+    int inserted = 0;               ///< Filas traídas de la otra base.
+    int updated = 0;                ///< Filas locales reemplazadas por la versión remota.
+    int synced = 0;                 ///< Filas cuyo estado sincronizado se anotó.
+    int duplicated = 0;             ///< Versiones remotas agregadas como filas nuevas (KeepBoth).
+    int removed = 0;                ///< Filas locales borradas (removeMissing).
+
+    /** @brief Bytes que habría que transferir: resúmenes más filas leídas. */
+    qint64 transferBytes() const { return digestsCompared * qint64(sizeof(DigestNode)) + rowBytes; }
+};
+
+/**
+ * @class InventorySync
+ * @brief Compara y fusiona la tabla inventario de dos bases (dos sedes).
+ *
+ * Las filas se cruzan por su identidad entre sedes (@ref RowOrigin: sede
+ * donde se crearon e ID allí), no por el ID local, que cada sede asigna
+ * por su cuenta. Cada lado resume su tabla en un @ref DigestTree; la
+ * comparación baja desde la raíz y solo pide los hijos de los nodos que
+ * difieren, así que con pocas diferencias se intercambian unos cientos
+ * de resúmenes y las filas de unas pocas hojas, no la tabla entera.
+ *
+ * La base local guarda el resumen de cada fila en la última
+ * sincronización con la otra sede. Con él, una fila distinta en los dos
+ * lados se clasifica sin preguntar: si el lado local sigue como entonces,
+ * solo cambió la otra base y la fusión trae su versión; si la otra base
+ * sigue como entonces, solo cambió aquí y se conserva. Solo cuando
+ * cambiaron las dos es un conflicto, que resuelve la @ref ConflictPolicy
+ * o una función propia. Lo mismo distingue una fila nueva allá de una
+ * borrada aquí, y una nueva aquí de una borrada allá.
+ *
+ * @ref merge aplica el resultado sobre la base local en una sola
+ * transacción y anota el nuevo estado sincronizado. Para sincronizar en
+ * los dos sentidos se repite con los papeles invertidos.
+ */
+class InventorySync
+{
+public:
+    /**
+     * @brief Qué hacer con una fila que cambió en las dos bases.
+     */
+    enum ConflictPolicy {
+        KeepLocal,      ///< Se conserva la versión local.
+        TakeRemote,     ///< Se toma la versión de la otra base.
+        KeepBoth        ///< Se conserva la local y la remota se agrega como fila nueva.
+    };
+
+    /**
+     * @brief Resolución propia: recibe (local, remota) y devuelve la fila a guardar.
+     */
+    using Resolver = std::function<InventoryItem(const InventoryItem &, const InventoryItem &)>;
+
+    /**
+     * @brief Prepara la comparación entre dos bases abiertas.
+     * @param local Base que recibe la fusión.
+     * @param remote Base de la otra sede (solo se lee).
+     */
+    InventorySync(InventoryManager &local, InventoryManager &remote);
+
+    /**
+     * @brief Tamaño del árbol: filas por hoja, en promedio (256), y ramificación (16).
+     */
+    void setTreeShape(int leafWidth, int fanout);
+
+    /**
+     * @brief Construye los árboles de ambos lados y localiza las diferencias.
+     * @return false si alguna de las bases no se pudo leer.
+     */
+    bool diff();
+
+    /**
+     * @brief Aplica las diferencias de la última @ref diff sobre la base local.
+     *
+     * Trae las filas nuevas y los cambios de un solo lado de la otra base,
+     * borra las que la otra base borró y resuelve los conflictos.
+     *
+     * @param policy Regla para los conflictos (si no hay @p resolver).
+     * @param removeMissing Borra también las filas locales que la otra base nunca tuvo.
+     * @param resolver Resolución propia de conflictos; tiene prioridad sobre @p policy.
+     * @return true si la transacción se confirmó.
+     */
+    bool merge(ConflictPolicy policy, bool removeMissing = false, const Resolver &resolver = {});
+
+    /** @brief Filas que solo están en la base local. */
+    const QList<InventoryItem> &onlyLocal() const { return localOnly; }
+
+    /** @brief Filas que solo están en la otra base. */
+    const QList<InventoryItem> &onlyRemote() const { return remoteOnly; }
+
+    /** @brief Pares (local, remota) que cambiaron en las dos bases. */
+    const QList<QPair<InventoryItem, InventoryItem>> &changed() const { return conflicts; }
+
+    /** @brief Pares (local, remota) que solo cambiaron en la otra base. */
+    const QList<QPair<InventoryItem, InventoryItem>> &changedRemotely() const { return remoteChanges; }
+
+    /** @brief Filas locales que la otra base borró y aquí no cambiaron. */
+    const QList<InventoryItem> &removedRemotely() const { return remoteRemovals; }
+
+    /** @brief Costo y resultado de la última comparación y fusión. */
+    SyncStats stats() const { return current; }
+
+    /**
+     * @brief Resumen de 64 bits de una fila: su identidad y todas sus columnas salvo el ID local.
+     */
+    static quint64 rowDigest(const InventoryRowView &row, const RowOrigin &key);
+
+    /**
+     * @brief Identidad y resumen de cada fila de una base, en una pasada.
+     * @param ok Recibe false si la base no tiene identidad de sede o no se pudo recorrer.
+     */
+    static QVector<SyncRow> summarize(InventoryManager &manager, bool *ok = nullptr);
+
+    /**
+     * @brief Árbol de resúmenes con @p leafCount hojas.
+     */
+    static DigestTree buildTree(const QVector<SyncRow> &rows, int leafCount, int fanout = 16);
+
+    /**
+     * @brief Separa una copia de su base original como otra sede.
+     *
+     * La copia recibe una identidad nueva (sus filas conservan su origen)
+     * y las dos bases anotan el estado actual como su última
+     * sincronización: los cambios posteriores de cada lado se aplican
+     * sin conflicto.
+     */
+    static bool splitCopy(InventoryManager &original, InventoryManager &copy);
+
+private:
+    /** @brief Clasifica las filas de una hoja que difiere. */
+    void compareLeaf(int leaf);
+
+    /** @brief Lee las filas completas de las diferencias. */
+    void fetchRows();
+
+    InventoryManager &local;
+    InventoryManager &remote;
+    int leafWidth = 256;
+    int fanout = 16;
+    qint64 peer = 0;                        ///< Sede de la otra base.
+    DigestTree mine;
+    DigestTree theirs;
+    QHash<RowOrigin, quint64> synced;       ///< Resumen de cada fila en la última sincronización.
+
+    // Resultado de diff, antes de leer las filas completas
+    QList<int> localOnlyIds;
+    QList<SyncRow> remoteOnlyRows;
+    QList<QPair<int, SyncRow>> conflictRows;        ///< (ID local, fila remota)
+    QList<QPair<int, SyncRow>> remoteChangeRows;    ///< (ID local, fila remota)
+    QList<int> remoteRemovalIds;
+    QHash<RowOrigin, quint64> settled;      ///< Resumen que tendrá cada fila en ambos lados tras la fusión.
+    QList<RowOrigin> forgotten;             ///< Filas cuyo estado sincronizado se descarta.
+
+    QList<InventoryItem> localOnly;
+    QList<InventoryItem> remoteOnly;
+    QList<RowOrigin> remoteOnlyKeys;
+    QList<QPair<InventoryItem, InventoryItem>> conflicts;
+    QList<QPair<InventoryItem, InventoryItem>> remoteChanges;
+    QList<InventoryItem> remoteRemovals;
+    SyncStats current;
+};
+
+#endif // INVENTORYSYNC_H
@@ -0,0 +1,262 @@
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaType>
+#include <QSqlDatabase>
+#include <QString>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class InventoryManager;
+
+/**
+ * @brief Estado de un trabajo de la cola.
+ */
+enum class JobState : quint8 {
+    Queued = 0,     ///< Esperando un hilo libre.
+    Running,        ///< En ejecución.
+    Done,           ///< Terminó bien (y sus escrituras se confirmaron).
+    Failed,         ///< Terminó con error; sus escrituras (o su último lote) se deshicieron.
+    Canceled        ///< Se canceló; sus escrituras (o su último lote) se deshicieron.
+};
+
+/**
+ * @brief Qué hace un trabajo con la base.
+ */
+enum class JobMode : quint8 {
+    Read = 0,       ///< Solo lee (exportaciones, reportes); varios pueden correr a la vez.
+    Write,          ///< Escribe: corre en una sola transacción y de a uno por vez.
+    Batched,        ///< Escribe de a uno, confirmando cada lote (JobContext::write).
+    Exclusive       ///< Escribe de a uno, pero sin transacción envolvente (copias de páginas).
+};
+
+/**
+ * @struct JobStats
+ * @brief Avance y resultado de un trabajo.
+ */
+struct JobStats {
+    int id = 0;
+    QString title;                  ///< Nombre para mostrar ("Exportar CSV", ...).
+    JobMode mode = JobMode::Read;
+    JobState state = JobState::Queued;
+    qint64 done = 0;                ///< Unidades hechas (filas, ítems...).
+    qint64 total = 0;               ///< Unidades totales; 0 si no se conocen.
+    QString detail;                 ///< Último texto de avance, o el motivo del fallo.
+    qint64 waitNs = 0;              ///< Tiempo en cola hasta empezar.
+    qint64 runNs = 0;               ///< Tiempo en ejecución, incluida la confirmación.
+
+    /** @brief Fracción hecha, entre 0 y 1 (0 si no se conoce el total). */
+    double fraction() const
+    {
+        return total > 0 ? qBound(0.0, double(done) / total, 1.0) : 0.0;
+    }
+
+    /** @brief El trabajo ya no va a cambiar de estado. */
+    bool isFinished() const
+    {
+        return state == JobState::Done || state == JobState::Failed || state == JobState::Canceled;
+    }
+};
+
+Q_DECLARE_METATYPE(JobStats)
+
+/**
+ * @class JobContext
+ * @brief Lo que recibe el cuerpo de un trabajo mientras corre.
+ *
+ * Da acceso a un InventoryManager sobre la conexión del hilo que ejecuta
+ * el trabajo, informa el avance y dice si se pidió cancelar. La
+ * cancelación es cooperativa: el cuerpo revisa @ref isCanceled entre
+ * filas o lotes y, si es true, retorna false.
+ */
+class JobContext
+{
+public:
+    /** @brief Gestor sobre la conexión del hilo del trabajo. */
+    InventoryManager &manager() { return *inventory; }
+
+    /** @brief Conexión del hilo del trabajo (la misma que usa @ref manager). */
+    QSqlDatabase database() const { return db; }
+
+    /** @brief Se pidió cancelar el trabajo. */
+    bool isCanceled() const;
+
+    /**
+     * @brief Informa el avance.
+     *
+     * Se puede llamar en cada fila: la cola reenvía el avance al hilo del
+     * dueño a lo sumo cada 100 ms.
+     *
+     * @param done Unidades hechas.
+     * @param total Unidades totales (0 si no se conocen).
+     * @param detail Texto opcional para mostrar.
+     */
+    void setProgress(qint64 done, qint64 total, const QString &detail = QString());
+
+    /**
+     * @brief Escribe un lote en su propia transacción (trabajos JobMode::Batched).
+     *
+     * Antes de tomar el bloqueo cede el turno a las escrituras del proceso
+     * que lo estén esperando (la ventana, por ejemplo), así un trabajo largo
+     * no las deja sin turno. Los lotes ya confirmados quedan aunque el
+     * trabajo se cancele o falle después.
+     *
+     * @param chunk Escrituras del lote; si retorna false, el lote se deshace.
+     * @return false si el lote falló o el trabajo ya estaba cancelado.
+     */
+    bool write(const std::function<bool()> &chunk);
+
+    /**
+     * @brief Anota el motivo del fallo (el cuerpo luego retorna false).
+     */
+    void fail(const QString &reason);
+
+private:
+    friend class JobQueue;
+    struct Shared;
+
+    JobContext(const std::shared_ptr<Shared> &job, InventoryManager &inventory, QSqlDatabase db)
+        : job(job), inventory(&inventory), db(db) {}
+
+    std::shared_ptr<Shared> job;
+    InventoryManager *inventory;
+    QSqlDatabase db;
+    QElapsedTimer lastReport;       ///< Desde el último avance reenviado.
+};
+
+/**
+ * @class JobQueue
+ * @brief Cola de trabajos largos (exportar, cargar, restaurar, importar,
+ * reportes) sobre un conjunto de hilos, con avance, cancelación y tiempos.
+ *
+ * Cada hilo abre su propia conexión al archivo de la base y su propio
+ * InventoryManager la primera vez que recibe un trabajo, así que la
+ * ventana sigue respondiendo mientras corren. Los trabajos se toman en
+ * orden de llegada:
+ *
+ * - Los de lectura (JobMode::Read) corren en paralelo, uno por hilo.
+ * - Los de escritura (JobMode::Write) corren de a uno, dentro de una sola
+ *   transacción (InventoryManager::writeAtomically): si el cuerpo retorna
+ *   false, falla o se cancela, todo lo que escribió se deshace. Mientras
+ *   uno escribe, los de lectura siguientes pueden adelantarse. Como el
+ *   bloqueo de escritura se tiene hasta el final, son para trabajos cortos.
+ * - Los de escritura por lotes (JobMode::Batched) también corren de a uno,
+ *   pero confirman cada lote con JobContext::write y sueltan el bloqueo
+ *   entre lotes, así las escrituras de la ventana no esperan al trabajo
+ *   entero. Al cancelar o fallar solo se deshace el lote en curso.
+ * - Los exclusivos (JobMode::Exclusive) también corren de a uno, pero sin
+ *   esa transacción: son para operaciones que ya son atómicas y no pueden
+ *   correr dentro de otra, como InventoryManager::restoreFromTemplate.
+ *   Solo se pueden cancelar antes de empezar a escribir.
+ *
+ * Al terminar un trabajo de escritura se llama a
+ * InventoryManager::pollExternalChanges del gestor local, para que sus
+ * vistas reciban los cambios sin esperar al próximo sondeo.
+ *
+ * Con una base en memoria (@p databasePath vacío) ninguna otra conexión
+ * puede abrirla: los trabajos corren de a uno en el hilo del dueño, sobre
+ * el gestor local, cada uno en su propia vuelta del bucle de eventos.
+ *
+ * El objeto se usa desde un solo hilo, normalmente el principal; las
+ * señales llegan a ese hilo.
+ */
+class JobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Cuerpo de un trabajo: retorna true si terminó bien.
+     */
+    using JobBody = std::function<bool(JobContext &)>;
+
+    /**
+     * @brief Prepara la cola (los hilos arrancan con el primer trabajo).
+     *
+     * @param local Gestor del dueño; recibe el aviso de los cambios.
+     * @param databasePath Archivo SQLite, o vacío para correr en el hilo del dueño.
+     * @param workers Hilos de trabajo (2 por defecto).
+     * @param parent Objeto padre opcional.
+     */
+    JobQueue(InventoryManager &local, const QString &databasePath,
+             int workers = 2, QObject *parent = nullptr);
+
+    /**
+     * @brief Cancela lo pendiente, espera lo que está corriendo y cierra los hilos.
+     */
+    ~JobQueue() override;
+
+    /**
+     * @brief Encola un trabajo.
+     * @return ID del trabajo, para @ref cancel y @ref stats.
+     */
+    int submit(const QString &title, JobMode mode, const JobBody &body);
+
+    /**
+     * @brief Pide cancelar un trabajo en cola o en curso.
+     * @return false si el trabajo no existe o ya terminó.
+     */
+    bool cancel(int id);
+
+    /** @brief Cancela todos los trabajos pendientes y en curso. */
+    void cancelAll();
+
+    /** @brief Estado de un trabajo activo o del historial. */
+    JobStats stats(int id) const;
+
+    /** @brief Trabajos en cola y en curso, en orden de llegada. */
+    QList<JobStats> activeJobs() const;
+
+    /** @brief Últimos trabajos terminados (el más reciente al final). */
+    QList<JobStats> history() const;
+
+    /** @brief No hay trabajos en cola ni en curso. */
+    bool isIdle() const;
+
+    /**
+     * @brief Informe de texto de los trabajos terminados: estado, espera y duración.
+     */
+    QString report() const;
+
+    /** @brief Nombre del estado para mostrar ("en cola", "cancelado", ...). */
+    static QString stateName(JobState state);
+
+signals:
+    void jobQueued(const JobStats &stats);
+    void jobStarted(const JobStats &stats);
+    void jobProgress(const JobStats &stats);
+    void jobFinished(const JobStats &stats);
+
+private:
+    struct Worker;
+    using Job = JobContext::Shared;
+
+    /** @brief Asigna los trabajos en cola a los hilos libres. */
+    void dispatch();
+
+    /** @brief Ejecuta el cuerpo en el hilo del trabajo y decide el estado final. */
+    static void execute(const std::shared_ptr<Job> &job, InventoryManager &inventory, QSqlDatabase db);
+
+    /** @brief Pasa un trabajo al historial y avisa (hilo del dueño). */
+    void finish(Worker *worker, const std::shared_ptr<Job> &job);
+
+    /** @brief Cierra la conexión y el hilo de un trabajador. */
+    void close(Worker &worker);
+
+    InventoryManager &local;
+    QString path;                                   ///< Vacío: se corre en el hilo del dueño.
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::deque<std::shared_ptr<Job>> queued;
+    QList<std::shared_ptr<Job>> running;
+    QList<JobStats> finished;
+    bool writing = false;                           ///< Hay un trabajo de escritura (o exclusivo) en curso.
+    bool localBusy = false;                         ///< Modo en el hilo del dueño: hay uno en curso.
+    int nextId = 1;
+};
+
+#endif // JOBQUEUE_H
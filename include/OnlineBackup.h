@@ -0,0 +1,166 @@
+#ifndef ONLINEBACKUP_H
+#define ONLINEBACKUP_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+struct sqlite3;
+struct sqlite3_backup;
+
+/**
+ * @struct BackupStats
+ * @brief Progreso y resultado de un respaldo en línea.
+ */
+struct BackupStats {
+    int pageCount = 0;          ///< Páginas de la base origen (según el último paso).
+    int remaining = 0;          ///< Páginas que faltan copiar.
+    int pageSize = 0;           ///< Tamaño de página en bytes.
+    qint64 pagesWritten = 0;    ///< Páginas copiadas en total, incluidas las de reinicios.
+    int steps = 0;              ///< Pasos ejecutados.
+    int busySteps = 0;          ///< Pasos que no avanzaron porque la base estaba bloqueada.
+    int restarts = 0;           ///< Veces que otra conexión modificó el origen y la copia volvió a empezar.
+    bool pinned = false;        ///< Se copia desde una instantánea fija (tras varios reinicios).
+    qint64 elapsedNs = 0;       ///< Tiempo total, incluidas las pausas entre pasos.
+    qint64 copyNs = 0;          ///< Tiempo dentro de los pasos.
+    qint64 maxStepNs = 0;       ///< Paso más largo (lo que se retuvo el hilo y la conexión).
+    bool finished = false;      ///< El respaldo terminó (bien o mal).
+    bool ok = false;            ///< Copia completa, verificada y en su lugar.
+    QString integrity;          ///< Resultado de PRAGMA integrity_check ("ok" si está sana).
+
+    /** @brief Fracción copiada, entre 0 y 1. */
+    double fraction() const
+    {
+        return pageCount > 0 ? double(pageCount - remaining) / pageCount : 0.0;
+    }
+
+    /** @brief Bytes por segundo de reloj, contando las pausas. */
+    double bytesPerSecond() const
+    {
+        return elapsedNs > 0 ? double(pagesWritten) * pageSize * 1e9 / elapsedNs : 0.0;
+    }
+};
+
+/**
+ * @class OnlineBackup
+ * @brief Respaldo de la base mientras la aplicación sigue en uso.
+ *
+ * Copia la base "main" de una conexión abierta (la de DatabaseManager) a
+ * un archivo con la API de copia en línea de SQLite (sqlite3_backup), de
+ * a @ref start pagesPerStep páginas por paso. Entre paso y paso se vuelve
+ * al bucle de eventos durante pauseMs milisegundos, de modo que la
+ * interfaz, la ingesta de escáneres y las escrituras de esta misma
+ * conexión siguen avanzando; esas escrituras se reflejan en la copia sin
+ * reiniciarla.
+ *
+ * Una escritura de otra conexión (otra estación) obliga a SQLite a
+ * empezar de nuevo. Tras varios reinicios, en modo WAL la copia vuelve a
+ * empezar desde una conexión de solo lectura propia con una transacción
+ * de lectura abierta: esa instantánea no cambia, así que los pasos siguen
+ * siendo del mismo tamaño y ya no se reinician, y los escritores de otros
+ * procesos no se frenan. La copia refleja entonces la base tal como
+ * estaba al fijar la instantánea.
+ *
+ * La copia se escribe en "<destino>.parcial". Al terminar se deja en modo
+ * de diario DELETE (un archivo autocontenido) y se verifica con
+ * `PRAGMA integrity_check` en un hilo aparte, con su propia conexión.
+ * Solo entonces reemplaza a @p targetPath: el respaldo anterior se aparta
+ * a "<destino>.anterior" y se borra cuando la copia nueva ya está en su
+ * lugar, así que un respaldo fallido nunca pisa el anterior.
+ *
+ * El objeto debe vivir en el hilo de la conexión origen.
+ */
+class OnlineBackup : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Prepara un respaldo de @p source (abierta, driver QSQLITE).
+     */
+    explicit OnlineBackup(QSqlDatabase source, QObject *parent = nullptr);
+    ~OnlineBackup() override;
+
+    /**
+     * @brief Empieza a copiar; el avance llega por @ref progress y el final por @ref finished.
+     *
+     * @param targetPath Archivo de respaldo (se reemplaza solo si la copia se verifica).
+     * @param pagesPerStep Páginas por paso (256 páginas de 4 KB = 1 MB).
+     * @param pauseMs Pausa entre pasos, en milisegundos.
+     * @return false si ya había un respaldo en curso o no se pudo empezar.
+     */
+    bool start(const QString &targetPath, int pagesPerStep = 256, int pauseMs = 10);
+
+    /**
+     * @brief Abandona el respaldo en curso; el destino anterior queda intacto.
+     */
+    void cancel();
+
+    /** @brief Hay un respaldo en curso (copiando o verificando). */
+    bool isRunning() const;
+
+    /** @brief Estado del respaldo en curso o del último terminado. */
+    BackupStats stats() const;
+
+    /**
+     * @brief Verifica un archivo SQLite con PRAGMA integrity_check.
+     *
+     * @param path Archivo a verificar.
+     * @param message Recibe "ok" o los problemas encontrados.
+     * @return true si la base está sana.
+     */
+    static bool verify(const QString &path, QString *message = nullptr);
+
+signals:
+    /** @brief Se emite después de cada paso. */
+    void progress(const BackupStats &stats);
+
+    /** @brief Se emite una vez, al terminar, fallar o cancelarse. */
+    void finished(bool ok, const BackupStats &stats);
+
+private slots:
+    void step();    ///< Copia un paso y programa el siguiente.
+
+private:
+    /**
+     * @brief Libera la copia y manda a verificarla (o la descarta).
+     */
+    void complete(bool copied, const QString &error);
+
+    /**
+     * @brief Recibe el resultado de la verificación y reemplaza el destino.
+     */
+    void finishVerify(bool verified, const QString &integrity);
+
+    /**
+     * @brief Descarta el archivo parcial y avisa el final.
+     */
+    void finish(bool ok, const QString &problem);
+
+    /**
+     * @brief Reinicia la copia desde una instantánea de lectura fija.
+     * @return false si el origen no es un archivo en modo WAL.
+     */
+    bool pinSnapshot();
+
+    QSqlDatabase source;                ///< Conexión origen.
+    QString target;                     ///< Destino final.
+    QString partial;                    ///< Archivo en construcción.
+    sqlite3 *dest = nullptr;            ///< Conexión nativa al archivo en construcción.
+    sqlite3_backup *backup = nullptr;   ///< Copia en curso.
+    sqlite3 *snapshot = nullptr;        ///< Conexión de solo lectura con la instantánea fija.
+    bool verifying = false;             ///< La verificación corre en @ref thread.
+    bool cancelled = false;             ///< Se canceló durante la verificación.
+    int lastRemaining = -1;             ///< Páginas que faltaban tras el último paso (-1 al empezar una copia).
+    int stepPages = 256;
+    QTimer timer;                       ///< Pausa entre pasos.
+    QElapsedTimer clock;                ///< Desde start().
+    BackupStats current;
+    QThread thread;                     ///< Hilo de verificación.
+    QObject *worker = nullptr;          ///< Contexto que vive en @ref thread.
+};
+
+#endif // ONLINEBACKUP_H
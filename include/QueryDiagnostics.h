@@ -0,0 +1,98 @@
+#ifndef QUERYDIAGNOSTICS_H
+#define QUERYDIAGNOSTICS_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class QSqlQuery;
+struct sqlite3_stmt;
+
+/**
+ * @brief Estadísticas acumuladas de una sentencia SQL distinta.
+ */
+struct QueryPlanStats {
+    QString sql;                ///< Texto de la sentencia (listas de `?` abreviadas).
+    QStringList plan;           ///< Líneas de EXPLAIN QUERY PLAN, con sangría por nivel.
+    bool fullScan = false;      ///< El plan recorre una tabla del inventario completa, sin índice.
+    qint64 executions = 0;      ///< Veces que se ejecutó.
+    qint64 totalNs = 0;         ///< Tiempo total, incluido el recorrido de sus filas.
+    qint64 maxNs = 0;           ///< Ejecución más lenta.
+    qint64 rowsScanned = 0;     ///< Filas visitadas en recorridos completos (FULLSCAN_STEP).
+    qint64 vmSteps = 0;         ///< Instrucciones de la máquina virtual de SQLite (VM_STEP).
+    bool warned = false;        ///< Ya se advirtió que es un recorrido completo frecuente.
+};
+
+/**
+ * @class QueryDiagnostics
+ * @brief Modo de diagnóstico de consultas: plan, tiempo y filas recorridas.
+ *
+ * Desactivado no cuesta más que una comprobación por sentencia. Activado,
+ * la primera vez que se ve cada sentencia distinta se ejecuta
+ * `EXPLAIN QUERY PLAN` sobre la misma conexión y se guarda el plan; en
+ * cada ejecución se suman el tiempo y los contadores de la sentencia
+ * (sqlite3_stmt_status), que se reinician al leerlos.
+ *
+ * Una sentencia cuyo plan recorre completa, sin índice, `inventario` o
+ * una de sus tablas auxiliares se marca, y cuando se vuelve frecuente (muchas ejecuciones o muchas filas
+ * recorridas en total) se emite una advertencia, una sola vez por
+ * sentencia. report() resume todo en texto para comprobar, a medida que
+ * crecen los datos, que las consultas siguen usando los índices.
+ */
+class QueryDiagnostics
+{
+public:
+    /**
+     * @brief Mide una sentencia ejecutada con QSqlQuery durante su alcance.
+     *
+     * Se declara después de la consulta (para destruirse antes que ella)
+     * y registra al salir del alcance, de modo que el tiempo y las filas
+     * recorridas incluyen la lectura de los resultados con next().
+     * finish() registra antes, cuando la consulta se reutiliza para otra
+     * sentencia o lo que sigue no debe contarse.
+     */
+    class Probe
+    {
+    public:
+        Probe(QueryDiagnostics &diagnostics, const QSqlQuery &query);
+        ~Probe();
+
+        void finish();
+
+        Probe(const Probe &) = delete;
+        Probe &operator=(const Probe &) = delete;
+
+    private:
+        QueryDiagnostics &diagnostics;
+        const QSqlQuery &query;
+        QElapsedTimer timer;
+    };
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    /**
+     * @brief Registra una ejecución de una sentencia nativa (antes de finalizarla).
+     */
+    void record(sqlite3_stmt *stmt, qint64 elapsedNs);
+
+    /**
+     * @brief Sentencias vistas, de mayor a menor tiempo total.
+     */
+    QList<QueryPlanStats> statements() const;
+
+    /**
+     * @brief Informe de texto: una entrada por sentencia, con su plan.
+     */
+    QString report() const;
+
+    void reset();
+
+private:
+    bool enabled = false;
+    QHash<QString, QueryPlanStats> stats;
+};
+
+#endif // QUERYDIAGNOSTICS_H
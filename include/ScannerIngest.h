@@ -0,0 +1,175 @@
+#ifndef SCANNERINGEST_H
+#define SCANNERINGEST_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <atomic>
+
+#include "BoundedQueue.h"
+
+class InventoryManager;
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * @struct ScanEvent
+ * @brief Movimiento de stock leído por un escáner: ítem y variación de cantidad.
+ */
+struct ScanEvent {
+    int id = 0;     ///< ID del ítem en la tabla inventario.
+    int delta = 0;  ///< Unidades que entran (positivo) o salen (negativo).
+};
+
+/**
+ * @struct IngestStats
+ * @brief Métricas de la etapa de ingesta, incluidas las de contrapresión.
+ */
+struct IngestStats {
+    qint64 received = 0;        ///< Eventos aceptados en la cola.
+    qint64 dropped = 0;         ///< Eventos rechazados por cola llena (solo @ref ScannerIngest::push).
+    qint64 malformed = 0;       ///< Líneas que no se pudieron interpretar.
+    qint64 stalls = 0;          ///< Veces que se pausó la lectura de una fuente por cola llena.
+    qint64 applied = 0;         ///< Eventos ya aplicados (antes de agrupar; incluye los que se anulan).
+    qint64 itemUpdates = 0;     ///< UPDATE ejecutados (después de agrupar por ítem).
+    qint64 batches = 0;         ///< Transacciones confirmadas.
+    qint64 failedBatches = 0;   ///< Transacciones que fallaron (el lote se reintenta en el siguiente vaciado).
+    qint64 discarded = 0;       ///< Eventos descartados tras agotar los reintentos de su lote.
+    qint64 flushNs = 0;         ///< Tiempo total dentro de las transacciones.
+    int queueDepth = 0;         ///< Ocupación actual de la cola.
+    int maxQueueDepth = 0;      ///< Ocupación máxima observada.
+    int queueCapacity = 0;      ///< Capacidad de la cola.
+};
+
+/**
+ * @class ScannerIngest
+ * @brief Recibe movimientos de escáneres y los aplica en lotes al inventario.
+ *
+ * Los eventos (ID, delta) llegan por un socket local (@ref listen), por el
+ * final de un archivo que crece (@ref tailFile) o directamente con
+ * @ref push desde cualquier hilo. Todos pasan por una @ref BoundedQueue sin
+ * bloqueos. Cada @ref window milisegundos la cola se vacía, los eventos se
+ * suman por ítem y el resultado se aplica con
+ * InventoryManager::applyQuantityDeltas en una sola transacción. Si la
+ * transacción falla (por ejemplo, base bloqueada), el lote se conserva y
+ * se suma al del siguiente vaciado.
+ *
+ * Formato de cada línea: `<id> <delta>` (también se aceptan `,` o `;`).
+ *
+ * Cuando la cola se llena, las fuentes de socket y archivo dejan de leer
+ * (los datos quedan en el búfer del sistema y el emisor se frena) y se
+ * reanudan en el siguiente vaciado; @ref push, en cambio, descarta.
+ *
+ * El objeto debe vivir en el hilo de la conexión de InventoryManager.
+ */
+class ScannerIngest : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Crea la etapa de ingesta.
+     * @param manager Gestor a través del cual se escriben los lotes.
+     * @param capacity Capacidad de la cola de eventos.
+     * @param windowMs Ventana de agrupación en milisegundos.
+     * @param parent Objeto padre opcional.
+     */
+    explicit ScannerIngest(InventoryManager &manager,
+                           int capacity = 65536,
+                           int windowMs = 50,
+                           QObject *parent = nullptr);
+    ~ScannerIngest() override;
+
+    /**
+     * @brief Encola un evento. Es seguro llamarlo desde cualquier hilo.
+     * @return false si la cola está llena (el evento se descarta).
+     */
+    bool push(int id, int delta);
+
+    /**
+     * @brief Escucha conexiones de escáneres en un socket local.
+     * @param name Nombre del socket (QLocalServer).
+     * @return true si el servidor quedó escuchando.
+     */
+    bool listen(const QString &name);
+
+    /**
+     * @brief Sigue un archivo de texto y procesa cada línea nueva.
+     *
+     * Solo se leen las líneas agregadas después de esta llamada.
+     *
+     * @param path Ruta del archivo.
+     * @return true si el archivo existe y pudo abrirse.
+     */
+    bool tailFile(const QString &path);
+
+    /** @brief Ventana de agrupación en milisegundos. */
+    int window() const;
+
+    /** @brief Cambia la ventana de agrupación. */
+    void setWindow(int windowMs);
+
+    /** @brief Copia de las métricas actuales. */
+    IngestStats stats() const;
+
+public slots:
+    /**
+     * @brief Vacía la cola y aplica los eventos acumulados.
+     *
+     * Lo llama el temporizador interno; se puede invocar a mano para
+     * forzar un vaciado (por ejemplo, antes de cerrar).
+     */
+    void flush();
+
+signals:
+    /**
+     * @brief Se emite después de confirmar un lote.
+     * @param ids IDs cuya cantidad cambió.
+     */
+    void batchApplied(const QList<int> &ids);
+
+private slots:
+    void onNewConnection();     ///< Acepta escáneres nuevos.
+    void readTail();            ///< Procesa lo agregado al archivo seguido.
+
+private:
+    /**
+     * @brief Lee líneas completas de un escáner mientras haya espacio en la cola.
+     */
+    void readSocket(QLocalSocket *socket);
+
+    /**
+     * @brief Interpreta una línea y la encola.
+     * @return false si la cola está llena y la línea debe reintentarse.
+     */
+    bool enqueueLine(const QByteArray &line);
+
+    /** @brief Actualiza la ocupación máxima observada. */
+    void noteDepth();
+
+    InventoryManager &manager;          ///< Destino de los lotes.
+    BoundedQueue<ScanEvent> queue;      ///< Eventos pendientes.
+    QTimer flushTimer;                  ///< Marca la ventana de agrupación.
+
+    QLocalServer *server = nullptr;     ///< Fuente por socket local.
+    QList<QLocalSocket *> sockets;      ///< Escáneres conectados.
+    QHash<QLocalSocket *, QByteArray> stalled; ///< Línea pendiente de cada escáner pausado.
+
+    QTimer tailTimer;                   ///< Sondeo del archivo seguido.
+    QString tailPath;                   ///< Archivo seguido.
+    qint64 tailOffset = 0;              ///< Bytes ya procesados del archivo.
+    QByteArray tailPending;             ///< Línea incompleta al final del archivo.
+
+    std::atomic<qint64> received{0};    ///< Contadores escritos por productores.
+    std::atomic<qint64> dropped{0};
+    std::atomic<int> maxDepth{0};
+    IngestStats counters;               ///< Contadores del hilo consumidor.
+
+    QHash<int, int> retryDeltas;        ///< Lote que no se pudo confirmar; va con el siguiente.
+    qint64 retryEvents = 0;             ///< Eventos agrupados en @ref retryDeltas.
+    int retries = 0;                    ///< Vaciados seguidos en que falló el lote.
+};
+
+#endif // SCANNERINGEST_H
@@ -0,0 +1,40 @@
+#ifndef SEARCHINDEXES_H
+#define SEARCHINDEXES_H
+
+#include <QList>
+#include <QThread>
+
+#include "FacetCounts.h"
+#include "FuzzyIndex.h"
+#include "InventoryManager.h"
+
+/**
+ * @struct SearchIndexes
+ * @brief Búsqueda aproximada y facetas armadas fuera del hilo de la ventana.
+ *
+ * Con una base grande, armar el índice de trigramas y los conteos de
+ * facetas con todas las filas toma segundos. Se arman en un hilo de fondo
+ * (StartupLoader al iniciar, un trabajo de la cola tras una recarga) y la
+ * ventana los toma con FuzzyIndex::adopt y FacetCounts::adopt, que solo
+ * intercambian contenedores.
+ */
+struct SearchIndexes {
+    FuzzyIndex fuzzy;
+    FacetCounts facets;
+
+    /**
+     * @brief Arma ambos índices y los pasa al hilo donde se adoptarán.
+     *
+     * @param items Todas las filas del inventario.
+     * @param target Hilo de quien los va a adoptar (y destruir).
+     */
+    void build(const QList<InventoryItem> &items, QThread *target)
+    {
+        fuzzy.setItems(items);
+        facets.setItems(items);
+        fuzzy.moveToThread(target);
+        facets.moveToThread(target);
+    }
+};
+
+#endif // SEARCHINDEXES_H
@@ -0,0 +1,81 @@
+#ifndef STARTUPLOADER_H
+#define STARTUPLOADER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QThread>
+#include <memory>
+
+#include "SearchIndexes.h"
+
+/**
+ * @class StartupLoader
+ * @brief Trabajo de arranque en segundo plano: esquema, lectura de todos
+ * los ítems y armado de la búsqueda aproximada y las facetas.
+ *
+ * Con una base grande, verificar el esquema (CREATE IF NOT EXISTS, claves
+ * de búsqueda faltantes, foto base del historial), leer todas las filas y
+ * armar con ellas la búsqueda aproximada y las facetas toma segundos. El
+ * cargador lo hace en su propio hilo y con su propia conexión al archivo,
+ * mientras la ventana ya está a la vista:
+ *
+ * 1. Verifica o crea el esquema y emite @ref schemaReady. A partir de
+ *    ahí la conexión principal puede leer la primera página.
+ * 2. Lee todos los ítems y la posición del registro de cambios en una
+ *    misma instantánea, arma los índices y emite @ref indexesReady; la
+ *    ventana solo tiene que adoptarlos y retomar los cambios desde ahí.
+ *
+ * Las señales llegan al hilo del cargador (normalmente el principal).
+ * Cada paso queda en StartupTrace. No sirve para la base en memoria:
+ * ninguna otra conexión puede abrirla.
+ */
+class StartupLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Prepara el cargador (no hace nada hasta @ref start).
+     * @param databasePath Archivo SQLite a abrir.
+     * @param parent Objeto padre opcional.
+     */
+    explicit StartupLoader(const QString &databasePath, QObject *parent = nullptr);
+
+    /**
+     * @brief Espera a que termine el trabajo en curso.
+     */
+    ~StartupLoader() override;
+
+    /**
+     * @brief Lanza los dos pasos en el hilo del cargador.
+     */
+    void start();
+
+    /** @brief true mientras quede trabajo en segundo plano. */
+    bool isRunning() const { return thread.isRunning(); }
+
+signals:
+    /**
+     * @brief El esquema quedó verificado (ok) o no se pudo crear.
+     */
+    void schemaReady(bool ok);
+
+    /**
+     * @brief Índices armados con todas las filas, leídas en una instantánea.
+     *
+     * Ya pertenecen al hilo del cargador (normalmente el principal).
+     * @p changeSeq es InventoryManager::changePosition en esa misma
+     * instantánea: los cambios posteriores son justo los que faltan en
+     * los índices.
+     */
+    void indexesReady(const std::shared_ptr<SearchIndexes> &indexes, qint64 changeSeq);
+
+private:
+    QString path;           ///< Archivo de la base (ruta absoluta).
+    QString connection;     ///< Nombre de la conexión del hilo.
+    QThread thread;
+    QObject *worker = nullptr;
+};
+
+#endif // STARTUPLOADER_H
@@ -0,0 +1,75 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QList>
+#include <QString>
+
+/**
+ * @struct StartupPhase
+ * @brief Una fase (o un evento puntual) del arranque.
+ */
+struct StartupPhase {
+    QString name;
+    QString thread;         ///< Hilo en el que ocurrió ("principal" o el nombre del QThread).
+    qint64 startNs = 0;     ///< Desde el primer registro (el inicio de main).
+    qint64 endNs = -1;      ///< -1 mientras la fase sigue abierta; igual a startNs en un evento.
+
+    qint64 durationNs() const { return endNs < 0 ? 0 : endNs - startNs; }
+};
+
+/**
+ * @class StartupTrace
+ * @brief Registro con marcas de tiempo de las fases del arranque.
+ *
+ * El reloj empieza con el primer registro, que main hace antes que nada.
+ * Cada fase anota su inicio y su fin (@ref begin / @ref end, o un
+ * @ref Scope) y cada hito un instante (@ref mark), con el hilo en el que
+ * ocurrió: así se ve qué trabajo quedó antes de mostrar la ventana y qué
+ * corre en segundo plano. Se puede registrar desde cualquier hilo.
+ */
+class StartupTrace
+{
+public:
+    /**
+     * @brief Registra una fase mientras dura el ámbito.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const QString &phase) : name(phase) { StartupTrace::begin(name); }
+        ~Scope() { StartupTrace::end(name); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        QString name;
+    };
+
+    /** @brief Abre una fase. */
+    static void begin(const QString &phase);
+
+    /** @brief Cierra la última fase abierta con ese nombre. */
+    static void end(const QString &phase);
+
+    /** @brief Registra un hito (fase de duración cero). */
+    static void mark(const QString &event);
+
+    /** @brief Nanosegundos desde el primer registro. */
+    static qint64 elapsedNs();
+
+    /** @brief Fases registradas, en orden de inicio. */
+    static QList<StartupPhase> phases();
+
+    /** @brief Instante de un hito o del fin de una fase, o -1 si no se registró. */
+    static qint64 reachedNs(const QString &name);
+
+    /**
+     * @brief Informe de texto: una línea por fase, con inicio, duración y hilo.
+     */
+    static QString report();
+
+    /** @brief Borra lo registrado y reinicia el reloj (para mediciones repetidas). */
+    static void reset();
+};
+
+#endif // STARTUPTRACE_H
@@ -11,6 +11,11 @@
  * Incluye información básica como su identificador, nombre, tipo, cantidad,
  * ubicación y fecha de compra. Provee métodos para obtener y modificar cada
  * uno de estos atributos.
+ *
+ * Los textos se reciben por valor y se mueven a los miembros, de modo que
+ * quien construye el componente a partir de temporales (por ejemplo, un
+ * InventoryItem que ya no se usa) no paga ninguna copia; los getters
+ * devuelven referencias constantes.
  */
 class Component
 {
@@ -32,47 +37,47 @@ public:
      * @param purchase_date Fecha de compra del componente.
      */
     Component(int id,
-              const QString &name,
-              const QString &type,
+              QString name,
+              QString type,
               int quantity,
-              const QString &location,
-              const QString &purchase_date);
+              QString location,
+              QString purchase_date);
 
     /** @brief Obtiene el ID del componente. */
     int getId() const;
 
     /** @brief Obtiene el nombre del componente. */
-    QString getName() const;
+    const QString &getName() const;
 
     /** @brief Obtiene el tipo del componente. */
-    QString getType() const;
+    const QString &getType() const;
 
     /** @brief Obtiene la cantidad disponible del componente. */
     int getQuantity() const;
 
     /** @brief Obtiene la ubicación del componente en el almacén. */
-    QString getLocation() const;
+    const QString &getLocation() const;
 
     /** @brief Obtiene la fecha de compra del componente. */
-    QString getPurchaseDate() const;
+    const QString &getPurchaseDate() const;
 
     /** @brief Establece el ID del componente. */
     void setId(int id);
 
     /** @brief Establece el nombre del componente. */
-    void setName(const QString &name);
+    void setName(QString name);
 
     /** @brief Establece el tipo del componente. */
-    void setType(const QString &type);
+    void setType(QString type);
 
     /** @brief Establece la cantidad del componente. */
     void setQuantity(int quantity);
 
     /** @brief Establece la ubicación del componente. */
-    void setLocation(const QString &location);
+    void setLocation(QString location);
 
     /** @brief Establece la fecha de compra del componente. */
-    void setPurchaseDate(const QString &purchase_date);
+    void setPurchaseDate(QString purchase_date);
 
 private:
     int m_id;                ///< Identificador único del componente.
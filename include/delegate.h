@@ -1,16 +1,25 @@
 #ifndef LOWSTOCKDELEGATE_H
 #define LOWSTOCKDELEGATE_H
 
+#include <QPainter>
 #include <QStyledItemDelegate>
 #include "InventoryManager.h"
+#include "InventoryModel.h"
+#include "InventorySchema.h"
 
 /**
  * @class LowStockDelegate
  * @brief Delegate que resalta en rojo los elementos con bajo stock.
  *
  * Esta clase hereda de QStyledItemDelegate y se encarga de modificar
- * la apariencia de las celdas en un QTableView o QListView cuando
- * la cantidad de un componente es menor a un umbral definido.
+ * la apariencia de las celdas en un QTableView o QListView según el
+ * estado de stock que el modelo ya calculó para cada fila
+ * (InventoryModel::StockStatusRole), con el punto de reorden propio de
+ * cada ítem o de su tipo.
+ *
+ * Al pintar solo se lee ese estado: no se compara ninguna cantidad ni se
+ * busca ningún umbral, así que el costo por celda no depende de cuántos
+ * puntos de reorden haya.
  *
  * Útil para visualizar rápidamente inventario crítico en interfaces Qt.
  */
@@ -20,18 +29,23 @@ public:
     /**
      * @brief Constructor del delegado de bajo stock.
      *
-     * @param threshold Umbral mínimo de cantidad antes de marcar el texto en rojo.
      * @param parent Objeto padre opcional según la jerarquía Qt.
      */
-    LowStockDelegate(int threshold, QObject *parent = nullptr)
-        : QStyledItemDelegate(parent), limit(threshold) {}
+    explicit LowStockDelegate(QObject *parent = nullptr)
+        : QStyledItemDelegate(parent) {}
+
+    /**
+     * @brief Resalta también el fondo de toda la fila de los ítems bajos o agotados.
+     */
+    void setHighlightRows(bool on) { highlightRows = on; }
 
     /**
      * @brief Sobrescribe el método paint para aplicar resaltado.
      *
-     * Cambia el color del texto a rojo cuando la columna correspondiente
-     * a la cantidad (columna 3 del modelo) tiene un valor menor al umbral
-     * definido en @ref limit.
+     * Cambia el color del texto a rojo en la columna de cantidad cuando
+     * la fila está bajo su punto de reorden, y además lo pone en negrita
+     * si está agotada. Con @ref setHighlightRows, pinta el fondo de toda
+     * la fila.
      *
      * @param painter Objeto empleado para realizar el dibujo.
      * @param option Opciones de estilo de la celda.
@@ -41,18 +55,28 @@ public:
                const QStyleOptionViewItem &option,
                const QModelIndex &index) const override
     {
-        QStyleOptionViewItem opt(option);
+        const auto status = StockStatus(index.data(InventoryModel::StockStatusRole).toInt());
+        if (status == StockStatus::Ok) {
+            QStyledItemDelegate::paint(painter, option, index);
+            return;
+        }
 
-        // Columna 3 → cantidad del componente
-        if (index.column() == 3 && index.data().toInt() < limit) {
+        QStyleOptionViewItem opt(option);
+        if (index.column() == InventorySchema::Cantidad) {
             opt.palette.setColor(QPalette::Text, Qt::red);
+            if (status == StockStatus::Out) {
+                opt.font.setBold(true);
+            }
+        }
+        if (highlightRows) {
+            painter->fillRect(option.rect, QColor(255, 200, 200)); // Rojo claro
         }
 
         QStyledItemDelegate::paint(painter, opt, index);
     }
 
 private:
-    int limit; ///< Umbral mínimo de cantidad para marcar el texto en rojo.
+    bool highlightRows = false; ///< Pinta el fondo de las filas bajas o agotadas.
 };
 
 #endif // LOWSTOCKDELEGATE_H
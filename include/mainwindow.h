@@ -3,21 +3,37 @@
 
 #include <QWidget>
 #include <QLineEdit>
+#include <QCheckBox>
+#include <QComboBox>
 #include <QSpinBox>
 #include <QDateEdit>
 #include <QTableView>
-#include <QSqlQueryModel>
-#include <QSortFilterProxyModel>
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QListWidget>
 #include <QMessageBox>
+#include <QTimer>
+#include <QPair>
+#include <memory>
 
+#include "DatabaseMaintenance.h"
 #include "InventoryManager.h"
+#include "InventoryModel.h"
+#include "InventoryFilterProxy.h"
+#include "JobQueue.h"
+#include "OnlineBackup.h"
+#include "FuzzyIndex.h"
+#include "FacetCounts.h"
+#include "ScannerIngest.h"
 #include "component.h"
 #include "report.h"
 
+class LowStockDelegate;
+class StartupLoader;
+struct SearchIndexes;
+
 /*
  * Clase AddDialog
  * ---------------
@@ -68,22 +84,90 @@ public:
     // Recibe la base de datos ya abierta y lista para usarse
     explicit MainWindow(QSqlDatabase db, QWidget *parent = nullptr);
 
+    // Etapa de ingesta de escáneres (socket local "inventario-escaner")
+    ScannerIngest &scannerIngest();
+
+    // Capa de datos de la ventana (por ejemplo, para su diagnóstico de consultas)
+    InventoryManager &inventoryManager();
+
+    // Mantenimiento de la base en tiempo ocioso (ANALYZE, vacuum, checkpoints)
+    DatabaseMaintenance &databaseMaintenance();
+
+    // Cola de trabajos largos (exportar, cargar y restaurar la base)
+    JobQueue &jobQueue();
+
 private slots:
     // Acciones asociadas a los botones de la UI
     void onEdit();
     void onAdd();
     void onDelete();
+    void onBulkAdjust();                 // Ajusta la cantidad de todas las filas seleccionadas
+    void onBulkRelocate();               // Cambia la ubicación de todas las filas seleccionadas
     void onExport();
+    void onBackup();                     // Respaldo en línea de la base, por pasos
     void onLowStock();
+    void onReorderPoint();               // Punto de reorden de las filas seleccionadas o del tipo elegido
+    void onSearchSites();                // Busca en las bases de todas las sedes adjuntas
+    void onSync();                       // Compara con la base de otra sede y trae sus cambios
+    void onHistory();                    // Existencias en una fecha pasada
+    void onForecast();                   // Ítems que se agotan pronto al ritmo de consumo actual
     void onSearch(const QString &text);  // Filtro de búsqueda en tiempo real
+    void onFacetChanged();               // Aplica la selección de tipo, ubicación y fechas
+    void updateFacetCounts();            // Refresca los conteos mostrados en las facetas
+    void updateJobList();                // Muestra los trabajos en cola y en curso con su avance
+    void onCancelJob();                  // Cancela el trabajo elegido (o el más antiguo)
+    void onJobFinished(const JobStats &stats); // Informa el resultado de un trabajo
+
+protected:
+    // Marca en StartupTrace la primera pintura de la tabla
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private:
     /*
-     * Refresca los datos del modelo leyendo desde InventoryManager.
-     * Se usa después de agregar, editar o eliminar ítems.
+     * Recarga completa del modelo leyendo desde InventoryManager.
+     * Se usa cuando la tabla se reemplaza completa; las
+     * ediciones normales se aplican fila por fila (itemsChanged).
      */
     void refreshModel();
 
+    /*
+     * Rearma la búsqueda aproximada y las facetas en un trabajo de la
+     * cola; adoptSearchIndexes las toma al terminar y vuelve a aplicar
+     * los cambios que llegaron mientras tanto (indexes nulo: se canceló).
+     */
+    void rebuildSearchIndexes();
+    void adoptSearchIndexes(int generation, const std::shared_ptr<SearchIndexes> &indexes);
+
+    /*
+     * Arranque diferido (ver el constructor): setStartupLocked bloquea los
+     * controles durante la carga; onSchemaReady lee la primera página y
+     * onStartupIndexes adopta la búsqueda y las facetas ya armadas en
+     * segundo plano, retoma los cambios desde changeSeq (la posición del
+     * registro en la instantánea de los índices) y libera la ventana.
+     */
+    void setStartupLocked(bool locked);
+    void onSchemaReady(bool ok);
+    void onStartupIndexes(const std::shared_ptr<SearchIndexes> &indexes, qint64 changeSeq);
+
+    /*
+     * Devuelve los IDs de todas las filas seleccionadas en la tabla.
+     * Recorre los rangos de selección en lugar de pedir un índice por
+     * celda, para que seleccionar decenas de miles de filas sea barato.
+     */
+    QList<int> selectedIds() const;
+
+    /*
+     * Guarda un cambio hecho desde la interfaz con InventoryManager::queueWrite:
+     * si otra estación tiene la base, queda en espera y se reintenta solo.
+     * El mensaje de error aparece solo si falla por otro motivo.
+     */
+    void submitWrite(const InventoryManager::WriteOp &op, const QString &errorMessage);
+
+    /*
+     * Lee la selección actual de los controles de facetas.
+     */
+    FacetFilter currentFacetFilter() const;
+
     /*
      * Revisa al iniciar si hay items con pocas existencias.
      * Si los hay, muestra una alerta al usuario.
@@ -92,23 +176,48 @@ private:
 
     /*
      * Carga datos iniciales por defecto para pruebas.
-     * (Dependiendo de tu implementación en el .cpp)
+     * Se encola como trabajo de escritura: se puede cancelar y, en ese
+     * caso, no queda ningún ítem a medias.
      */
     void onLoadDefaults();
 
     /*
-     * Restaura valores iniciales del sistema.
+     * Restaura valores iniciales del sistema (trabajo exclusivo de la cola).
      */
     void onRestoreDefaults();
 
 private:
     InventoryManager manager;       // Administrador de inventario (capa de BD)
-    QSqlQueryModel *model;          // Modelo base conectado a SQL
-    QSortFilterProxyModel *proxy;   // Modelo para búsqueda y filtrado
+    ScannerIngest ingest;           // Movimientos de escáneres (debe declararse después de manager)
+    QTimer externalPoll;            // Revisa periódicamente cambios de otras estaciones
+    DatabaseMaintenance maintenance; // Mantenimiento en un hilo propio cuando no hay actividad
+    OnlineBackup backup;            // Respaldo en línea sobre la conexión principal
+    JobQueue jobs;                  // Trabajos largos en hilos propios (debe declararse después de manager)
+    FuzzyIndex fuzzy;               // Índice de trigramas para la búsqueda aproximada
+    FacetCounts facets;             // Conteos por tipo, ubicación y fecha
+    InventoryModel *model;          // Modelo base, paginado, filtrado y ordenado en SQL
+    InventoryFilterProxy *proxy;    // Delega el orden por columna al modelo
     QTableView *tableView;          // Tabla que muestra los ítems
     QLineEdit *searchEdit;          // Barra de búsqueda
-
-    const int lowStockThreshold = 5;  // Cantidad mínima antes de considerarse "bajo stock"
+    QCheckBox *fuzzyCheck;          // Búsqueda aproximada (tolera errores de tipeo)
+    QComboBox *tipoFacet;           // Faceta de tipo, con conteo por valor
+    QComboBox *ubicacionFacet;      // Faceta de ubicación, con conteo por valor
+    QCheckBox *dateFacetCheck;      // Activa el rango de fechas de adquisición
+    QDateEdit *dateFrom;
+    QDateEdit *dateTo;
+    QLabel *facetCountLabel;        // Ítems que cumplen las facetas elegidas
+    QLabel *pendingWritesLabel;     // Cambios en espera de que otra estación libere la base
+    QListWidget *jobList;           // Trabajos en cola y en curso (oculta si no hay)
+    QPushButton *btnCancelJob;      // Cancela el trabajo elegido en jobList
+
+    LowStockDelegate *stockDelegate;  // Resalta las filas bajo su punto de reorden
+    StartupLoader *startup = nullptr; // Carga inicial en segundo plano (nulo con la base en memoria)
+    bool firstPaintSeen = false;      // Ya se registró la primera pintura de la tabla
+    int indexGeneration = 0;          // Última reconstrucción pedida de búsqueda y facetas
+    int adoptedGeneration = 0;        // Última reconstrucción adoptada (o cancelada)
+    QList<QPair<QList<InventoryItem>, QList<int>>> lateChanges; // Cambios llegados durante la reconstrucción
+
+    const int lowStockThreshold = 5;  // Punto de reorden general (ítems sin punto propio ni de su tipo)
 };
 
 #endif // MAINWINDOW_H
@@ -12,6 +12,7 @@
 
 #include <QString>
 #include <QList>
+#include <functional>
 
 /**
  * @struct InventoryItem
@@ -22,6 +23,8 @@
  */
 struct InventoryItem;
 
+class InventoryManager;
+
 /**
  * @class CSVReport
  * @brief Clase encargada de generar reportes CSV del inventario.
@@ -53,6 +56,26 @@ public:
      */
     bool generate(const QList<InventoryItem> &items,
                   const QString &filePath);
+
+    /**
+     * @brief Genera el CSV recorriendo la tabla directamente.
+     *
+     * Cada fila se escribe a medida que se lee (InventoryManager::forEachItem),
+     * sin construir la lista completa ni un InventoryItem por fila.
+     *
+     * Si se indica @p onRow, se llama tras cada fila con las filas escritas;
+     * si retorna false (por ejemplo, porque se canceló la exportación) se
+     * detiene y se borra el archivo a medio escribir.
+     *
+     * @param manager Origen de las filas.
+     * @param filePath Ruta completa donde se guardará el archivo CSV.
+     * @param onRow Avance opcional; retorna false para detener.
+     *
+     * @return true si el archivo se generó completo, false en caso contrario.
+     */
+    bool generate(InventoryManager &manager,
+                  const QString &filePath,
+                  const std::function<bool(qint64 rows)> &onRow = {});
 };
 
 #endif // CSVREPORT_H
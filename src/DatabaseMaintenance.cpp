@@ -0,0 +1,558 @@
+#include "DatabaseMaintenance.h"
+#include "DatabaseManager.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <sqlite3.h>
+
+/**
+ * @brief Cada cuánto se revisa si toca lanzar una porción, en ms.
+ */
+static const int kTickMs = 250;
+
+/**
+ * @brief Espera máxima por el bloqueo en la conexión de mantenimiento, en ms.
+ *
+ * Es corta: si la base está ocupada, la porción se abandona y se
+ * reintenta en otro momento ocioso.
+ */
+static const int kBusyTimeoutMs = 25;
+
+/**
+ * @brief Páginas liberadas por cada paso de incremental_vacuum.
+ */
+static const int kVacuumStepPages = 64;
+
+/**
+ * @brief Tamaño del WAL a partir del cual se vuelca sin esperar el intervalo.
+ */
+static const qint64 kWalCheckpointBytes = 4 * 1024 * 1024;
+
+/**
+ * @brief Límite de filas examinadas por índice en el ANALYZE de PRAGMA optimize.
+ */
+static const int kAnalysisLimit = 400;
+
+/**
+ * @brief Porciones que se conservan en el historial.
+ */
+static const int kHistoryLimit = 200;
+
+/**
+ * @brief Ejecuta una sentencia nativa recorriéndola hasta el final.
+ *
+ * Algunas sentencias de mantenimiento hacen su trabajo en cada paso
+ * (incremental_vacuum libera una página por sqlite3_step), así que no
+ * basta con ejecutarlas una vez como haría QSqlQuery::exec.
+ *
+ * @return SQLITE_OK, o el código de error de SQLite.
+ */
+static int stepAll(sqlite3 *handle, const QString &sql)
+{
+    const QByteArray utf8 = sql.toUtf8();
+    sqlite3_stmt *stmt = nullptr;
+    int rc = sqlite3_prepare_v2(handle, utf8.constData(), int(utf8.size()), &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+/**
+ * @brief Ejecuta una consulta que devuelve un entero.
+ * @return Valor de la primera fila, o -1 si falló o no hubo filas.
+ */
+static qint64 scalarValue(sqlite3 *handle, const QByteArray &sql)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, sql.constData(), int(sql.size()), &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    const qint64 value = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+/**
+ * @brief Lee un PRAGMA que devuelve un entero.
+ * @return Valor, o -1 si falló.
+ */
+static qint64 pragmaValue(sqlite3 *handle, const char *pragma)
+{
+    return scalarValue(handle, QByteArray("PRAGMA ") + pragma);
+}
+
+/**
+ * @brief Marca una porción como fallida con el error de SQLite.
+ *
+ * Si la base estaba ocupada la tarea queda pendiente para otro momento
+ * ocioso; cualquier otro error la da por terminada hasta su próximo turno.
+ */
+static void fail(MaintenanceRun &run, sqlite3 *handle, int rc)
+{
+    run.ok = false;
+    run.finished = (rc & 0xff) != SQLITE_BUSY && (rc & 0xff) != SQLITE_LOCKED;
+    run.detail = QString::fromUtf8(sqlite3_errmsg(handle));
+}
+
+/**
+ * @brief PRAGMA optimize con un ANALYZE acotado.
+ *
+ * Con `analysis_limit` el ANALYZE examina como mucho esa cantidad de
+ * filas por índice, así que su costo no crece con la tabla. La máscara
+ * 0x10002 pide revisar todas las tablas (no solo las usadas por esta
+ * conexión, que acaba de abrirse); si todavía no hay estadísticas se
+ * ejecuta ANALYZE, también acotado.
+ */
+static void runOptimize(sqlite3 *handle, MaintenanceRun &run)
+{
+    stepAll(handle, QString("PRAGMA analysis_limit = %1").arg(kAnalysisLimit));
+
+    const bool hasStats = scalarValue(handle, "SELECT COUNT(*) FROM sqlite_master "
+                                              "WHERE type = 'table' AND name = 'sqlite_stat1'") > 0;
+    const int rc = stepAll(handle, hasStats ? "PRAGMA optimize = 0x10002" : "ANALYZE");
+    if (rc != SQLITE_OK) {
+        fail(run, handle, rc);
+        return;
+    }
+    run.detail = hasStats ? "estadísticas del planificador revisadas"
+                          : "estadísticas del planificador creadas (ANALYZE)";
+}
+
+/**
+ * @brief Devuelve páginas libres al sistema, en pasos, hasta agotar el presupuesto.
+ *
+ * Si la base no usa auto_vacuum incremental (fue creada antes de que
+ * DatabaseManager lo pidiera) no hace nada: convertirla es
+ * @ref runEnableAutoVacuum, que solo corre a pedido.
+ */
+static void runIncrementalVacuum(sqlite3 *handle, int budgetMs, MaintenanceRun &run)
+{
+    const qint64 pageSize = pragmaValue(handle, "page_size");
+    const qint64 freeBefore = pragmaValue(handle, "freelist_count");
+    if (pageSize <= 0 || freeBefore < 0) {
+        run.ok = false;
+        run.finished = false;
+        run.detail = "no se pudo leer el espacio libre";
+        return;
+    }
+    if (freeBefore == 0) {
+        run.detail = "sin páginas libres";
+        return;
+    }
+
+    if (pragmaValue(handle, "auto_vacuum") != 2) {
+        run.detail = QString("%1 páginas libres; la base no usa auto_vacuum incremental").arg(freeBefore);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QString step = QString("PRAGMA incremental_vacuum(%1)").arg(kVacuumStepPages);
+    qint64 freeNow = freeBefore;
+    while (freeNow > 0 && timer.elapsed() < budgetMs) {
+        const int rc = stepAll(handle, step);
+        if (rc != SQLITE_OK) {
+            fail(run, handle, rc);
+            break;
+        }
+        freeNow = qMax<qint64>(0, pragmaValue(handle, "freelist_count"));
+    }
+
+    run.reclaimedBytes = (freeBefore - freeNow) * pageSize;
+    if (run.ok) {
+        run.finished = (freeNow == 0);
+        run.detail = QString("%1 páginas liberadas, quedan %2").arg(freeBefore - freeNow).arg(freeNow);
+    }
+}
+
+/**
+ * @brief Convierte la base a auto_vacuum incremental con un VACUUM completo.
+ *
+ * Es la única tarea no acotada: reescribe el archivo entero y, mientras
+ * dura, las escrituras de las demás conexiones esperan. Solo corre a
+ * pedido (DatabaseMaintenance::runNow), nunca por inactividad.
+ */
+static void runEnableAutoVacuum(sqlite3 *handle, MaintenanceRun &run)
+{
+    if (pragmaValue(handle, "auto_vacuum") == 2) {
+        run.detail = "la base ya usa auto_vacuum incremental";
+        return;
+    }
+
+    const qint64 pageSize = pragmaValue(handle, "page_size");
+    const qint64 freeBefore = pragmaValue(handle, "freelist_count");
+    int rc = stepAll(handle, "PRAGMA auto_vacuum = INCREMENTAL");
+    if (rc == SQLITE_OK) {
+        rc = stepAll(handle, "VACUUM");
+    }
+    if (rc != SQLITE_OK) {
+        fail(run, handle, rc);
+        return;
+    }
+    run.reclaimedBytes = qMax<qint64>(0, freeBefore - pragmaValue(handle, "freelist_count")) * qMax<qint64>(0, pageSize);
+    run.detail = "auto_vacuum incremental activado (VACUUM completo)";
+}
+
+/**
+ * @brief Vuelca el WAL sobre la base y, si quedó todo volcado, lo trunca.
+ *
+ * PASSIVE no espera a lectores ni escritores: vuelca lo que puede. Solo
+ * si eso alcanzó para todo se pide TRUNCATE, que deja el archivo WAL en
+ * cero bytes; si un lector lo impide, la porción termina igual y el
+ * truncado se intenta en la siguiente.
+ */
+static void runCheckpoint(sqlite3 *handle, const QString &path, MaintenanceRun &run)
+{
+    const QString walPath = path + "-wal";
+    const qint64 walBefore = QFileInfo(walPath).size();
+
+    int logFrames = 0;
+    int copied = 0;
+    const int rc = sqlite3_wal_checkpoint_v2(handle, nullptr, SQLITE_CHECKPOINT_PASSIVE, &logFrames, &copied);
+    if (rc != SQLITE_OK) {
+        fail(run, handle, rc);
+        return;
+    }
+    if (logFrames < 0) {
+        run.detail = "la base no está en modo WAL";
+        return;
+    }
+
+    bool truncated = false;
+    if (copied == logFrames && walBefore > 0) {
+        truncated = sqlite3_wal_checkpoint_v2(handle, nullptr, SQLITE_CHECKPOINT_TRUNCATE,
+                                              nullptr, nullptr) == SQLITE_OK;
+    }
+
+    run.reclaimedBytes = qMax<qint64>(0, walBefore - QFileInfo(walPath).size());
+    run.finished = (copied == logFrames);
+    run.detail = QString("%1 de %2 marcos volcados%3")
+                     .arg(copied)
+                     .arg(logFrames)
+                     .arg(truncated ? ", WAL truncado" : "");
+}
+
+/**
+ * @brief Ejecuta una porción de una tarea (hilo de mantenimiento).
+ */
+static MaintenanceRun runSlice(const QString &connection, const QString &path, int task, int budgetMs)
+{
+    MaintenanceRun run;
+    run.task = task;
+    run.startedAt = QDateTime::currentDateTime();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    sqlite3 *handle = DatabaseManager::nativeHandle(QSqlDatabase::database(connection));
+    if (!handle) {
+        run.ok = false;
+        run.finished = false;
+        run.detail = "conexión de mantenimiento cerrada";
+    } else if (task == DatabaseMaintenance::Optimize) {
+        runOptimize(handle, run);
+    } else if (task == DatabaseMaintenance::IncrementalVacuum) {
+        runIncrementalVacuum(handle, budgetMs, run);
+    } else if (task == DatabaseMaintenance::EnableAutoVacuum) {
+        runEnableAutoVacuum(handle, run);
+    } else {
+        runCheckpoint(handle, path, run);
+    }
+
+    run.durationNs = timer.nsecsElapsed();
+    return run;
+}
+
+/**
+ * @brief Crea el planificador con los intervalos por defecto.
+ *
+ * Intervalos: optimize cada 6 horas, vacuum incremental cada 30 minutos
+ * y volcado del WAL cada 5 minutos (o antes, si pasa de 4 MB). La primera
+ * vez que la aplicación queda ociosa se ejecutan las tres.
+ */
+DatabaseMaintenance::DatabaseMaintenance(const QString &databasePath, QObject *parent)
+    : QObject(parent),
+      path(QFileInfo(databasePath).absoluteFilePath()),
+      connection(QString("inventario_mantenimiento_%1").arg(quintptr(this), 0, 16))
+{
+    qRegisterMetaType<MaintenanceRun>();
+
+    intervalMs[Optimize] = 6 * 3600 * 1000LL;
+    intervalMs[IncrementalVacuum] = 30 * 60 * 1000LL;
+    intervalMs[Checkpoint] = 5 * 60 * 1000LL;
+    intervalMs[EnableAutoVacuum] = 0;   // Nunca por intervalo (ver isDue)
+
+    worker = new QObject;
+    worker->moveToThread(&thread);
+    thread.setObjectName("mantenimiento");
+
+    timer.setInterval(kTickMs);
+    connect(&timer, &QTimer::timeout, this, &DatabaseMaintenance::tick);
+}
+
+/**
+ * @brief Detiene el hilo (esperando la porción en curso) y cierra su conexión.
+ */
+DatabaseMaintenance::~DatabaseMaintenance()
+{
+    stop();
+    delete worker;
+}
+
+/**
+ * @brief Abre la conexión de mantenimiento en su hilo y empieza a vigilar.
+ */
+void DatabaseMaintenance::start()
+{
+    if (thread.isRunning()) {
+        return;
+    }
+    thread.start(QThread::LowestPriority);
+
+    const QString name = connection;
+    const QString file = path;
+    QMetaObject::invokeMethod(worker, [name, file]() {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(file);
+        db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(kBusyTimeoutMs));
+        if (!db.open()) {
+            qDebug() << "No se pudo abrir la conexión de mantenimiento:" << db.lastError();
+        }
+    }, Qt::QueuedConnection);
+
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        app->installEventFilter(this);
+    }
+    idle.start();
+    timer.start();
+}
+
+/**
+ * @brief Deja de lanzar porciones y cierra el hilo.
+ *
+ * El cierre de la conexión se encola detrás de la porción en curso, así
+ * que esta termina antes de que el hilo se detenga.
+ */
+void DatabaseMaintenance::stop()
+{
+    timer.stop();
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        app->removeEventFilter(this);
+    }
+    if (!thread.isRunning()) {
+        return;
+    }
+
+    const QString name = connection;
+    QMetaObject::invokeMethod(worker, [name]() {
+        {
+            QSqlDatabase db = QSqlDatabase::database(name, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }, Qt::BlockingQueuedConnection);
+
+    thread.quit();
+    thread.wait();
+    busy = false;
+}
+
+/**
+ * @brief Cambia la inactividad necesaria antes de mantener.
+ */
+void DatabaseMaintenance::setIdleDelay(int ms)
+{
+    idleDelayMs = qMax(0, ms);
+}
+
+/**
+ * @brief Cambia el presupuesto de tiempo de cada porción.
+ */
+void DatabaseMaintenance::setSliceBudget(int ms)
+{
+    sliceBudgetMs = qMax(1, ms);
+}
+
+/**
+ * @brief Cambia el periodo de una tarea.
+ */
+void DatabaseMaintenance::setInterval(Task task, int seconds)
+{
+    if (task >= 0 && task < TaskCount) {
+        intervalMs[task] = qMax(1, seconds) * 1000LL;
+    }
+}
+
+/**
+ * @brief Pide una tarea para el próximo momento en que el hilo esté libre.
+ */
+void DatabaseMaintenance::runNow(Task task)
+{
+    if (task >= 0 && task < TaskCount) {
+        pending[task] = true;
+        forced[task] = true;
+    }
+}
+
+/**
+ * @brief Indica si hay una porción en curso.
+ */
+bool DatabaseMaintenance::isBusy() const
+{
+    return busy;
+}
+
+/**
+ * @brief Copia del historial de porciones.
+ */
+QList<MaintenanceRun> DatabaseMaintenance::history() const
+{
+    return runs;
+}
+
+/**
+ * @brief Nombre de la tarea para el historial y los mensajes.
+ */
+QString DatabaseMaintenance::taskName(int task)
+{
+    switch (task) {
+    case Optimize:
+        return "optimize";
+    case IncrementalVacuum:
+        return "vacuum incremental";
+    case Checkpoint:
+        return "checkpoint";
+    case EnableAutoVacuum:
+        return "activar auto_vacuum";
+    default:
+        return "desconocida";
+    }
+}
+
+/**
+ * @brief Reinicia la cuenta de inactividad.
+ */
+void DatabaseMaintenance::noteActivity()
+{
+    idle.restart();
+}
+
+/**
+ * @brief Cuenta como actividad el teclado, el ratón y el tacto.
+ *
+ * El evento nunca se consume.
+ */
+bool DatabaseMaintenance::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+        idle.restart();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+/**
+ * @brief Indica si una tarea está pendiente o le tocó por intervalo.
+ */
+bool DatabaseMaintenance::isDue(Task task) const
+{
+    if (task == EnableAutoVacuum) {
+        return pending[task];
+    }
+    if (pending[task] || !lastRun[task].isValid() || lastRun[task].elapsed() >= intervalMs[task]) {
+        return true;
+    }
+    return task == Checkpoint && QFileInfo(path + "-wal").size() >= kWalCheckpointBytes;
+}
+
+/**
+ * @brief Lanza como mucho una porción: primero las pedidas con runNow y,
+ *        si la aplicación está ociosa, la primera tarea que toque.
+ */
+void DatabaseMaintenance::tick()
+{
+    if (busy) {
+        return;
+    }
+    for (int t = 0; t < TaskCount; t++) {
+        if (forced[t]) {
+            dispatch(Task(t));
+            return;
+        }
+    }
+    if (idle.elapsed() < idleDelayMs) {
+        return;
+    }
+    for (int t = 0; t < TaskCount; t++) {
+        if (isDue(Task(t))) {
+            dispatch(Task(t));
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Encola una porción en el hilo de mantenimiento.
+ *
+ * El resultado vuelve al hilo principal por la cola de eventos.
+ */
+void DatabaseMaintenance::dispatch(Task task)
+{
+    busy = true;
+
+    const QString name = connection;
+    const QString file = path;
+    const int budget = sliceBudgetMs;
+    QMetaObject::invokeMethod(worker, [this, name, file, task, budget]() {
+        const MaintenanceRun run = runSlice(name, file, task, budget);
+        QMetaObject::invokeMethod(this, [this, run]() { finishSlice(run); }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Registra una porción terminada y decide si la tarea sigue pendiente.
+ *
+ * Solo se anuncia en el registro lo que cambia el estado: una porción
+ * fallida, la primera que vuelve a funcionar tras una falla y la
+ * conversión a auto_vacuum. Las porciones de rutina quedan en
+ * @ref history y en @ref taskFinished.
+ */
+void DatabaseMaintenance::finishSlice(const MaintenanceRun &run)
+{
+    busy = false;
+    lastRun[run.task].start();
+    pending[run.task] = !run.finished;
+    forced[run.task] = forced[run.task] && !run.finished && run.ok;
+
+    runs.append(run);
+    if (runs.size() > kHistoryLimit) {
+        runs.removeFirst();
+    }
+
+    const bool recovered = run.ok && failed[run.task];
+    failed[run.task] = !run.ok;
+    if (!run.ok || recovered || run.task == EnableAutoVacuum) {
+        qDebug().noquote() << QString("Mantenimiento: %1 en %2 ms, %3 KB recuperados%4: %5")
+                                  .arg(taskName(run.task))
+                                  .arg(run.durationNs / 1e6, 0, 'f', 1)
+                                  .arg(run.reclaimedBytes / 1024)
+                                  .arg(run.ok ? "" : " (fallida)")
+                                  .arg(run.detail);
+    }
+    emit taskFinished(run);
+}
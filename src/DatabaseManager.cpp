@@ -1,7 +1,25 @@
 #include "DatabaseManager.h"
+#include <QSqlQuery>
 #include <QSqlError>
+#include <QSqlDriver>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
 #include <QDebug>
 
+#include <sqlite3.h>
+
+/**
+ * @brief Nombre del archivo SQLite utilizado por la aplicación.
+ */
+static const char *kDatabaseFile = "inventario.db";
+
+/**
+ * @brief Nombre de la conexión Qt usada para las lecturas largas.
+ */
+static const char *kReadConnection = "inventario_lectura";
+
 /**
  * @brief Inicialización del objeto estático de base de datos.
  *
@@ -10,6 +28,34 @@
  */
 QSqlDatabase DatabaseManager::db = QSqlDatabase();
 
+/**
+ * @brief Inicialización de la conexión de solo lectura.
+ *
+ * Al igual que @ref db, se configura de forma perezosa en getReadDatabase().
+ */
+QSqlDatabase DatabaseManager::readDb = QSqlDatabase();
+
+/**
+ * @brief Estado del modo en memoria (ver DatabaseManager::setInMemory).
+ */
+static bool inMemory = false;
+static int flushIntervalMs = 30000;
+static QTimer *flushTimer = nullptr;
+static int lastFlushedChanges = -1;
+static FlushStats flushCounters;
+
+/**
+ * @brief Páginas por paso de un volcado (256 páginas de 4 KB = 1 MB).
+ */
+static const int kFlushStepPages = 256;
+
+/**
+ * @brief Volcado en curso: conexiones nativas y copia (nulos si no hay).
+ */
+static sqlite3 *flushSource = nullptr;
+static sqlite3 *flushDest = nullptr;
+static sqlite3_backup *flushBackup = nullptr;
+
 /**
  * @brief Obtiene y gestiona la conexión a la base de datos SQLite.
  *
@@ -18,6 +64,13 @@ QSqlDatabase DatabaseManager::db = QSqlDatabase();
  * - Se configure con el driver "QSQLITE".
  * - Utilice como archivo local "inventario.db".
  * - Abra la conexión si aún no lo está.
+ * - Trabaje en modo WAL, para que los lectores no bloqueen a los escritores.
+ * - Use auto_vacuum incremental si el archivo es nuevo, para que
+ *   DatabaseMaintenance pueda devolver el espacio libre por partes.
+ *
+ * En modo en memoria la base se abre en ":memory:", se carga desde
+ * "inventario.db" (si existe) y se programa su volcado periódico y al
+ * cerrar la aplicación.
  *
  * Si ocurre un error al abrir la base de datos,
  * el mensaje es mostrado mediante qDebug().
@@ -29,7 +82,8 @@ QSqlDatabase DatabaseManager::getDatabase()
     // Si la instancia aún no es válida, configurar el driver
     if (!db.isValid()) {
         db = QSqlDatabase::addDatabase("QSQLITE");
-        db.setDatabaseName("inventario.db");
+        db.setDatabaseName(inMemory ? ":memory:" : kDatabaseFile);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
     }
 
     // Abrir la base de datos si aún no está abierta
@@ -38,8 +92,358 @@ QSqlDatabase DatabaseManager::getDatabase()
             qDebug() << "ERROR al abrir la base de datos:" << db.lastError();
         } else {
             qDebug() << "Base de datos abierta correctamente.";
+
+            // auto_vacuum solo se puede elegir antes de crear la primera tabla;
+            // un archivo existente se convierte fuera de línea
+            // (DatabaseMaintenance::EnableAutoVacuum)
+            QSqlQuery pragma(db);
+            pragma.exec("PRAGMA auto_vacuum = INCREMENTAL");
+
+            if (inMemory) {
+                openInMemory();
+            } else if (!pragma.exec("PRAGMA journal_mode=WAL")) {
+                // El modo WAL es persistente en el archivo; basta con pedirlo una vez
+                qDebug() << "No se pudo activar el modo WAL:" << pragma.lastError();
+            }
         }
     }
 
     return db;
 }
+
+/**
+ * @brief Obtiene la conexión de solo lectura sobre "inventario.db".
+ *
+ * Primero se asegura de que la conexión principal esté abierta, ya que es
+ * ella la que crea el archivo y activa el modo WAL. La conexión de lectura
+ * se abre con la opción QSQLITE_OPEN_READONLY, de modo que cualquier
+ * intento de escritura a través de ella falla en lugar de competir por el
+ * bloqueo de escritura.
+ *
+ * @return Conexión de lectura abierta, o inválida si hubo un error o la
+ *         base está en memoria.
+ */
+QSqlDatabase DatabaseManager::getReadDatabase()
+{
+    // En memoria no hay un archivo que otra conexión pueda abrir
+    if (!getDatabase().isOpen() || inMemory) {
+        return QSqlDatabase();
+    }
+
+    if (!readDb.isValid()) {
+        readDb = QSqlDatabase::addDatabase("QSQLITE", kReadConnection);
+        readDb.setDatabaseName(kDatabaseFile);
+        readDb.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+    }
+
+    if (!readDb.isOpen() && !readDb.open()) {
+        qDebug() << "ERROR al abrir la conexión de lectura:" << readDb.lastError();
+        return QSqlDatabase();
+    }
+
+    return readDb;
+}
+
+/**
+ * @brief Obtiene el manejador nativo sqlite3* de una conexión Qt.
+ *
+ * @param database Conexión abierta con el driver QSQLITE.
+ * @return Manejador nativo, o nullptr si la conexión no es SQLite.
+ */
+sqlite3 *DatabaseManager::nativeHandle(const QSqlDatabase &database)
+{
+    const QVariant handle = database.driver()->handle();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) {
+        return nullptr;
+    }
+    return *static_cast<sqlite3 *const *>(handle.constData());
+}
+
+/**
+ * @brief Copia un archivo SQLite completo sobre una conexión abierta.
+ *
+ * El archivo origen se abre en modo solo lectura con la API nativa y se
+ * copia en un único paso (sqlite3_backup_step con -1), que ocurre dentro
+ * de una sola transacción de escritura sobre el destino. Tras la copia se
+ * vuelve a pedir el modo WAL, por si el archivo origen usaba otro.
+ *
+ * @param target Conexión destino.
+ * @param sourcePath Archivo a copiar.
+ * @return true si la copia fue confirmada.
+ */
+bool DatabaseManager::restoreFrom(QSqlDatabase target, const QString &sourcePath)
+{
+    sqlite3 *dest = nativeHandle(target);
+    if (!dest) {
+        qDebug() << "La conexión destino no es una base SQLite abierta.";
+        return false;
+    }
+
+    sqlite3 *source = nullptr;
+    if (sqlite3_open_v2(sourcePath.toUtf8().constData(), &source,
+                        SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo abrir el archivo origen:" << sourcePath
+                 << sqlite3_errmsg(source);
+        sqlite3_close(source);
+        return false;
+    }
+
+    bool ok = false;
+    sqlite3_backup *backup = sqlite3_backup_init(dest, "main", source, "main");
+    if (backup) {
+        const int rc = sqlite3_backup_step(backup, -1);
+        ok = (rc == SQLITE_DONE);
+        if (!ok) {
+            qDebug() << "La copia se detuvo con el código" << rc << ":" << sqlite3_errstr(rc);
+        }
+        sqlite3_backup_finish(backup);
+    } else {
+        qDebug() << "No se pudo iniciar la copia:" << sqlite3_errmsg(dest);
+    }
+
+    sqlite3_close(source);
+
+    if (ok) {
+        QSqlQuery pragma(target);
+        pragma.exec("PRAGMA journal_mode=WAL");
+    }
+    return ok;
+}
+
+/**
+ * @brief Copia una conexión abierta sobre un archivo en un solo paso.
+ *
+ * @param source Conexión origen.
+ * @param targetPath Archivo destino.
+ * @return true si la copia fue confirmada.
+ */
+bool DatabaseManager::saveTo(QSqlDatabase source, const QString &targetPath)
+{
+    sqlite3 *src = nativeHandle(source);
+    if (!src) {
+        qDebug() << "La conexión origen no es una base SQLite abierta.";
+        return false;
+    }
+
+    sqlite3 *dest = nullptr;
+    if (sqlite3_open_v2(targetPath.toUtf8().constData(), &dest,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo abrir el archivo destino:" << targetPath << sqlite3_errmsg(dest);
+        sqlite3_close(dest);
+        return false;
+    }
+    // Puede haber otra estación leyendo el archivo
+    sqlite3_busy_timeout(dest, 5000);
+
+    bool ok = false;
+    sqlite3_backup *backup = sqlite3_backup_init(dest, "main", src, "main");
+    if (backup) {
+        const int rc = sqlite3_backup_step(backup, -1);
+        ok = (rc == SQLITE_DONE);
+        if (!ok) {
+            qDebug() << "La copia se detuvo con el código" << rc << ":" << sqlite3_errstr(rc);
+        }
+        sqlite3_backup_finish(backup);
+    } else {
+        qDebug() << "No se pudo iniciar la copia:" << sqlite3_errmsg(dest);
+    }
+
+    sqlite3_close(dest);
+    return ok;
+}
+
+/**
+ * @brief Abre "inventario.db" y prepara la copia desde @p source; no copia nada.
+ */
+static bool beginFlush(sqlite3 *source)
+{
+    if (sqlite3_open_v2(kDatabaseFile, &flushDest,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo abrir el archivo destino:" << kDatabaseFile << sqlite3_errmsg(flushDest);
+        sqlite3_close(flushDest);
+        flushDest = nullptr;
+        return false;
+    }
+    // Puede haber otra estación leyendo el archivo
+    sqlite3_busy_timeout(flushDest, 5000);
+
+    flushBackup = sqlite3_backup_init(flushDest, "main", source, "main");
+    if (!flushBackup) {
+        qDebug() << "No se pudo iniciar la copia:" << sqlite3_errmsg(flushDest);
+        sqlite3_close(flushDest);
+        flushDest = nullptr;
+        return false;
+    }
+    flushSource = source;
+    return true;
+}
+
+/**
+ * @brief Copia un paso de @ref kFlushStepPages páginas del volcado en curso.
+ * @return SQLITE_OK si quedan páginas, SQLITE_DONE al terminar, o el error.
+ */
+static int stepFlush()
+{
+    QElapsedTimer timer;
+    timer.start();
+    const int rc = sqlite3_backup_step(flushBackup, kFlushStepPages);
+    const qint64 ns = timer.nsecsElapsed();
+
+    flushCounters.steps++;
+    flushCounters.totalNs += ns;
+    flushCounters.maxNs = qMax(flushCounters.maxNs, ns);
+    return rc;
+}
+
+/**
+ * @brief Cierra el volcado en curso; con SQLITE_DONE el archivo queda confirmado.
+ */
+static bool endFlush(int rc)
+{
+    sqlite3_backup_finish(flushBackup);
+    sqlite3_close(flushDest);
+    flushBackup = nullptr;
+    flushDest = nullptr;
+
+    if (rc != SQLITE_DONE) {
+        qDebug() << "La copia se detuvo con el código" << rc << ":" << sqlite3_errstr(rc);
+        flushCounters.failures++;
+        return false;
+    }
+    // Lo escrito durante la copia ya está en el archivo
+    lastFlushedChanges = sqlite3_total_changes(flushSource);
+    flushCounters.flushes++;
+    return true;
+}
+
+/**
+ * @brief Da un paso del volcado por pasos y encola el siguiente.
+ */
+static void continueFlush()
+{
+    if (!flushBackup) {
+        return; // flushToDisk lo terminó
+    }
+    const int rc = stepFlush();
+    if (rc == SQLITE_OK) {
+        QTimer::singleShot(0, QCoreApplication::instance(), &continueFlush);
+        return;
+    }
+    endFlush(rc);
+}
+
+/**
+ * @brief Activa o desactiva el modo en memoria (antes de abrir la base).
+ */
+void DatabaseManager::setInMemory(bool enabled, int intervalMs)
+{
+    if (db.isValid()) {
+        qDebug() << "El modo en memoria debe elegirse antes de abrir la base.";
+        return;
+    }
+    inMemory = enabled;
+    flushIntervalMs = qMax(1000, intervalMs);
+}
+
+/**
+ * @brief Indica si la base principal está en memoria.
+ */
+bool DatabaseManager::isInMemory()
+{
+    return inMemory;
+}
+
+/**
+ * @brief Carga "inventario.db" en la base en memoria recién abierta.
+ *
+ * El temporizador de volcado cuelga de la aplicación, y el volcado final
+ * se hace en aboutToQuit, antes de que se destruyan las conexiones.
+ */
+void DatabaseManager::openInMemory()
+{
+    if (QFile::exists(kDatabaseFile)) {
+        QElapsedTimer timer;
+        timer.start();
+        if (restoreFrom(db, kDatabaseFile)) {
+            qDebug() << "Base cargada en memoria en" << timer.elapsed() << "ms.";
+        } else {
+            qDebug() << "No se pudo cargar" << kDatabaseFile << "en memoria; se empieza vacía.";
+        }
+    }
+    lastFlushedChanges = sqlite3_total_changes(nativeHandle(db));
+
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app || flushTimer) {
+        return;
+    }
+    flushTimer = new QTimer(app);
+    flushTimer->setInterval(flushIntervalMs);
+    QObject::connect(flushTimer, &QTimer::timeout, [] { flushInSteps(); });
+    QObject::connect(app, &QCoreApplication::aboutToQuit, flushTimer, [] { flushToDisk(); });
+    flushTimer->start();
+}
+
+/**
+ * @brief Vuelca la base en memoria al archivo, si cambió desde el último volcado.
+ *
+ * Los cambios se detectan con sqlite3_total_changes, que en memoria solo
+ * puede mover esta conexión. Completa el volcado por pasos en curso, si
+ * lo hay, en lugar de empezar otro.
+ */
+bool DatabaseManager::flushToDisk()
+{
+    if (!inMemory || !db.isOpen()) {
+        return false;
+    }
+
+    if (!flushBackup) {
+        sqlite3 *source = nativeHandle(db);
+        if (sqlite3_total_changes(source) == lastFlushedChanges && QFile::exists(kDatabaseFile)) {
+            flushCounters.skipped++;
+            return true;
+        }
+        if (!beginFlush(source)) {
+            flushCounters.failures++;
+            return false;
+        }
+    }
+
+    int rc;
+    while ((rc = stepFlush()) == SQLITE_OK) {
+    }
+    return endFlush(rc);
+}
+
+/**
+ * @brief Empieza un volcado por pasos; cada paso vuelve al bucle de eventos.
+ *
+ * Ningún paso copia más de @ref kFlushStepPages páginas, así que el hilo
+ * principal queda libre entre uno y otro sin importar el tamaño de la
+ * base. Mientras dura, "inventario.db" sigue mostrando el volcado
+ * anterior: la copia se confirma recién en el último paso.
+ */
+void DatabaseManager::flushInSteps()
+{
+    if (!inMemory || !db.isOpen() || flushBackup) {
+        return;
+    }
+
+    sqlite3 *source = nativeHandle(db);
+    if (sqlite3_total_changes(source) == lastFlushedChanges && QFile::exists(kDatabaseFile)) {
+        flushCounters.skipped++;
+        return;
+    }
+    if (!beginFlush(source)) {
+        flushCounters.failures++;
+        return;
+    }
+    continueFlush();
+}
+
+/**
+ * @brief Contadores de los volcados a disco.
+ */
+FlushStats DatabaseManager::flushStats()
+{
+    return flushCounters;
+}
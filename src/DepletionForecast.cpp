@@ -0,0 +1,253 @@
+#include "DepletionForecast.h"
+#include "InventoryManager.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/** @brief Días restantes de un ítem que no se consume. */
+static const float kNever = std::numeric_limits<float>::infinity();
+
+/** @brief Ritmo mínimo usado como divisor (evita dividir por cero). */
+static const float kMinRate = 1e-9f;
+
+/**
+ * @brief Fecha en que se agota, contando desde @p today.
+ */
+QDate ForecastRow::depletionDate(const QDate &today) const
+{
+    if (!std::isfinite(daysLeft) || daysLeft > 36500.0f) {
+        return QDate();
+    }
+    return today.addDays(qint64(std::floor(daysLeft)));
+}
+
+/**
+ * @brief Fija la ventana de historial (mínimo un día, máximo 65535).
+ */
+void DepletionForecast::setWindow(int days)
+{
+    windowDays = qBound(1, days, 65535);
+}
+
+/**
+ * @brief Fija la vida media del peso de los consumos.
+ */
+void DepletionForecast::setHalfLife(double days)
+{
+    halfLifeDays = qMax(0.1, days);
+}
+
+/**
+ * @brief Vacía los datos y fija el instante del pronóstico.
+ * @param expectedItems Reserva para los ítems que se van a agregar.
+ * @param expectedChanges Reserva para los movimientos que se van a agregar.
+ */
+void DepletionForecast::reset(const QDateTime &now, int expectedItems, int expectedChanges)
+{
+    nowTs = now.toSecsSinceEpoch();
+    ids.clear();
+    quantities.clear();
+    perDay.clear();
+    daysLeft.clear();
+    denseIndex.clear();
+    sparseIndex.clear();
+    changeItem.clear();
+    changeDay.clear();
+    changeUsed.clear();
+    contribution.clear();
+    ids.reserve(expectedItems);
+    quantities.reserve(expectedItems);
+    changeItem.reserve(expectedChanges);
+    changeDay.reserve(expectedChanges);
+    changeUsed.reserve(expectedChanges);
+    current = ForecastStats();
+}
+
+/**
+ * @brief Agrega un ítem y registra su posición.
+ *
+ * Los IDs de la tabla son casi consecutivos, así que la posición se guarda
+ * en un vector indexado por ID mientras no quede demasiado disperso; los
+ * IDs muy por encima del resto van a un hash.
+ */
+void DepletionForecast::addItem(int id, int cantidad)
+{
+    const int index = int(ids.size());
+    ids.push_back(id);
+    quantities.push_back(float(cantidad));
+
+    const size_t denseLimit = qMax<size_t>(1024, ids.size() * 4);
+    if (id >= 0 && size_t(id) < denseLimit) {
+        if (size_t(id) >= denseIndex.size()) {
+            denseIndex.resize(size_t(id) + 1, -1);
+        }
+        denseIndex[size_t(id)] = index;
+    } else {
+        sparseIndex.insert(id, index);
+    }
+}
+
+/**
+ * @brief Posición de un ID en las columnas de ítems.
+ */
+int DepletionForecast::indexOf(int id) const
+{
+    if (id >= 0 && size_t(id) < denseIndex.size() && denseIndex[size_t(id)] >= 0) {
+        return denseIndex[size_t(id)];
+    }
+    return sparseIndex.value(id, -1);
+}
+
+/**
+ * @brief Agrega un movimiento si es un consumo dentro de la ventana.
+ *
+ * Los movimientos de ítems que ya no existen se descartan.
+ */
+void DepletionForecast::addChange(int id, qint64 ts, int delta)
+{
+    if (delta >= 0) {
+        return;
+    }
+    const int index = indexOf(id);
+    if (index < 0) {
+        return;
+    }
+    const qint64 age = qMax<qint64>(0, nowTs - ts) / 86400;
+    if (age >= windowDays) {
+        return;
+    }
+    changeItem.push_back(index);
+    changeDay.push_back(quint16(age));
+    changeUsed.push_back(float(-qint64(delta)));
+}
+
+/**
+ * @brief Lee los ítems y los consumos de la ventana.
+ *
+ * Cada lectura usa su propia instantánea; un ítem agregado entre las dos
+ * solo pierde los consumos de ese instante.
+ */
+bool DepletionForecast::load(InventoryManager &manager, const QDateTime &now)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    reset(now);
+    bool ok = manager.forEachItem([this](const InventoryRowView &row) {
+        addItem(row.id, row.cantidad);
+        return true;
+    });
+    ok = ok && manager.forEachQuantityChange(now.addDays(-windowDays),
+                                              [this](int id, qint64 ts, int delta) {
+                                                  addChange(id, ts, delta);
+                                              });
+    if (!ok) {
+        qDebug() << "No se pudo leer el inventario o su historial para el pronóstico.";
+    }
+    current.loadNs = timer.nsecsElapsed();
+    return ok;
+}
+
+/**
+ * @brief Ritmo de consumo y días restantes de cada ítem.
+ *
+ * El consumo de hace d días pesa 2^(-(d + 0.5) / vida media) y la suma
+ * ponderada se divide por la suma de los pesos de la ventana: con un
+ * consumo constante de c unidades por día, el ritmo da exactamente c.
+ */
+void DepletionForecast::compute()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<float> weight(size_t(windowDays), 0.0f);
+    double weightSum = 0;
+    for (int d = 0; d < windowDays; ++d) {
+        weight[size_t(d)] = float(std::exp2(-(d + 0.5) / halfLifeDays));
+        weightSum += weight[size_t(d)];
+    }
+    const float norm = float(1.0 / weightSum);
+
+    const size_t changes = changeUsed.size();
+    const size_t items = ids.size();
+    contribution.resize(changes);
+    perDay.assign(items, 0.0f);
+    daysLeft.resize(items);
+
+    const float *w = weight.data();
+    const quint16 *day = changeDay.data();
+    const float *used = changeUsed.data();
+    float *contrib = contribution.data();
+    for (size_t k = 0; k < changes; ++k) {
+        contrib[k] = used[k] * w[day[k]];
+    }
+
+    const int *item = changeItem.data();
+    float *rate = perDay.data();
+    for (size_t k = 0; k < changes; ++k) {
+        rate[item[k]] += contrib[k];
+    }
+
+    const float *qty = quantities.data();
+    float *left = daysLeft.data();
+    for (size_t i = 0; i < items; ++i) {
+        const float r = rate[i] * norm;
+        const float d = qty[i] / std::max(r, kMinRate);
+        rate[i] = r;
+        left[i] = r > 0.0f ? d : kNever;
+    }
+
+    current.items = qint64(items);
+    current.changes = qint64(changes);
+    current.computeNs = timer.nsecsElapsed();
+}
+
+/**
+ * @brief Pronóstico del ítem en la posición indicada.
+ */
+ForecastRow DepletionForecast::row(int index) const
+{
+    ForecastRow result;
+    if (index < 0 || size_t(index) >= ids.size()) {
+        return result;
+    }
+    result.id = ids[size_t(index)];
+    result.cantidad = int(quantities[size_t(index)]);
+    result.perDay = index < int(perDay.size()) ? perDay[size_t(index)] : 0.0f;
+    result.daysLeft = index < int(daysLeft.size()) ? daysLeft[size_t(index)] : kNever;
+    return result;
+}
+
+/**
+ * @brief Ítems que se agotan dentro del plazo, ordenados por días restantes.
+ */
+QList<ForecastRow> DepletionForecast::runsOutWithin(double days, int limit) const
+{
+    std::vector<int> matches;
+    for (size_t i = 0; i < daysLeft.size(); ++i) {
+        if (daysLeft[i] <= days) {
+            matches.push_back(int(i));
+        }
+    }
+
+    auto earlier = [this](int a, int b) {
+        return daysLeft[size_t(a)] < daysLeft[size_t(b)]
+               || (daysLeft[size_t(a)] == daysLeft[size_t(b)] && ids[size_t(a)] < ids[size_t(b)]);
+    };
+    if (limit > 0 && size_t(limit) < matches.size()) {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), earlier);
+        matches.resize(size_t(limit));
+    } else {
+        std::sort(matches.begin(), matches.end(), earlier);
+    }
+
+    QList<ForecastRow> result;
+    result.reserve(int(matches.size()));
+    for (int index : matches) {
+        result.append(row(index));
+    }
+    return result;
+}
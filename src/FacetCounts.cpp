@@ -0,0 +1,217 @@
+#include "FacetCounts.h"
+
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief Constructor.
+ * @param parent Objeto padre opcional.
+ */
+FacetCounts::FacetCounts(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Conteo por tipo respetando la ubicación y el rango de fechas elegidos.
+ *
+ * Recorre solo las celdas en memoria (tipo, ubicación) y, dentro de cada
+ * una, las fechas del rango; nunca toca la base de datos.
+ */
+QList<QPair<QString, int>> FacetCounts::tipoCounts(const FacetFilter &filter) const
+{
+    QList<QPair<QString, int>> result;
+
+    for (auto t = cells.constBegin(); t != cells.constEnd(); ++t) {
+        int count = 0;
+        if (filter.ubicacion.isEmpty()) {
+            for (const DateCounts &dates : t.value()) {
+                count += countDates(dates, filter);
+            }
+        } else {
+            auto u = t.value().constFind(filter.ubicacion);
+            if (u != t.value().constEnd()) {
+                count = countDates(*u, filter);
+            }
+        }
+        result.append({t.key(), count});
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief Conteo por ubicación respetando el tipo y el rango de fechas elegidos.
+ */
+QList<QPair<QString, int>> FacetCounts::ubicacionCounts(const FacetFilter &filter) const
+{
+    QHash<QString, int> totals;
+
+    for (auto t = cells.constBegin(); t != cells.constEnd(); ++t) {
+        const bool selected = filter.tipo.isEmpty() || t.key() == filter.tipo;
+        for (auto u = t.value().constBegin(); u != t.value().constEnd(); ++u) {
+            // Las ubicaciones de otros tipos se listan igual, con 0
+            totals[u.key()] += selected ? countDates(u.value(), filter) : 0;
+        }
+    }
+
+    QList<QPair<QString, int>> result;
+    result.reserve(totals.size());
+    for (auto it = totals.constBegin(); it != totals.constEnd(); ++it) {
+        result.append({it.key(), it.value()});
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief Número de ítems que pasan el filtro completo.
+ */
+int FacetCounts::matchCount(const FacetFilter &filter) const
+{
+    if (filter.isEmpty()) {
+        return keyById.size();
+    }
+
+    int count = 0;
+    for (auto t = cells.constBegin(); t != cells.constEnd(); ++t) {
+        if (!filter.tipo.isEmpty() && t.key() != filter.tipo) {
+            continue;
+        }
+        for (auto u = t.value().constBegin(); u != t.value().constEnd(); ++u) {
+            if (filter.ubicacion.isEmpty() || u.key() == filter.ubicacion) {
+                count += countDates(u.value(), filter);
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Intercambia los conteos con otros ya armados y avisa del cambio.
+ * @param built Conteos armados (normalmente con @ref setItems en otro hilo).
+ */
+void FacetCounts::adopt(FacetCounts &built)
+{
+    std::swap(cells, built.cells);
+    std::swap(keyById, built.keyById);
+    emit countsChanged();
+}
+
+/**
+ * @brief Recalcula todos los conteos.
+ * @param items Todas las filas del inventario.
+ */
+void FacetCounts::setItems(const QList<InventoryItem> &items)
+{
+    cells.clear();
+    keyById.clear();
+    keyById.reserve(items.size());
+
+    for (const InventoryItem &it : items) {
+        const Key key{it.tipo, it.ubicacion, it.fechaAdquisicion};
+        keyById.insert(it.id, key);
+        add(key);
+    }
+    emit countsChanged();
+}
+
+/**
+ * @brief Mueve cada ítem cambiado de su celda anterior a la nueva.
+ *
+ * @param rows Filas nuevas o modificadas.
+ * @param removedIds IDs borrados.
+ */
+void FacetCounts::applyChanges(const QList<InventoryItem> &rows, const QList<int> &removedIds)
+{
+    bool changed = false;
+
+    for (const InventoryItem &it : rows) {
+        const Key key{it.tipo, it.ubicacion, it.fechaAdquisicion};
+
+        auto found = keyById.find(it.id);
+        if (found != keyById.end()) {
+            if (*found == key) {
+                continue;
+            }
+            remove(*found);
+            *found = key;
+        } else {
+            keyById.insert(it.id, key);
+        }
+        add(key);
+        changed = true;
+    }
+
+    for (int id : removedIds) {
+        auto found = keyById.find(id);
+        if (found != keyById.end()) {
+            remove(*found);
+            keyById.erase(found);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        emit countsChanged();
+    }
+}
+
+/**
+ * @brief Suma un ítem a su celda.
+ */
+void FacetCounts::add(const Key &key)
+{
+    cells[key.tipo][key.ubicacion][key.fecha]++;
+}
+
+/**
+ * @brief Resta un ítem de su celda; las celdas vacías se eliminan.
+ */
+void FacetCounts::remove(const Key &key)
+{
+    auto t = cells.find(key.tipo);
+    if (t == cells.end()) {
+        return;
+    }
+    auto u = t->find(key.ubicacion);
+    if (u == t->end()) {
+        return;
+    }
+    auto d = u->find(key.fecha);
+    if (d == u->end()) {
+        return;
+    }
+
+    if (--d.value() == 0) {
+        u->erase(d);
+        if (u->isEmpty()) {
+            t->erase(u);
+            if (t->isEmpty()) {
+                cells.erase(t);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Ítems de una celda dentro del rango de fechas del filtro.
+ *
+ * Las fechas están ordenadas, así que solo se recorre el tramo del rango.
+ */
+int FacetCounts::countDates(const DateCounts &dates, const FacetFilter &filter)
+{
+    if (!filter.desde.isEmpty() && !filter.hasta.isEmpty() && filter.desde > filter.hasta) {
+        return 0;
+    }
+
+    auto it = filter.desde.isEmpty() ? dates.constBegin() : dates.lowerBound(filter.desde);
+    const auto end = filter.hasta.isEmpty() ? dates.constEnd() : dates.upperBound(filter.hasta);
+
+    int count = 0;
+    for (; it != end; ++it) {
+        count += it.value();
+    }
+    return count;
+}
@@ -0,0 +1,466 @@
+#include "FuzzyIndex.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <array>
+#include <utility>
+
+/**
+ * @brief Longitud máxima del texto buscado (un bit por carácter en la verificación).
+ */
+static const int kMaxPatternLength = 64;
+
+/**
+ * @brief Máximo de candidatos que se verifican con la distancia de edición.
+ *
+ * Si el filtro de trigramas deja más, se verifican los que más trigramas
+ * comparten; mantiene acotado el tiempo de las consultas muy cortas.
+ */
+static const int kMaxVerified = 4096;
+
+/**
+ * @brief Posiciones borradas a partir de las cuales se compacta el índice.
+ */
+static const int kCompactMinDead = 1024;
+
+/**
+ * @brief Pliega un texto y deja sus palabras separadas por un solo espacio.
+ *
+ * "Transistor 2N3904-TO92" produce "transistor 2n3904 to92". Se aplica
+ * igual a los nombres y al texto buscado.
+ */
+static QString normalizeText(const QString &text)
+{
+    QString folded = InventoryManager::foldSearchText(text);
+    for (QChar &c : folded) {
+        if (!c.isLetterOrNumber()) {
+            c = QChar(' ');
+        }
+    }
+    return folded.simplified();
+}
+
+/**
+ * @brief Agrega a @p out los trigramas (sin repetir) de un texto normalizado.
+ *
+ * Cada palabra se rellena con dos espacios delante y uno detrás, de modo
+ * que las palabras cortas también producen trigramas y el inicio de
+ * palabra pesa más. Un trigrama son tres unidades UTF-16 en 48 bits.
+ */
+static void collectTrigrams(const QString &normalized, std::vector<quint64> &out)
+{
+    out.clear();
+    const QStringList words = normalized.split(QChar(' '), Qt::SkipEmptyParts);
+
+    for (const QString &word : words) {
+        const QString padded = "  " + word + ' ';
+        for (int i = 0; i + 2 < padded.size(); i++) {
+            out.push_back((quint64(padded.at(i).unicode()) << 32)
+                          | (quint64(padded.at(i + 1).unicode()) << 16)
+                          | quint64(padded.at(i + 2).unicode()));
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+/**
+ * @brief Máscaras de caracteres del texto buscado para el algoritmo de Myers.
+ *
+ * El bit i de mask(c) vale 1 si el carácter i del patrón es c. Los
+ * caracteres Latin-1 (la gran mayoría) se resuelven con una tabla directa.
+ */
+struct PatternMasks {
+    std::array<quint64, 256> low{};
+    std::vector<std::pair<char16_t, quint64>> high;
+    int length = 0;
+
+    explicit PatternMasks(const QString &pattern)
+    {
+        length = qMin(int(pattern.size()), kMaxPatternLength);
+        for (int i = 0; i < length; i++) {
+            const char16_t c = pattern.at(i).unicode();
+            if (c < 256) {
+                low[c] |= quint64(1) << i;
+                continue;
+            }
+            auto found = std::find_if(high.begin(), high.end(),
+                                      [c](const auto &entry) { return entry.first == c; });
+            if (found == high.end()) {
+                high.emplace_back(c, quint64(1) << i);
+            } else {
+                found->second |= quint64(1) << i;
+            }
+        }
+    }
+
+    quint64 mask(char16_t c) const
+    {
+        if (c < 256) {
+            return low[c];
+        }
+        for (const auto &entry : high) {
+            if (entry.first == c) {
+                return entry.second;
+            }
+        }
+        return 0;
+    }
+};
+
+/**
+ * @brief Menor distancia de edición entre el patrón y cualquier fragmento del texto.
+ *
+ * Algoritmo bit-paralelo de Myers (1999): las diferencias verticales de
+ * una columna de la matriz de programación dinámica se guardan en dos
+ * palabras de 64 bits y se actualizan con unas pocas operaciones por
+ * carácter del texto. La primera fila es cero (búsqueda), de modo que el
+ * patrón puede empezar en cualquier posición.
+ *
+ * @param masks Máscaras del patrón (1 a 64 caracteres).
+ * @param text Nombre a comparar.
+ * @return Distancia mínima encontrada (0 si el patrón aparece tal cual).
+ */
+static int substringDistance(const PatternMasks &masks, const QString &text)
+{
+    const quint64 highBit = quint64(1) << (masks.length - 1);
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    int score = masks.length;
+    int best = score;
+
+    for (QChar qc : text) {
+        const quint64 eq = masks.mask(qc.unicode());
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+
+        if (ph & highBit) {
+            score++;
+        } else if (mh & highBit) {
+            score--;
+        }
+
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        if (score < best) {
+            best = score;
+            if (best == 0) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Constructor del índice.
+ * @param parent Objeto padre opcional.
+ */
+FuzzyIndex::FuzzyIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Busca nombres parecidos, tolerando errores de tipeo.
+ *
+ * Se admite 1 error para textos de hasta 8 caracteres, 2 hasta 16 y uno
+ * por cada 8 caracteres a partir de ahí (con búsqueda por fragmento, una
+ * transposición como "2N3940" por "2N3904" suele costar un solo error). Los textos de más de
+ * @ref kMaxPatternLength caracteres se recortan.
+ *
+ * @param text Texto buscado.
+ * @param limit Máximo de resultados.
+ * @return Coincidencias, de la más a la menos parecida.
+ */
+QList<FuzzyMatch> FuzzyIndex::search(const QString &text, int limit) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<FuzzyMatch> result;
+    const QString pattern = normalizeText(text).left(kMaxPatternLength);
+    if (pattern.isEmpty() || entries.empty()) {
+        lastNs = timer.nsecsElapsed();
+        return result;
+    }
+
+    std::vector<quint64> grams;
+    collectTrigrams(pattern, grams);
+
+    const int length = pattern.size();
+    const int maxEdits = length <= 8 ? 1 : (length <= 16 ? 2 : length / 8);
+    const int minShared = qMax(1, int(grams.size()) - 3 * maxEdits);
+
+    // Listas del patrón, de la más corta a la más larga
+    std::vector<const std::vector<quint32> *> lists;
+    for (quint64 gram : grams) {
+        auto list = postings.constFind(gram);
+        if (list != postings.constEnd()) {
+            lists.push_back(&*list);
+        }
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const auto *a, const auto *b) { return a->size() < b->size(); });
+
+    // 1a. Un candidato que comparte minShared trigramas aparece en al menos
+    // una de las (n - minShared + 1) listas más cortas: solo esas aportan
+    // candidatos nuevos (los trigramas sin lista cuentan como listas vacías)
+    counts.resize(entries.size(), 0);
+    const int missing = int(grams.size() - lists.size());
+    const int probeLists = qMax(0, int(grams.size()) - minShared + 1 - missing);
+    std::vector<quint32> touched;
+    for (int j = 0; j < probeLists; j++) {
+        for (quint32 slot : *lists[j]) {
+            if (counts[slot]++ == 0) {
+                touched.push_back(slot);
+            }
+        }
+    }
+
+    // 1b. Las listas largas solo suman a los candidatos existentes: por
+    // búsqueda binaria si hay pocos, o recorriendo la lista si hay muchos.
+    // Tras cada lista se descartan los que ya no pueden llegar a minShared.
+    bool touchedSorted = false;
+    for (int j = probeLists; j < int(lists.size()); j++) {
+        const std::vector<quint32> &list = *lists[j];
+
+        if (touched.size() * 20 < list.size()) {
+            if (!touchedSorted) {
+                std::sort(touched.begin(), touched.end());
+                touchedSorted = true;
+            }
+            auto pos = list.begin();
+            for (quint32 slot : touched) {
+                pos = std::lower_bound(pos, list.end(), slot);
+                if (pos == list.end()) {
+                    break;
+                }
+                if (*pos == slot) {
+                    counts[slot]++;
+                }
+            }
+        } else {
+            for (quint32 slot : list) {
+                if (counts[slot] != 0) {
+                    counts[slot]++;
+                }
+            }
+        }
+
+        const int remaining = int(lists.size()) - j - 1;
+        size_t kept = 0;
+        for (quint32 slot : touched) {
+            if (counts[slot] + remaining >= minShared) {
+                touched[kept++] = slot;
+            } else {
+                counts[slot] = 0;
+            }
+        }
+        touched.resize(kept);
+    }
+
+    std::vector<quint32> candidates;
+    for (quint32 slot : touched) {
+        if (counts[slot] >= minShared && entries[slot].id != 0) {
+            candidates.push_back(slot);
+        }
+    }
+
+    if (int(candidates.size()) > kMaxVerified) {
+        std::nth_element(candidates.begin(), candidates.begin() + kMaxVerified, candidates.end(),
+                         [this](quint32 a, quint32 b) { return counts[a] > counts[b]; });
+        candidates.resize(kMaxVerified);
+    }
+
+    // 2. Verificación bit-paralela de los candidatos
+    const PatternMasks masks(pattern);
+    struct Scored {
+        quint32 slot;
+        int distance;
+    };
+    std::vector<Scored> scored;
+    for (quint32 slot : candidates) {
+        const int distance = substringDistance(masks, entries[slot].name);
+        if (distance <= maxEdits) {
+            scored.push_back({slot, distance});
+        }
+    }
+
+    // 3. Orden: menos ediciones, más trigramas compartidos, nombre más corto
+    std::sort(scored.begin(), scored.end(), [this](const Scored &a, const Scored &b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        if (counts[a.slot] != counts[b.slot]) {
+            return counts[a.slot] > counts[b.slot];
+        }
+        return entries[a.slot].name.size() < entries[b.slot].name.size();
+    });
+
+    const int take = qMin(limit, int(scored.size()));
+    result.reserve(take);
+    for (int i = 0; i < take; i++) {
+        FuzzyMatch match;
+        match.id = entries[scored[i].slot].id;
+        match.distance = scored[i].distance;
+        match.score = 1.0 - double(scored[i].distance) / length;
+        result.append(match);
+    }
+
+    for (quint32 slot : touched) {
+        counts[slot] = 0;
+    }
+
+    lastNs = timer.nsecsElapsed();
+    return result;
+}
+
+/**
+ * @brief Número de ítems indexados (sin contar posiciones borradas).
+ */
+int FuzzyIndex::size() const
+{
+    return slotById.size();
+}
+
+/**
+ * @brief Duración de la última llamada a @ref search, en nanosegundos.
+ */
+qint64 FuzzyIndex::lastSearchNs() const
+{
+    return lastNs;
+}
+
+/**
+ * @brief Intercambia el contenido con un índice ya armado.
+ * @param built Índice armado (normalmente con @ref setItems en otro hilo).
+ */
+void FuzzyIndex::adopt(FuzzyIndex &built)
+{
+    std::swap(entries, built.entries);
+    std::swap(slotById, built.slotById);
+    std::swap(postings, built.postings);
+    std::swap(deadCount, built.deadCount);
+    std::swap(counts, built.counts);
+}
+
+/**
+ * @brief Reconstruye el índice desde cero.
+ * @param items Todas las filas del inventario.
+ */
+void FuzzyIndex::setItems(const QList<InventoryItem> &items)
+{
+    entries.clear();
+    slotById.clear();
+    postings.clear();
+    counts.clear();
+    deadCount = 0;
+
+    entries.reserve(items.size());
+    slotById.reserve(items.size());
+    for (const InventoryItem &it : items) {
+        insertEntry(it.id, normalizeText(it.nombre));
+    }
+}
+
+/**
+ * @brief Actualiza el índice con los cambios notificados por InventoryManager.
+ *
+ * Una fila cuyo nombre no cambió (movimientos de stock, reubicaciones)
+ * no se toca. Un nombre modificado se indexa en una posición nueva y la
+ * anterior queda marcada como borrada.
+ *
+ * @param rows Filas nuevas o modificadas.
+ * @param removedIds IDs borrados.
+ */
+void FuzzyIndex::applyChanges(const QList<InventoryItem> &rows, const QList<int> &removedIds)
+{
+    for (const InventoryItem &it : rows) {
+        const QString name = normalizeText(it.nombre);
+
+        auto found = slotById.constFind(it.id);
+        if (found != slotById.constEnd()) {
+            if (entries[*found].name == name) {
+                continue;
+            }
+            removeEntry(it.id);
+        }
+        insertEntry(it.id, name);
+    }
+
+    for (int id : removedIds) {
+        removeEntry(id);
+    }
+
+    if (deadCount >= kCompactMinDead && deadCount > int(slotById.size())) {
+        compact();
+    }
+}
+
+/**
+ * @brief Agrega un nombre normalizado en una posición nueva.
+ */
+void FuzzyIndex::insertEntry(int id, const QString &name)
+{
+    const quint32 slot = quint32(entries.size());
+    entries.push_back({id, name});
+    slotById.insert(id, slot);
+
+    std::vector<quint64> grams;
+    collectTrigrams(name, grams);
+    for (quint64 gram : grams) {
+        postings[gram].push_back(slot);
+    }
+}
+
+/**
+ * @brief Marca como borrada la posición vigente de un ID.
+ *
+ * Las listas de trigramas no se recorren: la posición se descarta al
+ * buscar y desaparece en la próxima compactación.
+ */
+void FuzzyIndex::removeEntry(int id)
+{
+    auto found = slotById.find(id);
+    if (found == slotById.end()) {
+        return;
+    }
+
+    Entry &entry = entries[*found];
+    entry.id = 0;
+    entry.name.clear();
+    slotById.erase(found);
+    deadCount++;
+}
+
+/**
+ * @brief Reconstruye las listas de trigramas sin las posiciones borradas.
+ */
+void FuzzyIndex::compact()
+{
+    std::vector<Entry> alive;
+    alive.reserve(slotById.size());
+    for (Entry &entry : entries) {
+        if (entry.id != 0) {
+            alive.push_back(std::move(entry));
+        }
+    }
+
+    entries.clear();
+    slotById.clear();
+    postings.clear();
+    counts.clear();
+    deadCount = 0;
+
+    entries.reserve(alive.size());
+    for (Entry &entry : alive) {
+        insertEntry(entry.id, entry.name);
+    }
+}
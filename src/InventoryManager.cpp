@@ -1,7 +1,315 @@
 #include "InventoryManager.h"
+#include "InventorySchema.h"
+#include "InventoryShards.h"
+#include "DatabaseManager.h"
+#include "QueryDiagnostics.h"
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
 #include <QDebug>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+#include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+
+/**
+ * @brief Máximo de IDs enlazados en una sola sentencia IN (...).
+ *
+ * SQLite limita el número de parámetros por sentencia (999 en versiones
+ * antiguas); las ráfagas más grandes se parten en bloques de este tamaño.
+ */
+static const int kMaxIdsPerQuery = 500;
+
+/**
+ * @brief Entradas recientes que se conservan en el registro de cambios.
+ *
+ * Un cliente que se atrase más que esto recarga la tabla completa.
+ */
+static const qint64 kChangeLogKeep = 50000;
+
+/**
+ * @brief Máximo de IDs que se procesan de forma incremental en una revisión.
+ *
+ * Por encima de este número (por ejemplo, tras una carga masiva) es más
+ * barato recargar la tabla completa que aplicar fila por fila.
+ */
+static const int kMaxIncrementalIds = 20000;
+
+/**
+ * @brief Intentos de tomar el bloqueo de escritura antes de abandonar.
+ */
+static const int kMaxWriteAttempts = 8;
+
+/**
+ * @brief Intentos en el hilo de la interfaz, donde no se duerme entre intentos.
+ */
+static const int kMaxGuiWriteAttempts = 3;
+
+/**
+ * @brief Espera máxima dentro de SQLite al tomar el bloqueo (busy_timeout), en ms.
+ *
+ * Es corta a propósito y solo rige para BEGIN IMMEDIATE y COMMIT: el
+ * planificador de escrituras hace el resto de la espera con su propio
+ * retroceso, que mide y puede abandonar. Las demás sentencias conservan
+ * el busy_timeout de la conexión.
+ */
+static const int kBusySliceMs = 20;
+
+/**
+ * @brief Primera espera entre intentos y tope de la espera exponencial, en ms.
+ */
+static const int kBaseBackoffMs = 2;
+static const int kMaxBackoffMs = 200;
+
+/**
+ * @brief Deltas mínimos entre dos fotos del historial.
+ *
+ * La regla general es una foto cuando los deltas superan al número de
+ * ítems; con inventarios chicos, este mínimo evita fotos demasiado seguidas.
+ */
+static const qint64 kMinKeyframeChanges = 10000;
+
+/**
+ * @brief Ejecuta una consulta con la API nativa de SQLite, fila por fila.
+ *
+ * @param diagnostics Diagnóstico de consultas (registra la sentencia si está activo).
+ * @param handle Conexión nativa (puede estar dentro de una transacción).
+ * @param sql Consulta a preparar.
+ * @param bind Enlaza los parámetros sobre la sentencia preparada.
+ * @param step Se llama con la sentencia en cada fila; false detiene el recorrido.
+ * @return true si la consulta terminó (o se detuvo) sin error.
+ */
+template <typename Bind, typename Step>
+static bool runNative(QueryDiagnostics &diagnostics, sqlite3 *handle, const QString &sql,
+                      Bind &&bind, Step &&step)
+{
+    QElapsedTimer timer;
+    if (diagnostics.isEnabled()) {
+        timer.start();
+    }
+
+    const QByteArray utf8 = sql.toUtf8();
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, utf8.constData(), int(utf8.size()), &stmt, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo preparar la lectura:" << sqlite3_errmsg(handle);
+        return false;
+    }
+    bind(stmt);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!step(stmt)) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+    if (timer.isValid()) {
+        diagnostics.record(stmt, timer.nsecsElapsed());
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        qDebug() << "Fallo al leer las filas:" << sqlite3_errstr(rc);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Vista de la fila actual de una sentencia nativa, sin copiar texto.
+ *
+ * Los QStringView apuntan al búfer UTF-16 de la sentencia, que SQLite
+ * mantiene hasta el siguiente sqlite3_step.
+ */
+static InventoryRowView nativeView(sqlite3_stmt *stmt)
+{
+    return InventorySchema::decodeView([stmt](int column, auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if constexpr (std::is_same_v<T, int>) {
+            return sqlite3_column_int(stmt, column);
+        } else {
+            const void *text = sqlite3_column_text16(stmt, column);
+            const int bytes = sqlite3_column_bytes16(stmt, column);
+            return QStringView(static_cast<const char16_t *>(text), bytes / 2);
+        }
+    });
+}
+
+/**
+ * @brief Fila actual de una sentencia nativa como InventoryItem.
+ *
+ * Cada texto se copia una sola vez del búfer UTF-16 de SQLite al QString,
+ * sin pasar por un QVariant.
+ */
+static InventoryItem nativeItem(sqlite3_stmt *stmt)
+{
+    return InventorySchema::decode([stmt](int column, auto *tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        if constexpr (std::is_same_v<T, int>) {
+            return sqlite3_column_int(stmt, column);
+        } else {
+            const void *text = sqlite3_column_text16(stmt, column);
+            const int bytes = sqlite3_column_bytes16(stmt, column);
+            return QString(static_cast<const QChar *>(text), bytes / 2);
+        }
+    });
+}
+
+/**
+ * @brief Enlaza parámetros (enteros o texto) sobre una sentencia nativa.
+ */
+static void bindNative(sqlite3_stmt *stmt, const QVariantList &params)
+{
+    for (int i = 0; i < params.size(); i++) {
+        const QVariant &v = params.at(i);
+        if (v.typeId() == QMetaType::Int || v.typeId() == QMetaType::LongLong) {
+            sqlite3_bind_int64(stmt, i + 1, v.toLongLong());
+        } else {
+            const QString text = v.toString();
+            sqlite3_bind_text16(stmt, i + 1, text.utf16(),
+                                int(text.size() * sizeof(char16_t)),
+                                SQLITE_TRANSIENT);
+        }
+    }
+}
+
+/**
+ * @brief Separa un texto ya plegado en palabras (letras y dígitos).
+ *
+ * Cualquier otro carácter (espacios, guiones, puntos...) separa palabras,
+ * así "10k-A1" produce "10k" y "a1".
+ *
+ * @param folded Texto devuelto por InventoryManager::foldSearchText.
+ * @return Palabras en orden de aparición, sin vacías.
+ */
+static QStringList splitSearchWords(const QString &folded)
+{
+    QStringList words;
+    QString current;
+
+    for (QChar c : folded) {
+        if (c.isLetterOrNumber()) {
+            current.append(c);
+        } else if (!current.isEmpty()) {
+            words.append(current);
+            current.clear();
+        }
+    }
+    if (!current.isEmpty()) {
+        words.append(current);
+    }
+    return words;
+}
+
+/**
+ * @brief Menor cadena mayor que todas las que empiezan por @p prefix.
+ *
+ * SQLite compara el texto byte a byte en UTF-8, que respeta el orden de
+ * los puntos de código; basta con incrementar el último.
+ *
+ * @param prefix Prefijo no vacío.
+ * @return Cota superior exclusiva para `clave < ?`.
+ */
+static QString prefixUpperBound(const QString &prefix)
+{
+    QList<uint> codes = prefix.toUcs4();
+    codes.last()++;
+    return QString::fromUcs4(reinterpret_cast<const char32_t *>(codes.constData()), codes.size());
+}
+
+/**
+ * @brief Consulta de búsqueda por prefijos: un rango de `inventario_claves` por palabra.
+ *
+ * Los rangos se intersecan, así que un ID aparece solo si cada palabra es
+ * prefijo de alguna de sus claves.
+ *
+ * @param words Palabras ya plegadas (al menos una).
+ * @param params Recibe los límites de cada rango, en orden.
+ * @return `SELECT item_id ... INTERSECT ...`.
+ */
+static QString searchSubquery(const QStringList &words, QVariantList &params)
+{
+    QStringList selects;
+    for (const QString &word : words) {
+        selects.append("SELECT item_id FROM inventario_claves WHERE clave >= ? AND clave < ?");
+        params.append(word);
+        params.append(prefixUpperBound(word));
+    }
+    return selects.join(" INTERSECT ");
+}
+
+/**
+ * @brief Condiciones de un PageFilter sobre la tabla inventario.
+ *
+ * Tipo y ubicación se comparan por igualdad exacta y las fechas como
+ * texto, igual que FacetFilter::matches. La búsqueda se resuelve con la
+ * misma subconsulta que InventoryManager::searchItems.
+ *
+ * @param filter Filtro a traducir.
+ * @param params Recibe los valores a enlazar, en orden.
+ * @return Condiciones unidas con AND, o vacío si el filtro no restringe nada.
+ */
+static QString filterConditions(const PageFilter &filter, QVariantList &params)
+{
+    QStringList conditions;
+    const FacetFilter &facets = filter.facets;
+    if (!facets.tipo.isEmpty()) {
+        conditions.append("tipo = ?");
+        params.append(facets.tipo);
+    }
+    if (!facets.ubicacion.isEmpty()) {
+        conditions.append("ubicacion = ?");
+        params.append(facets.ubicacion);
+    }
+    if (!facets.desde.isEmpty()) {
+        conditions.append("fechaAdquisicion >= ?");
+        params.append(facets.desde);
+    }
+    if (!facets.hasta.isEmpty()) {
+        conditions.append("fechaAdquisicion <= ?");
+        params.append(facets.hasta);
+    }
+
+    if (!filter.search.trimmed().isEmpty()) {
+        const QStringList words = splitSearchWords(InventoryManager::foldSearchText(filter.search));
+        // Un texto sin palabras (solo signos) no coincide con nada, como en searchItems
+        conditions.append(words.isEmpty() ? "0" : "id IN (" + searchSubquery(words, params) + ")");
+    }
+    return conditions.join(" AND ");
+}
+
+/**
+ * @brief Comparación equivalente a COLLATE NOCASE de SQLite.
+ *
+ * NOCASE solo pliega las letras ASCII y compara el resto por punto de
+ * código, que es lo que se reproduce aquí.
+ */
+static int compareNocase(const QString &a, const QString &b)
+{
+    const int n = qMin(a.size(), b.size());
+    for (int i = 0; i < n; i++) {
+        char16_t ca = a.at(i).unicode();
+        char16_t cb = b.at(i).unicode();
+        if (ca >= 'A' && ca <= 'Z') {
+            ca += 'a' - 'A';
+        }
+        if (cb >= 'A' && cb <= 'Z') {
+            cb += 'a' - 'A';
+        }
+        if (ca != cb) {
+            return ca < cb ? -1 : 1;
+        }
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
 
 /**
  * @brief Constructor de InventoryManager.
@@ -21,8 +329,19 @@ InventoryManager::InventoryManager(QSqlDatabase database, QObject *parent)
         qFatal("ERROR FATAL: Base de datos no válida. "
                "Asegúrate de usar DatabaseManager::getDatabase().");
     }
+
+    // La espera del resto de las sentencias es la que eligió quien abrió la conexión
+    QSqlQuery timeout(db);
+    if (timeout.exec("PRAGMA busy_timeout") && timeout.next()) {
+        statementBusyMs = timeout.value(0).toInt();
+    }
 }
 
+/**
+ * @brief Destructor; cierra las sedes adjuntas, si las hay.
+ */
+InventoryManager::~InventoryManager() = default;
+
 /**
  * @brief Crea la tabla principal del inventario si no existe.
  *
@@ -34,13 +353,28 @@ InventoryManager::InventoryManager(QSqlDatabase database, QObject *parent)
  * - ubicacion
  * - fechaAdquisicion
  *
+ * Además crea el registro de cambios `inventario_cambios` y los triggers
+ * que lo alimentan: cada INSERT, UPDATE o DELETE sobre inventario, venga
+ * de esta aplicación o de otra estación, deja una entrada con un número
+ * de secuencia creciente y el ID afectado. Un ID 0 marca que la tabla
+ * se reemplazó completa.
+ *
+ * Por último crea las claves de búsqueda `inventario_claves` (palabra
+ * plegada -> ID, ver @ref searchItems). Las escribe esta clase al insertar
+ * o editar; un trigger las borra junto con la fila. Si hay filas sin
+ * claves (base o plantilla de una versión anterior), se regeneran.
+ *
+ * Cada columna ordenable tiene su índice (`inventario_orden_*`), con la
+ * misma intercalación que usa @ref fetchPage; el ID ya es la clave de
+ * la tabla y cada índice lo incluye, lo que sirve de desempate.
+ *
  * @return true si la tabla se creó o ya existía; false si hubo error en la ejecución.
  */
 bool InventoryManager::createTable()
 {
     QSqlQuery query(db);
 
-    QString sql =
+    const QStringList statements = {
         "CREATE TABLE IF NOT EXISTS inventario ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "nombre TEXT NOT NULL,"
@@ -48,14 +382,166 @@ bool InventoryManager::createTable()
         "cantidad INTEGER NOT NULL,"
         "ubicacion TEXT NOT NULL,"
         "fechaAdquisicion TEXT NOT NULL"
-        ");";
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS inventario_cambios ("
+        "seq INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "item_id INTEGER NOT NULL"
+        ");",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_cambio_insert AFTER INSERT ON inventario "
+        "BEGIN INSERT INTO inventario_cambios (item_id) VALUES (NEW.id); END;",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_cambio_update AFTER UPDATE ON inventario "
+        "BEGIN INSERT INTO inventario_cambios (item_id) VALUES (NEW.id); END;",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_cambio_delete AFTER DELETE ON inventario "
+        "BEGIN INSERT INTO inventario_cambios (item_id) VALUES (OLD.id); END;",
+
+        "CREATE TABLE IF NOT EXISTS inventario_claves ("
+        "clave TEXT NOT NULL,"
+        "item_id INTEGER NOT NULL,"
+        "PRIMARY KEY (clave, item_id)"
+        ") WITHOUT ROWID;",
+
+        "CREATE INDEX IF NOT EXISTS inventario_claves_item ON inventario_claves (item_id);",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_claves_delete AFTER DELETE ON inventario "
+        "BEGIN DELETE FROM inventario_claves WHERE item_id = OLD.id; END;",
+
+        "CREATE INDEX IF NOT EXISTS inventario_orden_nombre ON inventario (nombre COLLATE NOCASE);",
+        "CREATE INDEX IF NOT EXISTS inventario_orden_tipo ON inventario (tipo COLLATE NOCASE);",
+        "CREATE INDEX IF NOT EXISTS inventario_orden_cantidad ON inventario (cantidad);",
+        "CREATE INDEX IF NOT EXISTS inventario_orden_ubicacion ON inventario (ubicacion COLLATE NOCASE);",
+        "CREATE INDEX IF NOT EXISTS inventario_orden_fecha ON inventario (fechaAdquisicion);",
+
+        // Historial de existencias: un delta por cambio de cantidad
+        // (evento 1 = alta, 0 = movimiento, 2 = baja, 3 = tabla reemplazada)
+        // y fotos periódicas
+        "CREATE TABLE IF NOT EXISTS inventario_historial ("
+        "seq INTEGER PRIMARY KEY,"
+        "ts INTEGER NOT NULL,"
+        "item_id INTEGER NOT NULL,"
+        "delta INTEGER NOT NULL,"
+        "evento INTEGER NOT NULL"
+        ");",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_historial_insert AFTER INSERT ON inventario "
+        "BEGIN INSERT INTO inventario_historial (ts, item_id, delta, evento) "
+        "VALUES (CAST(strftime('%s', 'now') AS INTEGER), NEW.id, NEW.cantidad, 1); END;",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_historial_update AFTER UPDATE OF cantidad ON inventario "
+        "WHEN NEW.cantidad <> OLD.cantidad "
+        "BEGIN INSERT INTO inventario_historial (ts, item_id, delta, evento) "
+        "VALUES (CAST(strftime('%s', 'now') AS INTEGER), NEW.id, NEW.cantidad - OLD.cantidad, 0); END;",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_historial_delete AFTER DELETE ON inventario "
+        "BEGIN INSERT INTO inventario_historial (ts, item_id, delta, evento) "
+        "VALUES (CAST(strftime('%s', 'now') AS INTEGER), OLD.id, -OLD.cantidad, 2); END;",
+
+        "CREATE TABLE IF NOT EXISTS inventario_fotos_indice ("
+        "foto INTEGER PRIMARY KEY,"
+        "ts INTEGER NOT NULL,"
+        "seq INTEGER NOT NULL,"
+        "filas INTEGER NOT NULL"
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS inventario_fotos ("
+        "foto INTEGER NOT NULL,"
+        "item_id INTEGER NOT NULL,"
+        "cantidad INTEGER NOT NULL,"
+        "PRIMARY KEY (foto, item_id)"
+        ") WITHOUT ROWID;",
+
+        // Puntos de reorden por ítem y por tipo; el del ítem se va con él
+        "CREATE TABLE IF NOT EXISTS inventario_reorden ("
+        "id INTEGER PRIMARY KEY,"
+        "punto INTEGER NOT NULL"
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS inventario_reorden_tipos ("
+        "tipo TEXT PRIMARY KEY,"
+        "punto INTEGER NOT NULL"
+        ") WITHOUT ROWID;",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_reorden_delete AFTER DELETE ON inventario "
+        "BEGIN DELETE FROM inventario_reorden WHERE id = OLD.id; END;",
+
+        // Sincronización entre sedes: identidad de esta base, origen de las
+        // filas traídas de otra sede y resumen de cada fila en la última
+        // sincronización con cada sede (par)
+        "CREATE TABLE IF NOT EXISTS inventario_sede ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "sede INTEGER NOT NULL"
+        ");",
+
+        "INSERT OR IGNORE INTO inventario_sede (id, sede) "
+        "VALUES (1, (random() & 9223372036854775807) | 1);",
+
+        "CREATE TABLE IF NOT EXISTS inventario_origen ("
+        "item_id INTEGER PRIMARY KEY,"
+        "sede INTEGER NOT NULL,"
+        "origen INTEGER NOT NULL"
+        ");",
+
+        "CREATE TRIGGER IF NOT EXISTS inventario_origen_delete AFTER DELETE ON inventario "
+        "BEGIN DELETE FROM inventario_origen WHERE item_id = OLD.id; END;",
 
-    return query.exec(sql);
+        "CREATE TABLE IF NOT EXISTS inventario_sincronizado ("
+        "par INTEGER NOT NULL,"
+        "sede INTEGER NOT NULL,"
+        "origen INTEGER NOT NULL,"
+        "resumen INTEGER NOT NULL,"
+        "PRIMARY KEY (par, sede, origen)"
+        ") WITHOUT ROWID;"
+    };
+
+    // Otra estación puede estar escribiendo: el esquema se crea en una
+    // transacción del planificador, con sus reintentos
+    const bool created = runWrite([&query, &statements] {
+        for (const QString &sql : statements) {
+            if (!query.exec(sql)) {
+                qDebug() << "Fallo al crear el esquema:" << query.lastError();
+                return false;
+            }
+        }
+        return true;
+    }, AfterWrite::Nothing);
+    if (!created) {
+        return false;
+    }
+
+    if (query.exec("SELECT EXISTS (SELECT 1 FROM inventario "
+                   "WHERE id NOT IN (SELECT item_id FROM inventario_claves))")
+        && query.next() && query.value(0).toBool()) {
+        query.finish();
+        if (!rebuildSearchKeys()) {
+            return false;
+        }
+    }
+
+    // La primera foto es la línea de base del historial: los ítems
+    // anteriores a los triggers no tienen delta de alta
+    if (query.exec("SELECT EXISTS (SELECT 1 FROM inventario_fotos_indice)")
+        && query.next() && !query.value(0).toBool()) {
+        query.finish();
+        if (!takeKeyframe()) {
+            return false;
+        }
+    }
+
+    // Punto de partida del seguimiento de cambios de esta conexión
+    if (!trackingDeferred) {
+        startChangeTracking();
+    }
+    return true;
 }
 
 /**
  * @brief Inserta un nuevo elemento en la tabla inventario.
  *
+ * La fila y sus claves de búsqueda se confirman en la misma transacción.
+ *
  * @param nombre Nombre del componente.
  * @param tipo Tipo o categoría.
  * @param cantidad Cantidad disponible.
@@ -70,23 +556,40 @@ bool InventoryManager::addItem(const QString &nombre,
                                const QString &ubicacion,
                                const QString &fechaAdquisicion)
 {
-    QSqlQuery query(db);
+    InventoryItem it{0, nombre, tipo, cantidad, ubicacion, fechaAdquisicion};
 
-    query.prepare(
-        "INSERT INTO inventario "
-        "(nombre, tipo, cantidad, ubicacion, fechaAdquisicion) "
-        "VALUES (?, ?, ?, ?, ?)"
-    );
+    return runWrite([this, &it] {
+        QSqlQuery query(db);
+        query.prepare(InventorySchema::insertSql());
+        InventorySchema::bindItem(query, it);
 
-    query.addBindValue(nombre);
-    query.addBindValue(tipo);
-    query.addBindValue(cantidad);
-    query.addBindValue(ubicacion);
-    query.addBindValue(fechaAdquisicion);
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        const bool inserted = query.exec();
+        probe.finish();
+        if (!inserted) {
+            return false;
+        }
 
-    return query.exec();
+        it.id = query.lastInsertId().toInt();
+        if (!writeSearchKeys({it})) {
+            return false;
+        }
+        lastInsertedId = it.id;
+        return true;
+    });
+}
+
+/**
+ * @brief ID asignado al último elemento agregado con addItem.
+ *
+ * @return ID, o 0 si todavía no se agregó ninguno.
+ */
+int InventoryManager::lastAddedId() const
+{
+    return lastInsertedId;
 }
 
+
 /**
  * @brief Actualiza únicamente la cantidad de un elemento identificado por id.
  *
@@ -97,13 +600,18 @@ bool InventoryManager::addItem(const QString &nombre,
  */
 bool InventoryManager::updateQuantity(int id, int newQuantity)
 {
-    QSqlQuery query(db);
-    query.prepare("UPDATE inventario SET cantidad = ? WHERE id = ?");
-    query.addBindValue(newQuantity);
-    query.addBindValue(id);
-    return query.exec();
+    return runWrite([this, id, newQuantity] {
+        QSqlQuery query(db);
+        query.prepare("UPDATE inventario SET cantidad = ? WHERE id = ?");
+        query.addBindValue(newQuantity);
+        query.addBindValue(id);
+
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        return query.exec();
+    });
 }
 
+
 /**
  * @brief Elimina un elemento del inventario.
  *
@@ -113,12 +621,17 @@ bool InventoryManager::updateQuantity(int id, int newQuantity)
  */
 bool InventoryManager::removeItem(int id)
 {
-    QSqlQuery query(db);
-    query.prepare("DELETE FROM inventario WHERE id = ?");
-    query.addBindValue(id);
-    return query.exec();
+    return runWrite([this, id] {
+        QSqlQuery query(db);
+        query.prepare("DELETE FROM inventario WHERE id = ?");
+        query.addBindValue(id);
+
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        return query.exec();
+    });
 }
 
+
 /**
  * @brief Obtiene todos los registros almacenados en la tabla inventario.
  *
@@ -127,26 +640,150 @@ bool InventoryManager::removeItem(int id)
 QList<InventoryItem> InventoryManager::getAllItems()
 {
     QList<InventoryItem> items;
-    QSqlQuery query(db);
+    forEachItem([&items](const InventoryRowView &row) {
+        items.append(row.toItem());
+        return true;
+    });
+    return items;
+}
+
+/**
+ * @brief Recorre todos los ítems sin materializarlos.
+ *
+ * @param visit Recibe cada fila; devuelve false para detener el recorrido.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::forEachItem(const RowVisitor &visit)
+{
+    return visitRows(QString(), {}, visit);
+}
+
+/**
+ * @brief Recorre un tramo de la tabla en orden de ID, sin materializarlo.
+ *
+ * El tramo se busca por rango sobre la clave primaria, así que cuesta lo
+ * mismo al principio que al final de la tabla.
+ *
+ * @param afterId Último ID del tramo anterior (0 para empezar).
+ * @param limit Filas como máximo.
+ * @param visit Recibe cada fila; devuelve false para detener el recorrido.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::forEachItemAfter(int afterId, int limit, const RowVisitor &visit)
+{
+    return visitRows("WHERE id > ? ORDER BY id LIMIT ?", {afterId, limit}, visit);
+}
+
+/**
+ * @brief Ejecuta `SELECT <columnas> FROM inventario <suffix>` y visita cada fila.
+ *
+ * Corre en la conexión de lectura dentro de una transacción, de modo que
+ * todo el recorrido ve una misma instantánea. Con la conexión nativa, las
+ * vistas apuntan al texto UTF-16 que SQLite ya decodificó: no se crea un
+ * QVariant, un QString ni un InventoryItem por fila. Si el controlador no
+ * expone la conexión nativa, se recurre a QSqlQuery y cada fila se
+ * materializa antes de visitarla.
+ *
+ * @param suffix Resto de la consulta (WHERE, ORDER BY), con parámetros `?`.
+ * @param params Valores de los parámetros (enteros o texto).
+ * @param visit Visitante de filas.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::visitRows(const QString &suffix,
+                                 const QVariantList &params,
+                                 const RowVisitor &visit)
+{
+    QSqlDatabase reader = readerDatabase();
+    const QString sql = suffix.isEmpty() ? InventorySchema::selectSql()
+                                         : InventorySchema::selectSql() + " " + suffix;
+
+    // Transacción de lectura: fija la instantánea durante todo el recorrido
+    const bool snapshot = (reader.connectionName() != db.connectionName())
+                          && reader.transaction();
+
+    bool ok;
+    if (sqlite3 *handle = DatabaseManager::nativeHandle(reader)) {
+        ok = runNative(diagnostics, handle, sql,
+                       [&params](sqlite3_stmt *stmt) { bindNative(stmt, params); },
+                       [&visit](sqlite3_stmt *stmt) { return visit(nativeView(stmt)); });
+    } else {
+        QSqlQuery query(reader);
+        query.setForwardOnly(true);
+        query.prepare(sql);
+        for (const QVariant &v : params) {
+            query.addBindValue(v);
+        }
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        ok = query.exec();
+        if (!ok) {
+            qDebug() << "Fallo al recorrer el inventario:" << query.lastError();
+        }
+        while (ok && query.next()) {
+            const InventoryItem it = InventorySchema::fromQuery(query);
+            if (!visit(InventorySchema::viewOf(it))) {
+                break;
+            }
+        }
+    }
+
+    if (snapshot) {
+        reader.commit();
+    }
+    return ok;
+}
+
+/**
+ * @brief Ejecuta `SELECT <columnas> FROM inventario <suffix>` y entrega cada fila como ítem.
+ *
+ * Con la conexión nativa cada celda se lee con sqlite3_column_* directo
+ * al InventoryItem; si el controlador no la expone, se recurre a
+ * QSqlQuery (un QVariant por celda).
+ *
+ * @param connection Conexión donde se consulta (la principal o la de lectura).
+ * @param suffix Resto de la consulta (WHERE, ORDER BY, LIMIT), con parámetros `?`.
+ * @param params Valores de los parámetros (enteros o texto).
+ * @param take Recibe cada fila.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::selectItems(QSqlDatabase connection,
+                                   const QString &suffix,
+                                   const QVariantList &params,
+                                   const ItemSink &take)
+{
+    const QString sql = suffix.isEmpty() ? InventorySchema::selectSql()
+                                         : InventorySchema::selectSql() + " " + suffix;
 
-    query.exec("SELECT id, nombre, tipo, cantidad, ubicacion, fechaAdquisicion FROM inventario");
+    if (sqlite3 *handle = DatabaseManager::nativeHandle(connection)) {
+        return runNative(diagnostics, handle, sql,
+                         [&params](sqlite3_stmt *stmt) { bindNative(stmt, params); },
+                         [&take](sqlite3_stmt *stmt) {
+                             take(nativeItem(stmt));
+                             return true;
+                         });
+    }
 
+    QSqlQuery query(connection);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant &v : params) {
+        query.addBindValue(v);
+    }
+    QueryDiagnostics::Probe probe(diagnostics, query);
+    if (!query.exec()) {
+        qDebug() << "Fallo al leer el inventario:" << query.lastError();
+        return false;
+    }
     while (query.next()) {
-        InventoryItem it;
-        it.id = query.value(0).toInt();
-        it.nombre = query.value(1).toString();
-        it.tipo = query.value(2).toString();
-        it.cantidad = query.value(3).toInt();
-        it.ubicacion = query.value(4).toString();
-        it.fechaAdquisicion = query.value(5).toString();
-        items.append(it);
+        take(InventorySchema::fromQuery(query));
     }
-    return items;
+    return true;
 }
 
 /**
  * @brief Actualiza todos los campos de un elemento del inventario.
  *
+ * Las claves de búsqueda del elemento se regeneran en la misma transacción.
+ *
  * @param id Identificador del registro a actualizar.
  * @param nombre Nuevo nombre.
  * @param tipo Nuevo tipo.
@@ -163,27 +800,28 @@ bool InventoryManager::updateItem(int id,
                                   const QString &ubicacion,
                                   const QString &fechaAdquisicion)
 {
-    QSqlQuery query(db);
+    const InventoryItem it{id, nombre, tipo, cantidad, ubicacion, fechaAdquisicion};
 
-    query.prepare(
-        "UPDATE inventario SET "
-        "nombre = ?, tipo = ?, cantidad = ?, ubicacion = ?, fechaAdquisicion = ? "
-        "WHERE id = ?"
-    );
+    return runWrite([this, &it] {
+        QSqlQuery query(db);
+        query.prepare(InventorySchema::updateSql());
+        InventorySchema::bindItem(query, it);
+        query.addBindValue(it.id);
 
-    query.addBindValue(nombre);
-    query.addBindValue(tipo);
-    query.addBindValue(cantidad);
-    query.addBindValue(ubicacion);
-    query.addBindValue(fechaAdquisicion);
-    query.addBindValue(id);
-
-    return query.exec();
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        const bool updated = query.exec();
+        probe.finish();
+        return updated && writeSearchKeys({it});
+    });
 }
 
+
 /**
  * @brief Obtiene un único elemento del inventario según su id.
  *
+ * Si el índice en memoria está activo, la fila se toma de él sin
+ * consultar SQLite. En ambos casos se acumula la latencia en @ref stats.
+ *
  * @param id Identificador buscado.
  *
  * @return Estructura InventoryItem con los datos encontrados.
@@ -192,22 +830,2242 @@ bool InventoryManager::updateItem(int id,
 InventoryItem InventoryManager::getItemById(int id)
 {
     InventoryItem it;
+    QElapsedTimer timer;
+    timer.start();
 
-    QSqlQuery query(db);
-    query.prepare("SELECT id, nombre, tipo, cantidad, ubicacion, fechaAdquisicion "
-                  "FROM inventario WHERE id = ?");
-    query.addBindValue(id);
+    if (idIndexEnabled) {
+        it = idIndex.value(id, it);
+        stats.indexLookups++;
+        stats.indexNs += timer.nsecsElapsed();
+        return it;
+    }
+
+    selectItems(db, "WHERE id = ?", {id}, [&it](InventoryItem &&row) { it = std::move(row); });
+
+    stats.sqlLookups++;
+    stats.sqlNs += timer.nsecsElapsed();
+    return it;  // vacío si no se encuentra
+}
+
+/**
+ * @brief Resuelve una ráfaga de IDs con una sola consulta.
+ *
+ * Sin índice en memoria, se ejecuta un único
+ * `SELECT ... WHERE id IN (?, ?, ...)` por cada bloque de
+ * @ref kMaxIdsPerQuery IDs, en lugar de un SELECT por ID. Con el índice
+ * activo, la ráfaga completa se resuelve en memoria.
+ *
+ * @param ids Identificadores buscados (se admiten repetidos).
+ *
+ * @return Ítems encontrados, en el mismo orden que @p ids.
+ */
+QList<InventoryItem> InventoryManager::getItemsByIds(const QList<int> &ids)
+{
+    QList<InventoryItem> items;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (idIndexEnabled) {
+        items.reserve(ids.size());
+        for (int id : ids) {
+            auto found = idIndex.constFind(id);
+            if (found != idIndex.constEnd()) {
+                items.append(*found);
+            }
+        }
+    } else {
+        items = fetchItems(ids);
+    }
+
+    stats.batchLookups++;
+    stats.batchIds += ids.size();
+    stats.batchNs += timer.nsecsElapsed();
+    return items;
+}
 
-    if (!query.exec() || !query.next()) {
-        return it;  // vacío si no se encuentra
+/**
+ * @brief Activa o desactiva el índice en memoria ID -> fila.
+ *
+ * Al activarlo se carga la tabla completa una vez; a partir de ahí se
+ * mantiene coherente con el registro de cambios, tanto para escrituras
+ * propias como para las de otras estaciones (ver @ref pollExternalChanges).
+ * Al desactivarlo se libera la memoria.
+ *
+ * @param enabled true para activar el índice.
+ */
+void InventoryManager::setIdIndexEnabled(bool enabled)
+{
+    idIndexEnabled = enabled;
+    if (enabled) {
+        rebuildIdIndex();
+    } else {
+        idIndex.clear();
+        idIndex.squeeze();
     }
+}
+
+/**
+ * @brief Indica si el índice en memoria está activo.
+ */
+bool InventoryManager::isIdIndexEnabled() const
+{
+    return idIndexEnabled;
+}
+
+/**
+ * @brief Devuelve los contadores de latencia de búsqueda por ID.
+ */
+LookupStats InventoryManager::lookupStats() const
+{
+    return stats;
+}
 
-    it.id = query.value(0).toInt();
-    it.nombre = query.value(1).toString();
-    it.tipo = query.value(2).toString();
-    it.cantidad = query.value(3).toInt();
-    it.ubicacion = query.value(4).toString();
-    it.fechaAdquisicion = query.value(5).toString();
+/**
+ * @brief Reinicia los contadores de latencia de búsqueda por ID.
+ */
+void InventoryManager::resetLookupStats()
+{
+    stats = LookupStats();
+}
+
+/**
+ * @brief Diagnóstico de consultas del gestor, para activarlo o leer su informe.
+ */
+QueryDiagnostics &InventoryManager::queryDiagnostics()
+{
+    return diagnostics;
+}
+
+/**
+ * @brief Sedes adjuntas; el conjunto se crea vacío en la primera llamada.
+ */
+InventoryShards &InventoryManager::shards()
+{
+    if (!siteShards) {
+        siteShards = std::make_unique<InventoryShards>();
+    }
+    return *siteShards;
+}
 
-    return it;
+/**
+ * @brief Reconstruye el inventario completo en un instante pasado.
+ *
+ * @param when Instante a consultar.
+ * @return Ítems que existían entonces, ordenados por ID, con la cantidad
+ *         de ese momento; vacía si el historial empieza después.
+ */
+QList<InventoryItem> InventoryManager::inventoryAt(const QDateTime &when)
+{
+    QList<InventoryItem> items;
+    QHash<int, int> quantities;
+    if (!replayHistory(when.toSecsSinceEpoch(), 0, quantities)) {
+        return items;
+    }
+
+    QList<int> ids = quantities.keys();
+    std::sort(ids.begin(), ids.end());
+
+    // Las demás columnas vienen de la fila actual, si todavía existe
+    const QList<InventoryItem> current = getItemsByIds(ids);
+    items.reserve(ids.size());
+    int next = 0;
+    for (int id : ids) {
+        if (next < current.size() && current.at(next).id == id) {
+            items.append(current.at(next++));
+        } else {
+            items.append({id, QString(), QString(), 0, QString(), QString()});
+        }
+        items.last().cantidad = quantities.value(id);
+    }
+    return items;
+}
+
+/**
+ * @brief Cantidad de un solo ítem en un instante pasado.
+ *
+ * @return La cantidad, o -1 si el ítem no existía (o el historial empieza después).
+ */
+int InventoryManager::quantityAt(int id, const QDateTime &when)
+{
+    QHash<int, int> quantities;
+    if (!replayHistory(when.toSecsSinceEpoch(), id, quantities)) {
+        return -1;
+    }
+    return quantities.value(id, -1);
+}
+
+/**
+ * @brief Instante de la primera foto del historial.
+ */
+QDateTime InventoryManager::historyStart()
+{
+    QSqlQuery query(readerDatabase());
+    if (query.exec("SELECT MIN(ts) FROM inventario_fotos_indice") && query.next()
+        && !query.value(0).isNull()) {
+        return QDateTime::fromSecsSinceEpoch(query.value(0).toLongLong());
+    }
+    return QDateTime();
+}
+
+/**
+ * @brief Guarda una foto de todas las cantidades actuales.
+ *
+ * La foto y la posición del historial que representa (el último delta)
+ * se escriben en la misma transacción, así que coinciden exactamente.
+ */
+bool InventoryManager::takeKeyframe()
+{
+    return runWrite([this] {
+        QSqlQuery query(db);
+        if (!query.exec("INSERT INTO inventario_fotos_indice (ts, seq, filas) "
+                        "SELECT CAST(strftime('%s', 'now') AS INTEGER), "
+                        "(SELECT COALESCE(MAX(seq), 0) FROM inventario_historial), "
+                        "(SELECT COUNT(*) FROM inventario)")) {
+            qDebug() << "Fallo al registrar la foto del inventario:" << query.lastError();
+            return false;
+        }
+        const qint64 foto = query.lastInsertId().toLongLong();
+
+        query.prepare("INSERT INTO inventario_fotos (foto, item_id, cantidad) "
+                      "SELECT ?, id, cantidad FROM inventario");
+        query.addBindValue(foto);
+        if (!query.exec()) {
+            qDebug() << "Fallo al guardar la foto del inventario:" << query.lastError();
+            return false;
+        }
+        return true;
+    }, AfterWrite::Nothing);
+}
+
+/**
+ * @brief Cuenta deltas y fotos y mide su espacio con la tabla virtual dbstat.
+ */
+HistoryStats InventoryManager::historyStats()
+{
+    HistoryStats result = hstats;
+    QSqlQuery query(readerDatabase());
+    if (query.exec("SELECT (SELECT COALESCE(MAX(seq), 0) FROM inventario_historial), "
+                   "COUNT(*), COALESCE(SUM(filas), 0) FROM inventario_fotos_indice")
+        && query.next()) {
+        result.changes = query.value(0).toLongLong();
+        result.keyframes = query.value(1).toLongLong();
+        result.keyframeRows = query.value(2).toLongLong();
+    }
+
+    // dbstat solo existe si SQLite se compiló con SQLITE_ENABLE_DBSTAT_VTAB
+    if (query.exec("SELECT name, SUM(pgsize) FROM dbstat WHERE name IN "
+                   "('inventario_historial', 'inventario_fotos', 'inventario_fotos_indice') "
+                   "GROUP BY name")) {
+        result.deltaBytes = 0;
+        result.keyframeBytes = 0;
+        while (query.next()) {
+            if (query.value(0).toString() == "inventario_historial") {
+                result.deltaBytes += query.value(1).toLongLong();
+            } else {
+                result.keyframeBytes += query.value(1).toLongLong();
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Visita los movimientos de cantidad desde un instante.
+ *
+ * inventario_historial no tiene índice por fecha; como seq y ts crecen
+ * juntos, el recorrido empieza en el seq de la última foto anterior a
+ * @p since (un rango sobre la clave primaria) y filtra por ts desde ahí.
+ *
+ * @param since Primer instante a incluir.
+ * @param visit Recibe ID, marca de tiempo (segundos UTC) y delta.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::forEachQuantityChange(const QDateTime &since, const ChangeVisitor &visit)
+{
+    QSqlDatabase reader = readerDatabase();
+    sqlite3 *handle = DatabaseManager::nativeHandle(reader);
+    if (!handle) {
+        qDebug() << "El historial necesita una conexión SQLite.";
+        return false;
+    }
+    const bool snapshot = (reader.connectionName() != db.connectionName())
+                          && reader.transaction();
+
+    const qint64 ts = since.toSecsSinceEpoch();
+    const bool ok = runNative(diagnostics, handle,
+                              "SELECT item_id, ts, delta FROM inventario_historial "
+                              "WHERE seq > (SELECT COALESCE(MAX(seq), 0) FROM inventario_fotos_indice WHERE ts < ?) "
+                              "AND ts >= ? AND evento = 0 ORDER BY seq",
+                              [ts](sqlite3_stmt *stmt) {
+                                  sqlite3_bind_int64(stmt, 1, ts);
+                                  sqlite3_bind_int64(stmt, 2, ts);
+                              },
+                              [&visit](sqlite3_stmt *stmt) {
+                                  visit(sqlite3_column_int(stmt, 0), sqlite3_column_int64(stmt, 1),
+                                        sqlite3_column_int(stmt, 2));
+                                  return true;
+                              });
+
+    if (snapshot) {
+        reader.commit();
+    }
+    return ok;
+}
+
+/**
+ * @brief Toma una foto cuando los deltas desde la última superan al número de ítems.
+ *
+ * Así el espacio de las fotos queda acotado por el de los deltas y una
+ * reconstrucción lee una foto y, como mucho, otros tantos deltas. Lo
+ * llama runWrite tras cada escritura confirmada; la comprobación son dos
+ * búsquedas por clave.
+ */
+void InventoryManager::maybeTakeKeyframe()
+{
+    QSqlQuery query(db);
+    if (!query.exec("SELECT (SELECT COALESCE(MAX(seq), 0) FROM inventario_historial), "
+                    "seq, filas FROM inventario_fotos_indice ORDER BY foto DESC LIMIT 1")
+        || !query.next()) {
+        return;
+    }
+    const qint64 pending = query.value(0).toLongLong() - query.value(1).toLongLong();
+    const qint64 rows = query.value(2).toLongLong();
+    query.finish();
+
+    if (pending >= qMax(kMinKeyframeChanges, rows)) {
+        takeKeyframe();
+    }
+}
+
+/**
+ * @brief Cantidades en el instante ts: última foto anterior más los deltas siguientes.
+ *
+ * Solo se leen los deltas entre esa foto y la siguiente (la siguiente ya
+ * es posterior a ts), así que el costo no depende del largo del
+ * historial. Todo corre en la conexión de lectura, dentro de una
+ * instantánea.
+ *
+ * @param ts Segundos desde la época (UTC).
+ * @param onlyId Si es distinto de cero, solo se reconstruye ese ítem.
+ * @param quantities Recibe ID -> cantidad de los ítems que existían.
+ * @return false si no hay ninguna foto anterior a ts o la lectura falló.
+ */
+bool InventoryManager::replayHistory(qint64 ts, int onlyId, QHash<int, int> &quantities)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlDatabase reader = readerDatabase();
+    sqlite3 *handle = DatabaseManager::nativeHandle(reader);
+    if (!handle) {
+        qDebug() << "El historial necesita una conexión SQLite.";
+        return false;
+    }
+    const bool snapshot = (reader.connectionName() != db.connectionName())
+                          && reader.transaction();
+
+    qint64 foto = 0;
+    qint64 fromSeq = 0;
+    qint64 toSeq = std::numeric_limits<qint64>::max();
+    qint64 replayed = 0;
+
+    bool ok = runNative(diagnostics, handle,
+                        "SELECT foto, seq, filas FROM inventario_fotos_indice "
+                        "WHERE ts <= ? ORDER BY foto DESC LIMIT 1",
+                        [ts](sqlite3_stmt *stmt) { sqlite3_bind_int64(stmt, 1, ts); },
+                        [&](sqlite3_stmt *stmt) {
+                            foto = sqlite3_column_int64(stmt, 0);
+                            fromSeq = sqlite3_column_int64(stmt, 1);
+                            if (!onlyId) {
+                                quantities.reserve(sqlite3_column_int(stmt, 2));
+                            }
+                            return false;
+                        });
+    ok = ok && foto > 0;
+
+    ok = ok && runNative(diagnostics, handle,
+                         "SELECT seq FROM inventario_fotos_indice WHERE foto > ? ORDER BY foto LIMIT 1",
+                         [foto](sqlite3_stmt *stmt) { sqlite3_bind_int64(stmt, 1, foto); },
+                         [&toSeq](sqlite3_stmt *stmt) {
+                             toSeq = sqlite3_column_int64(stmt, 0);
+                             return false;
+                         });
+
+    const QString itemFilter = onlyId ? " AND item_id = ?" : "";
+    // La marca de reemplazo (evento 3) afecta a todos los ítems
+    const QString deltaFilter = onlyId ? " AND (item_id = ? OR evento = 3)" : "";
+    ok = ok && runNative(diagnostics, handle,
+                         "SELECT item_id, cantidad FROM inventario_fotos WHERE foto = ?" + itemFilter,
+                         [foto, onlyId](sqlite3_stmt *stmt) {
+                             sqlite3_bind_int64(stmt, 1, foto);
+                             if (onlyId) {
+                                 sqlite3_bind_int(stmt, 2, onlyId);
+                             }
+                         },
+                         [&quantities](sqlite3_stmt *stmt) {
+                             quantities.insert(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1));
+                             return true;
+                         });
+
+    ok = ok && runNative(diagnostics, handle,
+                         "SELECT item_id, delta, evento FROM inventario_historial "
+                         "WHERE seq > ? AND seq <= ? AND ts <= ?" + deltaFilter + " ORDER BY seq",
+                         [&](sqlite3_stmt *stmt) {
+                             sqlite3_bind_int64(stmt, 1, fromSeq);
+                             sqlite3_bind_int64(stmt, 2, toSeq);
+                             sqlite3_bind_int64(stmt, 3, ts);
+                             if (onlyId) {
+                                 sqlite3_bind_int(stmt, 4, onlyId);
+                             }
+                         },
+                         [&](sqlite3_stmt *stmt) {
+                             const int id = sqlite3_column_int(stmt, 0);
+                             const int delta = sqlite3_column_int(stmt, 1);
+                             switch (sqlite3_column_int(stmt, 2)) {
+                             case 1: quantities.insert(id, delta); break;
+                             case 2: quantities.remove(id); break;
+                             case 3: quantities.clear(); break;
+                             default: quantities[id] += delta; break;
+                             }
+                             replayed++;
+                             return true;
+                         });
+
+    if (snapshot) {
+        reader.commit();
+    }
+
+    hstats.lastReplayed = replayed;
+    hstats.lastReconstructNs = timer.nsecsElapsed();
+    if (!ok) {
+        quantities.clear();
+    }
+    return ok;
+}
+
+/**
+ * @brief Inserta una lista de elementos en una única transacción.
+ *
+ * Agrupar las inserciones evita un commit (y un fsync) por fila, y
+ * garantiza que la lista se guarde completa o no se guarde.
+ *
+ * @param items Elementos a insertar; el campo id se ignora.
+ *
+ * @return true si todas las filas fueron insertadas y confirmadas.
+ */
+bool InventoryManager::addItems(const QList<InventoryItem> &items)
+{
+    return runWrite([this, &items] { return insertItems(items); });
+}
+
+/**
+ * @brief Inserta o actualiza filas con su propio ID, en una transacción.
+ *
+ * Las claves de búsqueda de cada fila se reescriben en la misma
+ * transacción; el registro de cambios recibe la inserción o la
+ * actualización por medio de los triggers.
+ *
+ * @param items Filas completas, con el ID que deben conservar.
+ * @return true si se escribieron todas.
+ */
+bool InventoryManager::putItems(const QList<InventoryItem> &items)
+{
+    return runWrite([this, &items] {
+        QSqlQuery query(db);
+        query.prepare(InventorySchema::upsertSql());
+        for (const InventoryItem &it : items) {
+            query.addBindValue(it.id);
+            InventorySchema::bindItem(query, it);
+
+            QueryDiagnostics::Probe probe(diagnostics, query);
+            if (!query.exec()) {
+                qDebug() << "Fallo al escribir el ítem" << it.id << ":" << query.lastError();
+                return false;
+            }
+        }
+        return writeSearchKeys(items);
+    });
+}
+
+/**
+ * @brief Identidad de esta base entre sedes.
+ * @return El número de sede, o 0 si la base no lo tiene (esquema anterior).
+ */
+qint64 InventoryManager::siteId()
+{
+    QSqlQuery query(readerDatabase());
+    if (!query.exec("SELECT sede FROM inventario_sede WHERE id = 1") || !query.next()) {
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
+
+/**
+ * @brief Origen de las filas traídas de otra sede.
+ *
+ * Las filas creadas aquí no tienen entrada: su origen es (siteId(), id).
+ *
+ * @return ID local -> origen (vacío si no hay ninguna o si falla la lectura).
+ */
+QHash<int, RowOrigin> InventoryManager::itemOrigins()
+{
+    QHash<int, RowOrigin> origins;
+    QSqlQuery query(readerDatabase());
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT item_id, sede, origen FROM inventario_origen")) {
+        qDebug() << "No se pudo leer el origen de las filas:" << query.lastError();
+        return origins;
+    }
+    while (query.next()) {
+        origins.insert(query.value(0).toInt(), {query.value(1).toLongLong(), query.value(2).toInt()});
+    }
+    return origins;
+}
+
+/**
+ * @brief Inserta filas de otra sede con un ID nuevo y anota su origen.
+ *
+ * @param items Filas tal como están en la otra sede (su ID se ignora).
+ * @param origins Origen de cada fila, en el mismo orden.
+ * @return true si se escribieron todas.
+ */
+bool InventoryManager::importItems(const QList<InventoryItem> &items, const QList<RowOrigin> &origins)
+{
+    if (items.size() != origins.size()) {
+        qDebug() << "importItems: cada fila necesita su origen.";
+        return false;
+    }
+    return runWrite([this, &items, &origins] {
+        QList<int> ids;
+        if (!insertItems(items, &ids)) {
+            return false;
+        }
+
+        QSqlQuery query(db);
+        query.prepare("INSERT OR REPLACE INTO inventario_origen (item_id, sede, origen) VALUES (?, ?, ?)");
+        for (int i = 0; i < ids.size(); i++) {
+            query.addBindValue(ids.at(i));
+            query.addBindValue(origins.at(i).sede);
+            query.addBindValue(origins.at(i).id);
+            if (!query.exec()) {
+                qDebug() << "Fallo al anotar el origen del ítem" << ids.at(i) << ":" << query.lastError();
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+/**
+ * @brief Resumen de cada fila en la última sincronización con una sede.
+ *
+ * @param peer Sede con la que se sincronizó.
+ * @return Origen de la fila -> resumen que tenía en las dos bases.
+ */
+QHash<RowOrigin, quint64> InventoryManager::syncedDigests(qint64 peer)
+{
+    QHash<RowOrigin, quint64> digests;
+    QSqlQuery query(readerDatabase());
+    query.setForwardOnly(true);
+    query.prepare("SELECT sede, origen, resumen FROM inventario_sincronizado WHERE par = ?");
+    query.addBindValue(peer);
+    if (!query.exec()) {
+        qDebug() << "No se pudo leer el estado de la última sincronización:" << query.lastError();
+        return digests;
+    }
+    while (query.next()) {
+        digests.insert({query.value(0).toLongLong(), query.value(1).toInt()},
+                       quint64(query.value(2).toLongLong()));
+    }
+    return digests;
+}
+
+/**
+ * @brief Anota el resumen sincronizado de algunas filas y olvida el de otras.
+ *
+ * @param peer Sede con la que se sincronizó.
+ * @param digests Origen -> resumen que las dos bases tienen ahora.
+ * @param forget Filas que ya no están en ninguna de las dos.
+ * @return true si se escribió todo (en una sola transacción).
+ */
+bool InventoryManager::setSyncedDigests(qint64 peer, const QHash<RowOrigin, quint64> &digests,
+                                        const QList<RowOrigin> &forget)
+{
+    if (digests.isEmpty() && forget.isEmpty()) {
+        return true;
+    }
+    return runWrite([this, peer, &digests, &forget] {
+        QSqlQuery query(db);
+        query.prepare("INSERT OR REPLACE INTO inventario_sincronizado (par, sede, origen, resumen) "
+                      "VALUES (?, ?, ?, ?)");
+        for (auto it = digests.cbegin(); it != digests.cend(); ++it) {
+            query.addBindValue(peer);
+            query.addBindValue(it.key().sede);
+            query.addBindValue(it.key().id);
+            query.addBindValue(qint64(it.value()));
+            if (!query.exec()) {
+                qDebug() << "Fallo al anotar la sincronización:" << query.lastError();
+                return false;
+            }
+        }
+
+        query.prepare("DELETE FROM inventario_sincronizado WHERE par = ? AND sede = ? AND origen = ?");
+        for (const RowOrigin &key : forget) {
+            query.addBindValue(peer);
+            query.addBindValue(key.sede);
+            query.addBindValue(key.id);
+            if (!query.exec()) {
+                qDebug() << "Fallo al anotar la sincronización:" << query.lastError();
+                return false;
+            }
+        }
+        return true;
+    }, AfterWrite::Nothing);
+}
+
+/**
+ * @brief Cambia la identidad de sede de esta base.
+ *
+ * Antes de cambiarla, las filas creadas aquí anotan su origen con la
+ * identidad anterior, de modo que siguen siendo las mismas filas para
+ * las sedes que ya las conocen.
+ *
+ * @return true si se confirmó.
+ */
+bool InventoryManager::renewSiteId()
+{
+    return runWrite([this] {
+        QSqlQuery query(db);
+        return query.exec("INSERT OR IGNORE INTO inventario_origen (item_id, sede, origen) "
+                          "SELECT id, (SELECT sede FROM inventario_sede WHERE id = 1), id "
+                          "FROM inventario")
+               && query.exec("UPDATE inventario_sede "
+                             "SET sede = (random() & 9223372036854775807) | 1 WHERE id = 1");
+    }, AfterWrite::Nothing);
+}
+
+
+/**
+ * @brief Sustituye el contenido completo de la tabla inventario.
+ *
+ * El DELETE y las inserciones se ejecutan en la misma transacción. Un
+ * lector que trabaje sobre una instantánea (por ejemplo, una exportación
+ * en curso) verá la tabla anterior completa o la nueva completa, nunca
+ * un estado intermedio.
+ *
+ * @param items Nuevo contenido de la tabla.
+ *
+ * @return true si el reemplazo fue confirmado.
+ */
+bool InventoryManager::replaceAllItems(const QList<InventoryItem> &items)
+{
+    return runWrite([this, &items] {
+        const qint64 previousSeq = maxChangeSeq();
+
+        QSqlQuery query(db);
+        if (!query.exec("DELETE FROM inventario") || !insertItems(items)
+            || !markTableReplaced(previousSeq)) {
+            qDebug() << "Fallo al reemplazar el inventario:" << query.lastError();
+            return false;
+        }
+        return true;
+    }, AfterWrite::ResetTracking);
+}
+
+
+/**
+ * @brief Pasa a la copia de la plantilla lo que la restauración conserva.
+ *
+ * El historial de existencias, sus fotos y los puntos de reorden por tipo
+ * (junto con el estado de la última sincronización con cada sede)
+ * se copian de @p from a @p into tal cual: son `INSERT ... SELECT *` sobre
+ * tablas vacías y sin triggers, que SQLite resuelve copiando los registros
+ * sin decodificarlos. Después se anotan la marca de tabla reemplazada en
+ * el registro de cambios (ID 0, con una secuencia mayor que cualquiera de
+ * @p from), un único delta de reemplazo en el historial (evento 3: desde
+ * ahí no queda ningún ítem anterior) y una foto con las cantidades de la
+ * plantilla. Ningún trigger corre por fila.
+ *
+ * La base restaurada recibe además una identidad de sede nueva: los IDs
+ * de la plantilla vuelven a empezar y no deben confundirse, en otra sede,
+ * con filas anteriores a la restauración.
+ *
+ * @param handle Conexión que ve ambos esquemas.
+ * @param from Esquema de la base en uso.
+ * @param into Esquema de la copia de la plantilla.
+ * @return false si alguna sentencia falló (no queda nada a medias).
+ */
+static bool carryOverHistory(sqlite3 *handle, const QString &from, const QString &into)
+{
+    QStringList statements = {"BEGIN"};
+    for (const QString &table : {QStringLiteral("inventario_historial"),
+                                 QStringLiteral("inventario_fotos_indice"),
+                                 QStringLiteral("inventario_fotos"),
+                                 QStringLiteral("inventario_reorden_tipos"),
+                                 QStringLiteral("inventario_sincronizado")}) {
+        statements << "DELETE FROM " + into + "." + table
+                   << "INSERT INTO " + into + "." + table + " SELECT * FROM " + from + "." + table;
+    }
+    const QString now = "CAST(strftime('%s', 'now') AS INTEGER)";
+    statements
+        << "DELETE FROM " + into + ".inventario_cambios"
+        << "INSERT INTO " + into + ".inventario_cambios (seq, item_id) "
+           "SELECT COALESCE(MAX(seq), 0) + 1, 0 FROM " + from + ".inventario_cambios"
+        << "INSERT INTO " + into + ".inventario_historial (ts, item_id, delta, evento) "
+           "VALUES (" + now + ", 0, 0, 3)"
+        << "UPDATE " + into + ".inventario_sede "
+           "SET sede = (random() & 9223372036854775807) | 1 WHERE id = 1"
+        << "INSERT INTO " + into + ".inventario_fotos_indice (ts, seq, filas) "
+           "SELECT " + now + ", (SELECT MAX(seq) FROM " + into + ".inventario_historial), "
+           "(SELECT COUNT(*) FROM " + into + ".inventario)"
+        << "INSERT INTO " + into + ".inventario_fotos (foto, item_id, cantidad) "
+           "SELECT (SELECT MAX(foto) FROM " + into + ".inventario_fotos_indice), id, cantidad "
+           "FROM " + into + ".inventario"
+        << "COMMIT";
+
+    for (const QString &sql : statements) {
+        char *error = nullptr;
+        if (sqlite3_exec(handle, sql.toUtf8().constData(), nullptr, nullptr, &error) != SQLITE_OK) {
+            qDebug() << "Fallo al preparar la restauración:" << error << "en" << sql;
+            sqlite3_free(error);
+            if (!sqlite3_get_autocommit(handle)) {
+                sqlite3_exec(handle, "ROLLBACK", nullptr, nullptr, nullptr);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Adjunta un archivo a una conexión nativa con el nombre de esquema indicado.
+ */
+static bool attachNative(sqlite3 *handle, const char *file, const char *schema)
+{
+    sqlite3_stmt *stmt = nullptr;
+    const QByteArray sql = QByteArray("ATTACH DATABASE ? AS ") + schema;
+    if (sqlite3_prepare_v2(handle, sql.constData(), -1, &stmt, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo adjuntar" << file << ":" << sqlite3_errmsg(handle);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, file, -1, SQLITE_TRANSIENT);
+    const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!ok) {
+        qDebug() << "No se pudo adjuntar" << file << ":" << sqlite3_errmsg(handle);
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+/**
+ * @brief Restaura la base desde un archivo plantilla con la API de copia en línea.
+ *
+ * 1. La plantilla se copia como archivo a "<plantilla>.restaurar".
+ * 2. Se abre la copia de la plantilla sobre la base en uso
+ *    (sqlite3_backup) con un primer paso vacío: toma el bloqueo de
+ *    escritura (esperando lo que indique la conexión) sin copiar nada.
+ *    Desde ahí ninguna otra estación puede escribir, pero sí leer.
+ * 3. Con el bloqueo tomado, la copia recibe el historial, las fotos y los
+ *    puntos de reorden por tipo de la base en uso, más la marca de tabla
+ *    reemplazada y una foto nueva (@ref carryOverHistory). Los ítems, sus
+ *    claves de búsqueda y sus puntos propios son los de la plantilla.
+ * 4. El resto de la copia pasa página por página en un solo paso, que se
+ *    confirma de forma atómica: los lectores ven la base anterior o la
+ *    restaurada, nunca una mezcla.
+ *
+ * No corre ningún trigger por fila ni se reescriben los ítems uno a uno:
+ * el costo es el de copiar las páginas de la plantilla y del historial.
+ * En modo en memoria no hay otras conexiones, así que el paso 3 se hace
+ * antes de copiar, desde la propia conexión.
+ *
+ * La conexión no debe tener una transacción ni consultas abiertas: no se
+ * puede llamar desde otra escritura (writeAtomically, writeBatch).
+ *
+ * @param templatePath Archivo plantilla construido con @ref buildTemplate.
+ *
+ * @return true si la restauración fue confirmada.
+ */
+bool InventoryManager::restoreFromTemplate(const QString &templatePath)
+{
+    sqlite3 *live = DatabaseManager::nativeHandle(db);
+    if (!live) {
+        qDebug() << "La restauración necesita una conexión SQLite.";
+        return false;
+    }
+    if (!sqlite3_get_autocommit(live)) {
+        qDebug() << "No se puede restaurar dentro de otra transacción.";
+        return false;
+    }
+    if (!QFile::exists(templatePath)) {
+        qDebug() << "No existe la plantilla:" << templatePath;
+        return false;
+    }
+
+    const QString stagingPath = templatePath + ".restaurar";
+    QFile::remove(stagingPath);
+    if (!QFile::copy(templatePath, stagingPath)) {
+        qDebug() << "No se pudo copiar la plantilla a" << stagingPath;
+        return false;
+    }
+
+    sqlite3 *staging = nullptr;
+    bool ok = sqlite3_open_v2(stagingPath.toUtf8().constData(), &staging,
+                              SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK;
+    if (!ok) {
+        qDebug() << "No se pudo abrir la copia de la plantilla:" << sqlite3_errmsg(staging);
+    }
+
+    const char *liveFile = sqlite3_db_filename(live, "main");
+    const bool onDisk = liveFile && *liveFile;
+    sqlite3_backup *backup = nullptr;
+
+    if (ok && onDisk) {
+        backup = sqlite3_backup_init(live, "main", staging, "main");
+        const int rc = backup ? sqlite3_backup_step(backup, 0) : SQLITE_ERROR;
+        ok = (rc == SQLITE_OK);
+        if (!ok) {
+            qDebug() << "No se pudo tomar el bloqueo para restaurar:" << sqlite3_errstr(rc);
+        }
+        ok = ok && attachNative(staging, liveFile, "actual");
+        if (ok) {
+            ok = carryOverHistory(staging, "actual", "main");
+            sqlite3_exec(staging, "DETACH DATABASE actual", nullptr, nullptr, nullptr);
+        }
+    } else if (ok) {
+        const QByteArray stagingFile = stagingPath.toUtf8();
+        ok = attachNative(live, stagingFile.constData(), "restaurar");
+        if (ok) {
+            ok = carryOverHistory(live, "main", "restaurar");
+            sqlite3_exec(live, "DETACH DATABASE restaurar", nullptr, nullptr, nullptr);
+        }
+        backup = ok ? sqlite3_backup_init(live, "main", staging, "main") : nullptr;
+        ok = ok && backup;
+    }
+
+    if (ok) {
+        const int rc = sqlite3_backup_step(backup, -1);
+        ok = (rc == SQLITE_DONE);
+        if (!ok) {
+            qDebug() << "La copia de la plantilla se detuvo:" << sqlite3_errstr(rc);
+        }
+    }
+    // Sin terminar, finish suelta el bloqueo y la base queda como estaba
+    if (backup) {
+        sqlite3_backup_finish(backup);
+    }
+    sqlite3_close(staging);
+    QFile::remove(stagingPath);
+
+    if (!ok) {
+        return false;
+    }
+
+    // Las demás estaciones encontrarán la marca en su próxima revisión
+    resetChangeTracking();
+    return true;
+}
+
+/**
+ * @brief Genera un archivo plantilla con los ítems indicados.
+ *
+ * Se usa una conexión propia y temporal, así que puede llamarse con la
+ * aplicación en marcha sin tocar la conexión principal.
+ *
+ * @param templatePath Ruta final de la plantilla.
+ * @param items Contenido de la tabla inventario en la plantilla.
+ *
+ * @return true si la plantilla quedó escrita en @p templatePath.
+ */
+bool InventoryManager::buildTemplate(const QString &templatePath,
+                                     const QList<InventoryItem> &items)
+{
+    const QString tempPath = templatePath + ".tmp";
+    const QString connection = "inventario_plantilla";
+    bool ok = false;
+
+    QFile::remove(tempPath);
+    {
+        QSqlDatabase tdb = QSqlDatabase::addDatabase("QSQLITE", connection);
+        tdb.setDatabaseName(tempPath);
+
+        if (tdb.open()) {
+            // La restauración copia las páginas de la plantilla: la base en
+            // uso hereda este modo y debe seguir con vacuum incremental
+            QSqlQuery(tdb).exec("PRAGMA auto_vacuum = INCREMENTAL");
+            InventoryManager builder(tdb);
+            ok = builder.createTable() && builder.addItems(items);
+            tdb.close();
+        } else {
+            qDebug() << "No se pudo crear la plantilla:" << tdb.lastError();
+        }
+    }
+    QSqlDatabase::removeDatabase(connection);
+
+    if (!ok) {
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    QFile::remove(templatePath);
+    return QFile::rename(tempPath, templatePath);
+}
+
+/**
+ * @brief Aplica movimientos de stock acumulados en una sola transacción.
+ *
+ * Pensado para la ingesta de escáneres: los eventos ya vienen agrupados
+ * por ítem, así que cada ID recibe un único UPDATE relativo y todo el
+ * lote se confirma con un solo commit.
+ *
+ * @param deltas Mapa ID -> variación de cantidad (positiva o negativa).
+ *
+ * @return true si el lote completo fue confirmado.
+ */
+bool InventoryManager::applyQuantityDeltas(const QHash<int, int> &deltas)
+{
+    if (deltas.isEmpty()) {
+        return true;
+    }
+    return runWrite([this, &deltas] { return writeQuantityDeltas(deltas); });
+}
+
+/**
+ * @brief Encola movimientos de stock para confirmarlos en lote.
+ *
+ * Los movimientos se suman por ID con los que ya estaban en cola (los que
+ * se anulan no generan escritura) y se confirman juntos en la próxima
+ * transacción: al volver al bucle de eventos, en @ref flushWrites o antes
+ * de cualquier otra escritura, que los incluye en su misma transacción.
+ * Mientras otra estación tiene tomado el bloqueo de escritura, los
+ * movimientos siguen acumulándose y se escriben todos en un solo commit.
+ *
+ * @param deltas Mapa ID -> variación de cantidad.
+ */
+void InventoryManager::queueQuantityDeltas(const QHash<int, int> &deltas)
+{
+    mergePendingDeltas(deltas);
+    scheduleFlush(0);
+}
+
+/**
+ * @brief Encola una escritura que se reintenta hasta que la base se libere.
+ *
+ * Se intenta enseguida: sin otra estación escribiendo, se confirma antes
+ * de volver, igual que una llamada directa. Si la base está bloqueada, la
+ * escritura queda en cola (en orden, detrás de las anteriores) y cada
+ * vaciado de la cola la vuelve a intentar en su propio SAVEPOINT, en la
+ * misma transacción que los movimientos en cola. Solo un error distinto
+ * de base bloqueada la hace fallar.
+ *
+ * @param op Escritura (llamadas a los métodos públicos), dueña de sus datos.
+ * @param done Se llama con el resultado de @p op al confirmarse o fallar.
+ */
+void InventoryManager::queueWrite(const WriteOp &op, const WriteDone &done)
+{
+    pendingOps.append({op, done});
+    if (inWrite) {
+        // Llamada desde otra escritura: va en la próxima transacción
+        scheduleFlush(0);
+    } else {
+        flushWrites();
+    }
+}
+
+/**
+ * @brief Escrituras de @ref queueWrite que esperan a que se libere la base.
+ */
+int InventoryManager::queuedWrites() const
+{
+    return pendingOps.size();
+}
+
+/**
+ * @brief Ejecuta varias escrituras en una sola transacción, cada una aislada.
+ *
+ * Las escrituras llaman a los métodos públicos (addItem, updateItem...);
+ * dentro del lote esos métodos no abren transacción propia. Los cambios
+ * se avisan una sola vez, al confirmar.
+ *
+ * @param ops Escrituras, en orden.
+ * @param results Resultado de cada una (opcional).
+ * @return true si la transacción se confirmó.
+ */
+bool InventoryManager::writeBatch(const QList<WriteOp> &ops, QList<bool> *results)
+{
+    QList<bool> done(ops.size(), false);
+    const bool committed = runWrite([this, &ops, &done] {
+        for (int i = 0; i < ops.size(); i++) {
+            done[i] = runIsolated(ops.at(i));
+        }
+        return true;
+    });
+
+    if (!committed) {
+        done.fill(false);
+    }
+    if (results) {
+        *results = done;
+    }
+    return committed;
+}
+
+/**
+ * @brief Ejecuta una operación larga como una sola transacción, todo o nada.
+ *
+ * La operación corre aislada en su SAVEPOINT (como cada escritura de
+ * @ref writeBatch): si retorna false, por error o porque se canceló a
+ * mitad de camino, se vuelve al punto de partida y no queda nada de lo
+ * que escribió. Las escrituras anidadas (addItems, replaceAllItems, ...)
+ * se unen a esta misma transacción.
+ *
+ * @param op Escrituras a ejecutar; retorna false para deshacerlas.
+ * @return true si op terminó bien y la transacción se confirmó.
+ */
+bool InventoryManager::writeAtomically(const WriteOp &op)
+{
+    return runWrite(op);
+}
+
+/**
+ * @brief Suma movimientos a la cola, por ID; los que quedan en cero se quitan.
+ */
+void InventoryManager::mergePendingDeltas(const QHash<int, int> &deltas)
+{
+    for (auto it = deltas.constBegin(); it != deltas.constEnd(); ++it) {
+        const int total = pendingDeltas.value(it.key()) + it.value();
+        if (total == 0) {
+            pendingDeltas.remove(it.key());
+        } else {
+            pendingDeltas.insert(it.key(), total);
+        }
+    }
+}
+
+/**
+ * @brief Confirma ahora los movimientos en cola.
+ *
+ * @return true si no quedaba nada en cola o el lote quedó confirmado.
+ */
+bool InventoryManager::flushWrites()
+{
+    if (pendingDeltas.isEmpty() && pendingOps.isEmpty()) {
+        return true;
+    }
+    return runWrite(nullptr);
+}
+
+/**
+ * @brief Programa un vaciado de la cola de escrituras, si no hay uno pendiente.
+ *
+ * @param delayMs Espera antes de intentarlo (0 = al volver al bucle de eventos).
+ */
+void InventoryManager::scheduleFlush(int delayMs)
+{
+    if (flushScheduled) {
+        return;
+    }
+    flushScheduled = true;
+    QTimer::singleShot(delayMs, this, [this] {
+        flushScheduled = false;
+        flushWrites();
+    });
+}
+
+/**
+ * @brief Contadores del planificador de escrituras.
+ */
+WriteStats InventoryManager::writeStats() const
+{
+    return wstats;
+}
+
+/**
+ * @brief Reinicia los contadores del planificador de escrituras.
+ */
+void InventoryManager::resetWriteStats()
+{
+    wstats = WriteStats();
+}
+
+/**
+ * @brief UPDATE relativo de cantidad por cada ID, dentro de la transacción en curso.
+ *
+ * @param deltas Mapa ID -> variación de cantidad; la cantidad no baja de cero.
+ * @return true si todos los UPDATE se ejecutaron.
+ */
+bool InventoryManager::writeQuantityDeltas(const QHash<int, int> &deltas)
+{
+    QSqlQuery query(db);
+    query.prepare("UPDATE inventario SET cantidad = MAX(cantidad + ?, 0) WHERE id = ?");
+
+    for (auto it = deltas.constBegin(); it != deltas.constEnd(); ++it) {
+        query.addBindValue(it.value());
+        query.addBindValue(it.key());
+
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        if (!query.exec()) {
+            qDebug() << "Fallo al aplicar movimiento al ítem" << it.key() << ":" << query.lastError();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Indica si un error de SQLite es de base bloqueada (SQLITE_BUSY o SQLITE_LOCKED).
+ *
+ * Se compara el código primario, de modo que también cubre los
+ * extendidos (por ejemplo, SQLITE_BUSY_SNAPSHOT).
+ */
+static bool isLockError(const QSqlError &error)
+{
+    bool ok = false;
+    const int code = error.nativeErrorCode().toInt(&ok) & 0xff;
+    return ok && (code == SQLITE_BUSY || code == SQLITE_LOCKED);
+}
+
+/**
+ * @brief Ejecuta una sentencia de control de transacción (BEGIN, COMMIT, SAVEPOINT...).
+ *
+ * @param sql Sentencia.
+ * @param busy Se pone en true si falló porque la base estaba bloqueada.
+ * @return true si se ejecutó.
+ */
+bool InventoryManager::execControl(const QString &sql, bool *busy)
+{
+    QSqlQuery query(db);
+    if (query.exec(sql)) {
+        return true;
+    }
+    if (busy) {
+        *busy = isLockError(query.lastError());
+    }
+    if (!busy || !*busy) {
+        qDebug() << "Fallo en" << sql << ":" << query.lastError();
+    }
+    return false;
+}
+
+/**
+ * @brief Ejecuta BEGIN IMMEDIATE o COMMIT esperando a lo sumo @ref kBusySliceMs.
+ *
+ * Al terminar vuelve al busy_timeout propio de la conexión.
+ */
+bool InventoryManager::execLockControl(const QString &sql, bool *busy)
+{
+    sqlite3 *handle = DatabaseManager::nativeHandle(db);
+    if (handle) {
+        sqlite3_busy_timeout(handle, kBusySliceMs);
+    }
+    const bool ok = execControl(sql, busy);
+    if (handle) {
+        sqlite3_busy_timeout(handle, statementBusyMs);
+    }
+    return ok;
+}
+
+/**
+ * @brief Escrituras del proceso que están intentando BEGIN IMMEDIATE.
+ */
+static std::atomic<int> writersWaiting{0};
+
+/**
+ * @brief Escrituras de este proceso (de cualquier conexión) que esperan el bloqueo.
+ */
+int InventoryManager::waitingWriters()
+{
+    return writersWaiting.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Indica si el hilo actual puede dormir entre intentos de escritura.
+ *
+ * El hilo de una aplicación con interfaz no duerme: ahí solo se espera el
+ * tramo corto de SQLite en cada intento, y lo que quede en cola se
+ * reintenta con un temporizador.
+ */
+static bool maySleepBetweenAttempts()
+{
+    const QCoreApplication *app = QCoreApplication::instance();
+    return !app || QThread::currentThread() != app->thread()
+           || !app->inherits("QGuiApplication");
+}
+
+/**
+ * @brief Ejecuta una escritura dentro de su propio SAVEPOINT.
+ *
+ * Si la escritura falla se deshace solo lo suyo, sin afectar al resto
+ * de las escrituras agrupadas en la misma transacción.
+ */
+bool InventoryManager::runIsolated(const WriteOp &op)
+{
+    if (!execControl("SAVEPOINT escritura")) {
+        return false;
+    }
+    if (op()) {
+        return execControl("RELEASE escritura");
+    }
+    execControl("ROLLBACK TO escritura");
+    execControl("RELEASE escritura");
+    return false;
+}
+
+/**
+ * @brief Planificador de escrituras: transacción inmediata, reintentos y lotes.
+ *
+ * Toda escritura pasa por aquí. La transacción se abre con
+ * `BEGIN IMMEDIATE`, que toma el bloqueo de escritura al empezar: si otra
+ * estación lo tiene, el fallo llega antes de haber hecho nada (un BEGIN
+ * diferido fallaría a mitad de camino, al querer escribir sobre una
+ * instantánea ya vieja, sin que esperar sirva de nada). Cada intento
+ * espera a lo sumo @ref kBusySliceMs dentro de SQLite; si la base sigue
+ * bloqueada se reintenta con espera exponencial y aleatoria (para que
+ * varios procesos no vuelvan a chocar al mismo tiempo), hasta
+ * @ref kMaxWriteAttempts intentos. En el hilo de la interfaz no se duerme:
+ * se hacen a lo sumo @ref kMaxGuiWriteAttempts intentos seguidos.
+ *
+ * En la misma transacción se confirman primero los movimientos en cola
+ * (@ref queueQuantityDeltas), luego las escrituras en cola
+ * (@ref queueWrite) y por último @p op, cada uno en su SAVEPOINT. Si se
+ * agotan los intentos con la base bloqueada, lo que estaba en cola vuelve
+ * a la cola y se reintenta más tarde; @p op se informa como fallida.
+ *
+ * Dentro de una escritura en curso (llamada anidada) se ejecuta @p op
+ * directamente; su @p after se guarda y la llamada de afuera aplica el
+ * más fuerte de los pedidos al confirmar.
+ *
+ * @param op Escritura a ejecutar (sin transacción propia), o nullptr para
+ *        solo vaciar la cola.
+ * @param after Qué avisar tras confirmar: cambios fila por fila, recarga
+ *        completa o nada.
+ * @return Resultado de @p op (o de la cola, si @p op es nullptr).
+ */
+bool InventoryManager::runWrite(const WriteOp &op, AfterWrite after)
+{
+    if (inWrite) {
+        nestedAfter = std::max(nestedAfter, after);
+        return op ? op() : true;
+    }
+
+    const bool maySleep = maySleepBetweenAttempts();
+    const int maxAttempts = maySleep ? kMaxWriteAttempts : kMaxGuiWriteAttempts;
+    const QHash<int, int> queued = std::exchange(pendingDeltas, {});
+    const QList<QPair<WriteOp, WriteDone>> queuedOps = std::exchange(pendingOps, {});
+    const int operations = (op ? 1 : 0) + (queued.isEmpty() ? 0 : 1) + int(queuedOps.size());
+    QList<bool> queuedOpsOk(queuedOps.size(), false);
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 waitNs = 0;
+    bool committed = false;
+    bool busy = false;
+    bool queuedOk = queued.isEmpty();
+    bool opOk = !op;
+
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
+        if (attempt > 0) {
+            if (maySleep) {
+                // Espera exponencial con componente aleatoria en [d/2, d]
+                const int delay = qMin(kMaxBackoffMs, kBaseBackoffMs << (attempt - 1));
+                QThread::msleep(QRandomGenerator::global()->bounded(delay / 2, delay + 1));
+            }
+            wstats.retries++;
+        }
+
+        busy = false;
+        writersWaiting++;
+        const bool locked = execLockControl("BEGIN IMMEDIATE", &busy);
+        writersWaiting--;
+        if (!locked) {
+            if (busy) {
+                continue;
+            }
+            break;
+        }
+        // Todo lo transcurrido hasta tener el bloqueo cuenta como espera
+        const qint64 lockedAt = timer.nsecsElapsed();
+        waitNs = lockedAt;
+
+        inWrite = true;
+        nestedAfter = AfterWrite::Nothing;
+        queuedOk = queued.isEmpty() || runIsolated([this, &queued] { return writeQuantityDeltas(queued); });
+        for (int i = 0; i < queuedOps.size(); i++) {
+            queuedOpsOk[i] = runIsolated(queuedOps.at(i).first);
+        }
+        opOk = !op || runIsolated(op);
+        inWrite = false;
+
+        if (execLockControl("COMMIT", &busy)) {
+            committed = true;
+            wstats.transactionNs += timer.nsecsElapsed() - lockedAt;
+            break;
+        }
+        execControl("ROLLBACK");
+        if (!busy) {
+            break;
+        }
+    }
+
+    if (!committed) {
+        waitNs = timer.nsecsElapsed();
+    }
+    wstats.lockWaitNs += waitNs;
+    wstats.maxLockWaitNs = qMax(wstats.maxLockWaitNs, waitNs);
+
+    if (!committed) {
+        wstats.failures += operations;
+        if (busy) {
+            qDebug() << "Base de datos bloqueada: escritura abandonada tras"
+                     << maxAttempts << "intentos";
+        }
+        if (!queued.isEmpty()) {
+            if (busy) {
+                // Los movimientos en cola no se pierden: se reintentan más tarde
+                mergePendingDeltas(queued);
+                scheduleFlush(kMaxBackoffMs);
+            } else {
+                emit queuedWritesFailed(int(queued.size()));
+            }
+        }
+        if (!queuedOps.isEmpty()) {
+            if (busy) {
+                // Tampoco las escrituras en cola, que conservan su orden
+                pendingOps = queuedOps + pendingOps;
+                scheduleFlush(kMaxBackoffMs);
+                emit queuedWritesChanged(int(pendingOps.size()));
+            } else {
+                for (const auto &write : queuedOps) {
+                    if (write.second) {
+                        write.second(false);
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    const int queuedOpsDone = int(queuedOpsOk.count(true));
+    wstats.transactions++;
+    wstats.operations += (queuedOk && !queued.isEmpty() ? 1 : 0) + (op && opOk ? 1 : 0) + queuedOpsDone;
+    wstats.failures += (queuedOk ? 0 : 1) + (opOk ? 0 : 1) + int(queuedOps.size()) - queuedOpsDone;
+    if (!queuedOk) {
+        emit queuedWritesFailed(int(queued.size()));
+    }
+
+    after = std::max(after, nestedAfter);
+    if (after == AfterWrite::SyncChanges) {
+        syncChanges();
+    } else if (after == AfterWrite::ResetTracking) {
+        resetChangeTracking();
+    }
+    if (after != AfterWrite::Nothing) {
+        maybeTakeKeyframe();
+    }
+
+    // Las vistas ya recibieron los cambios; ahora se avisa a quien esperaba
+    if (!queuedOps.isEmpty()) {
+        emit queuedWritesChanged(int(pendingOps.size()));
+        for (int i = 0; i < queuedOps.size(); i++) {
+            if (queuedOps.at(i).second) {
+                queuedOps.at(i).second(queuedOpsOk.at(i));
+            }
+        }
+    }
+    return op ? opOk : queuedOk;
+}
+
+
+/**
+ * @brief Elimina varios elementos en una sola transacción.
+ *
+ * @param ids Identificadores a borrar.
+ *
+ * @return true si el borrado completo fue confirmado.
+ */
+bool InventoryManager::removeItems(const QList<int> &ids)
+{
+    return runWrite([this, &ids] { return execForIds("DELETE FROM inventario", {}, ids); });
+}
+
+
+/**
+ * @brief Suma el mismo delta a la cantidad de varios elementos.
+ *
+ * La cantidad resultante nunca baja de cero.
+ *
+ * @param ids Identificadores a modificar.
+ * @param delta Variación de cantidad (positiva o negativa).
+ *
+ * @return true si el ajuste completo fue confirmado.
+ */
+bool InventoryManager::adjustQuantities(const QList<int> &ids, int delta)
+{
+    return runWrite([this, &ids, delta] {
+        return execForIds("UPDATE inventario SET cantidad = MAX(cantidad + ?, 0)", {delta}, ids);
+    });
+}
+
+
+/**
+ * @brief Cambia la ubicación de varios elementos.
+ *
+ * La ubicación forma parte de las claves de búsqueda, así que también
+ * se regeneran las de los elementos movidos.
+ *
+ * @param ids Identificadores a mover.
+ * @param ubicacion Nueva ubicación física.
+ *
+ * @return true si la reubicación completa fue confirmada.
+ */
+bool InventoryManager::relocateItems(const QList<int> &ids, const QString &ubicacion)
+{
+    return runWrite([this, &ids, &ubicacion] {
+        return execForIds("UPDATE inventario SET ubicacion = ?", {ubicacion}, ids)
+               && writeSearchKeys(fetchItems(ids));
+    });
+}
+
+
+/**
+ * @brief Obtiene los elementos con cantidad inferior a un umbral.
+ *
+ * La consulta se hace sobre la conexión de lectura, por lo que no
+ * compite con las escrituras de la interfaz.
+ *
+ * @param threshold Cantidad mínima aceptable.
+ *
+ * @return Lista de elementos con stock bajo, ordenada por cantidad.
+ */
+QList<InventoryItem> InventoryManager::getLowStockItems(int threshold)
+{
+    QList<InventoryItem> items;
+    forEachLowStockItem(threshold, [&items](const InventoryRowView &row) {
+        items.append(row.toItem());
+        return true;
+    });
+    return items;
+}
+
+/**
+ * @brief Visita los ítems con cantidad menor al umbral, de menor a mayor.
+ *
+ * @param threshold Umbral de stock.
+ * @param visit Recibe cada fila; devuelve false para detener el recorrido.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::forEachLowStockItem(int threshold, const RowVisitor &visit)
+{
+    return visitRows("WHERE cantidad < ? ORDER BY cantidad", {threshold}, visit);
+}
+
+/**
+ * @brief Lee los puntos de reorden de ítems y tipos.
+ *
+ * Solo se guardan los puntos fijados a mano, así que la lectura es
+ * pequeña aunque la tabla tenga millones de filas.
+ *
+ * @return Puntos por ítem y por tipo, más el general.
+ */
+ReorderPoints InventoryManager::reorderPoints()
+{
+    ReorderPoints points;
+    points.fallback = reorderFallback;
+
+    QSqlQuery query(readerDatabase());
+    query.setForwardOnly(true);
+    if (query.exec("SELECT id, punto FROM inventario_reorden")) {
+        while (query.next()) {
+            points.byItem.insert(query.value(0).toInt(), query.value(1).toInt());
+        }
+    } else {
+        qDebug() << "Fallo al leer los puntos de reorden:" << query.lastError();
+    }
+    if (query.exec("SELECT tipo, punto FROM inventario_reorden_tipos")) {
+        while (query.next()) {
+            points.byTipo.insert(query.value(0).toString(), query.value(1).toInt());
+        }
+    } else {
+        qDebug() << "Fallo al leer los puntos de reorden por tipo:" << query.lastError();
+    }
+    return points;
+}
+
+/**
+ * @brief Fija (o quita) el punto de reorden de varios ítems.
+ *
+ * Los IDs que no existen en la tabla se ignoran.
+ *
+ * @param ids Ítems a modificar.
+ * @param point Nuevo punto; negativo para volver al del tipo.
+ * @return true si la transacción se confirmó.
+ */
+bool InventoryManager::setReorderPoints(const QList<int> &ids, int point)
+{
+    if (ids.isEmpty()) {
+        return true;
+    }
+    const bool ok = runWrite([this, &ids, point] {
+        if (point < 0) {
+            return execForIds("DELETE FROM inventario_reorden", {}, ids);
+        }
+        return execForIds("INSERT OR REPLACE INTO inventario_reorden (id, punto) "
+                          "SELECT id, ? FROM inventario", {point}, ids);
+    }, AfterWrite::Nothing);
+    if (ok) {
+        emit reorderPointsChanged();
+    }
+    return ok;
+}
+
+/**
+ * @brief Fija (o quita) el punto de reorden de un tipo.
+ *
+ * @param tipo Tipo, tal como está escrito en los ítems.
+ * @param point Nuevo punto; negativo para volver al general.
+ * @return true si la transacción se confirmó.
+ */
+bool InventoryManager::setTypeReorderPoint(const QString &tipo, int point)
+{
+    const bool ok = runWrite([this, &tipo, point] {
+        QSqlQuery query(db);
+        if (point < 0) {
+            query.prepare("DELETE FROM inventario_reorden_tipos WHERE tipo = ?");
+            query.addBindValue(tipo);
+        } else {
+            query.prepare("INSERT OR REPLACE INTO inventario_reorden_tipos (tipo, punto) VALUES (?, ?)");
+            query.addBindValue(tipo);
+            query.addBindValue(point);
+        }
+        if (!query.exec()) {
+            qDebug() << "Fallo al guardar el punto de reorden del tipo:" << query.lastError();
+            return false;
+        }
+        return true;
+    }, AfterWrite::Nothing);
+    if (ok) {
+        emit reorderPointsChanged();
+    }
+    return ok;
+}
+
+/**
+ * @brief Cambia el punto de reorden general (ítems sin punto propio ni de tipo).
+ */
+void InventoryManager::setDefaultReorderPoint(int point)
+{
+    if (point == reorderFallback) {
+        return;
+    }
+    reorderFallback = qMax(0, point);
+    emit reorderPointsChanged();
+}
+
+/**
+ * @brief Visita los ítems por debajo de su punto de reorden, de menor a mayor.
+ *
+ * El punto de cada fila se resuelve en la misma consulta, con una
+ * búsqueda por clave primaria en cada tabla de puntos.
+ *
+ * @param visit Recibe cada fila; devuelve false para detener el recorrido.
+ * @return false si la consulta falló.
+ */
+bool InventoryManager::forEachBelowReorderPoint(const RowVisitor &visit)
+{
+    return visitRows("WHERE cantidad < COALESCE("
+                     "(SELECT punto FROM inventario_reorden WHERE inventario_reorden.id = inventario.id), "
+                     "(SELECT punto FROM inventario_reorden_tipos WHERE inventario_reorden_tipos.tipo = inventario.tipo), "
+                     "?) ORDER BY cantidad",
+                     {reorderFallback}, visit);
+}
+
+/**
+ * @brief Lee una página ordenada por una columna usando paginación por clave.
+ *
+ * La primera página es `ORDER BY <col>, id LIMIT n`; las siguientes
+ * añaden `WHERE (<col>, id) > (valor, id)` con la última fila ya leída.
+ * SQLite resuelve ambas como un recorrido del índice
+ * `inventario_orden_<col>` que empieza en la posición buscada y se
+ * detiene a las n filas, así que el costo no depende del tamaño de la
+ * tabla ni de cuántas páginas se hayan leído. La intercalación NOCASE se
+ * indica en el valor enlazado para que coincida con la del índice.
+ *
+ * @param column Columna de ordenamiento (InventorySchema::Column).
+ * @param order Sentido; el desempate por ID sigue el mismo sentido.
+ * @param after Última fila de la página anterior, o nullptr.
+ * @param limit Filas por página.
+ * @param filter Facetas y búsqueda; se agregan al WHERE, así que la página
+ *        trae @p limit filas que lo pasan aunque estén lejos en la tabla.
+ *
+ * @return Filas de la página, en orden.
+ */
+QList<InventoryItem> InventoryManager::fetchPage(int column,
+                                                 Qt::SortOrder order,
+                                                 const InventoryItem *after,
+                                                 int limit,
+                                                 const PageFilter &filter)
+{
+    QList<InventoryItem> items;
+    if (column < 0 || column >= InventorySchema::ColumnCount) {
+        column = InventorySchema::Id;
+    }
+
+    const bool ascending = (order == Qt::AscendingOrder);
+    const QString name = InventorySchema::name(column);
+    const QString collate = InventorySchema::isNocase(column) ? " COLLATE NOCASE" : "";
+    const QString direction = ascending ? " ASC" : " DESC";
+    const QString op = ascending ? " > " : " < ";
+
+    QStringList conditions;
+    QVariantList params;
+    if (after) {
+        if (column == InventorySchema::Id) {
+            conditions.append("id" + op + "?");
+        } else {
+            conditions.append("(" + name + ", id)" + op + "(?" + collate + ", ?)");
+            params.append(InventorySchema::value(*after, column));
+        }
+        params.append(after->id);
+    }
+    const QString filtered = filterConditions(filter, params);
+    if (!filtered.isEmpty()) {
+        conditions.append(filtered);
+    }
+
+    QString suffix;
+    if (!conditions.isEmpty()) {
+        suffix += "WHERE " + conditions.join(" AND ") + " ";
+    }
+    suffix += (column == InventorySchema::Id) ? "ORDER BY id" + direction
+                            : "ORDER BY " + name + collate + direction + ", id" + direction;
+    suffix += " LIMIT ?";
+    params.append(limit);
+
+    items.reserve(limit);
+    if (!selectItems(readerDatabase(), suffix, params,
+                     [&items](InventoryItem &&row) { items.append(std::move(row)); })) {
+        qDebug() << "Fallo al leer la página";
+        items.clear();
+    }
+    return items;
+}
+
+/**
+ * @brief Filtra una lista de IDs con las mismas condiciones que @ref fetchPage.
+ *
+ * Ejecuta un `SELECT id ... WHERE id IN (...) AND <filtro>` por cada bloque
+ * de @ref kMaxIdsPerQuery IDs.
+ *
+ * @param ids IDs a comprobar.
+ * @param filter Facetas y búsqueda.
+ * @return Los IDs de @p ids que pasan el filtro, en el mismo orden.
+ */
+QList<int> InventoryManager::filterIds(const QList<int> &ids, const PageFilter &filter)
+{
+    if (filter.isEmpty()) {
+        return ids;
+    }
+
+    QSet<int> passing;
+    QSqlDatabase reader = readerDatabase();
+    for (int start = 0; start < ids.size(); start += kMaxIdsPerQuery) {
+        const int count = qMin(kMaxIdsPerQuery, int(ids.size()) - start);
+
+        QString placeholders = QString("?,").repeated(count);
+        placeholders.chop(1);
+
+        QVariantList params;
+        params.reserve(count);
+        for (int i = start; i < start + count; i++) {
+            params.append(ids.at(i));
+        }
+        const QString sql = "SELECT id FROM inventario WHERE id IN (" + placeholders + ") AND "
+                            + filterConditions(filter, params);
+
+        QSqlQuery query(reader);
+        query.setForwardOnly(true);
+        query.prepare(sql);
+        for (const QVariant &v : params) {
+            query.addBindValue(v);
+        }
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        if (!query.exec()) {
+            qDebug() << "Fallo al filtrar los IDs:" << query.lastError();
+            return {};
+        }
+        while (query.next()) {
+            passing.insert(query.value(0).toInt());
+        }
+    }
+
+    QList<int> result;
+    for (int id : ids) {
+        if (passing.contains(id)) {
+            result.append(id);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Compara dos ítems como lo hace el ORDER BY de @ref fetchPage (ascendente).
+ *
+ * @return Negativo si @p a va antes que @p b, positivo si va después, 0 si son el mismo ID.
+ */
+int InventoryManager::compareForSort(const InventoryItem &a, const InventoryItem &b, int column)
+{
+    int cmp = 0;
+    InventorySchema::forEachColumn([&](auto index, const auto &def) {
+        if (index != column || index == InventorySchema::Id) {
+            return;
+        }
+        const auto &x = a.*def.member;
+        const auto &y = b.*def.member;
+        if constexpr (std::is_same_v<std::decay_t<decltype(x)>, int>) {
+            cmp = (x > y) - (x < y);
+        } else {
+            cmp = def.nocase ? compareNocase(x, y) : QString::compare(x, y);
+        }
+    });
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a.id > b.id) - (a.id < b.id);
+}
+
+/**
+ * @brief Pliega un texto para búsqueda: sin tildes ni diferencias de mayúsculas.
+ *
+ * Descompone el texto (NFKD), descarta las marcas diacríticas y aplica
+ * plegado de mayúsculas, de modo que "Cajón", "CAJON" y "cajón" producen
+ * "cajon". Es la misma transformación para las claves guardadas y para
+ * el texto buscado.
+ *
+ * @param text Texto original.
+ * @return Texto plegado.
+ */
+QString InventoryManager::foldSearchText(const QString &text)
+{
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+
+    QString folded;
+    folded.reserve(decomposed.size());
+    for (QChar c : decomposed) {
+        if (c.category() != QChar::Mark_NonSpacing) {
+            folded.append(c);
+        }
+    }
+    return folded.toCaseFolded();
+}
+
+/**
+ * @brief Busca ítems por prefijos de palabra, sin distinguir tildes ni mayúsculas.
+ *
+ * El texto se pliega con @ref foldSearchText y se separa en palabras.
+ * Cada palabra se resuelve como un rango sobre la clave primaria de
+ * `inventario_claves` (`clave >= p AND clave < p'`) y los resultados se
+ * intersecan en la misma consulta: un ítem aparece solo si cada palabra
+ * buscada es prefijo de alguna de sus palabras (nombre, tipo, ubicación,
+ * fecha o ID). No se recorre ni se pliega ninguna celda al buscar.
+ *
+ * @param text Texto escrito por el usuario.
+ * @return IDs que coinciden; vacía si no hay coincidencias o el texto no
+ *         contiene palabras.
+ */
+QList<int> InventoryManager::searchItems(const QString &text)
+{
+    QList<int> ids;
+    const QStringList words = splitSearchWords(foldSearchText(text));
+    if (words.isEmpty()) {
+        return ids;
+    }
+
+    QVariantList params;
+    const QString sql = searchSubquery(words, params);
+
+    QSqlQuery query(readerDatabase());
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant &v : params) {
+        query.addBindValue(v);
+    }
+
+    QueryDiagnostics::Probe probe(diagnostics, query);
+    if (!query.exec()) {
+        qDebug() << "Fallo en la búsqueda:" << query.lastError();
+        return ids;
+    }
+
+    while (query.next()) {
+        ids.append(query.value(0).toInt());
+    }
+    return ids;
+}
+
+/**
+ * @brief Asigna la conexión de solo lectura usada para consultas largas.
+ *
+ * @param database Conexión abierta en modo solo lectura sobre el mismo archivo.
+ */
+void InventoryManager::setReadDatabase(QSqlDatabase database)
+{
+    readDb = database;
+}
+
+/**
+ * @brief Elige la conexión sobre la que se ejecutan las lecturas largas.
+ *
+ * @return La conexión de lectura si está abierta; de lo contrario, la principal.
+ */
+QSqlDatabase InventoryManager::readerDatabase() const
+{
+    if (readDb.isValid() && readDb.isOpen()) {
+        return readDb;
+    }
+    return db;
+}
+
+/**
+ * @brief Inserta filas reutilizando una sola sentencia preparada.
+ *
+ * No maneja transacciones; se espera que quien llama ya haya abierto una.
+ * También escribe las claves de búsqueda de cada fila insertada.
+ *
+ * @param items Elementos a insertar; el campo id se ignora.
+ *
+ * @return true si todas las inserciones fueron exitosas.
+ */
+bool InventoryManager::insertItems(const QList<InventoryItem> &items, QList<int> *ids)
+{
+    QList<InventoryItem> keyed;
+    keyed.reserve(items.size());
+
+    QSqlQuery query(db);
+    query.prepare(InventorySchema::insertSql());
+
+    for (const InventoryItem &it : items) {
+        InventorySchema::bindItem(query, it);
+
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        if (!query.exec()) {
+            qDebug() << "Fallo al insertar" << it.nombre << ":" << query.lastError();
+            return false;
+        }
+
+        InventoryItem inserted = it;
+        inserted.id = query.lastInsertId().toInt();
+        keyed.append(inserted);
+        if (ids) {
+            ids->append(inserted.id);
+        }
+    }
+    return writeSearchKeys(keyed);
+}
+
+/**
+ * @brief Aplica una sentencia a un conjunto de IDs, por bloques.
+ *
+ * Con decenas de miles de IDs, una sentencia por ID sería demasiado
+ * lenta y una sola sentencia superaría el límite de parámetros de
+ * SQLite; por eso se usan bloques de @ref kMaxIdsPerQuery. Las dos
+ * longitudes de bloque posibles (completo y resto) se preparan una vez.
+ *
+ * @param sql Sentencia sin cláusula WHERE (p. ej. "DELETE FROM inventario").
+ * @param binds Valores para los `?` de @p sql, enlazados antes de los IDs.
+ * @param ids Identificadores afectados.
+ *
+ * @return true si todos los bloques se ejecutaron sin error.
+ */
+bool InventoryManager::execForIds(const QString &sql,
+                                  const QVariantList &binds,
+                                  const QList<int> &ids)
+{
+    QSqlQuery query(db);
+    int preparedCount = -1;
+
+    for (int start = 0; start < ids.size(); start += kMaxIdsPerQuery) {
+        const int count = qMin(kMaxIdsPerQuery, int(ids.size()) - start);
+
+        if (count != preparedCount) {
+            QString placeholders = QString("?,").repeated(count);
+            placeholders.chop(1);
+            if (!query.prepare(sql + " WHERE id IN (" + placeholders + ")")) {
+                qDebug() << "No se pudo preparar la operación masiva:" << query.lastError();
+                return false;
+            }
+            preparedCount = count;
+        }
+
+        for (const QVariant &value : binds) {
+            query.addBindValue(value);
+        }
+        for (int i = start; i < start + count; i++) {
+            query.addBindValue(ids.at(i));
+        }
+
+        QueryDiagnostics::Probe probe(diagnostics, query);
+        if (!query.exec()) {
+            qDebug() << "Fallo en la operación masiva:" << query.lastError();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reescribe las claves de búsqueda de los ítems indicados.
+ *
+ * Borra las claves anteriores de cada ID e inserta las palabras plegadas
+ * de su nombre, tipo, ubicación y fecha, más el propio ID. La cantidad no
+ * se indexa: cambia con cada movimiento de stock.
+ * No maneja transacciones; se espera que quien llama ya haya abierto una.
+ *
+ * @param items Ítems con su contenido vigente (el id debe ser válido).
+ * @return true si todas las claves se escribieron.
+ */
+bool InventoryManager::writeSearchKeys(const QList<InventoryItem> &items)
+{
+    QSqlQuery remove(db);
+    QSqlQuery insert(db);
+    remove.prepare("DELETE FROM inventario_claves WHERE item_id = ?");
+    insert.prepare("INSERT OR IGNORE INTO inventario_claves (clave, item_id) VALUES (?, ?)");
+
+    for (const InventoryItem &it : items) {
+        remove.addBindValue(it.id);
+        QueryDiagnostics::Probe removeProbe(diagnostics, remove);
+        if (!remove.exec()) {
+            qDebug() << "Fallo al borrar las claves del ítem" << it.id << ":" << remove.lastError();
+            return false;
+        }
+
+        const QString text = it.nombre + ' ' + it.tipo + ' ' + it.ubicacion + ' '
+                             + it.fechaAdquisicion + ' ' + QString::number(it.id);
+        const QStringList words = splitSearchWords(foldSearchText(text));
+
+        for (const QString &word : words) {
+            insert.addBindValue(word);
+            insert.addBindValue(it.id);
+            QueryDiagnostics::Probe insertProbe(diagnostics, insert);
+            if (!insert.exec()) {
+                qDebug() << "Fallo al escribir las claves del ítem" << it.id << ":" << insert.lastError();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Regenera todas las claves de búsqueda en una transacción.
+ *
+ * Solo se usa al abrir una base (o restaurar una plantilla) creada por
+ * una versión que no tenía claves.
+ *
+ * @return true si las claves quedaron confirmadas.
+ */
+bool InventoryManager::rebuildSearchKeys()
+{
+    QList<InventoryItem> items;
+    if (!selectItems(db, QString(), {}, [&items](InventoryItem &&row) { items.append(std::move(row)); })) {
+        qDebug() << "No se pudieron leer los ítems para las claves";
+        return false;
+    }
+
+    // Las claves no pasan por el registro de cambios: no hay nada que sincronizar
+    return runWrite([this, &items] {
+        QSqlQuery query(db);
+        return query.exec("DELETE FROM inventario_claves") && writeSearchKeys(items);
+    }, AfterWrite::Nothing);
+}
+
+/**
+ * @brief Recarga el índice en memoria desde la tabla completa.
+ */
+void InventoryManager::rebuildIdIndex()
+{
+    idIndex.clear();
+
+    if (!selectItems(db, QString(), {}, [this](InventoryItem &&row) {
+            const int id = row.id;
+            idIndex.insert(id, std::move(row));
+        })) {
+        qDebug() << "No se pudo cargar el índice por ID";
+    }
+}
+
+/**
+ * @brief Revisa si otra conexión confirmó cambios y, si es así, los aplica.
+ *
+ * `PRAGMA data_version` solo cambia cuando otra conexión (otro proceso u
+ * otra estación) confirma una transacción, así que la comprobación es una
+ * consulta trivial que no lee la tabla. Pensada para llamarse con un
+ * temporizador.
+ *
+ * @return true si se detectaron cambios externos.
+ */
+bool InventoryManager::pollExternalChanges()
+{
+    if (trackingDeferred) {
+        return false;
+    }
+    const qint64 version = dataVersion();
+    if (version == lastDataVersion) {
+        return false;
+    }
+
+    lastDataVersion = version;
+    syncChanges();
+    return true;
+}
+
+/**
+ * @brief Pone en pausa el seguimiento de cambios hasta @ref startChangeTracking.
+ *
+ * Sirve para cargar los datos en segundo plano al arrancar: mientras
+ * tanto nadie recibe cambios a medias, y al retomar se emiten todos los
+ * posteriores a la posición desde la que se cargó.
+ */
+void InventoryManager::deferChangeTracking()
+{
+    trackingDeferred = true;
+}
+
+/**
+ * @brief Retoma (o empieza) el seguimiento de cambios.
+ *
+ * @param fromSeq Posición del registro desde la que se emiten cambios
+ * (los consumidores ya tienen lo anterior), o -1 para empezar desde la
+ * posición actual sin emitir nada.
+ */
+void InventoryManager::startChangeTracking(qint64 fromSeq)
+{
+    trackingDeferred = false;
+    lastDataVersion = dataVersion();
+    if (fromSeq < 0) {
+        lastChangeSeq = maxChangeSeq();
+        return;
+    }
+    lastChangeSeq = fromSeq;
+    syncChanges();
+}
+
+/**
+ * @brief Posición actual del registro de cambios (para @ref startChangeTracking).
+ */
+qint64 InventoryManager::changePosition()
+{
+    return maxChangeSeq();
+}
+
+/**
+ * @brief Procesa las entradas del registro de cambios posteriores a la última vista.
+ *
+ * Obtiene los IDs afectados, lee solo esas filas y emite
+ * @ref itemsChanged con las filas vigentes y los IDs que ya no existen.
+ * Si el registro fue recortado por delante de nuestra posición, retrocedió
+ * (restauración desde plantilla) o contiene la marca de tabla reemplazada,
+ * se emite @ref inventoryReset para que los consumidores recarguen todo.
+ */
+void InventoryManager::syncChanges()
+{
+    if (trackingDeferred) {
+        return;
+    }
+
+    QSqlQuery query(db);
+    QueryDiagnostics::Probe bounds(diagnostics, query);
+    // Dos subconsultas: MIN y MAX juntos en un solo SELECT recorren todo el registro
+    if (!query.exec("SELECT (SELECT MIN(seq) FROM inventario_cambios), "
+                    "(SELECT MAX(seq) FROM inventario_cambios)") || !query.next()
+        || query.isNull(1)) {
+        return;
+    }
+
+    const qint64 minSeq = query.value(0).toLongLong();
+    const qint64 maxSeq = query.value(1).toLongLong();
+    if (maxSeq == lastChangeSeq) {
+        return;
+    }
+    if (maxSeq < lastChangeSeq || minSeq > lastChangeSeq + 1) {
+        resetChangeTracking();
+        return;
+    }
+    bounds.finish();
+
+    query.prepare("SELECT DISTINCT item_id FROM inventario_cambios WHERE seq > ? AND seq <= ?");
+    query.addBindValue(lastChangeSeq);
+    query.addBindValue(maxSeq);
+    QueryDiagnostics::Probe changes(diagnostics, query);
+    if (!query.exec()) {
+        qDebug() << "No se pudo leer el registro de cambios:" << query.lastError();
+        return;
+    }
+
+    QList<int> ids;
+    while (query.next()) {
+        const int id = query.value(0).toInt();
+        if (id == 0) {
+            resetChangeTracking();
+            return;
+        }
+        ids.append(id);
+    }
+    changes.finish();
+    query.finish();
+
+    if (ids.size() > kMaxIncrementalIds) {
+        resetChangeTracking();
+        return;
+    }
+    lastChangeSeq = maxSeq;
+
+    const QList<InventoryItem> rows = fetchItems(ids);
+
+    QSet<int> present;
+    present.reserve(rows.size());
+    for (const InventoryItem &it : rows) {
+        present.insert(it.id);
+    }
+
+    QList<int> removed;
+    for (int id : ids) {
+        if (!present.contains(id)) {
+            removed.append(id);
+        }
+    }
+
+    if (idIndexEnabled) {
+        for (const InventoryItem &it : rows) {
+            idIndex.insert(it.id, it);
+        }
+        for (int id : removed) {
+            idIndex.remove(id);
+        }
+    }
+
+    emit itemsChanged(rows, removed);
+
+    // Recorte ocasional del registro; los clientes muy atrasados recargarán.
+    // Pasa por el planificador como cualquier escritura; si confirma también
+    // movimientos en cola, la revisión posterior los avisa
+    if (maxSeq - minSeq > 2 * kChangeLogKeep) {
+        const bool pruned = runWrite([this, maxSeq] {
+            QSqlQuery prune(db);
+            prune.prepare("DELETE FROM inventario_cambios WHERE seq <= ?");
+            prune.addBindValue(maxSeq - kChangeLogKeep);
+            if (!prune.exec()) {
+                qDebug() << "No se pudo recortar el registro de cambios:" << prune.lastError();
+                return false;
+            }
+            return true;
+        });
+        if (!pruned) {
+            qDebug() << "Registro de cambios sin recortar; se reintenta en la próxima revisión";
+        }
+    }
+}
+
+/**
+ * @brief Se posiciona al final del registro de cambios y avisa que todo cambió.
+ */
+void InventoryManager::resetChangeTracking()
+{
+    lastChangeSeq = maxChangeSeq();
+    lastDataVersion = dataVersion();
+
+    if (idIndexEnabled) {
+        rebuildIdIndex();
+    }
+    emit inventoryReset();
+}
+
+/**
+ * @brief Vacía el registro de cambios y deja solo la marca de tabla reemplazada.
+ *
+ * La marca (ID 0) lleva un número de secuencia mayor que cualquiera que
+ * hayan visto las demás estaciones, así que la encontrarán en su próxima
+ * revisión y recargarán la tabla completa.
+ *
+ * @param previousSeq Última secuencia existente antes del reemplazo.
+ * @return true si la marca quedó escrita.
+ */
+bool InventoryManager::markTableReplaced(qint64 previousSeq)
+{
+    QSqlQuery query(db);
+    if (!query.exec("DELETE FROM inventario_cambios")) {
+        return false;
+    }
+
+    query.prepare("INSERT INTO inventario_cambios (seq, item_id) VALUES (?, 0)");
+    query.addBindValue(qMax(previousSeq, maxChangeSeq()) + 1);
+    return query.exec();
+}
+
+/**
+ * @brief Última secuencia del registro de cambios (0 si está vacío).
+ */
+qint64 InventoryManager::maxChangeSeq()
+{
+    QSqlQuery query(db);
+    if (query.exec("SELECT COALESCE(MAX(seq), 0) FROM inventario_cambios") && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+/**
+ * @brief Valor actual de `PRAGMA data_version` en la conexión principal.
+ */
+qint64 InventoryManager::dataVersion()
+{
+    QSqlQuery query(db);
+    if (query.exec("PRAGMA data_version") && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+/**
+ * @brief Lee de la base las filas de los IDs indicados, sin pasar por el índice.
+ *
+ * Ejecuta un `SELECT ... WHERE id IN (...)` por cada bloque de
+ * @ref kMaxIdsPerQuery IDs.
+ *
+ * @param ids Identificadores buscados.
+ * @return Filas encontradas, en el orden de @p ids.
+ */
+QList<InventoryItem> InventoryManager::fetchItems(const QList<int> &ids)
+{
+    QHash<int, InventoryItem> found;
+    found.reserve(ids.size());
+
+    for (int start = 0; start < ids.size(); start += kMaxIdsPerQuery) {
+        const int count = qMin(kMaxIdsPerQuery, int(ids.size()) - start);
+
+        QString placeholders = QString("?,").repeated(count);
+        placeholders.chop(1);
+
+        QVariantList params;
+        params.reserve(count);
+        for (int i = start; i < start + count; i++) {
+            params.append(ids.at(i));
+        }
+
+        if (!selectItems(db, "WHERE id IN (" + placeholders + ")", params, [&found](InventoryItem &&row) {
+                const int id = row.id;
+                found.insert(id, std::move(row));
+            })) {
+            qDebug() << "Fallo en la búsqueda por lote";
+            break;
+        }
+    }
+
+    QList<InventoryItem> items;
+    items.reserve(found.size());
+    for (int id : ids) {
+        auto it = found.constFind(id);
+        if (it != found.constEnd()) {
+            items.append(*it);
+        }
+    }
+    return items;
 }
@@ -0,0 +1,450 @@
+#include "InventoryModel.h"
+#include "InventorySchema.h"
+
+#include <QSet>
+#include <algorithm>
+#include <functional>
+
+/**
+ * @brief Filas que se leen por página.
+ */
+static const int kPageSize = 256;
+
+/**
+ * @brief Cambios que se aplican fila por fila.
+ *
+ * Con más cambios juntos que esto, es más barato reordenar las filas
+ * cargadas una sola vez y reconstruir el modelo.
+ */
+static const int kMaxRowByRowChanges = 64;
+
+/**
+ * @brief Constructor del modelo.
+ * @param manager Origen de las páginas.
+ * @param parent Objeto padre opcional.
+ */
+InventoryModel::InventoryModel(InventoryManager &manager, QObject *parent)
+    : QAbstractTableModel(parent), manager(manager)
+{
+    connect(&manager, &InventoryManager::reorderPointsChanged,
+            this, &InventoryModel::refreshReorderPoints);
+}
+
+/**
+ * @brief Número de filas (ítems) del modelo.
+ */
+int InventoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(items.size());
+}
+
+/**
+ * @brief Número de columnas del modelo.
+ */
+int InventoryModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(InventorySchema::ColumnCount);
+}
+
+/**
+ * @brief Valor de una celda.
+ *
+ * Cada columna se devuelve con el tipo declarado en InventorySchema: ID y
+ * Cantidad como enteros, para que se ordenen como números. Con
+ * @ref StockStatusRole se devuelve el estado ya calculado de la fila.
+ */
+QVariant InventoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= items.size()) {
+        return QVariant();
+    }
+    if (role == StockStatusRole) {
+        return int(statuses.at(index.row()));
+    }
+    if (role != Qt::DisplayRole && role != Qt::EditRole) {
+        return QVariant();
+    }
+
+    return InventorySchema::value(items.at(index.row()), index.column());
+}
+
+/**
+ * @brief Títulos de las columnas.
+ */
+QVariant InventoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    const QString title = InventorySchema::header(section);
+    return title.isEmpty() ? QVariant() : QVariant(title);
+}
+
+/**
+ * @brief Indica si quedan páginas por leer.
+ */
+bool InventoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !complete;
+}
+
+/**
+ * @brief Lee la página siguiente a la última fila cargada y la agrega al final.
+ */
+void InventoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || complete) {
+        return;
+    }
+
+    const QList<InventoryItem> page = manager.fetchPage(
+        sortColumn, sortOrder, items.isEmpty() ? nullptr : &items.last(), kPageSize, filter);
+    complete = page.size() < kPageSize;
+    if (page.isEmpty()) {
+        return;
+    }
+
+    const int first = int(items.size());
+    beginInsertRows(QModelIndex(), first, first + int(page.size()) - 1);
+    items += page;
+    for (int r = first; r < items.size(); r++) {
+        rowById.insert(items.at(r).id, r);
+        statuses.append(points.statusOf(items.at(r)));
+    }
+    endInsertRows();
+}
+
+/**
+ * @brief Cambia el orden de la tabla; el ordenamiento lo hace SQLite.
+ *
+ * @param column Columna (0-5); cualquier otro valor vuelve al orden por ID.
+ * @param order Sentido del orden.
+ */
+void InventoryModel::sort(int column, Qt::SortOrder order)
+{
+    sortColumn = (column >= 0 && column < InventorySchema::ColumnCount) ? column : int(InventorySchema::Id);
+    sortOrder = order;
+    rankOrder = false;
+    reload();
+}
+
+/**
+ * @brief Vuelve a la primera página con el orden y el filtro vigentes.
+ *
+ * En modo aproximado se leen de una vez todos los IDs encontrados (son
+ * pocos) y se dejan en orden de relevancia o de la columna elegida.
+ */
+void InventoryModel::reload()
+{
+    beginResetModel();
+    points = manager.reorderPoints();
+    if (ranked) {
+        items.clear();
+        for (InventoryItem &it : manager.getItemsByIds(rankedIds)) {
+            if (filter.facets.matches(it.tipo, it.ubicacion, it.fechaAdquisicion)) {
+                items.append(std::move(it));
+            }
+        }
+        std::sort(items.begin(), items.end(),
+                  [this](const InventoryItem &a, const InventoryItem &b) { return before(a, b); });
+        complete = true;
+    } else {
+        items = manager.fetchPage(sortColumn, sortOrder, nullptr, kPageSize, filter);
+        complete = items.size() < kPageSize;
+    }
+    rebuildRowIndex();
+    rebuildStatuses();
+    endResetModel();
+}
+
+/**
+ * @brief Filtra por texto en SQL, como InventoryManager::searchItems.
+ *
+ * Si el filtro no cambia, no se vuelve a leer.
+ *
+ * @param text Texto buscado; vacío (o solo espacios) muestra todo.
+ */
+void InventoryModel::setSearch(const QString &text)
+{
+    const QString search = text.trimmed().isEmpty() ? QString() : text;
+    if (!ranked && search == filter.search) {
+        return;
+    }
+    filter.search = search;
+    ranked = false;
+    rankOrder = false;
+    rankedIds.clear();
+    rankOf.clear();
+    reload();
+}
+
+/**
+ * @brief Muestra solo los IDs de la búsqueda aproximada, en su orden.
+ * @param ids IDs del más al menos parecido (vacía: ninguna fila).
+ */
+void InventoryModel::setRankedIds(const QList<int> &ids)
+{
+    if (ranked && ids == rankedIds) {
+        return;
+    }
+    filter.search.clear();
+    ranked = true;
+    rankOrder = true;
+    rankedIds = ids;
+    rankOf.clear();
+    rankOf.reserve(ids.size());
+    for (int i = 0; i < ids.size(); i++) {
+        rankOf.insert(ids.at(i), i);
+    }
+    reload();
+}
+
+/**
+ * @brief Cambia las facetas; se aplican en SQL (o sobre los IDs del modo aproximado).
+ */
+void InventoryModel::setFacetFilter(const FacetFilter &facets)
+{
+    filter.facets = facets;
+    reload();
+}
+
+/**
+ * @brief Aplica altas, bajas y modificaciones sobre las filas cargadas.
+ *
+ * - Bajas, y filas que dejan de pasar el filtro: se quitan si estaban cargadas.
+ * - Modificaciones que no cambian la posición: dataChanged solo para esa fila.
+ * - Altas y modificaciones que mueven la fila: se insertan en su posición
+ *   si cae dentro del tramo cargado; si no, se omiten (llegarán con su página).
+ * - El índice ID -> fila se reconstruye una vez por lote, no por fila.
+ * - Con muchos cambios juntos, se reordena lo cargado una vez y se
+ *   reconstruye el modelo, sin volver a consultar.
+ *
+ * @param changedRows Filas nuevas o modificadas.
+ * @param removedIds IDs eliminados.
+ */
+void InventoryModel::applyChanges(const QList<InventoryItem> &changedRows, const QList<int> &removedIds)
+{
+    // Con filtro, las filas que ya no lo pasan cuentan como bajas
+    QList<InventoryItem> rows = changedRows;
+    QList<int> gone = removedIds;
+    if (ranked || !filter.isEmpty()) {
+        const QSet<int> accepted = acceptedIds(changedRows);
+        rows.clear();
+        for (const InventoryItem &it : changedRows) {
+            if (accepted.contains(it.id)) {
+                rows.append(it);
+            } else {
+                gone.append(it.id);
+            }
+        }
+    }
+
+    if (rows.size() + gone.size() > kMaxRowByRowChanges) {
+        QSet<int> changed(gone.cbegin(), gone.cend());
+        for (const InventoryItem &it : rows) {
+            changed.insert(it.id);
+        }
+
+        QList<InventoryItem> kept;
+        kept.reserve(items.size() + rows.size());
+        for (const InventoryItem &it : items) {
+            if (!changed.contains(it.id)) {
+                kept.append(it);
+            }
+        }
+        for (const InventoryItem &it : rows) {
+            if (withinLoaded(it)) {
+                kept.append(it);
+            }
+        }
+        std::sort(kept.begin(), kept.end(),
+                  [this](const InventoryItem &a, const InventoryItem &b) { return before(a, b); });
+
+        beginResetModel();
+        items = std::move(kept);
+        rebuildRowIndex();
+        rebuildStatuses();
+        endResetModel();
+        return;
+    }
+
+    // Cada cambio se ubica primero con el índice vigente. Después se borra
+    // de la última fila a la primera (así las anteriores no se mueven) y se
+    // inserta; el índice ID -> fila se reconstruye una sola vez, al final
+    QList<int> doomed;
+    for (int id : gone) {
+        const int row = rowOfId(id);
+        if (row >= 0) {
+            doomed.append(row);
+        }
+    }
+
+    QList<InventoryItem> arrivals;
+    for (const InventoryItem &it : rows) {
+        const int row = rowOfId(it.id);
+        if (row >= 0) {
+            const bool inPlace = (row == 0 || before(items.at(row - 1), it))
+                                 && (row == items.size() - 1 || before(it, items.at(row + 1)));
+            if (inPlace) {
+                items[row] = it;
+                statuses[row] = points.statusOf(it);
+                emit dataChanged(index(row, 0), index(row, InventorySchema::ColumnCount - 1));
+                continue;
+            }
+            doomed.append(row);
+        }
+        arrivals.append(it);
+    }
+
+    std::sort(doomed.begin(), doomed.end(), std::greater<int>());
+    doomed.erase(std::unique(doomed.begin(), doomed.end()), doomed.end());
+    for (int row : doomed) {
+        beginRemoveRows(QModelIndex(), row, row);
+        items.removeAt(row);
+        statuses.removeAt(row);
+        rowIndexDirty = true;
+        endRemoveRows();
+    }
+
+    for (const InventoryItem &it : arrivals) {
+        if (!withinLoaded(it)) {
+            continue;
+        }
+        const auto pos = std::lower_bound(items.begin(), items.end(), it,
+            [this](const InventoryItem &a, const InventoryItem &b) { return before(a, b); });
+        const int target = int(pos - items.begin());
+        beginInsertRows(QModelIndex(), target, target);
+        items.insert(target, it);
+        statuses.insert(target, points.statusOf(it));
+        rowIndexDirty = true;
+        endInsertRows();
+    }
+
+    if (rowIndexDirty) {
+        rebuildRowIndex();
+    }
+}
+
+/**
+ * @brief ID del ítem de una fila (0 si no existe).
+ */
+int InventoryModel::idAt(int row) const
+{
+    return (row >= 0 && row < items.size()) ? items.at(row).id : 0;
+}
+
+/**
+ * @brief Fila de un ID (-1 si no está en el modelo).
+ *
+ * Si se consulta a mitad de un lote de cambios (desde una señal de
+ * filas insertadas o quitadas), el índice se reconstruye antes.
+ */
+int InventoryModel::rowOfId(int id) const
+{
+    if (rowIndexDirty) {
+        rebuildRowIndex();
+    }
+    return rowById.value(id, -1);
+}
+
+/**
+ * @brief Estado de stock de una fila (Ok si no existe).
+ */
+StockStatus InventoryModel::statusAt(int row) const
+{
+    return (row >= 0 && row < statuses.size()) ? statuses.at(row) : StockStatus::Ok;
+}
+
+/**
+ * @brief Relee los puntos de reorden y avisa a la vista de los estados nuevos.
+ *
+ * Solo cambia el rol de estado, así que la vista repinta sin que el
+ * proxy vuelva a filtrar ni ordenar.
+ */
+void InventoryModel::refreshReorderPoints()
+{
+    points = manager.reorderPoints();
+    rebuildStatuses();
+    if (!items.isEmpty()) {
+        emit dataChanged(index(0, 0), index(int(items.size()) - 1, InventorySchema::ColumnCount - 1),
+                         {StockStatusRole});
+    }
+}
+
+/**
+ * @brief Compara dos ítems con el orden vigente (el mismo que usa SQL).
+ */
+bool InventoryModel::before(const InventoryItem &a, const InventoryItem &b) const
+{
+    if (rankOrder) {
+        return rankOf.value(a.id) < rankOf.value(b.id);
+    }
+    const int cmp = InventoryManager::compareForSort(a, b, sortColumn);
+    return sortOrder == Qt::AscendingOrder ? cmp < 0 : cmp > 0;
+}
+
+/**
+ * @brief IDs de las filas que pasan el filtro vigente.
+ *
+ * En modo aproximado, las que están entre los IDs encontrados y pasan
+ * las facetas; si no, las que la base acepta con el mismo WHERE de las
+ * páginas (una consulta por lote de cambios).
+ */
+QSet<int> InventoryModel::acceptedIds(const QList<InventoryItem> &rows)
+{
+    QSet<int> accepted;
+    if (ranked) {
+        for (const InventoryItem &it : rows) {
+            if (rankOf.contains(it.id) && filter.facets.matches(it.tipo, it.ubicacion, it.fechaAdquisicion)) {
+                accepted.insert(it.id);
+            }
+        }
+        return accepted;
+    }
+
+    QList<int> ids;
+    ids.reserve(rows.size());
+    for (const InventoryItem &it : rows) {
+        ids.append(it.id);
+    }
+    const QList<int> passing = manager.filterIds(ids, filter);
+    return QSet<int>(passing.cbegin(), passing.cend());
+}
+
+/**
+ * @brief Indica si un ítem cae dentro del tramo ya cargado.
+ *
+ * Las filas cargadas son siempre todas las que van antes de la última,
+ * así que basta con compararlo con ella (o, si ya no quedan páginas,
+ * cualquier ítem cae dentro).
+ */
+bool InventoryModel::withinLoaded(const InventoryItem &it) const
+{
+    return complete || (!items.isEmpty() && before(it, items.last()));
+}
+
+/**
+ * @brief Recalcula el índice ID -> fila.
+ */
+void InventoryModel::rebuildRowIndex() const
+{
+    rowIndexDirty = false;
+    rowById.clear();
+    rowById.reserve(items.size());
+    for (int r = 0; r < items.size(); r++) {
+        rowById.insert(items.at(r).id, r);
+    }
+}
+
+/**
+ * @brief Recalcula el estado de stock de todas las filas cargadas.
+ */
+void InventoryModel::rebuildStatuses()
+{
+    statuses.clear();
+    statuses.reserve(items.size());
+    for (const InventoryItem &it : items) {
+        statuses.append(points.statusOf(it));
+    }
+}
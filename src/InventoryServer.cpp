@@ -0,0 +1,546 @@
+#include "InventoryServer.h"
+#include "InventoryManager.h"
+#include "InventoryProtocol.h"
+
+#include <QDebug>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QtAlgorithms>
+#include <utility>
+
+using namespace InventoryProtocol;
+
+/**
+ * @brief Bytes pendientes de envío por debajo de los cuales EXPORT lee otro tramo.
+ */
+static const int kExportChunk = 64 * 1024;
+
+/**
+ * @brief Filas por tramo de EXPORT (una consulta acotada por tramo).
+ */
+static const int kExportPageRows = 500;
+
+/**
+ * @brief Cubeta del histograma para una latencia: cuatro por potencia de dos.
+ */
+static int bucketOf(qint64 ns)
+{
+    if (ns < 4) {
+        return int(qMax<qint64>(0, ns));
+    }
+    const int lg = 63 - qCountLeadingZeroBits(quint64(ns));
+    const int sub = int((quint64(ns) >> (lg - 2)) & 3);
+    return lg * 4 + sub;
+}
+
+/**
+ * @brief Mayor latencia que cae en una cubeta.
+ */
+static qint64 bucketUpper(int bucket)
+{
+    if (bucket < 8) {
+        return bucket;
+    }
+    const int lg = bucket / 4;
+    const int sub = bucket % 4;
+    return qint64((quint64(4 + sub + 1) << (lg - 2)) - 1);
+}
+
+/**
+ * @brief Percentil aproximado: cota superior de la cubeta donde cae.
+ */
+qint64 EndpointStats::percentileNs(double p) const
+{
+    if (requests == 0) {
+        return 0;
+    }
+    const qint64 rank = qMax<qint64>(1, qint64(p * requests + 0.5));
+    qint64 seen = 0;
+    for (int b = 0; b < int(histogram.size()); b++) {
+        seen += histogram[b];
+        if (seen >= rank) {
+            return qMin(bucketUpper(b), maxNs);
+        }
+    }
+    return maxNs;
+}
+
+/**
+ * @brief Constructor: prepara la ventana de agrupación; no escucha todavía.
+ *
+ * @param manager Capa de datos a exponer.
+ * @param batchWindowMs Ventana de agrupación de escrituras, en ms.
+ * @param maxBatch Tamaño de lote que se confirma sin esperar la ventana.
+ * @param parent Objeto padre opcional.
+ */
+InventoryServer::InventoryServer(InventoryManager &manager,
+                                 int batchWindowMs,
+                                 int maxBatch,
+                                 QObject *parent)
+    : QObject(parent),
+      manager(manager),
+      maxBatchSize(qMax(1, maxBatch))
+{
+    for (int e = 0; e < EndpointCount; e++) {
+        endpoints[e].name = endpointName(e);
+    }
+    clock.start();
+
+    batchTimer.setSingleShot(true);
+    batchTimer.setInterval(qMax(0, batchWindowMs));
+    connect(&batchTimer, &QTimer::timeout, this, &InventoryServer::flushWrites);
+}
+
+/**
+ * @brief Destructor: confirma las escrituras en espera antes de cerrar.
+ */
+InventoryServer::~InventoryServer()
+{
+    flushWrites();
+}
+
+/**
+ * @brief Empieza a aceptar conexiones en la dirección y puerto indicados.
+ */
+bool InventoryServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!server) {
+        server = new QTcpServer(this);
+        connect(server, &QTcpServer::newConnection, this, &InventoryServer::onNewConnection);
+    }
+    if (!server->listen(address, port)) {
+        qDebug() << "No se pudo escuchar en" << address.toString() << port << ":" << server->errorString();
+        return false;
+    }
+    qDebug() << "Servidor de inventario escuchando en" << address.toString() << server->serverPort();
+    return true;
+}
+
+/**
+ * @brief Puerto en el que escucha (0 si no escucha).
+ */
+quint16 InventoryServer::port() const
+{
+    return server ? server->serverPort() : 0;
+}
+
+/**
+ * @brief Nombre de la operación tal como viaja en el protocolo.
+ */
+QByteArray InventoryServer::endpointName(int endpoint)
+{
+    static const char *names[EndpointCount] = {
+        "PING", "ADD", "UPDATE", "QTY", "DEL", "GET", "FIND", "EXPORT", "METRICS"
+    };
+    return endpoint >= 0 && endpoint < EndpointCount ? QByteArray(names[endpoint]) : QByteArray();
+}
+
+/**
+ * @brief Copia de las latencias por operación.
+ */
+QList<EndpointStats> InventoryServer::endpointStats() const
+{
+    return QList<EndpointStats>(endpoints.begin(), endpoints.end());
+}
+
+/**
+ * @brief Copia de los contadores generales.
+ */
+ServerStats InventoryServer::stats() const
+{
+    return counters;
+}
+
+/**
+ * @brief Reinicia latencias y contadores; conserva el número de conexiones.
+ */
+void InventoryServer::resetStats()
+{
+    const int connections = counters.connections;
+    counters = ServerStats();
+    counters.connections = connections;
+    for (int e = 0; e < EndpointCount; e++) {
+        endpoints[e] = EndpointStats();
+        endpoints[e].name = endpointName(e);
+    }
+}
+
+/**
+ * @brief Resumen de texto: lotes de escritura y latencias por operación.
+ */
+QString InventoryServer::report() const
+{
+    QString text = QString("Servidor: %1 conexiones, %2 solicitudes, %3 lotes de escritura "
+                           "(%4 escrituras, media %5 por lote, máx %6), %7 errores de protocolo\n")
+                       .arg(counters.connections)
+                       .arg(counters.requests)
+                       .arg(counters.batches)
+                       .arg(counters.batchedWrites)
+                       .arg(counters.batches ? double(counters.batchedWrites) / counters.batches : 0.0, 0, 'f', 1)
+                       .arg(counters.maxBatch)
+                       .arg(counters.protocolErrors);
+
+    for (const EndpointStats &e : endpoints) {
+        if (e.requests == 0) {
+            continue;
+        }
+        text += QString("  %1 %2 solicitudes, %3 errores, media %4 us, p50 %5 us, p99 %6 us, máx %7 us\n")
+                    .arg(QString::fromLatin1(e.name).leftJustified(8))
+                    .arg(e.requests, 8)
+                    .arg(e.errors)
+                    .arg(e.totalNs / 1e3 / e.requests, 0, 'f', 1)
+                    .arg(e.percentileNs(0.50) / 1e3, 0, 'f', 1)
+                    .arg(e.percentileNs(0.99) / 1e3, 0, 'f', 1)
+                    .arg(e.maxNs / 1e3, 0, 'f', 1);
+    }
+    return text;
+}
+
+/**
+ * @brief Acepta las conexiones pendientes y conecta sus señales.
+ */
+void InventoryServer::onNewConnection()
+{
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        counters.accepted++;
+        counters.connections++;
+        // Respuestas cortas y encadenadas: sin esperar a juntar un segmento
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readClient(socket); });
+        connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() {
+            if (exports.contains(socket)) {
+                continueExport(socket);
+            }
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            counters.connections--;
+            pendingBySocket.remove(socket);
+            exports.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+/**
+ * @brief Atiende cada línea completa recibida de un cliente.
+ *
+ * Una línea más larga que kMaxLineLength se considera un error de
+ * protocolo y cierra la conexión, tanto si llegó completa como si aún
+ * falta su final: no se vuelve a leer nada de ese cliente, así el resto
+ * de la línea nunca se interpreta como otra solicitud.
+ *
+ * Mientras el cliente tiene una exportación en curso, sus solicitudes
+ * siguientes esperan en el socket: se atienden al terminarla, para que
+ * las respuestas lleguen en orden.
+ */
+void InventoryServer::readClient(QTcpSocket *socket)
+{
+    if (socket->state() != QAbstractSocket::ConnectedState || exports.contains(socket)) {
+        return;
+    }
+
+    bool tooLong = false;
+    while (socket->canReadLine() && !exports.contains(socket)) {
+        const QByteArray received = socket->readLine(kMaxLineLength + 1);
+        counters.bytesIn += received.size();
+        if (!received.endsWith('\n')) {
+            tooLong = true;
+            break;
+        }
+        handleLine(socket, received, clock.nsecsElapsed());
+    }
+
+    if (tooLong || (!exports.contains(socket) && socket->bytesAvailable() > kMaxLineLength)) {
+        counters.protocolErrors++;
+        socket->write(line("0", "ERR", {"línea demasiado larga"}));
+        socket->disconnectFromHost();
+    }
+}
+
+/**
+ * @brief Interpreta una solicitud y la atiende o la encola.
+ *
+ * @param socket Cliente que la envió.
+ * @param received Línea completa.
+ * @param arrivalNs Momento de llegada, en el reloj del servidor.
+ */
+void InventoryServer::handleLine(QTcpSocket *socket, const QByteArray &received, qint64 arrivalNs)
+{
+    const QByteArrayList parts = fields(received);
+    const QByteArray requestId = parts.value(0);
+    const QByteArray verb = parts.value(1);
+    counters.requests++;
+
+    int endpoint = -1;
+    for (int e = 0; e < EndpointCount; e++) {
+        if (endpoints[e].name == verb) {
+            endpoint = e;
+            break;
+        }
+    }
+    if (endpoint < 0 || requestId.isEmpty()) {
+        counters.protocolErrors++;
+        socket->write(line(requestId.isEmpty() ? "0" : requestId, "ERR", {"operación desconocida"}));
+        return;
+    }
+
+    auto invalid = [&]() {
+        respond(socket, line(requestId, "ERR", {"argumentos inválidos"}), endpoint, arrivalNs, false);
+    };
+    bool ok = true;
+    const int id = parts.value(2).toInt(&ok);
+
+    PendingWrite write;
+    write.socket = socket;
+    write.requestId = requestId;
+    write.endpoint = endpoint;
+    write.arrivalNs = arrivalNs;
+
+    switch (endpoint) {
+    case Ping:
+        respond(socket, line(requestId, "OK"), endpoint, arrivalNs, true);
+        return;
+
+    case Add: {
+        bool qtyOk = false;
+        const int cantidad = parts.value(4).toInt(&qtyOk);
+        if (parts.size() < 7 || !qtyOk) {
+            invalid();
+            return;
+        }
+        const QString nombre = unescape(parts.at(2));
+        const QString tipo = unescape(parts.at(3));
+        const QString ubicacion = unescape(parts.at(5));
+        const QString fecha = unescape(parts.at(6));
+        write.op = [this, nombre, tipo, cantidad, ubicacion, fecha](PendingWrite &w) {
+            if (!manager.addItem(nombre, tipo, cantidad, ubicacion, fecha)) {
+                return false;
+            }
+            w.resultId = manager.lastAddedId();
+            return true;
+        };
+        queueWrite(std::move(write));
+        return;
+    }
+
+    case Update: {
+        bool qtyOk = false;
+        const int cantidad = parts.value(5).toInt(&qtyOk);
+        if (parts.size() < 8 || !ok || !qtyOk) {
+            invalid();
+            return;
+        }
+        const QString nombre = unescape(parts.at(3));
+        const QString tipo = unescape(parts.at(4));
+        const QString ubicacion = unescape(parts.at(6));
+        const QString fecha = unescape(parts.at(7));
+        write.op = [this, id, nombre, tipo, cantidad, ubicacion, fecha](PendingWrite &) {
+            return manager.updateItem(id, nombre, tipo, cantidad, ubicacion, fecha);
+        };
+        queueWrite(std::move(write));
+        return;
+    }
+
+    case Quantity: {
+        bool qtyOk = false;
+        const int cantidad = parts.value(3).toInt(&qtyOk);
+        if (!ok || !qtyOk) {
+            invalid();
+            return;
+        }
+        write.op = [this, id, cantidad](PendingWrite &) { return manager.updateQuantity(id, cantidad); };
+        queueWrite(std::move(write));
+        return;
+    }
+
+    case Remove:
+        if (!ok) {
+            invalid();
+            return;
+        }
+        write.op = [this, id](PendingWrite &) { return manager.removeItem(id); };
+        queueWrite(std::move(write));
+        return;
+
+    default:
+        break;
+    }
+
+    // Lecturas: el cliente debe ver antes sus propias escrituras en espera
+    if (pendingBySocket.value(socket) > 0) {
+        flushWrites();
+    }
+
+    switch (endpoint) {
+    case Get: {
+        const QList<InventoryItem> items = ok ? manager.getItemsByIds({id}) : QList<InventoryItem>();
+        if (items.isEmpty()) {
+            respond(socket, line(requestId, "ERR", {ok ? "no existe" : "argumentos inválidos"}),
+                    endpoint, arrivalNs, false);
+            return;
+        }
+        respond(socket, line(requestId, "ROW", rowFields(items.first())) + line(requestId, "OK", {"1"}),
+                endpoint, arrivalNs, true);
+        return;
+    }
+
+    case Find: {
+        const QList<InventoryItem> items = manager.getItemsByIds(manager.searchItems(unescape(parts.value(2))));
+        QByteArray data;
+        for (const InventoryItem &it : items) {
+            data += line(requestId, "ROW", rowFields(it));
+        }
+        data += line(requestId, "OK", {QByteArray::number(items.size())});
+        respond(socket, data, endpoint, arrivalNs, true);
+        return;
+    }
+
+    case Export: {
+        ExportState &state = exports[socket];
+        state.requestId = requestId;
+        state.arrivalNs = arrivalNs;
+        continueExport(socket);
+        return;
+    }
+
+    case Metrics:
+        respond(socket, line(requestId, "OK", {escape(report())}), endpoint, arrivalNs, true);
+        return;
+
+    default:
+        return;
+    }
+}
+
+/**
+ * @brief Escribe tramos de la exportación hasta llenar el búfer de envío.
+ *
+ * Cada tramo son @ref kExportPageRows filas leídas por rango de ID
+ * (InventoryManager::forEachItemAfter), así que ninguna consulta recorre
+ * la tabla entera y en memoria nunca hay más de unos @ref kExportChunk
+ * bytes por cliente. Cuando el socket tiene esa cantidad pendiente se
+ * vuelve al bucle de eventos; bytesWritten trae de vuelta aquí cuando el
+ * cliente la leyó. Entre tramo y tramo se atienden los demás clientes y
+ * se confirman escrituras: cada fila sale una sola vez, tal como estaba
+ * al leer su tramo (no es una instantánea de toda la tabla).
+ */
+void InventoryServer::continueExport(QTcpSocket *socket)
+{
+    auto state = exports.find(socket);
+    if (state == exports.end()) {
+        return;
+    }
+
+    while (socket->bytesToWrite() < kExportChunk) {
+        QByteArray chunk;
+        int pageRows = 0;
+        const bool read = manager.forEachItemAfter(state->lastId, kExportPageRows,
+                                                   [&](const InventoryRowView &row) {
+            chunk += line(state->requestId, "ROW", rowFields(row));
+            state->lastId = row.id;
+            pageRows++;
+            return true;
+        });
+        state->rows += pageRows;
+
+        if (read && pageRows == kExportPageRows) {
+            counters.bytesOut += socket->write(chunk);
+            continue;
+        }
+
+        // Último tramo (o error): la respuesta se cierra y el cliente sigue
+        const ExportState done = exports.take(socket);
+        chunk += read ? line(done.requestId, "OK", {QByteArray::number(done.rows)})
+                      : line(done.requestId, "ERR", {"no se pudo leer el inventario"});
+        respond(socket, chunk, Export, done.arrivalNs, read);
+        if (socket->canReadLine()) {
+            QTimer::singleShot(0, socket, [this, socket]() { readClient(socket); });
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Agrega una escritura al lote en curso.
+ *
+ * El lote se confirma al cerrar la ventana o, sin esperar, al llegar a
+ * @ref maxBatchSize escrituras.
+ */
+void InventoryServer::queueWrite(PendingWrite write)
+{
+    pendingBySocket[write.socket.data()]++;
+    pending.append(std::move(write));
+
+    if (pending.size() >= maxBatchSize) {
+        flushWrites();
+    } else if (!batchTimer.isActive()) {
+        batchTimer.start();
+    }
+}
+
+/**
+ * @brief Confirma el lote de escrituras en una transacción y responde a cada una.
+ *
+ * Si la transacción no se pudo confirmar (por ejemplo, otro proceso tenía
+ * el bloqueo y se agotaron los reintentos), todas las escrituras del lote
+ * se responden con ERR para que sus clientes las reintenten.
+ */
+void InventoryServer::flushWrites()
+{
+    batchTimer.stop();
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    QList<PendingWrite> batch = std::exchange(pending, {});
+    pendingBySocket.clear();
+
+    QList<InventoryManager::WriteOp> ops;
+    ops.reserve(batch.size());
+    for (PendingWrite &w : batch) {
+        PendingWrite *write = &w;
+        ops.append([write]() { return write->op(*write); });
+    }
+
+    QList<bool> results;
+    const bool committed = manager.writeBatch(ops, &results);
+
+    counters.batches++;
+    counters.batchedWrites += batch.size();
+    counters.maxBatch = qMax(counters.maxBatch, int(batch.size()));
+
+    for (int i = 0; i < batch.size(); i++) {
+        const PendingWrite &w = batch.at(i);
+        const bool ok = results.value(i);
+        QByteArray data;
+        if (ok && w.endpoint == Add) {
+            data = line(w.requestId, "OK", {QByteArray::number(w.resultId)});
+        } else if (ok) {
+            data = line(w.requestId, "OK");
+        } else {
+            data = line(w.requestId, "ERR", {committed ? "la escritura falló" : "base ocupada; reintente"});
+        }
+        respond(w.socket, data, w.endpoint, w.arrivalNs, ok);
+    }
+}
+
+/**
+ * @brief Escribe la respuesta (si el cliente sigue conectado) y registra la latencia.
+ */
+void InventoryServer::respond(QTcpSocket *socket, const QByteArray &data, int endpoint,
+                              qint64 arrivalNs, bool ok)
+{
+    if (socket && socket->state() == QAbstractSocket::ConnectedState) {
+        counters.bytesOut += socket->write(data);
+    }
+
+    const qint64 ns = clock.nsecsElapsed() - arrivalNs;
+    EndpointStats &e = endpoints[endpoint];
+    e.requests++;
+    e.errors += ok ? 0 : 1;
+    e.totalNs += ns;
+    e.maxNs = qMax(e.maxNs, ns);
+    e.histogram[qMin(bucketOf(ns), int(e.histogram.size()) - 1)]++;
+}
@@ -0,0 +1,351 @@
+#include "InventoryShards.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <algorithm>
+
+/**
+ * @brief Sede adjunta: hilo, conexión y capa de datos propios.
+ *
+ * @ref manager y la conexión @ref connection se crean, usan y destruyen
+ * solo dentro de @ref thread.
+ */
+struct InventoryShards::Shard {
+    QString site;
+    QString path;
+    QString connection;                 ///< Nombre de la conexión Qt de la sede.
+    QThread thread;
+    QObject *worker = nullptr;          ///< Contexto que vive en @ref thread.
+    InventoryManager *manager = nullptr;
+    ShardStats stats;
+};
+
+/**
+ * @brief Respuesta de una sede a una consulta repartida.
+ */
+struct InventoryShards::Reply {
+    bool answered = false;      ///< La sede respondió dentro del plazo.
+    bool ok = false;            ///< La consulta terminó sin error.
+    qint64 elapsedNs = 0;
+    QList<InventoryItem> items;
+    SiteTotals totals;
+};
+
+/**
+ * @brief Crea el conjunto vacío; las sedes se agregan con @ref attach.
+ */
+InventoryShards::InventoryShards(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Cierra todas las sedes.
+ */
+InventoryShards::~InventoryShards()
+{
+    for (auto &shard : shards) {
+        close(*shard);
+    }
+}
+
+/**
+ * @brief Abre la base de la sede en su propio hilo y verifica su esquema.
+ */
+bool InventoryShards::attach(const QString &site, const QString &path)
+{
+    if (sites().contains(site)) {
+        qDebug() << "La sede ya está adjunta:" << site;
+        return false;
+    }
+    if (!QFileInfo::exists(path)) {
+        qDebug() << "No existe la base de la sede" << site << ":" << path;
+        return false;
+    }
+
+    static int serial = 0;
+    auto shard = std::make_unique<Shard>();
+    shard->site = site;
+    shard->path = QFileInfo(path).absoluteFilePath();
+    shard->connection = QString("inventario_sede_%1").arg(++serial);
+    shard->stats.site = site;
+    shard->stats.path = shard->path;
+
+    shard->worker = new QObject;
+    shard->worker->moveToThread(&shard->thread);
+    shard->thread.setObjectName("sede " + site);
+    shard->thread.start();
+
+    bool opened = false;
+    Shard *s = shard.get();
+    QMetaObject::invokeMethod(s->worker, [s, &opened]() {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", s->connection);
+        db.setDatabaseName(s->path);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+        if (!db.open()) {
+            qDebug() << "No se pudo abrir la base de la sede" << s->site << ":" << db.lastError();
+            return;
+        }
+
+        // La búsqueda necesita las claves plegadas además de la tabla
+        QSqlQuery schema(db);
+        if (!schema.exec("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' "
+                         "AND name IN ('inventario', 'inventario_claves')")
+            || !schema.next() || schema.value(0).toInt() != 2) {
+            qDebug() << "La base de la sede" << s->site << "no tiene el esquema al día:" << s->path;
+            return;
+        }
+        s->manager = new InventoryManager(db);
+        opened = true;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!opened) {
+        close(*shard);
+        return false;
+    }
+    shards.push_back(std::move(shard));
+    return true;
+}
+
+/**
+ * @brief Quita una sede; su consulta en curso, si la hay, termina antes.
+ */
+bool InventoryShards::detach(const QString &site)
+{
+    auto it = std::find_if(shards.begin(), shards.end(),
+                           [&site](const auto &shard) { return shard->site == site; });
+    if (it == shards.end()) {
+        return false;
+    }
+    close(**it);
+    shards.erase(it);
+    return true;
+}
+
+/**
+ * @brief Nombres de las sedes adjuntas.
+ */
+QStringList InventoryShards::sites() const
+{
+    QStringList names;
+    for (const auto &shard : shards) {
+        names.append(shard->site);
+    }
+    return names;
+}
+
+/**
+ * @brief Cambia el plazo de las consultas repartidas.
+ */
+void InventoryShards::setTimeout(int ms)
+{
+    timeoutMs = qMax(1, ms);
+}
+
+/**
+ * @brief Busca en cada sede con sus claves plegadas y trae las filas encontradas.
+ */
+QList<SiteItem> InventoryShards::search(const QString &text)
+{
+    const QList<Reply> replies = fanOut([text](InventoryManager &manager, QSqlDatabase, Reply &reply) {
+        reply.items = manager.getItemsByIds(manager.searchItems(text));
+        return true;
+    });
+
+    QList<SiteItem> found;
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (!replies.at(int(i)).ok) {
+            continue;
+        }
+        for (const InventoryItem &it : replies.at(int(i)).items) {
+            found.append({shards[i]->site, it});
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Stock bajo de todas las sedes, unido por cantidad.
+ *
+ * Cada sede ya devuelve sus filas ordenadas; el ordenamiento estable
+ * conserva el orden de las sedes entre filas con la misma cantidad.
+ */
+QList<SiteItem> InventoryShards::lowStock(int threshold)
+{
+    const QList<Reply> replies = fanOut([threshold](InventoryManager &manager, QSqlDatabase, Reply &reply) {
+        return manager.forEachLowStockItem(threshold, [&reply](const InventoryRowView &row) {
+            reply.items.append(row.toItem());
+            return true;
+        });
+    });
+
+    QList<SiteItem> low;
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (!replies.at(int(i)).ok) {
+            continue;
+        }
+        for (const InventoryItem &it : replies.at(int(i)).items) {
+            low.append({shards[i]->site, it});
+        }
+    }
+    std::stable_sort(low.begin(), low.end(), [](const SiteItem &a, const SiteItem &b) {
+        return a.item.cantidad < b.item.cantidad;
+    });
+    return low;
+}
+
+/**
+ * @brief Un solo recorrido agregado por sede: filas, unidades y stock bajo.
+ */
+QList<SiteTotals> InventoryShards::totals(int lowStockThreshold)
+{
+    const QList<Reply> replies = fanOut([lowStockThreshold](InventoryManager &, QSqlDatabase db, Reply &reply) {
+        QSqlQuery query(db);
+        query.prepare("SELECT COUNT(*), COALESCE(SUM(cantidad), 0), COALESCE(SUM(cantidad < ?), 0) "
+                      "FROM inventario");
+        query.addBindValue(lowStockThreshold);
+        if (!query.exec() || !query.next()) {
+            qDebug() << "Fallo al totalizar la sede:" << query.lastError();
+            return false;
+        }
+        reply.totals.items = query.value(0).toLongLong();
+        reply.totals.units = query.value(1).toLongLong();
+        reply.totals.lowStock = query.value(2).toLongLong();
+        return true;
+    });
+
+    QList<SiteTotals> result;
+    for (size_t i = 0; i < shards.size(); i++) {
+        const Reply &reply = replies.at(int(i));
+        SiteTotals totals = reply.totals;
+        totals.site = shards[i]->site;
+        totals.ok = reply.answered && reply.ok;
+        totals.elapsedNs = reply.elapsedNs;
+        result.append(totals);
+    }
+    return result;
+}
+
+/**
+ * @brief Contadores acumulados de cada sede.
+ */
+QList<ShardStats> InventoryShards::shardStats() const
+{
+    QList<ShardStats> list;
+    for (const auto &shard : shards) {
+        list.append(shard->stats);
+    }
+    return list;
+}
+
+/**
+ * @brief Tiempos de la última consulta repartida.
+ */
+FanOutStats InventoryShards::lastFanOut() const
+{
+    return last;
+}
+
+/**
+ * @brief Reparte una consulta a todas las sedes y espera a la última (o al plazo).
+ *
+ * Cada sede ejecuta @p query en su hilo y deja su respuesta en un estado
+ * compartido. Ese estado lo sostienen también las tareas en curso: si el
+ * plazo vence, la sede atrasada escribe su respuesta tarde sin tocar
+ * memoria de quien ya volvió, y su resultado se descarta.
+ */
+QList<InventoryShards::Reply> InventoryShards::fanOut(const ShardQuery &query)
+{
+    struct State {
+        QMutex mutex;
+        QSemaphore done;
+        QList<Reply> replies;
+    };
+    auto state = std::make_shared<State>();
+    state->replies.resize(int(shards.size()));
+
+    QElapsedTimer clock;
+    clock.start();
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        Shard *shard = shards[i].get();
+        InventoryManager *manager = shard->manager;
+        const QString connection = shard->connection;
+        const int slot = int(i);
+        QMetaObject::invokeMethod(shard->worker, [state, query, manager, connection, slot]() {
+            Reply reply;
+            QElapsedTimer timer;
+            timer.start();
+            reply.ok = query(*manager, QSqlDatabase::database(connection, false), reply);
+            reply.elapsedNs = timer.nsecsElapsed();
+            reply.answered = true;
+            {
+                QMutexLocker lock(&state->mutex);
+                state->replies[slot] = std::move(reply);
+            }
+            state->done.release();
+        }, Qt::QueuedConnection);
+    }
+
+    state->done.tryAcquire(int(shards.size()), timeoutMs);
+
+    QList<Reply> replies;
+    {
+        QMutexLocker lock(&state->mutex);
+        replies = state->replies;
+    }
+
+    last = FanOutStats();
+    last.shards = int(shards.size());
+    last.wallNs = clock.nsecsElapsed();
+    for (size_t i = 0; i < shards.size(); i++) {
+        const Reply &reply = replies.at(int(i));
+        ShardStats &stats = shards[i]->stats;
+        if (!reply.answered) {
+            stats.timeouts++;
+            last.failed++;
+            qDebug() << "La sede" << shards[i]->site << "no respondió en" << timeoutMs << "ms.";
+            continue;
+        }
+        if (reply.ok) {
+            stats.queries++;
+        } else {
+            stats.failures++;
+            last.failed++;
+        }
+        stats.totalNs += reply.elapsedNs;
+        stats.maxNs = qMax(stats.maxNs, reply.elapsedNs);
+        last.slowestNs = qMax(last.slowestNs, reply.elapsedNs);
+        last.sumNs += reply.elapsedNs;
+    }
+    return replies;
+}
+
+/**
+ * @brief Destruye la capa de datos y la conexión en su hilo y detiene el hilo.
+ */
+void InventoryShards::close(Shard &shard)
+{
+    if (shard.thread.isRunning()) {
+        Shard *s = &shard;
+        QMetaObject::invokeMethod(s->worker, [s]() {
+            delete s->manager;
+            s->manager = nullptr;
+            {
+                QSqlDatabase db = QSqlDatabase::database(s->connection, false);
+                db.close();
+            }
+            QSqlDatabase::removeDatabase(s->connection);
+        }, Qt::BlockingQueuedConnection);
+        shard.thread.quit();
+        shard.thread.wait();
+    }
+    delete shard.worker;
+    shard.worker = nullptr;
+}
@@ -0,0 +1,500 @@
+#include "InventorySync.h"
+#include "InventorySchema.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Un paso de FNV-1a de 64 bits sobre un valor entero.
+ */
+static inline quint64 mixValue(quint64 hash, quint64 value)
+{
+    hash ^= value;
+    return hash * 0x100000001b3ULL;
+}
+
+/**
+ * @brief Finalizador de splitmix64: reparte los bits del resumen.
+ *
+ * Los resúmenes de fila se suman; sin este paso, filas parecidas darían
+ * resúmenes cercanos y una suma podría compensar a otra.
+ */
+static inline quint64 finalize(quint64 hash)
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
+/**
+ * @brief Hash de la identidad de una fila: decide su hoja.
+ */
+static inline quint64 keyHash(const RowOrigin &key)
+{
+    return finalize(mixValue(mixValue(0xcbf29ce484222325ULL, quint64(key.sede)), quint32(key.id)));
+}
+
+/**
+ * @brief Arma los niveles desde las hojas hasta la raíz.
+ */
+void DigestTree::seal()
+{
+    if (levels.isEmpty()) {
+        levels.append(QVector<DigestNode>(1));
+    }
+    levels.resize(1);
+
+    while (levels.last().size() > 1) {
+        const QVector<DigestNode> below = levels.last();
+        QVector<DigestNode> above((below.size() + fanout - 1) / fanout);
+        for (int i = 0; i < below.size(); i++) {
+            above[i / fanout].digest += below.at(i).digest;
+            above[i / fanout].rows += below.at(i).rows;
+        }
+        levels.append(above);
+    }
+}
+
+/**
+ * @brief Prepara la comparación; no lee nada hasta @ref diff.
+ */
+InventorySync::InventorySync(InventoryManager &local, InventoryManager &remote)
+    : local(local), remote(remote)
+{
+}
+
+/**
+ * @brief Cambia la forma de los árboles de las próximas comparaciones.
+ *
+ * Hojas más anchas dan árboles más chicos pero obligan a leer más filas
+ * por cada hoja distinta.
+ */
+void InventorySync::setTreeShape(int leafWidth, int fanout)
+{
+    this->leafWidth = qMax(1, leafWidth);
+    this->fanout = qMax(2, fanout);
+}
+
+/**
+ * @brief Resume una fila con FNV-1a sobre su identidad y sus columnas, y un finalizador.
+ *
+ * El ID local queda fuera: la misma fila tiene otro ID en cada sede.
+ * Los textos se recorren como unidades UTF-16, tal como los entrega la
+ * vista, sin convertirlos; cada uno termina con un separador fuera del
+ * rango UTF-16 para que ("ab", "c") y ("a", "bc") no coincidan.
+ */
+quint64 InventorySync::rowDigest(const InventoryRowView &row, const RowOrigin &key)
+{
+    quint64 hash = mixValue(mixValue(0xcbf29ce484222325ULL, quint64(key.sede)), quint32(key.id));
+    InventorySchema::forEachColumn([&](auto index, const auto &def) {
+        if constexpr (decltype(index)::value != InventorySchema::Id) {
+            const auto &value = InventorySchema::field(row, def);
+            if constexpr (std::is_same_v<std::decay_t<decltype(value)>, int>) {
+                hash = mixValue(hash, quint32(value));
+            } else {
+                for (QChar c : value) {
+                    hash = mixValue(hash, c.unicode());
+                }
+                hash = mixValue(hash, 0x10000);
+            }
+        }
+    });
+    return finalize(hash);
+}
+
+/**
+ * @brief Recorre la tabla una vez (sin copiar filas) y guarda identidad y resumen de cada una.
+ *
+ * Las filas sin origen anotado son de esta sede: (siteId(), id).
+ */
+QVector<SyncRow> InventorySync::summarize(InventoryManager &manager, bool *ok)
+{
+    QVector<SyncRow> rows;
+    const qint64 site = manager.siteId();
+    bool read = site != 0;
+    if (read) {
+        const QHash<int, RowOrigin> origins = manager.itemOrigins();
+        read = manager.forEachItem([&](const InventoryRowView &row) {
+            const RowOrigin key = origins.value(row.id, RowOrigin{site, row.id});
+            rows.append(SyncRow{key, row.id, rowDigest(row, key)});
+            return true;
+        });
+    } else {
+        qDebug() << "La base no tiene identidad de sede; ábrala una vez con esta versión.";
+    }
+    if (ok) {
+        *ok = read;
+    }
+    return rows;
+}
+
+/**
+ * @brief Reparte las filas en hojas por el hash de su identidad y sella el árbol.
+ */
+DigestTree InventorySync::buildTree(const QVector<SyncRow> &rows, int leafCount, int fanout)
+{
+    DigestTree tree;
+    tree.fanout = qMax(2, fanout);
+    leafCount = qMax(1, leafCount);
+
+    QVector<DigestNode> leaves(leafCount);
+    tree.rows.resize(leafCount);
+    for (const SyncRow &row : rows) {
+        const int leaf = int(keyHash(row.key) % quint64(leafCount));
+        leaves[leaf].digest += row.digest;
+        leaves[leaf].rows++;
+        tree.rows[leaf].append(row);
+    }
+
+    tree.levels.append(leaves);
+    tree.seal();
+    return tree;
+}
+
+/**
+ * @brief Separa una copia de su base original como otra sede.
+ *
+ * Las dos bases tienen el mismo contenido, así que el resumen de cada
+ * fila de la copia (ya con su origen anotado) es el estado sincronizado
+ * de ambas.
+ */
+bool InventorySync::splitCopy(InventoryManager &original, InventoryManager &copy)
+{
+    if (!copy.renewSiteId()) {
+        return false;
+    }
+
+    bool ok = false;
+    const QVector<SyncRow> rows = summarize(copy, &ok);
+    if (!ok) {
+        return false;
+    }
+    QHash<RowOrigin, quint64> digests;
+    digests.reserve(rows.size());
+    for (const SyncRow &row : rows) {
+        digests.insert(row.key, row.digest);
+    }
+    return original.setSyncedDigests(copy.siteId(), digests)
+           && copy.setSyncedDigests(original.siteId(), digests);
+}
+
+/**
+ * @brief Arma los dos árboles con la misma forma y baja solo por los nodos distintos.
+ *
+ * El número de hojas sale de la tabla más grande (un dato que se
+ * intercambia antes de armar los árboles). En cada nivel se comparan
+ * únicamente los hijos de los nodos que difirieron en el nivel de arriba;
+ * cada comparación cuenta como un resumen pedido al otro lado.
+ */
+bool InventorySync::diff()
+{
+    localOnlyIds.clear();
+    remoteOnlyRows.clear();
+    conflictRows.clear();
+    remoteChangeRows.clear();
+    remoteRemovalIds.clear();
+    settled.clear();
+    forgotten.clear();
+    current = SyncStats();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool localRead = false;
+    bool remoteRead = false;
+    const QVector<SyncRow> localRows = summarize(local, &localRead);
+    const QVector<SyncRow> remoteRows = summarize(remote, &remoteRead);
+    if (!localRead || !remoteRead) {
+        qDebug() << "No se pudo recorrer el inventario de" << (localRead ? "la otra base." : "la base local.");
+        return false;
+    }
+    peer = remote.siteId();
+    if (peer == local.siteId()) {
+        qDebug() << "Las dos bases tienen la misma identidad de sede (¿una es copia de la otra?).";
+        return false;
+    }
+    synced = local.syncedDigests(peer);
+
+    const qint64 largest = qMax(localRows.size(), remoteRows.size());
+    const int leafCount = int(qMax<qint64>(1, (largest + leafWidth - 1) / leafWidth));
+    mine = buildTree(localRows, leafCount, fanout);
+    theirs = buildTree(remoteRows, leafCount, fanout);
+
+    current.buildNs = timer.nsecsElapsed();
+    current.localRows = mine.rowCount();
+    current.remoteRows = theirs.rowCount();
+    current.leaves = leafCount;
+    current.levels = mine.levels.size();
+
+    timer.restart();
+    QVector<bool> differs(leafCount, false);
+    QList<int> candidates = {0};
+    for (int level = mine.levels.size() - 1; level >= 0 && !candidates.isEmpty(); level--) {
+        QList<int> differing;
+        for (int node : candidates) {
+            current.digestsCompared++;
+            if (mine.levels[level][node] != theirs.levels[level][node]) {
+                differing.append(node);
+            }
+        }
+
+        if (level == 0) {
+            current.differingLeaves = differing.size();
+            for (int leaf : differing) {
+                differs[leaf] = true;
+                compareLeaf(leaf);
+            }
+            break;
+        }
+
+        candidates.clear();
+        const int below = mine.levels[level - 1].size();
+        for (int node : differing) {
+            for (int child = node * fanout; child < qMin((node + 1) * fanout, below); child++) {
+                candidates.append(child);
+            }
+        }
+    }
+
+    // En las hojas iguales, cada fila está igual en los dos lados: es el
+    // estado sincronizado (no cuesta nada al otro lado)
+    for (int leaf = 0; leaf < leafCount; leaf++) {
+        if (differs.at(leaf)) {
+            continue;
+        }
+        for (const SyncRow &row : mine.rows.at(leaf)) {
+            const auto it = synced.constFind(row.key);
+            if (it == synced.constEnd() || it.value() != row.digest) {
+                settled.insert(row.key, row.digest);
+            }
+        }
+    }
+
+    fetchRows();
+
+    current.onlyLocal = localOnly.size();
+    current.onlyRemote = remoteOnly.size();
+    current.changed = conflicts.size();
+    current.changedRemote = remoteChanges.size();
+    current.removedRemote = remoteRemovals.size();
+    current.diffNs = timer.nsecsElapsed();
+    return true;
+}
+
+/**
+ * @brief Cruza las filas de la hoja por identidad y las clasifica con el estado sincronizado.
+ *
+ * Con el resumen de la última sincronización (base) de cada fila:
+ * - en los dos lados y distinta: si el local es la base, cambió solo la
+ *   otra base; si la remota es la base, cambió solo aquí; si no, conflicto.
+ * - solo en la otra base: sin base es nueva allá; con base, se borró aquí
+ *   y solo vuelve si allá cambió después.
+ * - solo aquí: sin base es nueva aquí; con base, la otra base la borró y
+ *   se borra aquí salvo que aquí haya cambiado después.
+ */
+void InventorySync::compareLeaf(int leaf)
+{
+    const QVector<SyncRow> &ours = mine.rows.at(leaf);
+    const QVector<SyncRow> &other = theirs.rows.at(leaf);
+    current.rowBytes += other.size() * qint64(sizeof(SyncRow));
+
+    QHash<RowOrigin, const SyncRow *> remoteByKey;
+    remoteByKey.reserve(other.size());
+    for (const SyncRow &row : other) {
+        remoteByKey.insert(row.key, &row);
+    }
+
+    for (const SyncRow &row : ours) {
+        const SyncRow *match = remoteByKey.take(row.key);
+        const auto base = synced.constFind(row.key);
+        const bool hasBase = base != synced.constEnd();
+
+        if (match) {
+            if (match->digest == row.digest) {
+                if (!hasBase || base.value() != row.digest) {
+                    settled.insert(row.key, row.digest);
+                }
+            } else if (hasBase && base.value() == row.digest) {
+                remoteChangeRows.append({row.id, *match});
+                settled.insert(row.key, match->digest);
+            } else if (hasBase && base.value() == match->digest) {
+                current.changedLocal++;
+            } else {
+                conflictRows.append({row.id, *match});
+                settled.insert(row.key, match->digest);
+            }
+        } else if (!hasBase) {
+            localOnlyIds.append(row.id);
+        } else if (base.value() == row.digest) {
+            remoteRemovalIds.append(row.id);
+            forgotten.append(row.key);
+        } else {
+            // Cambió aquí después de que la otra base la borrara: se conserva como nueva
+            localOnlyIds.append(row.id);
+            forgotten.append(row.key);
+        }
+    }
+
+    for (const SyncRow *row : std::as_const(remoteByKey)) {
+        const auto base = synced.constFind(row->key);
+        if (base == synced.constEnd() || base.value() != row->digest) {
+            remoteOnlyRows.append(*row);
+            settled.insert(row->key, row->digest);
+        } else {
+            current.changedLocal++;
+        }
+    }
+}
+
+/**
+ * @brief Lee de cada lado, en un lote, las filas completas de las diferencias.
+ *
+ * Del otro lado solo se leen las filas que la fusión podría traer: las
+ * nuevas, las que cambiaron allá y las de los conflictos.
+ */
+void InventorySync::fetchRows()
+{
+    localOnly.clear();
+    remoteOnly.clear();
+    remoteOnlyKeys.clear();
+    conflicts.clear();
+    remoteChanges.clear();
+    remoteRemovals.clear();
+
+    QList<int> localIds = localOnlyIds + remoteRemovalIds;
+    QList<int> remoteIds;
+    for (const SyncRow &row : std::as_const(remoteOnlyRows)) {
+        remoteIds.append(row.id);
+    }
+    for (const auto *pairs : {&conflictRows, &remoteChangeRows}) {
+        for (const auto &pair : *pairs) {
+            localIds.append(pair.first);
+            remoteIds.append(pair.second.id);
+        }
+    }
+
+    QHash<int, InventoryItem> ourItems;
+    for (const InventoryItem &it : local.getItemsByIds(localIds)) {
+        ourItems.insert(it.id, it);
+    }
+    QHash<int, InventoryItem> theirItems;
+    for (const InventoryItem &it : remote.getItemsByIds(remoteIds)) {
+        theirItems.insert(it.id, it);
+        current.rowsFetched++;
+        current.rowBytes += 2 * sizeof(int)
+                            + 2 * (it.nombre.size() + it.tipo.size() + it.ubicacion.size()
+                                   + it.fechaAdquisicion.size());
+    }
+
+    for (int id : std::as_const(localOnlyIds)) {
+        localOnly.append(ourItems.value(id));
+    }
+    for (int id : std::as_const(remoteRemovalIds)) {
+        remoteRemovals.append(ourItems.value(id));
+    }
+    for (const SyncRow &row : std::as_const(remoteOnlyRows)) {
+        remoteOnly.append(theirItems.value(row.id));
+        remoteOnlyKeys.append(row.key);
+    }
+    for (const auto &pair : std::as_const(conflictRows)) {
+        conflicts.append({ourItems.value(pair.first), theirItems.value(pair.second.id)});
+    }
+    for (const auto &pair : std::as_const(remoteChangeRows)) {
+        remoteChanges.append({ourItems.value(pair.first), theirItems.value(pair.second.id)});
+    }
+}
+
+/**
+ * @brief Escribe en la base local lo que decidió la comparación, todo o nada.
+ *
+ * Las filas nuevas de la otra base entran con un ID nuevo y su origen
+ * (InventoryManager::importItems); los cambios de un solo lado y los
+ * conflictos resueltos a favor de la otra base reemplazan la fila local
+ * conservando su ID. Con KeepBoth la versión remota de un conflicto entra
+ * como fila nueva de esta sede. Todo, junto con el nuevo estado
+ * sincronizado, va en una sola operación de writeBatch: comparten
+ * transacción y SAVEPOINT.
+ *
+ * Un conflicto resuelto, sea cual sea la versión elegida, anota la
+ * remota como sincronizada: la próxima vez la fila cuenta como cambiada
+ * solo aquí (o en ningún lado) y no vuelve a preguntarse.
+ */
+bool InventorySync::merge(ConflictPolicy policy, bool removeMissing, const Resolver &resolver)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<InventoryItem> puts;
+    QList<InventoryItem> copies;
+    QList<int> removals;
+
+    for (const auto &pair : std::as_const(remoteChanges)) {
+        InventoryItem taken = pair.second;
+        taken.id = pair.first.id;
+        puts.append(taken);
+    }
+    for (const auto &pair : std::as_const(conflicts)) {
+        if (resolver) {
+            InventoryItem chosen = resolver(pair.first, pair.second);
+            chosen.id = pair.first.id;
+            if (rowDigest(InventorySchema::viewOf(chosen), {})
+                != rowDigest(InventorySchema::viewOf(pair.first), {})) {
+                puts.append(chosen);
+            }
+            continue;
+        }
+        switch (policy) {
+        case KeepLocal:
+            break;
+        case TakeRemote: {
+            InventoryItem taken = pair.second;
+            taken.id = pair.first.id;
+            puts.append(taken);
+            break;
+        }
+        case KeepBoth:
+            copies.append(pair.second);
+            break;
+        }
+    }
+    for (const InventoryItem &it : std::as_const(remoteRemovals)) {
+        removals.append(it.id);
+    }
+    if (removeMissing) {
+        for (const InventoryItem &it : std::as_const(localOnly)) {
+            removals.append(it.id);
+        }
+    }
+
+    if (puts.isEmpty() && copies.isEmpty() && removals.isEmpty() && remoteOnly.isEmpty()
+        && settled.isEmpty() && forgotten.isEmpty()) {
+        current.mergeNs = timer.nsecsElapsed();
+        return true;
+    }
+
+    QList<bool> results;
+    const bool committed = local.writeBatch({[&]() {
+        return (puts.isEmpty() || local.putItems(puts))
+               && (remoteOnly.isEmpty() || local.importItems(remoteOnly, remoteOnlyKeys))
+               && (copies.isEmpty() || local.addItems(copies))
+               && (removals.isEmpty() || local.removeItems(removals))
+               && local.setSyncedDigests(peer, settled, forgotten);
+    }}, &results);
+
+    current.mergeNs = timer.nsecsElapsed();
+    if (!committed || !results.value(0)) {
+        qDebug() << "No se pudo aplicar la fusión; la base local quedó como estaba.";
+        return false;
+    }
+
+    current.inserted = remoteOnly.size();
+    current.updated = puts.size();
+    current.duplicated = copies.size();
+    current.removed = removals.size();
+    current.synced = settled.size() + forgotten.size();
+    return true;
+}
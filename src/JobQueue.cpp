@@ -0,0 +1,515 @@
+#include "JobQueue.h"
+#include "DatabaseManager.h"
+#include "InventoryManager.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+
+/**
+ * @brief Intervalo mínimo entre dos avances reenviados al dueño, en ms.
+ */
+static const int kProgressIntervalMs = 100;
+
+/**
+ * @brief Trabajos terminados que se conservan en el historial.
+ */
+static const int kHistoryLimit = 100;
+
+/**
+ * @brief Espera máxima de un lote mientras otras escrituras toman el bloqueo, en ms.
+ */
+static const int kMaxYieldMs = 50;
+
+/**
+ * @brief Estado compartido de un trabajo entre el dueño y su hilo.
+ *
+ * Las estadísticas se protegen con el mutex; la cancelación es atómica
+ * para que el cuerpo pueda consultarla en cada fila sin bloquear.
+ */
+struct JobContext::Shared {
+    JobQueue *queue = nullptr;
+    JobQueue::JobBody body;
+    JobMode mode = JobMode::Read;
+    std::atomic<bool> canceled{false};
+    QElapsedTimer clock;            ///< Desde que se encoló.
+
+    mutable QMutex mutex;
+    JobStats stats;
+
+    JobStats snapshot() const
+    {
+        QMutexLocker lock(&mutex);
+        return stats;
+    }
+
+    /** @brief Pasa a "en curso" y anota la espera en cola. */
+    JobStats start()
+    {
+        QMutexLocker lock(&mutex);
+        stats.state = JobState::Running;
+        stats.waitNs = clock.nsecsElapsed();
+        return stats;
+    }
+};
+
+/**
+ * @brief Un hilo de trabajo con su conexión y su gestor (creados en el hilo).
+ */
+struct JobQueue::Worker {
+    QThread thread;
+    QObject *context = nullptr;                 ///< Vive en el hilo; recibe los trabajos.
+    QString connection;                         ///< Nombre de la conexión del hilo.
+    std::unique_ptr<InventoryManager> manager;  ///< Solo se usa desde el hilo.
+    std::shared_ptr<Job> job;                   ///< Trabajo en curso (lo administra el dueño).
+};
+
+/**
+ * @brief Indica si se pidió cancelar el trabajo.
+ */
+bool JobContext::isCanceled() const
+{
+    return job->canceled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Actualiza el avance y lo reenvía al dueño si pasó el intervalo mínimo.
+ */
+void JobContext::setProgress(qint64 done, qint64 total, const QString &detail)
+{
+    JobStats snapshot;
+    {
+        QMutexLocker lock(&job->mutex);
+        job->stats.done = done;
+        job->stats.total = total;
+        if (!detail.isEmpty()) {
+            job->stats.detail = detail;
+        }
+        if (lastReport.isValid() && lastReport.elapsed() < kProgressIntervalMs
+            && (total <= 0 || done < total)) {
+            return;
+        }
+        snapshot = job->stats;
+    }
+    lastReport.start();
+
+    JobQueue *queue = job->queue;
+    QMetaObject::invokeMethod(queue, [queue, snapshot]() { emit queue->jobProgress(snapshot); });
+}
+
+/**
+ * @brief Confirma un lote en su propia transacción, después de ceder el turno.
+ *
+ * Mientras otra escritura del proceso espera el bloqueo, el hilo del
+ * trabajo duerme de a 1 ms (a lo sumo @ref kMaxYieldMs) para que la tome
+ * primero.
+ */
+bool JobContext::write(const std::function<bool()> &chunk)
+{
+    QElapsedTimer yielding;
+    yielding.start();
+    while (InventoryManager::waitingWriters() > 0 && yielding.elapsed() < kMaxYieldMs) {
+        QThread::msleep(1);
+    }
+    return !isCanceled() && inventory->writeAtomically(chunk);
+}
+
+/**
+ * @brief Anota el motivo del fallo para el informe del trabajo.
+ */
+void JobContext::fail(const QString &reason)
+{
+    QMutexLocker lock(&job->mutex);
+    job->stats.detail = reason;
+}
+
+/**
+ * @brief Constructor: reserva los hilos y el nombre de sus conexiones.
+ */
+JobQueue::JobQueue(InventoryManager &local, const QString &databasePath, int workerCount, QObject *parent)
+    : QObject(parent),
+      local(local),
+      path(databasePath.isEmpty() ? QString() : QFileInfo(databasePath).absoluteFilePath())
+{
+    qRegisterMetaType<JobStats>();
+
+    if (path.isEmpty()) {
+        return;
+    }
+    for (int i = 0; i < qMax(1, workerCount); i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->connection = QString("inventario_trabajos_%1_%2").arg(quintptr(this), 0, 16).arg(i);
+        worker->context = new QObject;
+        worker->context->moveToThread(&worker->thread);
+        worker->thread.setObjectName(QString("trabajos %1").arg(i + 1));
+        workers.push_back(std::move(worker));
+    }
+}
+
+/**
+ * @brief Cancela todo, espera los trabajos en curso y cierra los hilos.
+ *
+ * Los trabajos en curso ven la cancelación en su próxima revisión y
+ * deshacen lo que escribieron. Ya no se emite ninguna señal: quien
+ * escuchaba puede estar destruyéndose.
+ */
+JobQueue::~JobQueue()
+{
+    blockSignals(true);
+    for (const std::shared_ptr<Job> &job : queued) {
+        job->canceled = true;
+    }
+    queued.clear();
+    for (const std::shared_ptr<Job> &job : running) {
+        job->canceled = true;
+    }
+    for (auto &worker : workers) {
+        close(*worker);
+        delete worker->context;
+    }
+}
+
+/**
+ * @brief Encola un trabajo y lo lanza si hay un hilo libre.
+ */
+int JobQueue::submit(const QString &title, JobMode mode, const JobBody &body)
+{
+    auto job = std::make_shared<Job>();
+    job->queue = this;
+    job->body = body;
+    job->mode = mode;
+    job->stats.id = nextId++;
+    job->stats.title = title;
+    job->stats.mode = mode;
+    job->clock.start();
+
+    queued.push_back(job);
+    emit jobQueued(job->stats);
+    dispatch();
+    return job->stats.id;
+}
+
+/**
+ * @brief Cancela un trabajo: si está en cola sale de ella, si corre se le avisa.
+ */
+bool JobQueue::cancel(int id)
+{
+    for (auto it = queued.begin(); it != queued.end(); ++it) {
+        if ((*it)->stats.id == id) {
+            std::shared_ptr<Job> job = *it;
+            queued.erase(it);
+            job->canceled = true;
+            job->stats.state = JobState::Canceled;
+            job->stats.waitNs = job->clock.nsecsElapsed();
+            finish(nullptr, job);
+            return true;
+        }
+    }
+    for (const std::shared_ptr<Job> &job : running) {
+        if (job->stats.id == id) {
+            job->canceled = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Cancela los trabajos en cola y avisa a los que están corriendo.
+ */
+void JobQueue::cancelAll()
+{
+    while (!queued.empty()) {
+        cancel(queued.front()->stats.id);
+    }
+    for (const std::shared_ptr<Job> &job : running) {
+        job->canceled = true;
+    }
+}
+
+/**
+ * @brief Estado de un trabajo; un JobStats vacío (id 0) si no se conoce.
+ */
+JobStats JobQueue::stats(int id) const
+{
+    for (const std::shared_ptr<Job> &job : running) {
+        if (job->stats.id == id) {
+            return job->snapshot();
+        }
+    }
+    for (const std::shared_ptr<Job> &job : queued) {
+        if (job->stats.id == id) {
+            return job->snapshot();
+        }
+    }
+    for (const JobStats &s : finished) {
+        if (s.id == id) {
+            return s;
+        }
+    }
+    return JobStats();
+}
+
+/**
+ * @brief Trabajos en curso y en cola, ordenados por ID (orden de llegada).
+ */
+QList<JobStats> JobQueue::activeJobs() const
+{
+    QList<JobStats> result;
+    for (const std::shared_ptr<Job> &job : running) {
+        result.append(job->snapshot());
+    }
+    for (const std::shared_ptr<Job> &job : queued) {
+        result.append(job->snapshot());
+    }
+    std::sort(result.begin(), result.end(),
+              [](const JobStats &a, const JobStats &b) { return a.id < b.id; });
+    return result;
+}
+
+/**
+ * @brief Historial de trabajos terminados.
+ */
+QList<JobStats> JobQueue::history() const
+{
+    return finished;
+}
+
+/**
+ * @brief Indica si no queda nada en cola ni en curso.
+ */
+bool JobQueue::isIdle() const
+{
+    return queued.empty() && running.isEmpty();
+}
+
+/**
+ * @brief Informe de los trabajos terminados: ID, estado, espera y duración en ms.
+ */
+QString JobQueue::report() const
+{
+    QString text = QString("%1  %2 %3 %4  %5\n")
+                       .arg(QString("id"), 5)
+                       .arg(QString("estado"), -10)
+                       .arg(QString("espera ms"), 10)
+                       .arg(QString("duración ms"), 12)
+                       .arg(QString("trabajo"));
+    for (const JobStats &s : finished) {
+        text += QString("%1  %2 %3 %4  %5%6\n")
+                    .arg(s.id, 5)
+                    .arg(stateName(s.state), -10)
+                    .arg(s.waitNs / 1e6, 10, 'f', 1)
+                    .arg(s.runNs / 1e6, 12, 'f', 1)
+                    .arg(s.title)
+                    .arg(s.detail.isEmpty() ? QString() : " (" + s.detail + ")");
+    }
+    return text;
+}
+
+/**
+ * @brief Nombre del estado para la interfaz y el informe.
+ */
+QString JobQueue::stateName(JobState state)
+{
+    switch (state) {
+    case JobState::Queued:
+        return "en cola";
+    case JobState::Running:
+        return "en curso";
+    case JobState::Done:
+        return "terminado";
+    case JobState::Failed:
+        return "falló";
+    case JobState::Canceled:
+        return "cancelado";
+    }
+    return QString();
+}
+
+/**
+ * @brief Reparte los trabajos en cola entre los hilos libres.
+ *
+ * Se respeta el orden de llegada, salvo que un trabajo de escritura
+ * espera a que termine el de escritura en curso y los de lectura que
+ * vienen detrás pueden adelantarlo.
+ */
+void JobQueue::dispatch()
+{
+    if (path.isEmpty()) {
+        // Base en memoria: de a uno, en el hilo del dueño, con el gestor local
+        if (localBusy || queued.empty()) {
+            return;
+        }
+        std::shared_ptr<Job> job = queued.front();
+        queued.pop_front();
+        running.append(job);
+        localBusy = true;
+        emit jobStarted(job->start());
+
+        QTimer::singleShot(0, this, [this, job]() {
+            execute(job, local, DatabaseManager::getDatabase());
+            finish(nullptr, job);
+        });
+        return;
+    }
+
+    for (auto it = queued.begin(); it != queued.end();) {
+        const std::shared_ptr<Job> job = *it;
+        if (job->mode != JobMode::Read && writing) {
+            ++it;
+            continue;
+        }
+
+        Worker *idle = nullptr;
+        for (auto &worker : workers) {
+            if (!worker->job) {
+                idle = worker.get();
+                break;
+            }
+        }
+        if (!idle) {
+            return;
+        }
+
+        it = queued.erase(it);
+        running.append(job);
+        idle->job = job;
+        if (job->mode != JobMode::Read) {
+            writing = true;
+        }
+        emit jobStarted(job->start());
+
+        if (!idle->thread.isRunning()) {
+            idle->thread.start();
+        }
+        const QString file = path;
+        QMetaObject::invokeMethod(idle->context, [this, idle, job, file]() {
+            if (!idle->manager) {
+                QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", idle->connection);
+                db.setDatabaseName(file);
+                // Rige para las sentencias del trabajo; InventoryManager solo
+                // acorta la espera mientras toma el bloqueo de escritura
+                db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+                if (db.open()) {
+                    // Los cambios los sigue el gestor local; este solo escribe
+                    idle->manager = std::make_unique<InventoryManager>(db);
+                    idle->manager->deferChangeTracking();
+                } else {
+                    qDebug() << "No se pudo abrir la conexión de trabajos:" << db.lastError();
+                }
+            }
+
+            if (idle->manager) {
+                execute(job, *idle->manager, QSqlDatabase::database(idle->connection, false));
+            } else {
+                QSqlDatabase::removeDatabase(idle->connection);
+                QMutexLocker lock(&job->mutex);
+                job->stats.state = JobState::Failed;
+                job->stats.detail = "No se pudo abrir la base de datos.";
+            }
+            QMetaObject::invokeMethod(this, [this, idle, job]() { finish(idle, job); },
+                                      Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief Corre el cuerpo de un trabajo y decide su estado final.
+ *
+ * Los trabajos de escritura corren dentro de
+ * InventoryManager::writeAtomically: si el cuerpo retorna false o se
+ * canceló antes de confirmar, todo lo escrito se deshace. Los de
+ * escritura por lotes confirman cada uno con JobContext::write.
+ */
+void JobQueue::execute(const std::shared_ptr<Job> &job, InventoryManager &inventory, QSqlDatabase db)
+{
+    JobContext context(job, inventory, db);
+    bool bodyOk = false;
+    bool ok = false;
+
+    if (!context.isCanceled()) {
+        if (job->mode == JobMode::Write) {
+            ok = inventory.writeAtomically([&]() {
+                bodyOk = job->body(context) && !context.isCanceled();
+                return bodyOk;
+            });
+        } else {
+            ok = bodyOk = job->body(context);
+        }
+    }
+
+    QMutexLocker lock(&job->mutex);
+    job->stats.runNs = job->clock.nsecsElapsed() - job->stats.waitNs;
+    if (ok) {
+        job->stats.state = JobState::Done;
+    } else if (context.isCanceled()) {
+        job->stats.state = JobState::Canceled;
+    } else {
+        job->stats.state = JobState::Failed;
+        if (bodyOk) {
+            job->stats.detail = "No se pudieron confirmar los cambios.";
+        } else if (job->stats.detail.isEmpty()) {
+            job->stats.detail = "El trabajo no se completó.";
+        }
+    }
+}
+
+/**
+ * @brief Cierra un trabajo en el hilo del dueño: historial, aviso y siguiente.
+ */
+void JobQueue::finish(Worker *worker, const std::shared_ptr<Job> &job)
+{
+    // Un trabajo cancelado en cola nunca llegó a ocupar un hilo
+    const bool started = running.removeOne(job);
+    if (worker) {
+        worker->job.reset();
+    }
+    if (path.isEmpty() && started) {
+        localBusy = false;
+    }
+    if (job->mode != JobMode::Read && worker) {
+        writing = false;
+        // Lo escrito en otra conexión llega a las vistas por el registro de cambios
+        local.pollExternalChanges();
+    }
+
+    const JobStats result = job->snapshot();
+    finished.append(result);
+    if (finished.size() > kHistoryLimit) {
+        finished.removeFirst();
+    }
+    emit jobFinished(result);
+    dispatch();
+}
+
+/**
+ * @brief Cierra el gestor y la conexión del hilo y lo detiene.
+ *
+ * El cierre se encola detrás del trabajo en curso, así que este termina
+ * (y confirma o deshace) antes de que el hilo se detenga.
+ */
+void JobQueue::close(Worker &worker)
+{
+    if (!worker.thread.isRunning()) {
+        return;
+    }
+
+    Worker *target = &worker;
+    QMetaObject::invokeMethod(worker.context, [target]() {
+        target->manager.reset();
+        {
+            QSqlDatabase db = QSqlDatabase::database(target->connection, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(target->connection);
+    }, Qt::BlockingQueuedConnection);
+
+    worker.thread.quit();
+    worker.thread.wait();
+}
@@ -0,0 +1,396 @@
+#include "OnlineBackup.h"
+#include "DatabaseManager.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <sqlite3.h>
+
+/**
+ * @brief Reinicios tolerados antes de copiar desde una instantánea fija.
+ */
+static const int kMaxRestarts = 3;
+
+/**
+ * @brief Tamaño de página de la base "main" de una conexión, en bytes.
+ */
+static int pageSize(sqlite3 *handle)
+{
+    int size = 0;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, "PRAGMA page_size", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            size = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return size;
+}
+
+/**
+ * @brief Modo de diario de la base "main" de una conexión ("wal", "delete", ...).
+ */
+static QByteArray journalMode(sqlite3 *handle)
+{
+    QByteArray mode;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, "PRAGMA journal_mode", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            mode = QByteArray(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))).toLower();
+        }
+        sqlite3_finalize(stmt);
+    }
+    return mode;
+}
+
+/**
+ * @brief Crea el respaldo sobre la conexión origen; no empieza a copiar.
+ */
+OnlineBackup::OnlineBackup(QSqlDatabase source, QObject *parent)
+    : QObject(parent), source(source)
+{
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, &OnlineBackup::step);
+
+    worker = new QObject;
+    worker->moveToThread(&thread);
+    thread.setObjectName("respaldo");
+}
+
+/**
+ * @brief Abandona el respaldo en curso, si lo hay; espera la verificación en curso.
+ */
+OnlineBackup::~OnlineBackup()
+{
+    const bool unfinished = isRunning();
+    timer.stop();
+    if (backup) {
+        sqlite3_backup_finish(backup);
+        sqlite3_close(dest);
+    }
+    sqlite3_close(snapshot);
+
+    thread.quit();
+    thread.wait();
+    delete worker;
+
+    if (unfinished) {
+        QFile::remove(partial);
+    }
+}
+
+/**
+ * @brief Abre el archivo parcial e inicia la copia; el primer paso va al bucle de eventos.
+ */
+bool OnlineBackup::start(const QString &targetPath, int pagesPerStep, int pauseMs)
+{
+    if (isRunning()) {
+        qDebug() << "Ya hay un respaldo en curso.";
+        return false;
+    }
+
+    sqlite3 *handle = DatabaseManager::nativeHandle(source);
+    if (!handle) {
+        qDebug() << "La conexión origen no es una base SQLite abierta.";
+        return false;
+    }
+
+    target = targetPath;
+    partial = targetPath + ".parcial";
+    QFile::remove(partial);
+
+    if (sqlite3_open_v2(partial.toUtf8().constData(), &dest,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo crear el archivo de respaldo:" << partial << sqlite3_errmsg(dest);
+        sqlite3_close(dest);
+        dest = nullptr;
+        return false;
+    }
+
+    backup = sqlite3_backup_init(dest, "main", handle, "main");
+    if (!backup) {
+        qDebug() << "No se pudo iniciar el respaldo:" << sqlite3_errmsg(dest);
+        sqlite3_close(dest);
+        dest = nullptr;
+        QFile::remove(partial);
+        return false;
+    }
+
+    stepPages = pagesPerStep > 0 ? pagesPerStep : -1;
+    lastRemaining = -1;
+    cancelled = false;
+    current = BackupStats();
+    current.pageSize = pageSize(handle);
+    timer.setInterval(qMax(0, pauseMs));
+    clock.start();
+    QTimer::singleShot(0, this, &OnlineBackup::step);
+    return true;
+}
+
+/**
+ * @brief Abandona la copia; borra el archivo parcial.
+ *
+ * Durante la verificación solo se marca: al terminar, la copia se
+ * descarta en lugar de reemplazar el destino.
+ */
+void OnlineBackup::cancel()
+{
+    if (backup) {
+        timer.stop();
+        complete(false, "respaldo cancelado");
+    } else if (verifying) {
+        cancelled = true;
+    }
+}
+
+/**
+ * @brief Indica si hay un respaldo en curso.
+ */
+bool OnlineBackup::isRunning() const
+{
+    return backup != nullptr || verifying;
+}
+
+/**
+ * @brief Estado actual (o final) del respaldo.
+ */
+BackupStats OnlineBackup::stats() const
+{
+    return current;
+}
+
+/**
+ * @brief Copia un paso de páginas y programa el siguiente tras la pausa.
+ *
+ * Mientras dura el paso, SQLite tiene una transacción de lectura sobre el
+ * origen; al volver, la conexión queda libre para escribir. Si la base
+ * está bloqueada el paso no avanza y se intenta de nuevo tras la pausa.
+ * Ningún paso copia más de stepPages páginas, ni siquiera cuando el
+ * origen obliga a reiniciar una y otra vez (ver @ref pinSnapshot).
+ */
+void OnlineBackup::step()
+{
+    if (!backup) {
+        return;
+    }
+
+    const int before = lastRemaining;
+
+    QElapsedTimer stepTimer;
+    stepTimer.start();
+    const int rc = sqlite3_backup_step(backup, stepPages);
+    const qint64 stepNs = stepTimer.nsecsElapsed();
+
+    current.steps++;
+    current.copyNs += stepNs;
+    current.maxStepNs = qMax(current.maxStepNs, stepNs);
+    current.elapsedNs = clock.nsecsElapsed();
+
+    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        current.busySteps++;
+        emit progress(current);
+        timer.start();
+        return;
+    }
+    if (rc != SQLITE_OK && rc != SQLITE_DONE) {
+        complete(false, QString::fromUtf8(sqlite3_errstr(rc)));
+        return;
+    }
+
+    current.pageCount = sqlite3_backup_pagecount(backup);
+    current.remaining = sqlite3_backup_remaining(backup);
+    lastRemaining = current.remaining;
+    const bool restarted = before >= 0 && current.remaining > before;
+    if (restarted) {
+        // Otra conexión escribió en el origen: SQLite empezó de nuevo
+        current.restarts++;
+        current.pagesWritten += current.pageCount - current.remaining;
+    } else {
+        current.pagesWritten += (before >= 0 ? before : current.pageCount) - current.remaining;
+    }
+
+    if (rc == SQLITE_DONE) {
+        complete(true, QString());
+        return;
+    }
+    if (restarted && current.restarts == kMaxRestarts && !pinSnapshot()) {
+        qDebug() << "El origen cambia sin parar y no está en modo WAL; el respaldo sigue por pasos.";
+    }
+    emit progress(current);
+    timer.start();
+}
+
+/**
+ * @brief Vuelve a empezar la copia desde una conexión de solo lectura propia
+ * con una transacción de lectura abierta.
+ *
+ * En modo WAL esa transacción fija una instantánea: las escrituras de otras
+ * conexiones (y de la principal) ya no la cambian, así que la copia no se
+ * reinicia más y los escritores siguen sin esperar. La instantánea se suelta
+ * al cerrar la conexión en @ref complete.
+ */
+bool OnlineBackup::pinSnapshot()
+{
+    sqlite3 *handle = DatabaseManager::nativeHandle(source);
+    const char *file = handle ? sqlite3_db_filename(handle, "main") : nullptr;
+    if (!file || !*file || journalMode(handle) != "wal") {
+        return false;
+    }
+
+    sqlite3 *reader = nullptr;
+    if (sqlite3_open_v2(file, &reader, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK
+        || sqlite3_exec(reader, "BEGIN; SELECT count(*) FROM sqlite_master", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        qDebug() << "No se pudo fijar una instantánea para el respaldo:" << sqlite3_errmsg(reader);
+        sqlite3_close(reader);
+        return false;
+    }
+
+    sqlite3_backup_finish(backup);
+    backup = sqlite3_backup_init(dest, "main", reader, "main");
+    if (!backup) {
+        qDebug() << "No se pudo copiar desde la instantánea:" << sqlite3_errmsg(dest);
+        sqlite3_close(reader);
+        backup = sqlite3_backup_init(dest, "main", handle, "main");
+        return false;
+    }
+
+    qDebug() << "El origen cambia sin parar; el respaldo sigue desde una instantánea fija.";
+    snapshot = reader;
+    lastRemaining = -1;
+    current.pinned = true;
+    return true;
+}
+
+/**
+ * @brief Cierra la copia y, si terminó, manda a verificarla al hilo de verificación.
+ *
+ * `PRAGMA integrity_check` recorre la copia entera, así que no corre en
+ * el hilo de la conexión origen: @ref verify abre su propia conexión en
+ * @ref thread y el resultado vuelve por @ref finishVerify.
+ *
+ * @param copied true si sqlite3_backup_step devolvió SQLITE_DONE.
+ * @param error Motivo, si no terminó.
+ */
+void OnlineBackup::complete(bool copied, const QString &error)
+{
+    const int rc = sqlite3_backup_finish(backup);
+    backup = nullptr;
+    sqlite3_close(dest);
+    dest = nullptr;
+    sqlite3_close(snapshot);
+    snapshot = nullptr;
+
+    if (!copied) {
+        finish(false, error);
+        return;
+    }
+    if (rc != SQLITE_OK) {
+        finish(false, QString::fromUtf8(sqlite3_errstr(rc)));
+        return;
+    }
+
+    verifying = true;
+    if (!thread.isRunning()) {
+        thread.start(QThread::LowestPriority);
+    }
+    const QString file = partial;
+    QMetaObject::invokeMethod(worker, [this, file]() {
+        QString integrity;
+        const bool verified = verify(file, &integrity);
+        QMetaObject::invokeMethod(this, [this, verified, integrity]() {
+            finishVerify(verified, integrity);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Pone la copia verificada en lugar del destino.
+ *
+ * El respaldo anterior se aparta a "<destino>.anterior" antes de mover la
+ * copia y se borra solo cuando la copia ya ocupa su lugar; si algo falla
+ * a mitad, se devuelve a su nombre. Nunca hay un momento sin respaldo.
+ */
+void OnlineBackup::finishVerify(bool verified, const QString &integrity)
+{
+    verifying = false;
+    current.integrity = integrity;
+    if (cancelled) {
+        finish(false, "respaldo cancelado");
+        return;
+    }
+    if (!verified) {
+        finish(false, "la copia no pasó la verificación de integridad");
+        return;
+    }
+
+    const QString previous = target + ".anterior";
+    QFile::remove(previous);
+    const bool hadPrevious = QFile::exists(target);
+    if (hadPrevious && !QFile::rename(target, previous)) {
+        finish(false, "no se pudo apartar el respaldo anterior " + target);
+        return;
+    }
+    if (!QFile::rename(partial, target)) {
+        if (hadPrevious) {
+            QFile::rename(previous, target);
+        }
+        finish(false, "no se pudo mover la copia a " + target);
+        return;
+    }
+    QFile::remove(previous);
+    finish(true, QString());
+}
+
+/**
+ * @brief Registra el final: descarta la copia si falló y emite @ref finished.
+ */
+void OnlineBackup::finish(bool ok, const QString &problem)
+{
+    if (!ok) {
+        QFile::remove(partial);
+        qDebug() << "Respaldo fallido:" << problem;
+    }
+
+    current.elapsedNs = clock.nsecsElapsed();
+    current.finished = true;
+    current.ok = ok;
+    emit finished(ok, current);
+}
+
+/**
+ * @brief Deja el archivo en modo de diario DELETE y ejecuta PRAGMA integrity_check.
+ *
+ * La copia hereda el modo WAL del origen; pasarla a DELETE la deja en un
+ * único archivo, sin "-wal" ni "-shm", listo para guardarse o restaurarse.
+ */
+bool OnlineBackup::verify(const QString &path, QString *message)
+{
+    sqlite3 *handle = nullptr;
+    if (sqlite3_open_v2(path.toUtf8().constData(), &handle, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        if (message) {
+            *message = QString::fromUtf8(sqlite3_errmsg(handle));
+        }
+        sqlite3_close(handle);
+        return false;
+    }
+
+    sqlite3_exec(handle, "PRAGMA journal_mode=DELETE", nullptr, nullptr, nullptr);
+
+    QStringList lines;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, "PRAGMA integrity_check", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            lines.append(QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))));
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        lines.append(QString::fromUtf8(sqlite3_errmsg(handle)));
+    }
+    sqlite3_close(handle);
+
+    const QString result = lines.join("\n");
+    if (message) {
+        *message = result;
+    }
+    return result == "ok";
+}
@@ -0,0 +1,245 @@
+#include "QueryDiagnostics.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QSqlQuery>
+#include <QSqlResult>
+#include <QVariant>
+#include <algorithm>
+#include <sqlite3.h>
+
+/**
+ * @brief Ejecuciones a partir de las cuales una sentencia se considera frecuente.
+ */
+static const qint64 kHotExecutions = 20;
+
+/**
+ * @brief Filas recorridas en total a partir de las cuales una sentencia se considera costosa.
+ */
+static const qint64 kHotRowsScanned = 100000;
+
+/**
+ * @brief Obtiene la sentencia nativa sqlite3_stmt* de un QSqlQuery.
+ *
+ * @return Sentencia, o nullptr si la consulta no está preparada o no es SQLite.
+ */
+static sqlite3_stmt *statementHandle(const QSqlQuery &query)
+{
+    const QVariant handle = query.result() ? query.result()->handle() : QVariant();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3_stmt*") != 0) {
+        return nullptr;
+    }
+    return *static_cast<sqlite3_stmt *const *>(handle.constData());
+}
+
+/**
+ * @brief Clave de una sentencia: su texto con las listas `?, ?, ...` abreviadas.
+ *
+ * Las búsquedas por lote generan `IN (?, ?, ...)` de longitudes distintas;
+ * todas tienen el mismo plan y se agrupan como una sola sentencia.
+ */
+static QString statementKey(const QString &sql)
+{
+    static const QRegularExpression placeholders("\\?(\\s*,\\s*\\?)+");
+    QString key = sql.simplified();
+    key.replace(placeholders, "?, ...");
+    return key;
+}
+
+/**
+ * @brief Ejecuta EXPLAIN QUERY PLAN sobre la conexión de la sentencia.
+ *
+ * Los parámetros quedan sin enlazar (NULL); el plan no depende de sus
+ * valores. Cada línea lleva dos espacios de sangría por nivel del árbol.
+ */
+static QStringList explainPlan(sqlite3 *handle, const char *sql)
+{
+    QStringList lines;
+    const QByteArray explain = QByteArray("EXPLAIN QUERY PLAN ") + sql;
+
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, explain.constData(), int(explain.size()), &stmt, nullptr) != SQLITE_OK) {
+        lines.append(QString("(sin plan: %1)").arg(QString::fromUtf8(sqlite3_errmsg(handle))));
+        return lines;
+    }
+
+    // Columnas: id, parent, notused, detail
+    QHash<int, int> depthOf;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const int id = sqlite3_column_int(stmt, 0);
+        const int parent = sqlite3_column_int(stmt, 1);
+        const int depth = depthOf.value(parent, -1) + 1;
+        depthOf.insert(id, depth);
+
+        const QString detail = QString::fromUtf8(
+            reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)));
+        lines.append(QString(depth * 2, QChar(' ')) + detail);
+    }
+    sqlite3_finalize(stmt);
+    return lines;
+}
+
+/**
+ * @brief Indica si alguna línea del plan recorre completa una tabla del inventario.
+ *
+ * Cubre `inventario` y sus tablas auxiliares (`inventario_claves`,
+ * `inventario_cambios`). SQLite escribe "SCAN inventario" (o "SCAN TABLE
+ * inventario" en versiones anteriores a 3.36); un recorrido por índice
+ * añade "USING ... INDEX" y no se marca.
+ */
+static bool planScansInventario(const QStringList &plan)
+{
+    static const QRegularExpression fullScan("^SCAN (TABLE )?inventario\\w*(\\s+AS\\s+\\w+)?$");
+    for (const QString &line : plan) {
+        if (fullScan.match(line.trimmed()).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Empieza a medir si el diagnóstico está activo.
+ */
+QueryDiagnostics::Probe::Probe(QueryDiagnostics &diagnostics, const QSqlQuery &query)
+    : diagnostics(diagnostics), query(query)
+{
+    if (diagnostics.isEnabled()) {
+        timer.start();
+    }
+}
+
+/**
+ * @brief Registra la sentencia si no se hizo antes con finish().
+ */
+QueryDiagnostics::Probe::~Probe()
+{
+    finish();
+}
+
+/**
+ * @brief Registra la sentencia con el tiempo transcurrido desde el constructor.
+ *
+ * Solo la primera llamada registra.
+ */
+void QueryDiagnostics::Probe::finish()
+{
+    if (!timer.isValid()) {
+        return;
+    }
+    if (sqlite3_stmt *stmt = statementHandle(query)) {
+        diagnostics.record(stmt, timer.nsecsElapsed());
+    }
+    timer.invalidate();
+}
+
+/**
+ * @brief Activa o desactiva el diagnóstico. Al desactivarlo se conservan los datos.
+ */
+void QueryDiagnostics::setEnabled(bool value)
+{
+    enabled = value;
+}
+
+/**
+ * @brief Suma una ejecución a las estadísticas de su sentencia.
+ *
+ * La primera vez que aparece la sentencia se obtiene su plan. Los
+ * contadores de la sentencia se leen y se reinician, así que una
+ * sentencia preparada y reutilizada aporta solo lo de esta ejecución.
+ *
+ * @param stmt Sentencia nativa, aún sin finalizar.
+ * @param elapsedNs Tiempo de la ejecución, incluida la lectura de filas.
+ */
+void QueryDiagnostics::record(sqlite3_stmt *stmt, qint64 elapsedNs)
+{
+    if (!enabled || !stmt) {
+        return;
+    }
+
+    const char *sql = sqlite3_sql(stmt);
+    if (!sql) {
+        return;
+    }
+    const QString key = statementKey(QString::fromUtf8(sql));
+
+    auto it = stats.find(key);
+    if (it == stats.end()) {
+        QueryPlanStats entry;
+        entry.sql = key;
+        entry.plan = explainPlan(sqlite3_db_handle(stmt), sql);
+        entry.fullScan = planScansInventario(entry.plan);
+        it = stats.insert(key, entry);
+    }
+
+    QueryPlanStats &s = it.value();
+    s.executions++;
+    s.totalNs += elapsedNs;
+    s.maxNs = qMax(s.maxNs, elapsedNs);
+    s.rowsScanned += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    s.vmSteps += sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+
+    if (s.fullScan && !s.warned
+        && (s.executions >= kHotExecutions || s.rowsScanned >= kHotRowsScanned)) {
+        s.warned = true;
+        qWarning().noquote() << "Consulta frecuente con recorrido completo de inventario ("
+                             << s.executions << "ejecuciones," << s.rowsScanned
+                             << "filas recorridas):" << s.sql << "\n  plan:" << s.plan.join(" | ");
+    }
+}
+
+/**
+ * @brief Sentencias registradas, ordenadas por tiempo total descendente.
+ */
+QList<QueryPlanStats> QueryDiagnostics::statements() const
+{
+    QList<QueryPlanStats> list = stats.values();
+    std::sort(list.begin(), list.end(), [](const QueryPlanStats &a, const QueryPlanStats &b) {
+        return a.totalNs > b.totalNs;
+    });
+    return list;
+}
+
+/**
+ * @brief Informe legible de todas las sentencias registradas.
+ *
+ * Cada entrada muestra si recorre la tabla completa, las ejecuciones, el
+ * tiempo total, medio y máximo, las filas recorridas y el plan.
+ */
+QString QueryDiagnostics::report() const
+{
+    const QList<QueryPlanStats> list = statements();
+
+    QString text;
+    int scans = 0;
+    for (const QueryPlanStats &s : list) {
+        if (s.fullScan) {
+            scans++;
+        }
+    }
+    text += QString("Diagnóstico de consultas: %1 sentencias, %2 con recorrido completo de inventario\n")
+                .arg(list.size()).arg(scans);
+
+    for (const QueryPlanStats &s : list) {
+        text += QString("\n%1%2\n").arg(QString(s.fullScan ? "[RECORRIDO COMPLETO] " : ""), s.sql);
+        text += QString("  %1 ejecuciones, total %2 ms, media %3 ms, máx %4 ms\n")
+                    .arg(s.executions)
+                    .arg(s.totalNs / 1e6, 0, 'f', 3)
+                    .arg(s.executions > 0 ? s.totalNs / 1e6 / s.executions : 0.0, 0, 'f', 3)
+                    .arg(s.maxNs / 1e6, 0, 'f', 3);
+        text += QString("  %1 filas recorridas en recorridos completos, %2 pasos de VM\n")
+                    .arg(s.rowsScanned).arg(s.vmSteps);
+        for (const QString &line : s.plan) {
+            text += "    " + line + "\n";
+        }
+    }
+    return text;
+}
+
+/**
+ * @brief Descarta todas las estadísticas (el modo sigue como estaba).
+ */
+void QueryDiagnostics::reset()
+{
+    stats.clear();
+}
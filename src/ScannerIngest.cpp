@@ -0,0 +1,354 @@
+#include "ScannerIngest.h"
+#include "InventoryManager.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QFile>
+#include <QDebug>
+#include <utility>
+
+/**
+ * @brief Máximo de bytes leídos del archivo seguido en cada sondeo.
+ */
+static const qint64 kTailChunk = 1 << 20;
+
+/**
+ * @brief Vaciados seguidos en que se reintenta un lote fallido antes de descartarlo.
+ *
+ * Con la ventana por defecto (50 ms) son unos 10 s: cubre una base
+ * bloqueada por otra estación, no un lote que nunca podrá aplicarse.
+ */
+static const int kMaxFlushRetries = 200;
+
+/**
+ * @brief Constructor: prepara la cola y arranca el temporizador de vaciado.
+ *
+ * @param manager Gestor a través del cual se escriben los lotes.
+ * @param capacity Capacidad de la cola de eventos.
+ * @param windowMs Ventana de agrupación en milisegundos.
+ * @param parent Objeto padre opcional.
+ */
+ScannerIngest::ScannerIngest(InventoryManager &manager,
+                             int capacity,
+                             int windowMs,
+                             QObject *parent)
+    : QObject(parent),
+      manager(manager),
+      queue(std::size_t(qMax(capacity, 2)))
+{
+    counters.queueCapacity = int(queue.capacity());
+
+    flushTimer.setInterval(windowMs);
+    connect(&flushTimer, &QTimer::timeout, this, &ScannerIngest::flush);
+    flushTimer.start();
+
+    tailTimer.setInterval(200);
+    connect(&tailTimer, &QTimer::timeout, this, &ScannerIngest::readTail);
+}
+
+/**
+ * @brief Destructor: aplica lo que quede en la cola antes de salir.
+ *
+ * Las señales se bloquean porque, en este punto, quien las recibe
+ * puede estar destruyéndose también.
+ */
+ScannerIngest::~ScannerIngest()
+{
+    blockSignals(true);
+    flush();
+    if (retryEvents > 0) {
+        qDebug() << "Se pierden" << retryEvents << "eventos de escáneres sin confirmar";
+    }
+}
+
+/**
+ * @brief Encola un movimiento sin bloquear.
+ *
+ * @param id ID del ítem.
+ * @param delta Variación de cantidad.
+ * @return false si la cola está llena; el evento se cuenta como descartado.
+ */
+bool ScannerIngest::push(int id, int delta)
+{
+    if (!queue.tryPush(ScanEvent{id, delta})) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    received.fetch_add(1, std::memory_order_relaxed);
+    noteDepth();
+    return true;
+}
+
+/**
+ * @brief Abre el socket local donde se conectan los escáneres.
+ *
+ * Si quedó un socket huérfano de una ejecución anterior, se elimina antes.
+ *
+ * @param name Nombre del socket.
+ * @return true si el servidor quedó escuchando.
+ */
+bool ScannerIngest::listen(const QString &name)
+{
+    if (!server) {
+        server = new QLocalServer(this);
+        connect(server, &QLocalServer::newConnection, this, &ScannerIngest::onNewConnection);
+    }
+
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        qDebug() << "No se pudo escuchar en el socket" << name << ":" << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Empieza a seguir el final de un archivo de movimientos.
+ *
+ * @param path Ruta del archivo.
+ * @return true si el archivo pudo abrirse.
+ */
+bool ScannerIngest::tailFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "No se puede seguir el archivo:" << path;
+        return false;
+    }
+
+    tailPath = path;
+    tailOffset = file.size();
+    tailPending.clear();
+    tailTimer.start();
+    return true;
+}
+
+/** @brief Ventana de agrupación en milisegundos. */
+int ScannerIngest::window() const
+{
+    return flushTimer.interval();
+}
+
+/** @brief Cambia la ventana de agrupación. */
+void ScannerIngest::setWindow(int windowMs)
+{
+    flushTimer.setInterval(windowMs);
+}
+
+/**
+ * @brief Devuelve una copia de las métricas, combinando las de productores y consumidor.
+ */
+IngestStats ScannerIngest::stats() const
+{
+    IngestStats s = counters;
+    s.received = received.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.queueDepth = int(queue.sizeApprox());
+    s.maxQueueDepth = maxDepth.load(std::memory_order_relaxed);
+    return s;
+}
+
+/**
+ * @brief Vacía la cola, agrupa por ítem y aplica el lote.
+ *
+ * En cada llamada se extraen como máximo tantos eventos como la capacidad
+ * de la cola, para que un productor muy rápido no retenga el hilo aquí.
+ * Si el lote anterior no se pudo confirmar, se suma a este; tras
+ * @ref kMaxFlushRetries fallos seguidos se descarta.
+ * Al terminar se reanudan las fuentes que estaban pausadas.
+ */
+void ScannerIngest::flush()
+{
+    QHash<int, int> deltas = std::exchange(retryDeltas, {});
+    qint64 events = std::exchange(retryEvents, 0);
+    ScanEvent ev;
+
+    const qint64 limit = events + qint64(queue.capacity());
+    while (events < limit && queue.tryPop(ev)) {
+        deltas[ev.id] += ev.delta;
+        events++;
+    }
+
+    // Los movimientos que se cancelan entre sí no generan escritura
+    for (auto it = deltas.begin(); it != deltas.end();) {
+        it = (it.value() == 0) ? deltas.erase(it) : std::next(it);
+    }
+
+    if (deltas.isEmpty()) {
+        counters.applied += events;
+        retries = 0;
+    } else {
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = manager.applyQuantityDeltas(deltas);
+        counters.flushNs += timer.nsecsElapsed();
+
+        if (ok) {
+            counters.batches++;
+            counters.applied += events;
+            counters.itemUpdates += deltas.size();
+            retries = 0;
+            emit batchApplied(deltas.keys());
+        } else {
+            counters.failedBatches++;
+            if (++retries < kMaxFlushRetries) {
+                retryDeltas = std::move(deltas);
+                retryEvents = events;
+            } else {
+                qDebug() << "Lote de escáneres descartado tras" << retries << "intentos:"
+                         << events << "eventos";
+                counters.discarded += events;
+                retries = 0;
+            }
+        }
+    }
+
+    for (QLocalSocket *socket : sockets) {
+        if (stalled.contains(socket) || socket->canReadLine()) {
+            readSocket(socket);
+        }
+    }
+}
+
+/**
+ * @brief Registra cada escáner que se conecta al socket local.
+ */
+void ScannerIngest::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        sockets.append(socket);
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            readSocket(socket);
+        });
+
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            // Procesar lo que el escáner alcanzó a enviar antes de cerrar
+            while (stalled.contains(socket) || socket->canReadLine()) {
+                flush();
+                readSocket(socket);
+            }
+            sockets.removeOne(socket);
+            stalled.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+/**
+ * @brief Lee líneas de un escáner hasta vaciar su búfer o llenar la cola.
+ *
+ * Si la cola se llena, la línea en curso se guarda y la lectura se
+ * detiene; el resto de los datos queda en el búfer del socket, lo que
+ * termina frenando al emisor.
+ *
+ * @param socket Escáner del que se lee.
+ */
+void ScannerIngest::readSocket(QLocalSocket *socket)
+{
+    auto pending = stalled.find(socket);
+    if (pending != stalled.end()) {
+        if (!enqueueLine(*pending)) {
+            return;
+        }
+        stalled.erase(pending);
+    }
+
+    while (socket->canReadLine()) {
+        const QByteArray line = socket->readLine();
+        if (!enqueueLine(line)) {
+            stalled.insert(socket, line);
+            counters.stalls++;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Procesa las líneas nuevas del archivo seguido.
+ *
+ * Si el archivo se truncó (rotación), se vuelve a leer desde el inicio.
+ */
+void ScannerIngest::readTail()
+{
+    QFile file(tailPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    if (file.size() < tailOffset) {
+        tailOffset = 0;
+        tailPending.clear();
+    }
+
+    // Con una línea pausada pendiente no se sigue acumulando en memoria
+    if (tailPending.size() < kTailChunk && file.size() > tailOffset) {
+        file.seek(tailOffset);
+        const QByteArray chunk = file.read(kTailChunk);
+        tailOffset += chunk.size();
+        tailPending += chunk;
+    }
+
+    qsizetype start = 0;
+    qsizetype end;
+    while ((end = tailPending.indexOf('\n', start)) >= 0) {
+        if (!enqueueLine(tailPending.mid(start, end - start))) {
+            counters.stalls++;
+            break;
+        }
+        start = end + 1;
+    }
+    tailPending.remove(0, start);
+}
+
+/**
+ * @brief Interpreta una línea `<id> <delta>` y la encola.
+ *
+ * Las líneas vacías o que empiezan con `#` se ignoran; las mal formadas
+ * se cuentan y se descartan.
+ *
+ * @param line Línea recibida (con o sin salto de línea final).
+ * @return false únicamente si la cola está llena.
+ */
+bool ScannerIngest::enqueueLine(const QByteArray &line)
+{
+    QByteArray text = line;
+    text.replace(',', ' ').replace(';', ' ');
+    text = text.simplified();
+
+    if (text.isEmpty() || text.startsWith('#')) {
+        return true;
+    }
+
+    const QList<QByteArray> parts = text.split(' ');
+    bool okId = false;
+    bool okDelta = false;
+    const int id = parts.value(0).toInt(&okId);
+    const int delta = parts.value(1).toInt(&okDelta);
+
+    if (parts.size() != 2 || !okId || !okDelta) {
+        counters.malformed++;
+        return true;
+    }
+
+    if (!queue.tryPush(ScanEvent{id, delta})) {
+        return false;
+    }
+
+    received.fetch_add(1, std::memory_order_relaxed);
+    noteDepth();
+    return true;
+}
+
+/**
+ * @brief Actualiza la ocupación máxima de la cola (seguro entre hilos).
+ */
+void ScannerIngest::noteDepth()
+{
+    const int depth = int(queue.sizeApprox());
+    int seen = maxDepth.load(std::memory_order_relaxed);
+    while (depth > seen
+           && !maxDepth.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+    }
+}
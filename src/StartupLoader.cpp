@@ -0,0 +1,97 @@
+#include "StartupLoader.h"
+#include "StartupTrace.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+
+/**
+ * @brief Constructor: reserva el hilo y el nombre de su conexión.
+ */
+StartupLoader::StartupLoader(const QString &databasePath, QObject *parent)
+    : QObject(parent),
+      path(QFileInfo(databasePath).absoluteFilePath()),
+      connection(QString("inventario_arranque_%1").arg(quintptr(this), 0, 16))
+{
+    worker = new QObject;
+    worker->moveToThread(&thread);
+    thread.setObjectName("arranque");
+}
+
+/**
+ * @brief Espera a que el hilo termine su paso en curso.
+ *
+ * Si la ventana se cierra durante el arranque, la lectura en curso
+ * termina y sus resultados se descartan.
+ */
+StartupLoader::~StartupLoader()
+{
+    thread.quit();
+    thread.wait();
+    delete worker;
+}
+
+/**
+ * @brief Verifica el esquema, lee los ítems y arma los índices en el hilo del cargador.
+ *
+ * La conexión se abre, se usa y se cierra dentro del hilo. La posición
+ * del registro de cambios y los ítems se leen en una misma transacción,
+ * así que ven una sola instantánea aunque la conexión principal ya esté
+ * escribiendo.
+ */
+void StartupLoader::start()
+{
+    if (thread.isRunning()) {
+        return;
+    }
+    thread.start();
+
+    const QString name = connection;
+    const QString file = path;
+    QThread *owner = QObject::thread();
+    QMetaObject::invokeMethod(worker, [this, name, file, owner]() {
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+            db.setDatabaseName(file);
+            db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+            bool ok = db.open();
+            if (!ok) {
+                qDebug() << "No se pudo abrir la conexión de arranque:" << db.lastError();
+            }
+
+            InventoryManager manager(db);
+            if (ok) {
+                StartupTrace::Scope phase("esquema");
+                ok = manager.createTable();
+            }
+            QMetaObject::invokeMethod(this, [this, ok]() { emit schemaReady(ok); }, Qt::QueuedConnection);
+
+            if (ok) {
+                QList<InventoryItem> items;
+                qint64 changeSeq = 0;
+                {
+                    StartupTrace::Scope phase("lectura de todos los ítems");
+                    const bool snapshot = db.transaction();
+                    changeSeq = manager.changePosition();
+                    items = manager.getAllItems();
+                    if (snapshot) {
+                        db.commit();
+                    }
+                }
+                auto indexes = std::make_shared<SearchIndexes>();
+                {
+                    StartupTrace::Scope phase("índices de búsqueda y facetas");
+                    indexes->build(items, owner);
+                }
+                QMetaObject::invokeMethod(this, [this, indexes, changeSeq]() {
+                    emit indexesReady(indexes, changeSeq);
+                }, Qt::QueuedConnection);
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+        QThread::currentThread()->quit();
+    }, Qt::QueuedConnection);
+}
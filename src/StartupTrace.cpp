@@ -0,0 +1,174 @@
+#include "StartupTrace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+/**
+ * @brief Estado compartido del registro (protegido por su mutex).
+ */
+struct TraceState {
+    QMutex mutex;
+    QElapsedTimer clock;
+    QList<StartupPhase> phases;
+};
+
+/**
+ * @brief Registro único del proceso.
+ */
+static TraceState &state()
+{
+    static TraceState instance;
+    return instance;
+}
+
+/**
+ * @brief Nombre del hilo que llama, para el informe.
+ *
+ * Antes de crear la aplicación solo corre el hilo principal.
+ */
+static QString currentThreadName()
+{
+    QThread *thread = QThread::currentThread();
+    const QCoreApplication *app = QCoreApplication::instance();
+    if (!app || thread == app->thread()) {
+        return QStringLiteral("principal");
+    }
+    return thread->objectName().isEmpty()
+               ? QString("hilo %1").arg(quintptr(thread), 0, 16)
+               : thread->objectName();
+}
+
+/**
+ * @brief Instante actual; arranca el reloj en el primer registro.
+ */
+static qint64 now(TraceState &s)
+{
+    if (!s.clock.isValid()) {
+        s.clock.start();
+    }
+    return s.clock.nsecsElapsed();
+}
+
+/**
+ * @brief Abre una fase en el hilo que llama.
+ */
+void StartupTrace::begin(const QString &phase)
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    StartupPhase p;
+    p.name = phase;
+    p.thread = currentThreadName();
+    p.startNs = now(s);
+    s.phases.append(p);
+}
+
+/**
+ * @brief Cierra la fase abierta más reciente con ese nombre.
+ */
+void StartupTrace::end(const QString &phase)
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    const qint64 t = now(s);
+    for (int i = int(s.phases.size()) - 1; i >= 0; i--) {
+        StartupPhase &p = s.phases[i];
+        if (p.endNs < 0 && p.name == phase) {
+            p.endNs = t;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Registra un hito.
+ */
+void StartupTrace::mark(const QString &event)
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    StartupPhase p;
+    p.name = event;
+    p.thread = currentThreadName();
+    p.startNs = now(s);
+    p.endNs = p.startNs;
+    s.phases.append(p);
+}
+
+/**
+ * @brief Tiempo desde el primer registro.
+ */
+qint64 StartupTrace::elapsedNs()
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    return now(s);
+}
+
+/**
+ * @brief Copia de las fases registradas, ordenadas por inicio.
+ */
+QList<StartupPhase> StartupTrace::phases()
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    QList<StartupPhase> result = s.phases;
+    std::stable_sort(result.begin(), result.end(),
+                     [](const StartupPhase &a, const StartupPhase &b) { return a.startNs < b.startNs; });
+    return result;
+}
+
+/**
+ * @brief Momento en que terminó la primera fase (o hito) con ese nombre.
+ */
+qint64 StartupTrace::reachedNs(const QString &name)
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    for (const StartupPhase &p : s.phases) {
+        if (p.name == name && p.endNs >= 0) {
+            return p.endNs;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Informe de las fases: inicio y duración en ms, hilo y nombre.
+ *
+ * Las fases que siguen abiertas se marcan con "(abierta)".
+ */
+QString StartupTrace::report()
+{
+    QString text = QString("%1 %2  %3  %4\n")
+                       .arg(QString("inicio ms"), 10)
+                       .arg(QString("duración ms"), 12)
+                       .arg(QString("hilo"), -14)
+                       .arg(QString("fase"));
+    for (const StartupPhase &p : phases()) {
+        const QString duration = p.endNs < 0 ? QString("(abierta)")
+                                 : p.endNs == p.startNs ? QString("-")
+                                 : QString::number(p.durationNs() / 1e6, 'f', 1);
+        text += QString("%1 %2  %3  %4\n")
+                    .arg(p.startNs / 1e6, 10, 'f', 1)
+                    .arg(duration, 12)
+                    .arg(p.thread, -14)
+                    .arg(p.name);
+    }
+    return text;
+}
+
+/**
+ * @brief Olvida lo registrado; el próximo registro vuelve a arrancar el reloj.
+ */
+void StartupTrace::reset()
+{
+    TraceState &s = state();
+    QMutexLocker lock(&s.mutex);
+    s.phases.clear();
+    s.clock.invalidate();
+}
@@ -1,5 +1,7 @@
 #include "component.h"
 
+#include <utility>
+
 /**
  * @brief Constructor por defecto.
  *
@@ -26,17 +28,17 @@ Component::Component()
  * @param purchase_date Fecha de adquisición.
  */
 Component::Component(int id,
-                     const QString &name,
-                     const QString &type,
+                     QString name,
+                     QString type,
                      int quantity,
-                     const QString &location,
-                     const QString &purchase_date)
+                     QString location,
+                     QString purchase_date)
     : m_id(id),
-      m_name(name),
-      m_type(type),
+      m_name(std::move(name)),
+      m_type(std::move(type)),
       m_quantity(quantity),
-      m_location(location),
-      m_purchase_date(purchase_date)
+      m_location(std::move(location)),
+      m_purchase_date(std::move(purchase_date))
 {
 }
 
@@ -50,13 +52,13 @@ int Component::getId() const { return m_id; }
  * @brief Obtiene el nombre del componente.
  * @return Nombre actual.
  */
-QString Component::getName() const { return m_name; }
+const QString &Component::getName() const { return m_name; }
 
 /**
  * @brief Obtiene el tipo del componente.
  * @return Tipo actual.
  */
-QString Component::getType() const { return m_type; }
+const QString &Component::getType() const { return m_type; }
 
 /**
  * @brief Obtiene la cantidad disponible.
@@ -68,13 +70,13 @@ int Component::getQuantity() const { return m_quantity; }
  * @brief Obtiene la ubicación física del componente.
  * @return Ubicación almacenada.
  */
-QString Component::getLocation() const { return m_location; }
+const QString &Component::getLocation() const { return m_location; }
 
 /**
  * @brief Obtiene la fecha de adquisición.
  * @return Fecha en formato QString.
  */
-QString Component::getPurchaseDate() const { return m_purchase_date; }
+const QString &Component::getPurchaseDate() const { return m_purchase_date; }
 
 /**
  * @brief Establece un nuevo ID.
@@ -86,13 +88,13 @@ void Component::setId(int id) { m_id = id; }
  * @brief Establece un nuevo nombre.
  * @param name Nombre actualizado.
  */
-void Component::setName(const QString &name) { m_name = name; }
+void Component::setName(QString name) { m_name = std::move(name); }
 
 /**
  * @brief Establece un nuevo tipo de componente.
  * @param type Tipo actualizado.
  */
-void Component::setType(const QString &type) { m_type = type; }
+void Component::setType(QString type) { m_type = std::move(type); }
 
 /**
  * @brief Cambia la cantidad disponible.
@@ -104,10 +106,10 @@ void Component::setQuantity(int quantity) { m_quantity = quantity; }
  * @brief Establece una nueva ubicación.
  * @param location Ubicación actualizada.
  */
-void Component::setLocation(const QString &location) { m_location = location; }
+void Component::setLocation(QString location) { m_location = std::move(location); }
 
 /**
  * @brief Establece una nueva fecha de adquisición.
  * @param purchase_date Fecha actualizada.
  */
-void Component::setPurchaseDate(const QString &purchase_date) { m_purchase_date = purchase_date; }
+void Component::setPurchaseDate(QString purchase_date) { m_purchase_date = std::move(purchase_date); }
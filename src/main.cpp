@@ -7,37 +7,211 @@
  */
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QMessageBox>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <QHostAddress>
 #include "DatabaseManager.h"
+#include "InventoryProtocol.h"
+#include "InventoryServer.h"
+#include "InventoryShards.h"
+#include "StartupTrace.h"
 #include "mainwindow.h"
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief Modo servidor: atiende a los clientes de red sin abrir la ventana.
+ *
+ * Este proceso queda como único dueño de la base; las estaciones se
+ * conectan por TCP (InventoryProtocol) en lugar de abrir el archivo.
+ * Corre sobre una QCoreApplication: no necesita pantalla ni plataforma
+ * gráfica, y el planificador de escrituras puede esperar entre intentos
+ * (solo el hilo de una interfaz gráfica tiene prohibido dormir).
+ *
+ * @param app Aplicación (sin interfaz) ya creada.
+ * @param db Conexión principal abierta.
+ * @param address Dirección de escucha.
+ * @param port Puerto TCP.
+ * @return Código de salida.
+ */
+static int runServer(QCoreApplication &app, QSqlDatabase db, const QHostAddress &address, quint16 port)
+{
+    InventoryManager manager(db);
+    if (!manager.createTable()) {
+        qWarning() << "No se pudo crear o verificar la tabla de inventario.";
+        return -1;
+    }
+    manager.setReadDatabase(DatabaseManager::getReadDatabase());
+
+    InventoryServer server(manager);
+    if (!server.listen(address, port)) {
+        return -1;
+    }
+
+    const int status = app.exec();
+    qInfo().noquote() << server.report();
+    return status;
+}
+
+/**
+ * @brief Indica si la línea de comandos pide el modo servidor.
+ *
+ * Se mira antes de crear la aplicación (QCommandLineParser necesita una):
+ * el modo servidor usa QCoreApplication y la ventana, QApplication.
+ */
+static bool wantsServer(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--servidor") == 0 || std::strncmp(argv[i], "--servidor=", 11) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
 /**
  * @brief Función principal de la aplicación.
  *
- * Inicializa QApplication, intenta abrir la base de datos y crea la ventana
+ * Inicializa la aplicación (QApplication con ventana, QCoreApplication en
+ * modo servidor), intenta abrir la base de datos y crea la ventana
  * principal si la conexión es exitosa.
  *
+ * Opciones:
+ * - `--escaner-archivo <ruta>`: sigue un archivo de movimientos de escáner
+ *   (una línea `<id> <delta>` por evento) además del socket local.
+ * - `--diagnostico-consultas <ruta>`: activa el diagnóstico de consultas
+ *   (plan, tiempo y filas recorridas por sentencia) y escribe el informe
+ *   en la ruta al cerrar la aplicación.
+ * - `--memoria`: trabaja con la base en memoria, cargada desde
+ *   "inventario.db" al iniciar y volcada al archivo periódicamente y al
+ *   cerrar (solo para una estación: demostraciones, pruebas, kioscos).
+ * - `--memoria-intervalo <segundos>`: periodo de volcado del modo en
+ *   memoria (30 por defecto); es lo máximo que se pierde ante un corte.
+ * - `--servidor <puerto>`: no abre la ventana; atiende a las estaciones
+ *   por TCP con InventoryServer.
+ * - `--servidor-direccion <ip>`: dirección de escucha del servidor
+ *   (127.0.0.1 por defecto; el protocolo no autentica).
+ * - `--sede <nombre=archivo>` (repetible): adjunta la base de otra sede,
+ *   en solo lectura, para "Buscar en sedes".
+ * - `--traza-arranque <ruta>`: escribe al salir las fases del arranque
+ *   (StartupTrace) con su inicio, duración e hilo.
+ *
  * @param argc Número de argumentos de línea de comandos.
  * @param argv Arreglo con los argumentos de línea de comandos.
  * @return int Código de salida de la aplicación.
  */
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    const bool server = wantsServer(argc, argv);
+    StartupTrace::begin("QApplication");
+    std::unique_ptr<QCoreApplication> app(server ? new QCoreApplication(argc, argv)
+                                                 : new QApplication(argc, argv));
+    StartupTrace::end("QApplication");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption scanFileOption("escaner-archivo",
+                                      "Archivo de movimientos de escáner a seguir.",
+                                      "ruta");
+    parser.addOption(scanFileOption);
+    QCommandLineOption planReportOption("diagnostico-consultas",
+                                        "Registra el plan de cada consulta y escribe el informe al salir.",
+                                        "ruta");
+    parser.addOption(planReportOption);
+    QCommandLineOption memoryOption("memoria",
+                                    "Trabaja con la base en memoria y la vuelca al archivo periódicamente.");
+    parser.addOption(memoryOption);
+    QCommandLineOption memoryIntervalOption("memoria-intervalo",
+                                            "Segundos entre volcados a disco en modo memoria (30).",
+                                            "segundos", "30");
+    parser.addOption(memoryIntervalOption);
+    QCommandLineOption serverOption("servidor",
+                                    "Atiende a las estaciones por TCP en el puerto indicado, sin ventana.",
+                                    "puerto");
+    parser.addOption(serverOption);
+    QCommandLineOption serverAddressOption("servidor-direccion",
+                                           "Dirección de escucha del servidor (127.0.0.1).",
+                                           "ip", "127.0.0.1");
+    parser.addOption(serverAddressOption);
+    QCommandLineOption siteOption("sede",
+                                  "Adjunta la base de otra sede (repetible).",
+                                  "nombre=archivo");
+    parser.addOption(siteOption);
+    QCommandLineOption startupTraceOption("traza-arranque",
+                                          "Escribe al salir las fases del arranque con sus tiempos.",
+                                          "ruta");
+    parser.addOption(startupTraceOption);
+    parser.process(*app);
+
+    if (parser.isSet(memoryOption)) {
+        DatabaseManager::setInMemory(true, parser.value(memoryIntervalOption).toInt() * 1000);
+    }
 
     // Obtener la conexión a la base de datos desde DatabaseManager
+    StartupTrace::begin("abrir base");
     QSqlDatabase db = DatabaseManager::getDatabase();
+    StartupTrace::end("abrir base");
 
     // Verificar si la base de datos se abrió correctamente
     if (!db.isValid() || !db.isOpen()) {
-        QMessageBox::critical(nullptr, "Error", "No se pudo abrir la base de datos.");
+        if (server) {
+            qWarning() << "No se pudo abrir la base de datos.";
+        } else {
+            QMessageBox::critical(nullptr, "Error", "No se pudo abrir la base de datos.");
+        }
         return -1;
     }
 
-    // Crear y mostrar la ventana principal
+    if (server) {
+        const quint16 port = quint16(parser.value(serverOption).toUInt());
+        return runServer(*app, db, QHostAddress(parser.value(serverAddressOption)),
+                         port ? port : InventoryProtocol::kDefaultPort);
+    }
+
+    // Crear y mostrar la ventana principal; el esquema y los datos se
+    // cargan después, en segundo plano
+    StartupTrace::begin("construir ventana");
     MainWindow w(db);
+    StartupTrace::end("construir ventana");
+    if (parser.isSet(scanFileOption)) {
+        w.scannerIngest().tailFile(parser.value(scanFileOption));
+    }
+    if (parser.isSet(planReportOption)) {
+        w.inventoryManager().queryDiagnostics().setEnabled(true);
+    }
+    for (const QString &site : parser.values(siteOption)) {
+        const QString name = site.section('=', 0, 0);
+        const QString path = site.section('=', 1);
+        if (name.isEmpty() || path.isEmpty()
+            || !w.inventoryManager().shards().attach(name, path)) {
+            qWarning() << "No se pudo adjuntar la sede:" << site;
+        }
+    }
     w.show();
+    StartupTrace::mark("ventana mostrada");
+
+    const int status = app->exec();
 
-    return app.exec();
+    if (parser.isSet(planReportOption)) {
+        QFile report(parser.value(planReportOption));
+        if (report.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QTextStream(&report) << w.inventoryManager().queryDiagnostics().report();
+        } else {
+            qWarning() << "No se pudo escribir el informe de consultas:" << report.fileName();
+        }
+    }
+    if (parser.isSet(startupTraceOption)) {
+        QFile trace(parser.value(startupTraceOption));
+        if (trace.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QTextStream(&trace) << StartupTrace::report();
+        } else {
+            qWarning() << "No se pudo escribir la traza de arranque:" << trace.fileName();
+        }
+    }
+    return status;
 }
 
@@ -24,11 +24,32 @@
 #include <QPushButton>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QProgressDialog>
+#include <QFile>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QItemSelection>
+#include <QHeaderView>
+#include <QHash>
+#include <QSet>
+#include <QDialog>
+#include <QEvent>
+#include <QTableWidget>
 #include <QSqlQuery>
 #include <QDebug>
 
+#include <algorithm>
+#include <utility>
+
 #include "report.h"
 #include "delegate.h"
+#include "DatabaseManager.h"
+#include "DepletionForecast.h"
+#include "InventorySchema.h"
+#include "InventoryShards.h"
+#include "InventorySync.h"
+#include "StartupLoader.h"
+#include "StartupTrace.h"
 
 // ============================================================================
 // FUNCIONES AUXILIARES ESTÁTICAS
@@ -43,13 +64,113 @@ static QString dateToString(const QDate &d) {
     return d.toString("yyyy-MM-dd");
 }
 
+/**
+ * @brief Rellena un combo de faceta con "valor (conteo)" conservando la selección.
+ * @details El valor real se guarda como dato del elemento; el primero
+ * ("Todos") tiene valor vacío. Si el valor elegido ya no tiene ítems, se
+ * mantiene en la lista con 0 para no cambiar el filtro por sorpresa.
+ * @param combo Combo a rellenar (sus señales se bloquean mientras tanto).
+ * @param counts Pares (valor, ítems) ordenados.
+ * @param total Ítems sin filtrar por esta faceta.
+ */
+static void fillFacetCombo(QComboBox *combo, const QList<QPair<QString, int>> &counts, int total)
+{
+    const QString selected = combo->currentData().toString();
+    const QSignalBlocker blocker(combo);
+
+    combo->clear();
+    combo->addItem(QString("Todos (%1)").arg(total), QString());
+    for (const auto &entry : counts) {
+        combo->addItem(QString("%1 (%2)").arg(entry.first).arg(entry.second), entry.first);
+    }
+
+    int index = combo->findData(selected);
+    if (index < 0) {
+        combo->addItem(QString("%1 (0)").arg(selected), selected);
+        index = combo->count() - 1;
+    }
+    combo->setCurrentIndex(index);
+}
+
 /**
  * @brief Adaptador que convierte una estructura de base de datos (InventoryItem) a un objeto de lógica (Component).
- * @param it Objeto InventoryItem recuperado del InventoryManager.
+ * @param it Objeto InventoryItem recuperado del InventoryManager; se recibe por
+ * valor y sus textos se mueven al componente (pasar un temporal o std::move no copia).
  * @return Objeto Component listo para ser procesado por la lógica de negocio.
  */
-static Component inventoryItemToComponent(const InventoryItem &it) {
-    return Component(it.id, it.nombre, it.tipo, it.cantidad, it.ubicacion, it.fechaAdquisicion);
+static Component inventoryItemToComponent(InventoryItem it) {
+    return Component(it.id, std::move(it.nombre), std::move(it.tipo), it.cantidad,
+                     std::move(it.ubicacion), std::move(it.fechaAdquisicion));
+}
+
+/**
+ * @brief Conjunto de componentes de prueba (Seed Data) usado al cargar o restaurar la base.
+ * @return Lista de aproximadamente 50 ítems predefinidos, sin ID asignado.
+ */
+static QList<InventoryItem> defaultItems() {
+    QList<QList<QString>> defaults = {
+      {"Resistor 10kΩ", "Electrónico", "100", "Cajón A1", "2024-01-10"},
+      {"Capacitor 100nF", "Electrónico", "80", "Cajón A1", "2024-01-12"},
+      {"Diodo 1N4148", "Electrónico", "150", "Cajón A2", "2024-02-01"},
+      {"LED Rojo 5mm", "Electrónico", "200", "Cajón A2", "2024-03-05"},
+      {"Transistor 2N3904", "Electrónico", "120", "Cajón A3", "2024-03-10"},
+      {"Potenciómetro 10k", "Electrónico", "15", "Cajón B1", "2024-02-20"},
+      {"Motor DC 6V", "Electrónico", "10", "Estante B2", "2024-03-03"},
+      {"Sensor HC-SR04", "Sensor", "12", "Estante C1", "2024-02-28"},
+      {"Arduino Uno", "Microcontrolador", "4", "Estante C2", "2023-11-22"},
+      {"Protoboard", "Herramienta", "10", "Estante C3", "2023-12-10"},
+      {"Raspberry Pi Pico", "Microcontrolador", "6", "Estante C2", "2024-01-30"},
+      {"Relé 5V", "Electrónico", "30", "Cajón A3", "2024-01-11"},
+      {"Cable Dupont (m/m)", "Accesorio", "300", "Cajón A1", "2024-01-05"},
+      {"Cable Dupont (h/h)", "Accesorio", "300", "Cajón A1", "2024-01-05"},
+      {"Batería 9V", "Electrónico", "25", "Estante D1", "2024-02-10"},
+      {"Multímetro Digital", "Instrumento", "3", "Mesa Taller", "2023-12-10"},
+      {"Osciloscopio", "Instrumento", "1", "Mesa Taller", "2023-09-10"},
+      {"Fuente DC 30V", "Instrumento", "2", "Mesa Taller", "2023-09-10"},
+      {"Sensor PIR SR505", "Sensor", "20", "Estante C1", "2024-01-05"},
+      {"Sensor DHT11", "Sensor", "15", "Estante C1", "2024-01-08"},
+      {"Sensor DHT22", "Sensor", "10", "Estante C1", "2024-01-08"},
+      {"ESP32-CAM", "Microcontrolador", "7", "Estante C2", "2024-02-01"},
+      {"ESP8266", "Microcontrolador", "10", "Estante C2", "2024-02-02"},
+      {"Cámara Web USB", "Computación", "5", "Estante D2", "2023-11-11"},
+      {"Router TP-Link", "Red", "3", "Estante D2", "2023-12-01"},
+      {"Switch Lógico", "Electrónico", "100", "Cajón A4", "2024-01-22"},
+      {"Cables USB", "Accesorio", "30", "Cajón B3", "2023-12-28"},
+      {"Rollo Cinta Aislante", "Herramienta", "20", "Cajón B3", "2023-12-30"},
+      {"Soldador 60W", "Herramienta", "2", "Mesa Taller", "2023-12-15"},
+      {"Estaño", "Consumible", "10", "Cajón B1", "2023-12-15"},
+      {"Alcohol Isopropílico", "Limpieza", "4", "Estante E1", "2024-01-02"},
+      {"Guantes Nitrilo", "Laboratorio", "200", "Armario F1", "2024-01-01"},
+      {"Termómetro Digital", "Laboratorio", "3", "Estante E2", "2023-12-10"},
+      {"Placa de Calentamiento", "Laboratorio", "1", "Estante E3", "2023-11-20"},
+      {"Cronómetro", "Laboratorio", "2", "Cajón B4", "2023-12-09"},
+      {"Lupa de Banco", "Herramienta", "2", "Mesa Taller", "2023-10-15"},
+      {"Extensión Eléctrica", "Hogar", "8", "Estante D1", "2023-10-10"},
+      {"Bombillo LED 12W", "Hogar", "20", "Estante D1", "2023-09-10"},
+      {"Tomacorriente", "Hogar", "40", "Estante D1", "2023-09-10"},
+      {"Interruptor de Pared", "Hogar", "40", "Estante D1", "2023-09-10"},
+      {"Control Remoto IR", "Electrónico", "15", "Cajón A2", "2024-02-01"},
+      {"Buzzer 5V", "Electrónico", "40", "Cajón A3", "2024-02-03"},
+      {"Servo SG90", "Electrónico", "15", "Cajón A3", "2024-02-10"},
+      {"Switch de Palanca", "Electrónico", "50", "Cajón A4", "2024-02-11"},
+      {"Jack DC 5.5mm", "Electrónico", "60", "Cajón A4", "2024-02-11"},
+      {"Pinzas de Cocodrilo", "Accesorio", "50", "Cajón B3", "2024-01-01"},
+      {"Termistor NTC 10k", "Sensor", "80", "Cajón A2", "2024-01-20"}
+    };
+
+    QList<InventoryItem> items;
+    items.reserve(defaults.size());
+    for (const auto &row : defaults) {
+        InventoryItem it;
+        it.id = 0;
+        it.nombre = row[0];
+        it.tipo = row[1];
+        it.cantidad = row[2].toInt();
+        it.ubicacion = row[3];
+        it.fechaAdquisicion = row[4];
+        items.append(it);
+    }
+    return items;
 }
 
 
@@ -167,7 +288,7 @@ void AddDialog::onCancel() { emit cancelled(); }
  * Esta clase orquesta la interacción entre el usuario y la base de datos.
  * Sus responsabilidades incluyen:
  * - Inicializar la base de datos y la interfaz de usuario.
- * - Gestionar el modelo de datos (QSqlQueryModel) y el filtrado (QSortFilterProxyModel).
+ * - Gestionar el modelo de datos (InventoryModel) y el filtrado (QSortFilterProxyModel).
  * - Manejar eventos de botones (CRUD, exportación, restauración).
  * - Aplicar delegados personalizados para la visualización (LowStockDelegate).
  */
@@ -182,7 +303,8 @@ void AddDialog::onCancel() { emit cancelled(); }
  * @param parent Widget padre (opcional).
  */
 MainWindow::MainWindow(QSqlDatabase db, QWidget *parent)
-    : QWidget(parent), manager(db)
+    : QWidget(parent), manager(db), ingest(manager), maintenance(db.databaseName()), backup(db),
+      jobs(manager, DatabaseManager::isInMemory() ? QString() : db.databaseName())
 {
     setWindowTitle("Gestión de Inventario");
     resize(1000, 600);
@@ -192,10 +314,20 @@ MainWindow::MainWindow(QSqlDatabase db, QWidget *parent)
 
     // -- Inicialización de Widgets --
     searchEdit = new QLineEdit(); searchEdit->setPlaceholderText("Buscar...");
+    fuzzyCheck = new QCheckBox("Aproximada");
+    fuzzyCheck->setToolTip("Tolera errores de tipeo y ordena por parecido (solo nombre)");
     QPushButton *btnAdd = new QPushButton("Agregar");
-    QPushButton *btnDelete = new QPushButton("Eliminar seleccionado");
+    QPushButton *btnDelete = new QPushButton("Eliminar seleccionados");
+    QPushButton *btnAdjust = new QPushButton("Ajustar cantidad");
+    QPushButton *btnRelocate = new QPushButton("Reubicar");
     QPushButton *btnExport = new QPushButton("Exportar CSV");
+    QPushButton *btnBackup = new QPushButton("Respaldar base");
     QPushButton *btnLowStock = new QPushButton("Revisar stock bajo");
+    QPushButton *btnReorder = new QPushButton("Punto de reorden");
+    QPushButton *btnSites = new QPushButton("Buscar en sedes");
+    QPushButton *btnSync = new QPushButton("Sincronizar");
+    QPushButton *btnHistory = new QPushButton("Historial");
+    QPushButton *btnForecast = new QPushButton("Se agota pronto");
     QPushButton *btnLoadDefaults = new QPushButton("Cargar base por defecto");
     QPushButton *btnRestore = new QPushButton("Restaurar base original");
     QPushButton *btnEdit = new QPushButton("Editar");
@@ -206,49 +338,322 @@ MainWindow::MainWindow(QSqlDatabase db, QWidget *parent)
     topLayout->addWidget(btnEdit);
     topLayout->addWidget(new QLabel("Buscar:"));
     topLayout->addWidget(searchEdit);
+    topLayout->addWidget(fuzzyCheck);
     topLayout->addWidget(btnAdd);
     topLayout->addWidget(btnDelete);
+    topLayout->addWidget(btnAdjust);
+    topLayout->addWidget(btnRelocate);
     topLayout->addWidget(btnLowStock);
+    topLayout->addWidget(btnReorder);
+    topLayout->addWidget(btnSites);
+    topLayout->addWidget(btnSync);
+    topLayout->addWidget(btnHistory);
+    topLayout->addWidget(btnForecast);
     topLayout->addWidget(btnExport);
+    topLayout->addWidget(btnBackup);
 
     mainLayout->addLayout(topLayout);
 
+    // -- Facetas: tipo, ubicación y rango de fechas, con conteos --
+    QHBoxLayout *facetLayout = new QHBoxLayout();
+    tipoFacet = new QComboBox();
+    ubicacionFacet = new QComboBox();
+    dateFacetCheck = new QCheckBox("Adquirido entre");
+    dateFrom = new QDateEdit(QDate::currentDate().addYears(-1)); dateFrom->setCalendarPopup(true);
+    dateTo = new QDateEdit(QDate::currentDate()); dateTo->setCalendarPopup(true);
+    dateFrom->setEnabled(false);
+    dateTo->setEnabled(false);
+    facetCountLabel = new QLabel();
+    pendingWritesLabel = new QLabel();
+    pendingWritesLabel->hide();
+
+    facetLayout->addWidget(new QLabel("Tipo:"));
+    facetLayout->addWidget(tipoFacet);
+    facetLayout->addWidget(new QLabel("Ubicación:"));
+    facetLayout->addWidget(ubicacionFacet);
+    facetLayout->addWidget(dateFacetCheck);
+    facetLayout->addWidget(dateFrom);
+    facetLayout->addWidget(new QLabel("y"));
+    facetLayout->addWidget(dateTo);
+    facetLayout->addStretch();
+    facetLayout->addWidget(pendingWritesLabel);
+    facetLayout->addWidget(facetCountLabel);
+    mainLayout->addLayout(facetLayout);
+
     // -- Configuración del Modelo MVC --
-    model = new QSqlQueryModel(this);
+    manager.setDefaultReorderPoint(lowStockThreshold);
+    model = new InventoryModel(manager, this);
     
-    // Configuración del Proxy para filtrado y ordenamiento
-    proxy = new QSortFilterProxyModel(this);
+    // Configuración del Proxy para filtrado (por IDs encontrados) y ordenamiento
+    proxy = new InventoryFilterProxy(this);
     proxy->setSourceModel(model);
-    proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
-    proxy->setFilterKeyColumn(-1); // Filtrar en todas las columnas
 
     // -- Configuración de la Tabla (Vista) --
     tableView = new QTableView();
     tableView->setModel(proxy);
     tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
-    tableView->setSelectionMode(QAbstractItemView::SingleSelection);
+    tableView->setSelectionMode(QAbstractItemView::ExtendedSelection); // Ctrl/Shift para operaciones masivas
     tableView->setEditTriggers(QAbstractItemView::NoEditTriggers); // Edición solo vía diálogo
+    tableView->horizontalHeader()->setSortIndicator(0, Qt::DescendingOrder); // Más nuevos arriba
     
-    // Inyección del delegado para resaltar stock bajo
-    tableView->setItemDelegate(new LowStockDelegate(lowStockThreshold, this));
+    // Inyección del delegado para resaltar stock bajo (lee el estado que calcula el modelo)
+    stockDelegate = new LowStockDelegate(this);
+    tableView->setItemDelegate(stockDelegate);
     mainLayout->addWidget(tableView);
 
+    // -- Trabajos largos: se ven solo mientras hay alguno en cola o en curso --
+    QHBoxLayout *jobLayout = new QHBoxLayout();
+    jobList = new QListWidget();
+    jobList->setMaximumHeight(80);
+    btnCancelJob = new QPushButton("Cancelar trabajo");
+    jobLayout->addWidget(jobList);
+    jobLayout->addWidget(btnCancelJob, 0, Qt::AlignTop);
+    mainLayout->addLayout(jobLayout);
+    jobList->hide();
+    btnCancelJob->hide();
+
     // -- Conexiones de Señales y Slots --
     connect(btnAdd, &QPushButton::clicked, this, &MainWindow::onAdd);
     connect(btnDelete, &QPushButton::clicked, this, &MainWindow::onDelete);
+    connect(btnAdjust, &QPushButton::clicked, this, &MainWindow::onBulkAdjust);
+    connect(btnRelocate, &QPushButton::clicked, this, &MainWindow::onBulkRelocate);
     connect(btnExport, &QPushButton::clicked, this, &MainWindow::onExport);
+    connect(btnBackup, &QPushButton::clicked, this, &MainWindow::onBackup);
     connect(btnLowStock, &QPushButton::clicked, this, &MainWindow::onLowStock);
+    connect(btnReorder, &QPushButton::clicked, this, &MainWindow::onReorderPoint);
+    connect(btnSites, &QPushButton::clicked, this, &MainWindow::onSearchSites);
+    connect(btnSync, &QPushButton::clicked, this, &MainWindow::onSync);
+    connect(btnHistory, &QPushButton::clicked, this, &MainWindow::onHistory);
+    connect(btnForecast, &QPushButton::clicked, this, &MainWindow::onForecast);
     connect(searchEdit, &QLineEdit::textChanged, this, &MainWindow::onSearch);
+    connect(fuzzyCheck, &QCheckBox::toggled, this, [this]() { onSearch(searchEdit->text()); });
+    connect(tipoFacet, &QComboBox::currentIndexChanged, this, &MainWindow::onFacetChanged);
+    connect(ubicacionFacet, &QComboBox::currentIndexChanged, this, &MainWindow::onFacetChanged);
+    connect(dateFacetCheck, &QCheckBox::toggled, dateFrom, &QWidget::setEnabled);
+    connect(dateFacetCheck, &QCheckBox::toggled, dateTo, &QWidget::setEnabled);
+    connect(dateFacetCheck, &QCheckBox::toggled, this, &MainWindow::onFacetChanged);
+    connect(dateFrom, &QDateEdit::dateChanged, this, &MainWindow::onFacetChanged);
+    connect(dateTo, &QDateEdit::dateChanged, this, &MainWindow::onFacetChanged);
     connect(btnLoadDefaults, &QPushButton::clicked, this, &MainWindow::onLoadDefaults);
     connect(btnRestore, &QPushButton::clicked, this, &MainWindow::onRestoreDefaults);
     connect(btnEdit, &QPushButton::clicked, this, &MainWindow::onEdit);
+    connect(btnCancelJob, &QPushButton::clicked, this, &MainWindow::onCancelJob);
+    connect(&jobs, &JobQueue::jobQueued, this, &MainWindow::updateJobList);
+    connect(&jobs, &JobQueue::jobStarted, this, &MainWindow::updateJobList);
+    connect(&jobs, &JobQueue::jobProgress, this, &MainWindow::updateJobList);
+    connect(&jobs, &JobQueue::jobFinished, this, &MainWindow::onJobFinished);
+
+    // Los cambios (propios, de la ingesta o de otras estaciones) llegan
+    // desde el registro de cambios y se aplican solo a las filas afectadas
+    connect(&manager, &InventoryManager::itemsChanged, model, &InventoryModel::applyChanges);
+    connect(&manager, &InventoryManager::itemsChanged, &fuzzy, &FuzzyIndex::applyChanges);
+    connect(&manager, &InventoryManager::itemsChanged, this,
+            [this](const QList<InventoryItem> &rows, const QList<int> &removedIds) {
+        // Hay una reconstrucción en curso: se reaplican sobre los índices nuevos
+        if (adoptedGeneration != indexGeneration) {
+            lateChanges.append({rows, removedIds});
+        }
+    });
+    connect(&manager, &InventoryManager::itemsChanged, &facets, &FacetCounts::applyChanges);
+    connect(&facets, &FacetCounts::countsChanged, this, &MainWindow::updateFacetCounts);
+    connect(&manager, &InventoryManager::inventoryReset, this, &MainWindow::refreshModel);
+
+    // Cambios propios en espera mientras otra estación tiene la base
+    connect(&manager, &InventoryManager::queuedWritesChanged, this, [this](int writes) {
+        pendingWritesLabel->setText(QString("%1 cambio(s) en espera: la base está ocupada por otra estación")
+                                        .arg(writes));
+        pendingWritesLabel->setVisible(writes > 0);
+    });
+
+    // Un ítem nuevo o renombrado puede entrar o salir de la búsqueda
+    // aproximada (la de prefijos la resuelve el modelo con cada cambio)
+    connect(&manager, &InventoryManager::itemsChanged, this, [this]() {
+        if (fuzzyCheck->isChecked() && !searchEdit->text().trimmed().isEmpty()) {
+            onSearch(searchEdit->text());
+        }
+    });
+
+    // Detección de commits de otras estaciones sobre el mismo archivo
+    // (el temporizador arranca cuando termina la carga inicial)
+    externalPoll.setInterval(1000);
+    connect(&externalPoll, &QTimer::timeout, &manager, &InventoryManager::pollExternalChanges);
+
+    // Mantenimiento de la base: solo tras un rato sin teclado, ratón ni cambios.
+    // En memoria no hay archivo que mantener (se reescribe entero en cada volcado)
+    if (!DatabaseManager::isInMemory()) {
+        connect(&manager, &InventoryManager::itemsChanged, &maintenance, &DatabaseMaintenance::noteActivity);
+    }
 
-    // Inicialización de la tabla en BD si no existe
-    if (!manager.createTable()) {
+    // Clic en la cabecera: el modelo vuelve a la primera página con ORDER BY
+    tableView->setSortingEnabled(true);
+    tableView->viewport()->installEventFilter(this);
+
+    // -- Arranque diferido --
+    // La ventana se muestra vacía y bloqueada; el esquema y la lectura de
+    // todos los ítems corren en segundo plano (StartupLoader). Mientras
+    // tanto no se emiten cambios: al terminar se retoman desde la posición
+    // del registro en la instantánea en que se leyeron todos los ítems.
+    manager.deferChangeTracking();
+    setStartupLocked(true);
+    if (DatabaseManager::isInMemory()) {
+        // Ninguna otra conexión puede abrir la base en memoria: los mismos
+        // pasos corren en este hilo, pero después de mostrar la ventana
+        QTimer::singleShot(0, this, [this]() {
+            bool ok;
+            {
+                StartupTrace::Scope phase("esquema");
+                ok = manager.createTable();
+            }
+            onSchemaReady(ok);
+            if (ok) {
+                QList<InventoryItem> items;
+                qint64 changeSeq;
+                {
+                    StartupTrace::Scope phase("lectura de todos los ítems");
+                    changeSeq = manager.changePosition();
+                    items = manager.getAllItems();
+                }
+                auto indexes = std::make_shared<SearchIndexes>();
+                {
+                    StartupTrace::Scope phase("índices de búsqueda y facetas");
+                    indexes->build(items, thread());
+                }
+                onStartupIndexes(indexes, changeSeq);
+            }
+        });
+    } else {
+        startup = new StartupLoader(db.databaseName(), this);
+        connect(startup, &StartupLoader::schemaReady, this, &MainWindow::onSchemaReady);
+        connect(startup, &StartupLoader::indexesReady, this, &MainWindow::onStartupIndexes);
+        startup->start();
+    }
+}
+
+/**
+ * @brief Bloquea o libera los controles mientras dura la carga inicial.
+ * @details La tabla queda siempre habilitada (se puede desplazar en cuanto
+ * llega la primera página); el resto de los controles, incluidas las
+ * acciones que escriben, espera a que la búsqueda y las facetas estén listas.
+ * @param locked true durante la carga.
+ */
+void MainWindow::setStartupLocked(bool locked)
+{
+    for (QWidget *child : findChildren<QWidget *>(QString(), Qt::FindDirectChildrenOnly)) {
+        if (child != tableView && child != facetCountLabel) {
+            child->setEnabled(!locked);
+        }
+    }
+    if (locked) {
+        facetCountLabel->setText("Cargando inventario...");
+    }
+}
+
+/**
+ * @brief Primer paso del arranque: el esquema está listo, se lee la primera página.
+ * @details La página no fija la posición del registro de cambios: la fija
+ * la instantánea de los índices (onStartupIndexes), que se lee después.
+ * Los cambios que la página ya muestre se vuelven a aplicar sin efecto.
+ * @param ok false si el esquema no se pudo crear o verificar.
+ */
+void MainWindow::onSchemaReady(bool ok)
+{
+    if (!ok) {
         QMessageBox::critical(this, "Error Crítico", "No se pudo crear o verificar la tabla de inventario en la base de datos.");
+        manager.startChangeTracking();
+        setStartupLocked(false);
+        facetCountLabel->clear();
+        return;
+    }
+
+    // Conexión de solo lectura para exportaciones y revisiones de stock
+    manager.setReadDatabase(DatabaseManager::getReadDatabase());
+
+    StartupTrace::Scope phase("primera página");
+    model->reload();
+    tableView->resizeColumnsToContents();
+}
+
+/**
+ * @brief Segundo paso del arranque: se adoptan la búsqueda aproximada y las
+ * facetas, se retoman los cambios y se liberan los controles.
+ * @details Los índices llegan armados desde el cargador; adoptarlos solo
+ * intercambia contenedores, así que el hilo de la ventana no recorre las filas.
+ * @param indexes Índices armados en segundo plano.
+ * @param changeSeq Posición del registro de cambios en la misma instantánea.
+ */
+void MainWindow::onStartupIndexes(const std::shared_ptr<SearchIndexes> &indexes, qint64 changeSeq)
+{
+    {
+        StartupTrace::Scope phase("adopción de índices");
+        fuzzy.adopt(indexes->fuzzy);
+        facets.adopt(indexes->facets);
+    }
+    manager.startChangeTracking(changeSeq);
+
+    externalPoll.start();
+    ingest.listen("inventario-escaner");
+    if (!DatabaseManager::isInMemory()) {
+        maintenance.start();
+    }
+
+    setStartupLocked(false);
+    onSearch(searchEdit->text());
+    StartupTrace::mark("arranque completo");
+}
+
+/**
+ * @brief Registra en StartupTrace las primeras pinturas de la tabla.
+ * @details Deja de observar la vista en cuanto se pinta con datos.
+ */
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == tableView->viewport() && event->type() == QEvent::Paint) {
+        if (!firstPaintSeen) {
+            firstPaintSeen = true;
+            StartupTrace::mark("primera pintura de la ventana");
+        }
+        if (model->rowCount() > 0) {
+            StartupTrace::mark("primera pintura con datos");
+            tableView->viewport()->removeEventFilter(this);
+        }
     }
+    return QWidget::eventFilter(watched, event);
+}
 
-    refreshModel();
+/**
+ * @brief Acceso a la etapa de ingesta, por ejemplo para seguir un archivo de movimientos.
+ * @return Referencia a la instancia de ScannerIngest de esta ventana.
+ */
+ScannerIngest &MainWindow::scannerIngest()
+{
+    return ingest;
+}
+
+/**
+ * @brief Acceso al administrador de inventario de la ventana.
+ * @return Referencia a la instancia de InventoryManager de esta ventana.
+ */
+InventoryManager &MainWindow::inventoryManager()
+{
+    return manager;
+}
+
+/**
+ * @brief Acceso al planificador de mantenimiento de la base.
+ * @return Referencia a la instancia de DatabaseMaintenance de esta ventana.
+ */
+DatabaseMaintenance &MainWindow::databaseMaintenance()
+{
+    return maintenance;
+}
+
+/**
+ * @brief Acceso a la cola de trabajos largos de la ventana.
+ * @return Referencia a la JobQueue.
+ */
+JobQueue &MainWindow::jobQueue()
+{
+    return jobs;
 }
 
 /**
@@ -258,7 +663,7 @@ MainWindow::MainWindow(QSqlDatabase db, QWidget *parent)
  * desde la base de datos, y abre un @ref AddDialog precargado con dicha información.
  *
  * @note Utiliza una función lambda para manejar la señal `accepted` del diálogo,
- * capturando el ID para realizar el `updateItem`.
+ * capturando el ID para realizar el `updateItem` con @ref submitWrite.
  */
 void MainWindow::onEdit()
 {
@@ -271,7 +676,7 @@ void MainWindow::onEdit()
     // Mapeo del índice del proxy al índice del modelo fuente para obtener el ID real
     QModelIndex idx = sel.first();
     QModelIndex src = proxy->mapToSource(idx);
-    int id = model->data(model->index(src.row(), 0)).toInt();
+    int id = model->idAt(src.row());
 
     InventoryItem it = manager.getItemById(id);
 
@@ -295,18 +700,12 @@ void MainWindow::onEdit()
             return;
         }
 
-        if (!manager.updateItem(
-                id,
-                dlg->getName(),
-                dlg->getType(),
-                dlg->getQuantity(),
-                dlg->getLocation(),
-                dlg->getDate().toString("yyyy-MM-dd")))
-        {
-            QMessageBox::critical(this, "Error", "Fallo al actualizar el componente en la base de datos.");
-        } else {
-            refreshModel();
-        }
+        const InventoryItem edited{id, dlg->getName(), dlg->getType(), dlg->getQuantity(),
+                                   dlg->getLocation(), dlg->getDate().toString("yyyy-MM-dd")};
+        submitWrite([this, edited] {
+            return manager.updateItem(edited.id, edited.nombre, edited.tipo, edited.cantidad,
+                                      edited.ubicacion, edited.fechaAdquisicion);
+        }, "Fallo al actualizar el componente en la base de datos.");
 
         dlg->close();
         dlg->deleteLater();
@@ -339,11 +738,10 @@ void MainWindow::onAdd()
                     dlg->getLocation(),
                     dateToString(dlg->getDate()));
 
-        if (!manager.addItem(c.getName(), c.getType(), c.getQuantity(), c.getLocation(), c.getPurchaseDate())) {
-            QMessageBox::critical(this, "Error", "No se pudo insertar el componente en la base de datos.");
-        } else {
-            refreshModel();
-        }
+        submitWrite([this, c] {
+            return manager.addItem(c.getName(), c.getType(), c.getQuantity(), c.getLocation(),
+                                   c.getPurchaseDate());
+        }, "No se pudo insertar el componente en la base de datos.");
         dlg->close();
         dlg->deleteLater();
     });
@@ -352,120 +750,166 @@ void MainWindow::onAdd()
 }
 
 /**
- * @brief Elimina el registro seleccionado en la tabla.
- * @details Muestra un cuadro de confirmación antes de proceder. Si se confirma,
- * solicita al InventoryManager la eliminación por ID.
+ * @brief Elimina los registros seleccionados en la tabla.
+ * @details Muestra un único cuadro de confirmación, sin importar cuántas filas
+ * estén seleccionadas, y borra todas en una sola transacción mediante
+ * InventoryManager::removeItems. La tabla se refresca una vez al final.
  */
 void MainWindow::onDelete()
 {
-    QModelIndexList sel = tableView->selectionModel()->selectedRows();
-    if (sel.isEmpty()) {
-        QMessageBox::information(this, "Eliminar", "Selecciona una fila para eliminar.");
+    const QList<int> ids = selectedIds();
+    if (ids.isEmpty()) {
+        QMessageBox::information(this, "Eliminar", "Selecciona al menos una fila para eliminar.");
         return;
     }
 
-    QModelIndex idx = sel.first();
-    QModelIndex src = proxy->mapToSource(idx);
-    int id = model->data(model->index(src.row(), 0)).toInt();
+    const QString question = (ids.size() == 1)
+        ? QString("¿Estás seguro de eliminar el registro con ID %1?").arg(ids.first())
+        : QString("¿Estás seguro de eliminar los %1 registros seleccionados?").arg(ids.size());
 
-    if (QMessageBox::question(this, "Confirmar Eliminación",
-                              QString("¿Estás seguro de eliminar el registro con ID %1?").arg(id)) == QMessageBox::Yes)
+    if (QMessageBox::question(this, "Confirmar Eliminación", question) == QMessageBox::Yes)
     {
-        if (!manager.removeItem(id)) {
-            QMessageBox::critical(this, "Error", "No se pudo eliminar el registro.");
-        } else {
-            refreshModel();
-        }
+        submitWrite([this, ids] { return manager.removeItems(ids); },
+                    "No se pudieron eliminar los registros. No se borró ninguno.");
     }
 }
 
 /**
- * @brief Carga un conjunto de datos de prueba (Seed Data).
- * @details Inserta aproximadamente 50 ítems predefinidos en la base de datos.
- * Útil para pruebas y demostraciones iniciales.
+ * @brief Suma (o resta) una cantidad a todas las filas seleccionadas.
+ * @details El ajuste es relativo: un valor negativo descuenta unidades, sin
+ * dejar ninguna cantidad por debajo de cero. Se aplica en una sola transacción.
  */
-void MainWindow::onLoadDefaults()
+void MainWindow::onBulkAdjust()
 {
-    QList<QList<QString>> defaults = {
-      {"Resistor 10kΩ", "Electrónico", "100", "Cajón A1", "2024-01-10"},
-      {"Capacitor 100nF", "Electrónico", "80", "Cajón A1", "2024-01-12"},
-      {"Diodo 1N4148", "Electrónico", "150", "Cajón A2", "2024-02-01"},
-      {"LED Rojo 5mm", "Electrónico", "200", "Cajón A2", "2024-03-05"},
-      {"Transistor 2N3904", "Electrónico", "120", "Cajón A3", "2024-03-10"},
-      {"Potenciómetro 10k", "Electrónico", "15", "Cajón B1", "2024-02-20"},
-      {"Motor DC 6V", "Electrónico", "10", "Estante B2", "2024-03-03"},
-      {"Sensor HC-SR04", "Sensor", "12", "Estante C1", "2024-02-28"},
-      {"Arduino Uno", "Microcontrolador", "4", "Estante C2", "2023-11-22"},
-      {"Protoboard", "Herramienta", "10", "Estante C3", "2023-12-10"},
-      {"Raspberry Pi Pico", "Microcontrolador", "6", "Estante C2", "2024-01-30"},
-      {"Relé 5V", "Electrónico", "30", "Cajón A3", "2024-01-11"},
-      {"Cable Dupont (m/m)", "Accesorio", "300", "Cajón A1", "2024-01-05"},
-      {"Cable Dupont (h/h)", "Accesorio", "300", "Cajón A1", "2024-01-05"},
-      {"Batería 9V", "Electrónico", "25", "Estante D1", "2024-02-10"},
-      {"Multímetro Digital", "Instrumento", "3", "Mesa Taller", "2023-12-10"},
-      {"Osciloscopio", "Instrumento", "1", "Mesa Taller", "2023-09-10"},
-      {"Fuente DC 30V", "Instrumento", "2", "Mesa Taller", "2023-09-10"},
-      {"Sensor PIR SR505", "Sensor", "20", "Estante C1", "2024-01-05"},
-      {"Sensor DHT11", "Sensor", "15", "Estante C1", "2024-01-08"},
-      {"Sensor DHT22", "Sensor", "10", "Estante C1", "2024-01-08"},
-      {"ESP32-CAM", "Microcontrolador", "7", "Estante C2", "2024-02-01"},
-      {"ESP8266", "Microcontrolador", "10", "Estante C2", "2024-02-02"},
-      {"Cámara Web USB", "Computación", "5", "Estante D2", "2023-11-11"},
-      {"Router TP-Link", "Red", "3", "Estante D2", "2023-12-01"},
-      {"Switch Lógico", "Electrónico", "100", "Cajón A4", "2024-01-22"},
-      {"Cables USB", "Accesorio", "30", "Cajón B3", "2023-12-28"},
-      {"Rollo Cinta Aislante", "Herramienta", "20", "Cajón B3", "2023-12-30"},
-      {"Soldador 60W", "Herramienta", "2", "Mesa Taller", "2023-12-15"},
-      {"Estaño", "Consumible", "10", "Cajón B1", "2023-12-15"},
-      {"Alcohol Isopropílico", "Limpieza", "4", "Estante E1", "2024-01-02"},
-      {"Guantes Nitrilo", "Laboratorio", "200", "Armario F1", "2024-01-01"},
-      {"Termómetro Digital", "Laboratorio", "3", "Estante E2", "2023-12-10"},
-      {"Placa de Calentamiento", "Laboratorio", "1", "Estante E3", "2023-11-20"},
-      {"Cronómetro", "Laboratorio", "2", "Cajón B4", "2023-12-09"},
-      {"Lupa de Banco", "Herramienta", "2", "Mesa Taller", "2023-10-15"},
-      {"Extensión Eléctrica", "Hogar", "8", "Estante D1", "2023-10-10"},
-      {"Bombillo LED 12W", "Hogar", "20", "Estante D1", "2023-09-10"},
-      {"Tomacorriente", "Hogar", "40", "Estante D1", "2023-09-10"},
-      {"Interruptor de Pared", "Hogar", "40", "Estante D1", "2023-09-10"},
-      {"Control Remoto IR", "Electrónico", "15", "Cajón A2", "2024-02-01"},
-      {"Buzzer 5V", "Electrónico", "40", "Cajón A3", "2024-02-03"},
-      {"Servo SG90", "Electrónico", "15", "Cajón A3", "2024-02-10"},
-      {"Switch de Palanca", "Electrónico", "50", "Cajón A4", "2024-02-11"},
-      {"Jack DC 5.5mm", "Electrónico", "60", "Cajón A4", "2024-02-11"},
-      {"Pinzas de Cocodrilo", "Accesorio", "50", "Cajón B3", "2024-01-01"},
-      {"Termistor NTC 10k", "Sensor", "80", "Cajón A2", "2024-01-20"}
-    };
+    const QList<int> ids = selectedIds();
+    if (ids.isEmpty()) {
+        QMessageBox::information(this, "Ajustar cantidad", "Selecciona al menos una fila.");
+        return;
+    }
+
+    bool ok = false;
+    const int delta = QInputDialog::getInt(
+        this, "Ajustar cantidad",
+        QString("Unidades a sumar a %1 ítem(s) (negativo para descontar):").arg(ids.size()),
+        0, -1000000, 1000000, 1, &ok);
+    if (!ok || delta == 0) return;
 
-    for (const auto &item : defaults) {
-        manager.addItem(item[0], item[1], item[2].toInt(), item[3], item[4]);
+    submitWrite([this, ids, delta] { return manager.adjustQuantities(ids, delta); },
+                "No se pudo ajustar la cantidad. No se modificó ningún ítem.");
+}
+
+/**
+ * @brief Mueve todas las filas seleccionadas a una nueva ubicación.
+ * @details Se aplica en una sola transacción mediante InventoryManager::relocateItems.
+ */
+void MainWindow::onBulkRelocate()
+{
+    const QList<int> ids = selectedIds();
+    if (ids.isEmpty()) {
+        QMessageBox::information(this, "Reubicar", "Selecciona al menos una fila.");
+        return;
     }
 
-    refreshModel();
-    QMessageBox::information(this, "Carga Completa", "Se han cargado exitosamente los componentes por defecto.");
+    bool ok = false;
+    const QString location = QInputDialog::getText(
+        this, "Reubicar",
+        QString("Nueva ubicación para %1 ítem(s):").arg(ids.size()),
+        QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || location.isEmpty()) return;
+
+    submitWrite([this, ids, location] { return manager.relocateItems(ids, location); },
+                "No se pudo reubicar. No se modificó ningún ítem.");
+}
+
+/**
+ * @brief Carga un conjunto de datos de prueba (Seed Data).
+ * @details Encola un trabajo de escritura que inserta aproximadamente 50 ítems
+ * predefinidos, por lotes, dentro de una sola transacción. Si se cancela o
+ * falla a mitad de camino, no queda ninguno.
+ * Útil para pruebas y demostraciones iniciales.
+ */
+void MainWindow::onLoadDefaults()
+{
+    jobs.submit("Cargar componentes por defecto", JobMode::Write, [](JobContext &job) {
+        const QList<InventoryItem> items = defaultItems();
+        const int batch = 10;
+        for (int i = 0; i < items.size(); i += batch) {
+            if (job.isCanceled()) {
+                return false;
+            }
+            if (!job.manager().addItems(items.mid(i, batch))) {
+                job.fail("No se pudieron cargar los componentes por defecto.");
+                return false;
+            }
+            job.setProgress(qMin(i + batch, int(items.size())), items.size());
+        }
+        return true;
+    });
 }
 
 /**
  * @brief Restaura la base de datos a su estado original (vacía y luego recargada).
- * @warning Esta acción ejecuta un `DELETE FROM inventario`, borrando todos los datos existentes.
+ * @details Reemplaza los ítems y sus claves de búsqueda por los de la plantilla
+ * "inventario_base.db" (creada la primera vez a partir de los datos por defecto)
+ * con InventoryManager::restoreFromTemplate, que copia sus páginas sobre la base
+ * en uso en un solo paso atómico. El historial (con una marca de reemplazo) y los
+ * puntos de reorden por tipo se conservan. Si la plantilla no se puede crear
+ * o usar, recurre a reemplazar todos los ítems en una sola transacción.
+ * Corre como trabajo exclusivo de la cola: se puede cancelar mientras espera
+ * o arma la plantilla, no una vez empezada la copia.
+ * @warning Borra todos los ítems existentes y sus puntos de reorden propios.
  */
 void MainWindow::onRestoreDefaults()
 {
     if (QMessageBox::question(this, "Restaurar Fábrica",
-                              "¿Seguro que deseas borrar TODO el inventario y restaurar los datos por defecto?\nEsta acción no se puede deshacer.")
+                              "¿Seguro que deseas borrar TODO el inventario y restaurar los datos por defecto?\n"
+                              "Los puntos de reorden de cada ítem se borran con él; "
+                              "los de cada tipo y el historial se conservan.\n"
+                              "Esta acción no se puede deshacer.")
         != QMessageBox::Yes)
         return;
-    QSqlQuery q;
-    q.exec("DELETE FROM inventario");
 
+    jobs.submit("Restaurar base original", JobMode::Exclusive, [](JobContext &job) {
+        // La plantilla se construye una sola vez; las restauraciones siguientes
+        // solo copian sus páginas sobre la base en uso
+        const QString templatePath = "inventario_base.db";
+        bool haveTemplate = QFile::exists(templatePath);
+        if (!haveTemplate) {
+            job.setProgress(0, 2, "Creando la plantilla...");
+            haveTemplate = InventoryManager::buildTemplate(templatePath, defaultItems());
+            if (!haveTemplate) {
+                qDebug() << "No se pudo crear la plantilla; se cargan los datos por defecto";
+            }
+        }
+        if (job.isCanceled()) {
+            return false;
+        }
+        job.setProgress(1, 2, "Copiando la plantilla...");
+
+        bool restored = haveTemplate && job.manager().restoreFromTemplate(templatePath);
+        if (haveTemplate && !restored) {
+            // Plantilla de un esquema anterior: se rehace una vez
+            QFile::remove(templatePath);
+            restored = InventoryManager::buildTemplate(templatePath, defaultItems())
+                       && job.manager().restoreFromTemplate(templatePath);
+        }
 
-    onLoadDefaults();
-    QMessageBox::information(this, "Restauración", "La base de datos ha sido restaurada.");
+        // Ambos caminos marcan la tabla como reemplazada: la ventana recarga
+        if (!restored && !job.manager().replaceAllItems(defaultItems())) {
+            job.fail("No se pudo restaurar la base de datos.");
+            return false;
+        }
+        job.setProgress(2, 2);
+        return true;
+    });
 }
 
 /**
  * @brief Genera y exporta un reporte del inventario en formato CSV.
- * @details Abre un diálogo de sistema para seleccionar la ruta de guardado y utiliza
- * la clase helper @ref CSVReport para generar el archivo.
+ * @details Abre un diálogo de sistema para seleccionar la ruta de guardado y
+ * encola un trabajo de lectura que usa la clase helper @ref CSVReport. El
+ * avance se ve en la lista de trabajos; si se cancela, el archivo a medio
+ * escribir se borra.
  */
 void MainWindow::onExport()
 {
@@ -474,47 +918,171 @@ void MainWindow::onExport()
 
     if (filename.isEmpty()) return;
 
-    CSVReport report;
-    // Obtiene todos los items mediante el manager y genera el archivo
-    if (report.generate(manager.getAllItems(), filename)) {
-        QMessageBox::information(this, "Éxito", "El reporte ha sido exportado correctamente.");
-    } else {
-        QMessageBox::critical(this, "Error de Exportación", "No se pudo escribir el archivo en la ruta seleccionada.");
+    jobs.submit(QString("Exportar CSV (%1)").arg(QFileInfo(filename).fileName()), JobMode::Read,
+                [filename](JobContext &job) {
+        qint64 total = 0;
+        QSqlQuery count(job.database());
+        if (count.exec("SELECT COUNT(*) FROM inventario") && count.next()) {
+            total = count.value(0).toLongLong();
+        }
+        count.finish();
+
+        CSVReport report;
+        // Escribe las filas a medida que se leen, sin copiar la tabla a memoria
+        const bool ok = report.generate(job.manager(), filename, [&job, total](qint64 rows) {
+            job.setProgress(rows, total);
+            return !job.isCanceled();
+        });
+        if (!ok && !job.isCanceled()) {
+            job.fail("No se pudo escribir el archivo en la ruta seleccionada.");
+        }
+        return ok;
+    });
+}
+
+/**
+ * @brief Muestra los trabajos en cola y en curso, con su avance.
+ * @details La lista se oculta cuando no queda ninguno; se conserva el
+ * trabajo elegido entre actualizaciones.
+ */
+void MainWindow::updateJobList()
+{
+    const QListWidgetItem *current = jobList->currentItem();
+    const int selected = current ? current->data(Qt::UserRole).toInt() : 0;
+
+    jobList->clear();
+    for (const JobStats &s : jobs.activeJobs()) {
+        QString text = QString("%1: %2").arg(s.title, JobQueue::stateName(s.state));
+        if (s.state == JobState::Running && s.total > 0) {
+            text += QString(" %1% (%2 de %3)").arg(int(s.fraction() * 100)).arg(s.done).arg(s.total);
+        }
+        if (s.state == JobState::Running && !s.detail.isEmpty()) {
+            text += " " + s.detail;
+        }
+        auto *item = new QListWidgetItem(text, jobList);
+        item->setData(Qt::UserRole, s.id);
+        if (s.id == selected) {
+            jobList->setCurrentItem(item);
+        }
     }
+
+    const bool visible = jobList->count() > 0;
+    jobList->setVisible(visible);
+    btnCancelJob->setVisible(visible);
 }
 
 /**
- * @brief Analiza el stock actual y resalta visualmente los ítems críticos.
- * @details
- * 1. Itera sobre todas las filas del modelo proxy.
- * 2. Compara la cantidad con `lowStockThreshold`.
- * 3. Si es menor, modifica el `Qt::BackgroundRole` de la celda para pintarla de rojo claro.
- * 4. Genera una lista de nombres de productos bajos en stock y la muestra en un MessageBox.
+ * @brief Cancela el trabajo elegido en la lista o, si no hay ninguno, el más antiguo.
+ * @details La cancelación es cooperativa: el trabajo se detiene en su próxima
+ * revisión y deshace lo que escribió.
  */
-void MainWindow::onLowStock()
+void MainWindow::onCancelJob()
 {
-    QStringList lowStockItems;
+    const QListWidgetItem *item = jobList->currentItem();
+    if (!item && jobList->count() > 0) {
+        item = jobList->item(0);
+    }
+    if (item) {
+        jobs.cancel(item->data(Qt::UserRole).toInt());
+    }
+}
 
-    for (int r = 0; r < proxy->rowCount(); r++) {
-        // Índice de la columna 'Cantidad' (columna 3)
-        QModelIndex idxQty = proxy->index(r, 3);
-        int qty = idxQty.data().toInt();
-
-        if (qty < lowStockThreshold) {
-            // Pintar toda la fila (iterando columnas)
-            for (int c = 0; c < proxy->columnCount(); c++) {
-                tableView->model()->setData(
-                    proxy->index(r, c),
-                    QColor(255, 200, 200), // Rojo claro
-                    Qt::BackgroundRole
-                );
-            }
+/**
+ * @brief Informa el resultado de un trabajo terminado.
+ * @details Los cancelados solo salen de la lista; los demás avisan con su duración
+ * o con el motivo del fallo.
+ * @param stats Estado final del trabajo.
+ */
+void MainWindow::onJobFinished(const JobStats &stats)
+{
+    updateJobList();
+
+    if (stats.state == JobState::Done) {
+        QMessageBox::information(this, "Trabajo terminado",
+            QString("%1: completado en %2 s.").arg(stats.title).arg(stats.runNs / 1e9, 0, 'f', 1));
+    } else if (stats.state == JobState::Failed) {
+        QMessageBox::critical(this, "Error", QString("%1: %2").arg(stats.title, stats.detail));
+    }
+}
 
-            // Agregar nombre a la lista de alerta
-            QModelIndex idxName = proxy->index(r, 1);
-            lowStockItems << idxName.data().toString();
+/**
+ * @brief Respalda la base en un archivo sin detener la aplicación.
+ * @details La copia avanza por pasos (OnlineBackup) mientras la ventana,
+ * los escáneres y las ediciones siguen funcionando. Un diálogo no modal
+ * muestra el avance y permite cancelar; al terminar se informa el caudal
+ * y el resultado de la verificación de integridad.
+ */
+void MainWindow::onBackup()
+{
+    if (backup.isRunning()) {
+        QMessageBox::information(this, "Respaldo", "Ya hay un respaldo en curso.");
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(
+        this, "Guardar Respaldo", "inventario_respaldo.db", "Bases SQLite (*.db)");
+
+    if (filename.isEmpty()) return;
+
+    auto *dialog = new QProgressDialog("Respaldando la base de datos...", "Cancelar", 0, 1000, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowModality(Qt::NonModal);
+    dialog->setMinimumDuration(500);
+
+    connect(dialog, &QProgressDialog::canceled, &backup, &OnlineBackup::cancel);
+    connect(&backup, &OnlineBackup::progress, dialog, [dialog](const BackupStats &s) {
+        dialog->setValue(int(s.fraction() * 1000));
+        dialog->setLabelText(QString("Respaldando la base de datos... %1 de %2 páginas (%3 MB/s)")
+                                 .arg(s.pageCount - s.remaining)
+                                 .arg(s.pageCount)
+                                 .arg(s.bytesPerSecond() / (1024.0 * 1024.0), 0, 'f', 1));
+    });
+    connect(&backup, &OnlineBackup::finished, dialog, [this, dialog](bool ok, const BackupStats &s) {
+        // Se desconecta antes de cerrar, para no tomar el cierre como cancelación
+        disconnect(dialog, nullptr, &backup, nullptr);
+        disconnect(&backup, nullptr, dialog, nullptr);
+        dialog->close();
+
+        if (ok) {
+            QMessageBox::information(this, "Éxito",
+                QString("Respaldo completo y verificado: %1 páginas en %2 s (%3 MB/s).")
+                    .arg(s.pageCount)
+                    .arg(s.elapsedNs / 1e9, 0, 'f', 1)
+                    .arg(s.bytesPerSecond() / (1024.0 * 1024.0), 0, 'f', 1));
+        } else if (s.integrity.isEmpty() || s.integrity == "ok") {
+            QMessageBox::warning(this, "Respaldo", "El respaldo no se completó; el archivo anterior no se modificó.");
+        } else {
+            QMessageBox::critical(this, "Error de Respaldo",
+                                  "La copia no pasó la verificación de integridad:\n" + s.integrity);
         }
+    });
+
+    if (!backup.start(filename)) {
+        dialog->close();
+        QMessageBox::critical(this, "Error de Respaldo", "No se pudo iniciar el respaldo en la ruta seleccionada.");
     }
+}
+
+/**
+ * @brief Analiza el stock actual y resalta visualmente los ítems críticos.
+ * @details
+ * 1. Activa en el delegado el fondo rojo claro de las filas bajo su punto
+ *    de reorden (el estado de cada fila ya lo calculó el modelo).
+ * 2. Consulta en la conexión de lectura los productos bajo su punto de
+ *    reorden (propio, de su tipo o el general) y los muestra en un MessageBox.
+ */
+void MainWindow::onLowStock()
+{
+    stockDelegate->setHighlightRows(true);
+    tableView->viewport()->update();
+
+    // La lista de alerta sale de una instantánea consistente de la base,
+    // no de las filas que el modelo haya alcanzado a cargar
+    QStringList lowStockItems;
+    manager.forEachBelowReorderPoint([&lowStockItems](const InventoryRowView &row) {
+        lowStockItems << row.nombre.toString();
+        return true;
+    });
 
     if (!lowStockItems.isEmpty()) {
         QMessageBox::warning(this, "Alerta de Stock Bajo", 
@@ -524,31 +1092,508 @@ void MainWindow::onLowStock()
     }
 }
 
+/**
+ * @brief Fija el punto de reorden de las filas seleccionadas o del tipo elegido.
+ * @details Con filas seleccionadas, el punto es propio de esos ítems. Sin
+ * selección, se aplica al tipo elegido en la faceta de tipo y vale para
+ * todos sus ítems que no tengan uno propio. Un valor de -1 quita el punto
+ * (los ítems vuelven al de su tipo, y el tipo al general).
+ */
+void MainWindow::onReorderPoint()
+{
+    const QList<int> ids = selectedIds();
+    const QString tipo = tipoFacet->currentData().toString();
+    if (ids.isEmpty() && tipo.isEmpty()) {
+        QMessageBox::information(this, "Punto de reorden",
+            "Selecciona filas o elige un tipo en la faceta de tipo.");
+        return;
+    }
+
+    const QString target = ids.isEmpty() ? QString("el tipo \"%1\"").arg(tipo)
+                                         : QString("%1 ítem(s)").arg(ids.size());
+    bool ok = false;
+    const int point = QInputDialog::getInt(
+        this, "Punto de reorden",
+        QString("Punto de reorden para %1 (general: %2; -1 para quitarlo):")
+            .arg(target).arg(manager.defaultReorderPoint()),
+        lowStockThreshold, -1, 1000000, 1, &ok);
+    if (!ok) return;
+
+    submitWrite([this, ids, tipo, point] {
+        return ids.isEmpty() ? manager.setTypeReorderPoint(tipo, point)
+                             : manager.setReorderPoints(ids, point);
+    }, "No se pudo guardar el punto de reorden.");
+}
+
+/**
+ * @brief Busca un texto en las bases de todas las sedes adjuntas.
+ * @details Las sedes se adjuntan al iniciar (`--sede nombre=archivo`). La
+ * búsqueda se reparte a todas en paralelo, así que tarda lo que la sede
+ * más lenta; cada resultado indica de qué sede viene.
+ */
+void MainWindow::onSearchSites()
+{
+    InventoryShards &sites = manager.shards();
+    if (sites.sites().isEmpty()) {
+        QMessageBox::information(this, "Buscar en sedes",
+            "No hay sedes adjuntas. Inicie la aplicación con --sede nombre=archivo.");
+        return;
+    }
+
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, "Buscar en sedes", "Texto a buscar:",
+                                               QLineEdit::Normal, searchEdit->text(), &ok);
+    if (!ok || text.trimmed().isEmpty()) return;
+
+    const QList<SiteItem> found = sites.search(text);
+    const FanOutStats fan = sites.lastFanOut();
+
+    // Se listan las primeras coincidencias; el resumen indica el total
+    const int shown = 200;
+    QStringList lines;
+    for (int i = 0; i < found.size() && i < shown; i++) {
+        const SiteItem &s = found.at(i);
+        lines << QString("[%1] %2 - %3 u. en %4")
+                     .arg(s.site, s.item.nombre)
+                     .arg(s.item.cantidad)
+                     .arg(s.item.ubicacion);
+    }
+    if (found.size() > shown) {
+        lines << QString("... y %1 más").arg(found.size() - shown);
+    }
+
+    QString summary = QString("%1 coincidencias en %2 sedes (%3 ms).")
+                          .arg(found.size())
+                          .arg(fan.shards)
+                          .arg(fan.wallNs / 1e6, 0, 'f', 1);
+    if (fan.failed > 0) {
+        summary += QString("\n%1 sedes no respondieron; sus resultados no se incluyen.").arg(fan.failed);
+    }
+    QMessageBox::information(this, "Buscar en sedes", summary + "\n\n" + lines.join("\n"));
+}
+
+/**
+ * @brief Trae a esta base los cambios de la base de otra sede.
+ * @details La otra base se abre en solo lectura y se compara con
+ * InventorySync, que cruza las filas por su identidad entre sedes y solo
+ * lee las de las hojas distintas de sus árboles de resúmenes. Los cambios
+ * de un solo lado se resuelven con el estado de la última sincronización;
+ * solo si hay filas que cambiaron en las dos sedes el usuario elige qué
+ * hacer con ellas. La fusión se confirma en una sola transacción. Las
+ * filas que solo están aquí no se tocan.
+ */
+void MainWindow::onSync()
+{
+    const QString filename = QFileDialog::getOpenFileName(
+        this, "Sincronizar con otra base", QString(), "Bases SQLite (*.db)");
+    if (filename.isEmpty()) return;
+
+    const QString connection = "inventario_sincronizacion";
+    auto compareAndMerge = [this, &filename, &connection]() {
+        QSqlDatabase other = QSqlDatabase::addDatabase("QSQLITE", connection);
+        other.setDatabaseName(filename);
+        other.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (!other.open()) {
+            QMessageBox::critical(this, "Sincronizar", "No se pudo abrir la otra base.");
+            return;
+        }
+
+        InventoryManager remote(other);
+        InventorySync sync(manager, remote);
+        if (!sync.diff()) {
+            QMessageBox::critical(this, "Sincronizar", "No se pudo leer el inventario de alguna de las bases.");
+            return;
+        }
+
+        const SyncStats s = sync.stats();
+        const QString summary = QString("%1 filas nuevas y %2 cambiadas en la otra base, %3 borradas allá, "
+                                        "%4 cambiadas en ambas y %5 solo en esta.\n"
+                                        "Comparación: %6 resúmenes y %7 filas leídas en %8 ms.")
+                                    .arg(s.onlyRemote)
+                                    .arg(s.changedRemote)
+                                    .arg(s.removedRemote)
+                                    .arg(s.changed)
+                                    .arg(s.onlyLocal)
+                                    .arg(s.digestsCompared)
+                                    .arg(s.rowsFetched)
+                                    .arg((s.buildNs + s.diffNs) / 1e6, 0, 'f', 1);
+
+        // Sin conflictos no hay nada que preguntar; la fusión igual anota
+        // el estado sincronizado
+        QString choice;
+        const QStringList policies = {"Conservar la versión de esta base",
+                                      "Tomar la versión de la otra base",
+                                      "Conservar ambas (la otra como fila nueva)"};
+        if (s.changed > 0) {
+            // El orden coincide con InventorySync::ConflictPolicy
+            bool ok = false;
+            choice = QInputDialog::getItem(this, "Sincronizar",
+                                           summary + "\n\nFilas cambiadas en ambas:",
+                                           policies, 0, false, &ok);
+            if (!ok) return;
+        }
+
+        const int policy = qMax(0, int(policies.indexOf(choice)));
+        if (sync.merge(InventorySync::ConflictPolicy(policy))) {
+            const SyncStats m = sync.stats();
+            QMessageBox::information(this, "Sincronizar",
+                QString("Sincronización completa: %1 filas nuevas, %2 reemplazadas, %3 borradas "
+                        "y %4 duplicadas.\n\n%5")
+                    .arg(m.inserted).arg(m.updated).arg(m.removed).arg(m.duplicated).arg(summary));
+        } else {
+            QMessageBox::critical(this, "Sincronizar", "No se pudo aplicar la fusión; esta base no cambió.");
+        }
+    };
+    compareAndMerge();
+    QSqlDatabase::removeDatabase(connection);
+}
+
+/**
+ * @brief Muestra las existencias tal como estaban en una fecha pasada.
+ * @details Se pide la fecha ("aaaa-mm-dd", que se toma al final del día,
+ * o "aaaa-mm-dd hh:mm"). Si la barra de búsqueda tiene texto, solo se
+ * listan los ítems que coinciden ("¿cuántos ESP32-CAM había el 1 de
+ * marzo?"). El inventario se reconstruye desde la foto más cercana del
+ * historial más los deltas posteriores a ella.
+ */
+void MainWindow::onHistory()
+{
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, "Historial", "Fecha (aaaa-mm-dd [hh:mm]):",
+                                               QLineEdit::Normal,
+                                               QDate::currentDate().toString("yyyy-MM-dd"), &ok);
+    if (!ok || text.trimmed().isEmpty()) return;
+
+    QDateTime when = QDateTime::fromString(text.trimmed(), "yyyy-MM-dd HH:mm");
+    if (!when.isValid()) {
+        const QDate day = QDate::fromString(text.trimmed(), "yyyy-MM-dd");
+        if (day.isValid()) {
+            when = day.endOfDay();
+        }
+    }
+    if (!when.isValid()) {
+        QMessageBox::warning(this, "Historial", "Fecha no válida.");
+        return;
+    }
+
+    const QDateTime start = manager.historyStart();
+    if (!start.isValid() || when < start) {
+        QMessageBox::information(this, "Historial",
+            "No hay historial para esa fecha. El historial empieza el "
+            + start.toString("yyyy-MM-dd HH:mm") + ".");
+        return;
+    }
+
+    QList<InventoryItem> items = manager.inventoryAt(when);
+    const QString filter = searchEdit->text().trimmed();
+    if (!filter.isEmpty()) {
+        const QList<int> matches = manager.searchItems(filter);
+        const QSet<int> wanted(matches.begin(), matches.end());
+        items.erase(std::remove_if(items.begin(), items.end(),
+                                   [&wanted](const InventoryItem &it) { return !wanted.contains(it.id); }),
+                    items.end());
+    }
+
+    qint64 units = 0;
+    QStringList lines;
+    const int shown = 200;
+    for (const InventoryItem &it : items) {
+        units += it.cantidad;
+        if (lines.size() < shown) {
+            lines << QString("%1 (ID %2): %3")
+                         .arg(it.nombre.isEmpty() ? QString("[eliminado]") : it.nombre)
+                         .arg(it.id)
+                         .arg(it.cantidad);
+        }
+    }
+    if (items.size() > shown) {
+        lines << QString("... y %1 más").arg(items.size() - shown);
+    }
+
+    const HistoryStats h = manager.historyStats();
+    QString summary = QString("%1 ítems y %2 unidades al %3.\n"
+                              "Reconstruido con %4 deltas en %5 ms. Historial: %6 deltas y %7 fotos")
+                          .arg(items.size())
+                          .arg(units)
+                          .arg(when.toString("yyyy-MM-dd HH:mm"))
+                          .arg(h.lastReplayed)
+                          .arg(h.lastReconstructNs / 1e6, 0, 'f', 1)
+                          .arg(h.changes)
+                          .arg(h.keyframes);
+    if (h.deltaBytes >= 0) {
+        summary += QString(", %1 bytes por cambio").arg(h.bytesPerChange(), 0, 'f', 1);
+    }
+    QMessageBox::information(this, "Historial", summary + ".\n\n" + lines.join("\n"));
+}
+
+/**
+ * @brief Lista los ítems que se agotarían dentro de un plazo al ritmo actual.
+ * @details El ritmo de cada ítem sale de sus consumos de los últimos 90
+ * días (DepletionForecast), con más peso para los recientes. La tabla se
+ * ordena por cualquier columna; por defecto, los más urgentes arriba.
+ * A diferencia de "Revisar stock bajo", un ítem con muchas unidades pero
+ * mucha salida también aparece.
+ */
+void MainWindow::onForecast()
+{
+    bool ok = false;
+    const int days = QInputDialog::getInt(this, "Se agota pronto", "Se agota en los próximos (días):",
+                                          14, 1, 3650, 1, &ok);
+    if (!ok) return;
+
+    DepletionForecast forecast;
+    if (!forecast.load(manager)) {
+        QMessageBox::warning(this, "Se agota pronto", "No se pudo leer el historial de existencias.");
+        return;
+    }
+    forecast.compute();
+    const QList<ForecastRow> rows = forecast.runsOutWithin(days);
+
+    QList<int> ids;
+    ids.reserve(rows.size());
+    for (const ForecastRow &row : rows) {
+        ids.append(row.id);
+    }
+    QHash<int, QString> names;
+    for (const InventoryItem &it : manager.getItemsByIds(ids)) {
+        names.insert(it.id, it.nombre);
+    }
+
+    // Los números van como datos, no como texto, para que el orden sea numérico
+    auto number = [](const QVariant &value) {
+        QTableWidgetItem *cell = new QTableWidgetItem();
+        cell->setData(Qt::DisplayRole, value);
+        cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        return cell;
+    };
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Se agota pronto");
+    dialog.resize(720, 480);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    const ForecastStats stats = forecast.stats();
+    layout->addWidget(new QLabel(QString("%1 de %2 ítems se agotarían en %3 días "
+                                         "(%4 consumos; lectura %5 ms, cálculo %6 ms).")
+                                     .arg(rows.size())
+                                     .arg(stats.items)
+                                     .arg(days)
+                                     .arg(stats.changes)
+                                     .arg(stats.loadNs / 1e6, 0, 'f', 1)
+                                     .arg(stats.computeNs / 1e6, 0, 'f', 1)));
+
+    QTableWidget *table = new QTableWidget(rows.size(), 6);
+    table->setHorizontalHeaderLabels({"ID", "Nombre", "Cantidad", "Consumo/día",
+                                      "Días restantes", "Se agota"});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    const QDate today = forecast.now().date();
+    for (int r = 0; r < rows.size(); ++r) {
+        const ForecastRow &row = rows[r];
+        table->setItem(r, 0, number(row.id));
+        table->setItem(r, 1, new QTableWidgetItem(names.value(row.id)));
+        table->setItem(r, 2, number(row.cantidad));
+        table->setItem(r, 3, number(qRound(row.perDay * 100) / 100.0));
+        table->setItem(r, 4, number(qRound(row.daysLeft * 10) / 10.0));
+        table->setItem(r, 5, new QTableWidgetItem(dateToString(row.depletionDate(today))));
+    }
+    table->setSortingEnabled(true);
+    table->sortByColumn(4, Qt::AscendingOrder);
+    table->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    layout->addWidget(table);
+
+    QPushButton *close = new QPushButton("Cerrar");
+    connect(close, &QPushButton::clicked, &dialog, &QDialog::accept);
+    layout->addWidget(close, 0, Qt::AlignRight);
+    dialog.exec();
+}
+
 /**
  * @brief Filtra la tabla en tiempo real según el texto ingresado.
- * @param text Cadena de búsqueda. Se busca coincidencia en cualquier columna.
+ * @details La búsqueda no distingue tildes ni mayúsculas ("cajon" encuentra
+ * "Cajón A1") y se resuelve en SQL con las claves plegadas e indexadas,
+ * dentro de las mismas consultas que leen las páginas del modelo: las
+ * coincidencias aparecen aunque estén lejos de lo ya cargado.
+ * Con "Aproximada" marcada se usa el índice de trigramas (FuzzyIndex)
+ * sobre el nombre: "2N3940" encuentra "2N3904" y los resultados se ordenan
+ * del más al menos parecido.
+ * @param text Cadena de búsqueda. Cada palabra debe ser prefijo de alguna
+ * palabra del nombre, tipo, ubicación, fecha o ID.
  */
 void MainWindow::onSearch(const QString &text)
 {
-    proxy->setFilterFixedString(text);
+    if (!text.trimmed().isEmpty() && fuzzyCheck->isChecked()) {
+        QList<int> ids;
+        for (const FuzzyMatch &match : fuzzy.search(text)) {
+            ids.append(match.id);
+        }
+        model->setRankedIds(ids);
+        return;
+    }
+    model->setSearch(text);
+}
+
+/**
+ * @brief Aplica a la tabla la selección de facetas y actualiza los conteos.
+ * @details El modelo vuelve a su primera página con las facetas en el WHERE
+ * de cada consulta, así que muestra los mismos ítems que cuentan los
+ * conteos, no solo los de las páginas ya cargadas.
+ */
+void MainWindow::onFacetChanged()
+{
+    model->setFacetFilter(currentFacetFilter());
+    updateFacetCounts();
+}
+
+/**
+ * @brief Muestra en cada faceta el número de ítems por valor.
+ * @details Los conteos de cada faceta respetan la selección de las demás;
+ * se leen de FacetCounts, que los mantiene con cada cambio de ítems.
+ */
+void MainWindow::updateFacetCounts()
+{
+    const FacetFilter filter = currentFacetFilter();
+
+    FacetFilter withoutTipo = filter;
+    withoutTipo.tipo.clear();
+    fillFacetCombo(tipoFacet, facets.tipoCounts(filter), facets.matchCount(withoutTipo));
+
+    FacetFilter withoutUbicacion = filter;
+    withoutUbicacion.ubicacion.clear();
+    fillFacetCombo(ubicacionFacet, facets.ubicacionCounts(filter), facets.matchCount(withoutUbicacion));
+
+    facetCountLabel->setText(QString("%1 ítems").arg(facets.matchCount(filter)));
+}
+
+/**
+ * @brief Construye el filtro de facetas a partir de los controles.
+ * @return Filtro con los campos vacíos donde no hay selección.
+ */
+FacetFilter MainWindow::currentFacetFilter() const
+{
+    FacetFilter filter;
+    filter.tipo = tipoFacet->currentData().toString();
+    filter.ubicacion = ubicacionFacet->currentData().toString();
+    if (dateFacetCheck->isChecked()) {
+        filter.desde = dateToString(dateFrom->date());
+        filter.hasta = dateToString(dateTo->date());
+    }
+    return filter;
+}
+
+/**
+ * @brief Obtiene los IDs de las filas seleccionadas.
+ * @details Recorre los rangos de la selección (no cada índice) y traduce
+ * cada fila del proxy a la fila del modelo fuente para leer su ID.
+ * @return Lista de IDs sin repetir.
+ */
+QList<int> MainWindow::selectedIds() const
+{
+    QList<int> ids;
+    const QItemSelection selection = tableView->selectionModel()->selection();
+
+    for (const QItemSelectionRange &range : selection) {
+        for (int r = range.top(); r <= range.bottom(); r++) {
+            const QModelIndex src = proxy->mapToSource(proxy->index(r, InventorySchema::Id));
+            ids.append(model->idAt(src.row()));
+        }
+    }
+
+    // Una fila puede aparecer en dos rangos si se seleccionaron celdas sueltas
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+/**
+ * @brief Guarda un cambio de la interfaz sin fallar porque la base esté ocupada.
+ * @details Usa InventoryManager::queueWrite: sin otra estación escribiendo se
+ * confirma enseguida; si no, queda en espera (se ve en pendingWritesLabel) y se
+ * reintenta con un temporizador. @p op se ejecuta más tarde, así que debe
+ * capturar sus datos por valor.
+ * @param op Escritura a realizar.
+ * @param errorMessage Texto del cuadro de error si falla por otro motivo.
+ */
+void MainWindow::submitWrite(const InventoryManager::WriteOp &op, const QString &errorMessage)
+{
+    manager.queueWrite(op, [this, errorMessage](bool ok) {
+        if (!ok) {
+            QMessageBox::critical(this, "Error", errorMessage);
+        }
+    });
 }
 
 /**
  * @brief Actualiza la vista recargando los datos desde la base de datos SQL.
- * @details Ejecuta de nuevo la consulta `SELECT` sobre el modelo y reasigna
- * los nombres de las cabeceras para una visualización amigable.
+ * @details Solo se usa cuando InventoryManager emite `inventoryReset` (tabla
+ * restaurada o demasiados cambios juntos); al iniciar, los mismos pasos se
+ * reparten entre onSchemaReady y onStartupIndexes. La tabla vuelve a su primera
+ * página (el resto se lee al desplazarse); la búsqueda aproximada y las facetas
+ * se reconstruyen con todos los ítems en segundo plano (@ref rebuildSearchIndexes).
+ * Los cambios habituales, propios o de otras estaciones, llegan por
+ * `itemsChanged` y se aplican fila por fila.
  */
 void MainWindow::refreshModel()
 {
-    model->setQuery("SELECT id, nombre, tipo, cantidad, ubicacion, fechaAdquisicion "
-                    "FROM inventario ORDER BY id DESC");
+    model->reload();
+    tableView->resizeColumnsToContents();
+    rebuildSearchIndexes();
+}
 
-    model->setHeaderData(0, Qt::Horizontal, "ID");
-    model->setHeaderData(1, Qt::Horizontal, "Nombre");
-    model->setHeaderData(2, Qt::Horizontal, "Tipo");
-    model->setHeaderData(3, Qt::Horizontal, "Cantidad");
-    model->setHeaderData(4, Qt::Horizontal, "Ubicación");
-    model->setHeaderData(5, Qt::Horizontal, "Fecha Adquisición");
+/**
+ * @brief Encola la reconstrucción de la búsqueda aproximada y las facetas.
+ * @details Un trabajo de lectura de la cola lee todos los ítems en una
+ * instantánea y arma ambos índices en su hilo. Hasta que se adoptan, la
+ * ventana sigue usando los anteriores y guarda los cambios que llegan
+ * (lateChanges) para volver a aplicarlos sobre los nuevos.
+ */
+void MainWindow::rebuildSearchIndexes()
+{
+    const int generation = ++indexGeneration;
+    QThread *gui = thread();
+    jobs.submit("Reconstruir búsqueda y facetas", JobMode::Read, [this, generation, gui](JobContext &job) {
+        std::shared_ptr<SearchIndexes> indexes;
+        QSqlDatabase db = job.database();
+        const bool snapshot = db.transaction();
+        const QList<InventoryItem> items = job.manager().getAllItems();
+        if (snapshot) {
+            db.commit();
+        }
+        if (!job.isCanceled()) {
+            indexes = std::make_shared<SearchIndexes>();
+            indexes->build(items, gui);
+        }
+        QMetaObject::invokeMethod(this, [this, generation, indexes]() {
+            adoptSearchIndexes(generation, indexes);
+        }, Qt::QueuedConnection);
+        return indexes != nullptr;
+    });
+}
 
-    tableView->resizeColumnsToContents();
+/**
+ * @brief Adopta los índices armados por @ref rebuildSearchIndexes.
+ * @details Si mientras tanto se pidió otra reconstrucción, se descartan y se
+ * espera la más reciente. Los cambios recibidos durante la reconstrucción se
+ * vuelven a aplicar en orden: aplicar de nuevo uno que ya estaba en la
+ * instantánea deja el mismo resultado.
+ * @param generation Número de la reconstrucción.
+ * @param indexes Índices armados, o nulo si el trabajo se canceló (se
+ * conservan los anteriores).
+ */
+void MainWindow::adoptSearchIndexes(int generation, const std::shared_ptr<SearchIndexes> &indexes)
+{
+    if (generation != indexGeneration) {
+        return;
+    }
+    adoptedGeneration = generation;
+    if (indexes) {
+        fuzzy.adopt(indexes->fuzzy);
+        facets.adopt(indexes->facets);
+        for (const auto &change : std::exchange(lateChanges, {})) {
+            fuzzy.applyChanges(change.first, change.second);
+            facets.applyChanges(change.first, change.second);
+        }
+    }
+    lateChanges.clear();
+    onSearch(searchEdit->text());
 }
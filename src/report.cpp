@@ -1,5 +1,6 @@
 #include "report.h"
 #include "InventoryManager.h"
+#include "InventorySchema.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
@@ -11,12 +12,44 @@ CSVReport::CSVReport()
 {
 }
 
+/**
+ * @brief Escribe la fila de encabezados del CSV.
+ */
+static void writeHeader(QTextStream &out)
+{
+    InventorySchema::forEachColumn([&](auto index, const auto &def) {
+        out << (index == 0 ? "" : ";") << def.csvHeader;
+    });
+    out << "\n";
+}
+
+/**
+ * @brief Escribe una fila (InventoryItem o InventoryRowView) del CSV.
+ *
+ * Los campos de texto van entre comillas dobles y los enteros sin ellas.
+ */
+template <typename Row>
+static void writeRow(QTextStream &out, const Row &row)
+{
+    InventorySchema::forEachColumn([&](auto index, const auto &def) {
+        using T = typename std::decay_t<decltype(def)>::Type;
+        out << (index == 0 ? "" : ";");
+        if constexpr (std::is_same_v<T, QString>) {
+            out << "\"" << InventorySchema::field(row, def) << "\"";
+        } else {
+            out << InventorySchema::field(row, def);
+        }
+    });
+    out << "\n";
+}
+
 /**
  * @brief Genera un archivo CSV con la información del inventario.
  *
  * Abre o crea un archivo en la ruta indicada y escribe una fila con
  * los encabezados seguida por una línea por cada elemento del inventario.
- * Los campos de texto son encapsulados entre comillas dobles.
+ * Las columnas y su orden salen de InventorySchema; los campos de texto
+ * son encapsulados entre comillas dobles y los enteros van sin comillas.
  *
  * Ejemplo de formato generado:
  * @code
@@ -42,19 +75,56 @@ bool CSVReport::generate(const QList<InventoryItem> &items,
 
     QTextStream out(&file);
 
-    // Encabezados del CSV
-    out << "ID;Nombre;Tipo;Cantidad;Ubicacion;FechaAdquisicion\n";
-
-    // Datos de cada item
+    writeHeader(out);
     for (const InventoryItem &it : items) {
-        out << it.id << ";"
-            << "\"" << it.nombre << "\";"
-            << "\"" << it.tipo << "\";"
-            << it.cantidad << ";"
-            << "\"" << it.ubicacion << "\";"
-            << "\"" << it.fechaAdquisicion << "\"\n";
+        writeRow(out, it);
     }
 
     file.close();
     return true;
 }
+
+/**
+ * @brief Genera el CSV leyendo las filas directamente de la base.
+ *
+ * Mismo formato que la versión con lista; las filas se escriben mientras
+ * se recorren, sin copias intermedias. Si @p onRow detiene el recorrido,
+ * el archivo incompleto se elimina.
+ *
+ * @param manager Origen de las filas.
+ * @param filePath Ruta completa del archivo CSV a generar.
+ * @param onRow Avance opcional (filas escritas); retorna false para detener.
+ *
+ * @return `true` si el archivo fue generado completo,
+ *         `false` si no fue posible abrirlo o leer la tabla, o si se detuvo.
+ */
+bool CSVReport::generate(InventoryManager &manager, const QString &filePath,
+                         const std::function<bool(qint64 rows)> &onRow)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "No se puede abrir archivo CSV:" << filePath;
+        return false;
+    }
+
+    QTextStream out(&file);
+    writeHeader(out);
+    qint64 rows = 0;
+    bool stopped = false;
+    const bool ok = manager.forEachItem([&](const InventoryRowView &row) {
+        writeRow(out, row);
+        if (onRow && !onRow(++rows)) {
+            stopped = true;
+            return false;
+        }
+        return true;
+    });
+
+    file.close();
+    if (stopped) {
+        file.remove();
+        return false;
+    }
+    return ok;
+}
@@ -0,0 +1,75 @@
+#ifndef TESTDATABASE_H
+#define TESTDATABASE_H
+
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "InventoryManager.h"
+
+/**
+ * @file TestDatabase.h
+ * @brief Utilidades compartidas por las pruebas: bases temporales y filas de ejemplo.
+ */
+
+/**
+ * @brief Abre una conexión a un archivo dentro de la carpeta temporal de la prueba.
+ *
+ * Varias conexiones al mismo archivo simulan varias estaciones. El archivo
+ * queda en modo WAL, como la base de la aplicación.
+ *
+ * @param dir Carpeta temporal de la prueba.
+ * @param connection Nombre único de la conexión.
+ * @param file Nombre del archivo dentro de @p dir.
+ */
+inline QSqlDatabase openTestDatabase(const QTemporaryDir &dir, const QString &connection,
+                                     const QString &file = "prueba.db")
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+    db.setDatabaseName(dir.filePath(file));
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (db.open()) {
+        QSqlQuery pragma(db);
+        pragma.exec("PRAGMA journal_mode=WAL");
+    }
+    return db;
+}
+
+/**
+ * @brief Cierra y quita una conexión abierta con @ref openTestDatabase.
+ *
+ * Los InventoryManager que la usaban deben haberse destruido antes.
+ */
+inline void closeTestDatabase(const QString &connection)
+{
+    {
+        QSqlDatabase db = QSqlDatabase::database(connection, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
+
+/**
+ * @brief Ítem de ejemplo (sin ID: lo asigna SQLite al insertarlo).
+ */
+inline InventoryItem sampleItem(const QString &nombre, const QString &tipo, int cantidad)
+{
+    return {0, nombre, tipo, cantidad, "Estante A", "2024-01-15"};
+}
+
+/**
+ * @brief Algunos ítems de ejemplo de tipos distintos.
+ */
+inline QList<InventoryItem> sampleItems()
+{
+    return {
+        sampleItem("Resistencia 10k", "Electrónico", 100),
+        sampleItem("Arduino Uno", "Microcontrolador", 4),
+        sampleItem("Sensor DHT22", "Sensor", 12),
+        sampleItem("Multímetro", "Instrumento", 2),
+    };
+}
+
+#endif // TESTDATABASE_H
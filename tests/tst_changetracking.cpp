@@ -0,0 +1,155 @@
+/**
+ * @file tst_changetracking.cpp
+ * @brief Pruebas del registro de cambios: señales por escrituras propias,
+ * externas y diferidas.
+ */
+
+#include <QFile>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+#include "InventoryManager.h"
+#include "TestDatabase.h"
+
+/**
+ * @brief Cambios recibidos por itemsChanged e inventoryReset.
+ */
+struct ChangeLog {
+    QList<QList<InventoryItem>> rows;
+    QList<QList<int>> removed;
+    int resets = 0;
+
+    void watch(InventoryManager &manager)
+    {
+        QObject::connect(&manager, &InventoryManager::itemsChanged,
+                         [this](const QList<InventoryItem> &changed, const QList<int> &removedIds) {
+            rows.append(changed);
+            removed.append(removedIds);
+        });
+        QObject::connect(&manager, &InventoryManager::inventoryReset, [this]() { resets++; });
+    }
+
+    void clear()
+    {
+        rows.clear();
+        removed.clear();
+        resets = 0;
+    }
+};
+
+class TestChangeTracking : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void ownWritesEmitChangedRows();
+    void removalEmitsRemovedId();
+    void externalWritesArriveByPolling();
+    void deferredTrackingEmitsOnStart();
+    void replacingTableEmitsReset();
+
+private:
+    QTemporaryDir dir;
+    std::unique_ptr<InventoryManager> manager;
+    ChangeLog log;
+};
+
+void TestChangeTracking::init()
+{
+    QVERIFY(dir.isValid());
+    QFile::remove(dir.filePath("prueba.db"));
+    manager = std::make_unique<InventoryManager>(openTestDatabase(dir, "principal"));
+    QVERIFY(manager->createTable());
+    log.clear();
+    log.watch(*manager);
+}
+
+void TestChangeTracking::cleanup()
+{
+    manager.reset();
+    closeTestDatabase("principal");
+    closeTestDatabase("externa");
+}
+
+void TestChangeTracking::ownWritesEmitChangedRows()
+{
+    QVERIFY(manager->addItem("Resistencia 10k", "Electrónico", 100, "Estante A", "2024-01-15"));
+    const int id = manager->lastAddedId();
+    QCOMPARE(log.rows.size(), 1);
+    QCOMPARE(log.rows.first().size(), 1);
+    QCOMPARE(log.rows.first().first().id, id);
+    QCOMPARE(log.rows.first().first().cantidad, 100);
+
+    QVERIFY(manager->updateQuantity(id, 40));
+    QCOMPARE(log.rows.size(), 2);
+    QCOMPARE(log.rows.last().first().cantidad, 40);
+    QVERIFY(log.removed.last().isEmpty());
+    QCOMPARE(log.resets, 0);
+}
+
+void TestChangeTracking::removalEmitsRemovedId()
+{
+    QVERIFY(manager->addItems(sampleItems()));
+    const QList<InventoryItem> items = manager->getAllItems();
+    QCOMPARE(items.size(), sampleItems().size());
+    log.clear();
+
+    QVERIFY(manager->removeItem(items.first().id));
+    QCOMPARE(log.removed.size(), 1);
+    QCOMPARE(log.removed.first(), QList<int>{items.first().id});
+    QVERIFY(log.rows.first().isEmpty());
+}
+
+void TestChangeTracking::externalWritesArriveByPolling()
+{
+    QVERIFY(manager->addItems(sampleItems()));
+    const int id = manager->getAllItems().first().id;
+    log.clear();
+
+    // Otra estación sobre el mismo archivo
+    {
+        InventoryManager other(openTestDatabase(dir, "externa"));
+        QVERIFY(other.createTable());
+        QVERIFY(other.updateQuantity(id, 7));
+    }
+    QVERIFY(log.rows.isEmpty());
+
+    QVERIFY(manager->pollExternalChanges());
+    QCOMPARE(log.rows.size(), 1);
+    QCOMPARE(log.rows.first().first().id, id);
+    QCOMPARE(log.rows.first().first().cantidad, 7);
+
+    // Sin cambios nuevos, el sondeo no emite nada
+    QVERIFY(!manager->pollExternalChanges());
+    QCOMPARE(log.rows.size(), 1);
+}
+
+void TestChangeTracking::deferredTrackingEmitsOnStart()
+{
+    manager->deferChangeTracking();
+    const qint64 position = manager->changePosition();
+
+    QVERIFY(manager->addItems(sampleItems()));
+    QVERIFY(log.rows.isEmpty());
+
+    manager->startChangeTracking(position);
+    QCOMPARE(log.rows.size(), 1);
+    QCOMPARE(log.rows.first().size(), sampleItems().size());
+}
+
+void TestChangeTracking::replacingTableEmitsReset()
+{
+    QVERIFY(manager->addItems(sampleItems()));
+    log.clear();
+
+    QVERIFY(manager->replaceAllItems({sampleItem("Protoboard", "Accesorio", 3)}));
+    QCOMPARE(log.resets, 1);
+    QCOMPARE(manager->getAllItems().size(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestChangeTracking)
+#include "tst_changetracking.moc"
@@ -0,0 +1,125 @@
+/**
+ * @file tst_history.cpp
+ * @brief Pruebas del historial de existencias: reconstrucción en el tiempo
+ * a partir de fotos y deltas.
+ */
+
+#include <QDateTime>
+#include <QFile>
+#include <QTest>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <memory>
+
+#include "InventoryManager.h"
+#include "TestDatabase.h"
+
+class TestHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void quantityFollowsChanges();
+    void inventoryAtListsExistingItems();
+    void keyframeLimitsReplay();
+    void beforeHistoryStartIsEmpty();
+
+private:
+    /** @brief Deja pasar un segundo entero: el historial guarda segundos. */
+    static QDateTime nextSecond();
+
+    QTemporaryDir dir;
+    std::unique_ptr<InventoryManager> manager;
+};
+
+void TestHistory::init()
+{
+    QVERIFY(dir.isValid());
+    QFile::remove(dir.filePath("prueba.db"));
+    manager = std::make_unique<InventoryManager>(openTestDatabase(dir, "principal"));
+    QVERIFY(manager->createTable());
+}
+
+void TestHistory::cleanup()
+{
+    manager.reset();
+    closeTestDatabase("principal");
+}
+
+QDateTime TestHistory::nextSecond()
+{
+    QTest::qSleep(1100);
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QTest::qSleep(1100);
+    return now;
+}
+
+void TestHistory::quantityFollowsChanges()
+{
+    QVERIFY(manager->addItem("Resistencia 10k", "Electrónico", 10, "Estante A", "2024-01-15"));
+    const int id = manager->lastAddedId();
+    const QDateTime afterAdd = nextSecond();
+
+    QVERIFY(manager->updateQuantity(id, 25));
+    const QDateTime afterUpdate = nextSecond();
+
+    QVERIFY(manager->removeItem(id));
+
+    QCOMPARE(manager->quantityAt(id, afterAdd), 10);
+    QCOMPARE(manager->quantityAt(id, afterUpdate), 25);
+    QCOMPARE(manager->quantityAt(id, QDateTime::currentDateTimeUtc()), -1);
+}
+
+void TestHistory::inventoryAtListsExistingItems()
+{
+    QVERIFY(manager->addItems(sampleItems()));
+    const QList<InventoryItem> before = manager->getAllItems();
+    const QDateTime snapshot = nextSecond();
+
+    QVERIFY(manager->removeItem(before.first().id));
+    QVERIFY(manager->updateQuantity(before.last().id, before.last().cantidad + 5));
+
+    const QList<InventoryItem> past = manager->inventoryAt(snapshot);
+    QCOMPARE(past.size(), before.size());
+    for (const InventoryItem &item : before) {
+        auto it = std::find_if(past.begin(), past.end(),
+                               [&item](const InventoryItem &p) { return p.id == item.id; });
+        QVERIFY(it != past.end());
+        QCOMPARE(it->cantidad, item.cantidad);
+    }
+    QCOMPARE(manager->inventoryAt(QDateTime::currentDateTimeUtc()).size(), before.size() - 1);
+}
+
+void TestHistory::keyframeLimitsReplay()
+{
+    QVERIFY(manager->addItems(sampleItems()));
+    const int id = manager->getAllItems().first().id;
+    QVERIFY(manager->takeKeyframe());
+    const qint64 keyframes = manager->historyStats().keyframes;
+
+    QVERIFY(manager->updateQuantity(id, 50));
+    QVERIFY(manager->updateQuantity(id, 60));
+    QCOMPARE(manager->historyStats().keyframes, keyframes);
+
+    QCOMPARE(manager->quantityAt(id, QDateTime::currentDateTimeUtc()), 60);
+    // Solo se aplican los deltas posteriores a la última foto
+    QCOMPARE(manager->historyStats().lastReplayed, qint64(2));
+}
+
+void TestHistory::beforeHistoryStartIsEmpty()
+{
+    QVERIFY(manager->addItems(sampleItems()));
+    const int id = manager->getAllItems().first().id;
+    const QDateTime start = manager->historyStart();
+    QVERIFY(start.isValid());
+
+    const QDateTime before = start.addSecs(-10);
+    QVERIFY(manager->inventoryAt(before).isEmpty());
+    QCOMPARE(manager->quantityAt(id, before), -1);
+}
+
+QTEST_GUILESS_MAIN(TestHistory)
+#include "tst_history.moc"
@@ -0,0 +1,133 @@
+/**
+ * @file tst_restore.cpp
+ * @brief Pruebas de la restauración desde una plantilla: ítems, claves de
+ * búsqueda, puntos de reorden, historial y aviso a las vistas.
+ */
+
+#include <QDateTime>
+#include <QFile>
+#include <QTest>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <memory>
+
+#include "InventoryManager.h"
+#include "TestDatabase.h"
+
+class TestRestore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void restoreReplacesItems();
+    void restoreKeepsTypeReorderPoints();
+    void restoreEmitsReset();
+    void restoreRecordsHistory();
+    void missingTemplateFails();
+
+private:
+    /** @brief Plantilla con un ítem por tipo, distinta de sampleItems(). */
+    static QList<InventoryItem> templateItems();
+
+    QTemporaryDir dir;
+    QString templatePath;
+    std::unique_ptr<InventoryManager> manager;
+};
+
+QList<InventoryItem> TestRestore::templateItems()
+{
+    return {
+        sampleItem("Capacitor 100uF", "Electrónico", 50),
+        sampleItem("Cajón A1", "Accesorio", 8),
+    };
+}
+
+void TestRestore::init()
+{
+    QVERIFY(dir.isValid());
+    QFile::remove(dir.filePath("prueba.db"));
+    templatePath = dir.filePath("plantilla.db");
+    QFile::remove(templatePath);
+    QVERIFY(InventoryManager::buildTemplate(templatePath, templateItems()));
+
+    manager = std::make_unique<InventoryManager>(openTestDatabase(dir, "principal"));
+    QVERIFY(manager->createTable());
+    QVERIFY(manager->addItems(sampleItems()));
+}
+
+void TestRestore::cleanup()
+{
+    manager.reset();
+    closeTestDatabase("principal");
+}
+
+void TestRestore::restoreReplacesItems()
+{
+    QVERIFY(manager->restoreFromTemplate(templatePath));
+
+    const QList<InventoryItem> items = manager->getAllItems();
+    QCOMPARE(items.size(), templateItems().size());
+    for (const InventoryItem &expected : templateItems()) {
+        auto it = std::find_if(items.begin(), items.end(), [&expected](const InventoryItem &item) {
+            return item.nombre == expected.nombre;
+        });
+        QVERIFY(it != items.end());
+        QCOMPARE(it->tipo, expected.tipo);
+        QCOMPARE(it->cantidad, expected.cantidad);
+    }
+
+    // Las claves de búsqueda vienen con la plantilla
+    QCOMPARE(manager->searchItems("cajon").size(), 1);
+    QCOMPARE(manager->searchItems("capacitor").size(), 1);
+    QVERIFY(manager->searchItems("arduino").isEmpty());
+}
+
+void TestRestore::restoreKeepsTypeReorderPoints()
+{
+    const int id = manager->getAllItems().first().id;
+    QVERIFY(manager->setTypeReorderPoint("Electrónico", 7));
+    QVERIFY(manager->setReorderPoints({id}, 3));
+
+    QVERIFY(manager->restoreFromTemplate(templatePath));
+
+    const ReorderPoints points = manager->reorderPoints();
+    QCOMPARE(points.byTipo.value("Electrónico"), 7);
+    QVERIFY(points.byItem.isEmpty());
+}
+
+void TestRestore::restoreEmitsReset()
+{
+    int resets = 0;
+    int changes = 0;
+    connect(manager.get(), &InventoryManager::inventoryReset, this, [&resets]() { resets++; });
+    connect(manager.get(), &InventoryManager::itemsChanged, this, [&changes]() { changes++; });
+
+    QVERIFY(manager->restoreFromTemplate(templatePath));
+    QCOMPARE(resets, 1);
+    QCOMPARE(changes, 0);
+
+    disconnect(manager.get(), nullptr, this, nullptr);
+}
+
+void TestRestore::restoreRecordsHistory()
+{
+    QVERIFY(manager->restoreFromTemplate(templatePath));
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (const InventoryItem &item : manager->getAllItems()) {
+        QCOMPARE(manager->quantityAt(item.id, now), item.cantidad);
+    }
+    QCOMPARE(manager->inventoryAt(now).size(), templateItems().size());
+}
+
+void TestRestore::missingTemplateFails()
+{
+    QVERIFY(!manager->restoreFromTemplate(dir.filePath("no-existe.db")));
+    QCOMPARE(manager->getAllItems().size(), sampleItems().size());
+}
+
+QTEST_GUILESS_MAIN(TestRestore)
+#include "tst_restore.moc"
@@ -0,0 +1,143 @@
+/**
+ * @file tst_writescheduler.cpp
+ * @brief Pruebas del planificador de escrituras: transacciones atómicas,
+ * lotes con SAVEPOINT, movimientos y escrituras en cola y base bloqueada
+ * por otra estación.
+ */
+
+#include <QFile>
+#include <QSqlQuery>
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+#include "InventoryManager.h"
+#include "TestDatabase.h"
+
+class TestWriteScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void atomicWriteRollsBack();
+    void batchKeepsSuccessfulOps();
+    void queuedDeltasMerge();
+    void lockedDatabaseRetriesLater();
+
+private:
+    QTemporaryDir dir;
+    std::unique_ptr<InventoryManager> manager;
+};
+
+void TestWriteScheduler::init()
+{
+    QVERIFY(dir.isValid());
+    QFile::remove(dir.filePath("prueba.db"));
+    manager = std::make_unique<InventoryManager>(openTestDatabase(dir, "principal"));
+    QVERIFY(manager->createTable());
+    QVERIFY(manager->addItems(sampleItems()));
+    manager->resetWriteStats();
+}
+
+void TestWriteScheduler::cleanup()
+{
+    manager.reset();
+    closeTestDatabase("principal");
+    closeTestDatabase("bloqueo");
+}
+
+void TestWriteScheduler::atomicWriteRollsBack()
+{
+    const int before = manager->getAllItems().size();
+
+    QVERIFY(!manager->writeAtomically([this] {
+        return manager->addItem("Protoboard", "Accesorio", 3, "Estante B", "2024-02-01")
+               && manager->addItem("Cable USB", "Accesorio", 10, "Estante B", "2024-02-01")
+               && false;
+    }));
+    QCOMPARE(manager->getAllItems().size(), before);
+
+    QVERIFY(manager->writeAtomically([this] {
+        return manager->addItem("Protoboard", "Accesorio", 3, "Estante B", "2024-02-01");
+    }));
+    QCOMPARE(manager->getAllItems().size(), before + 1);
+    QCOMPARE(manager->writeStats().transactions, qint64(1));
+}
+
+void TestWriteScheduler::batchKeepsSuccessfulOps()
+{
+    const int before = manager->getAllItems().size();
+
+    QList<bool> results;
+    QVERIFY(manager->writeBatch({
+        [this] { return manager->addItem("Protoboard", "Accesorio", 3, "Estante B", "2024-02-01"); },
+        [this] {
+            manager->addItem("Fuente 12V", "Accesorio", 1, "Estante B", "2024-02-01");
+            return false;
+        },
+        [this] { return manager->addItem("Cable USB", "Accesorio", 10, "Estante B", "2024-02-01"); },
+    }, &results));
+
+    QCOMPARE(results, (QList<bool>{true, false, true}));
+    QCOMPARE(manager->getAllItems().size(), before + 2);
+    QVERIFY(manager->searchItems("fuente").isEmpty());
+    QCOMPARE(manager->writeStats().transactions, qint64(1));
+}
+
+void TestWriteScheduler::queuedDeltasMerge()
+{
+    const InventoryItem item = manager->getAllItems().first();
+
+    manager->queueQuantityDeltas({{item.id, 5}});
+    manager->queueQuantityDeltas({{item.id, 3}});
+    QCOMPARE(manager->writeStats().transactions, qint64(0));
+
+    QVERIFY(manager->flushWrites());
+    QCOMPARE(manager->getItemById(item.id).cantidad, item.cantidad + 8);
+    QCOMPARE(manager->writeStats().transactions, qint64(1));
+
+    // Sin nada en cola no se abre otra transacción
+    QVERIFY(manager->flushWrites());
+    QCOMPARE(manager->writeStats().transactions, qint64(1));
+}
+
+void TestWriteScheduler::lockedDatabaseRetriesLater()
+{
+    const InventoryItem item = manager->getAllItems().first();
+
+    // Otra estación toma el bloqueo de escritura y no lo suelta
+    QSqlDatabase other = openTestDatabase(dir, "bloqueo");
+    QSqlQuery lock(other);
+    QVERIFY(lock.exec("BEGIN IMMEDIATE"));
+
+    QVERIFY(!manager->updateQuantity(item.id, 1));
+    QVERIFY(manager->writeStats().retries > 0);
+    QVERIFY(manager->writeStats().failures > 0);
+
+    // Los movimientos y las escrituras en cola no se pierden mientras dure el bloqueo
+    manager->queueQuantityDeltas({{item.id, 4}});
+    QVERIFY(!manager->flushWrites());
+    QCOMPARE(manager->getItemById(item.id).cantidad, item.cantidad);
+    QCOMPARE(InventoryManager::waitingWriters(), 0);
+
+    QList<bool> done;
+    manager->queueWrite([this, item] { return manager->relocateItems({item.id}, "Cajón Z9"); },
+                        [&done](bool ok) { done.append(ok); });
+    QVERIFY(done.isEmpty());
+    QCOMPARE(manager->queuedWrites(), 1);
+    QCOMPARE(manager->getItemById(item.id).ubicacion, item.ubicacion);
+
+    QVERIFY(lock.exec("COMMIT"));
+    QVERIFY(manager->flushWrites());
+    QCOMPARE(manager->getItemById(item.id).cantidad, item.cantidad + 4);
+    QCOMPARE(manager->getItemById(item.id).ubicacion, QString("Cajón Z9"));
+    QCOMPARE(done, QList<bool>{true});
+    QCOMPARE(manager->queuedWrites(), 0);
+    QCOMPARE(InventoryManager::waitingWriters(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestWriteScheduler)
+#include "tst_writescheduler.moc"
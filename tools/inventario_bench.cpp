@@ -0,0 +1,2299 @@
+/**
+ * @file inventario_bench.cpp
+ * @brief Herramienta de línea de comandos para medir la capa de datos del inventario.
+ *
+ * Cada subcomando crea una base SQLite temporal, la llena con datos
+ * sintéticos y mide un camino concreto de InventoryManager. Nunca toca
+ * el archivo "inventario.db" de la aplicación.
+ *
+ * Uso:
+ * @code
+ * inventario_bench lookup [filas] [consultas] [rafaga]
+ * inventario_bench scanner [eventos] [items] [clientes] [ventana_ms]
+ * inventario_bench fuzzy [items] [consultas]
+ * inventario_bench stream [filas]
+ * inventario_bench plans [filas,filas,...]
+ * inventario_bench contention [procesos] [escrituras] [lote]
+ * inventario_bench maintenance [filas] [presupuesto_ms]
+ * inventario_bench backup [filas] [paginas_por_paso]
+ * inventario_bench memory [filas] [operaciones]
+ * inventario_bench server [clientes] [solicitudes] [profundidad]
+ * inventario_bench loadgen <host> <puerto> [solicitudes] [profundidad] [items]
+ * inventario_bench shards [sedes] [filas]
+ * inventario_bench sync [filas] [diferencias]
+ * inventario_bench history [filas] [cambios]
+ * inventario_bench forecast [items] [consumos]
+ * inventario_bench scroll [filas] [cuadros]
+ * inventario_bench startup [filas]
+ * inventario_bench jobs [filas]
+ * @endcode
+ */
+
+#include <QApplication>
+#include <QCoreApplication>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QFile>
+#include <QHash>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QTcpSocket>
+#include <QThread>
+#include <QEventLoop>
+#include <QImage>
+#include <QScrollBar>
+#include <QTableView>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "component.h"
+#include "DatabaseMaintenance.h"
+#include "DatabaseManager.h"
+#include "delegate.h"
+#include "DepletionForecast.h"
+#include "FacetCounts.h"
+#include "FuzzyIndex.h"
+#include "InventoryFilterProxy.h"
+#include "InventoryManager.h"
+#include "InventoryModel.h"
+#include "InventoryProtocol.h"
+#include "InventoryServer.h"
+#include "InventoryShards.h"
+#include "InventorySync.h"
+#include "JobQueue.h"
+#include "OnlineBackup.h"
+#include "report.h"
+#include "ScannerIngest.h"
+#include "StartupLoader.h"
+#include "StartupTrace.h"
+
+#if defined(__GLIBC__)
+/**
+ * @brief Contador de reservas de memoria del proceso.
+ *
+ * En glibc, malloc/calloc/realloc se reemplazan aquí por envolturas que
+ * cuentan cada llamada y delegan en las de la biblioteca. Cuenta tanto
+ * operator new como las reservas de Qt (QArrayData usa malloc), que es
+ * lo que interesa para medir copias de QString.
+ */
+static std::atomic<qint64> allocationCount{0};
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+static qint64 allocations()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+#else
+static qint64 allocations()
+{
+    return -1;
+}
+#endif
+
+/**
+ * @brief Salida estándar compartida por todos los subcomandos.
+ */
+static QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+/**
+ * @brief Abre (creando desde cero) una base SQLite en modo WAL.
+ *
+ * @param path Ruta del archivo; si existe, se elimina antes.
+ * @param connection Nombre de la conexión Qt.
+ * @return Conexión abierta, o inválida si falló.
+ */
+static QSqlDatabase openBenchDatabase(const QString &path, const QString &connection)
+{
+    QFile::remove(path);
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+    db.setDatabaseName(path);
+    if (!db.open()) {
+        out() << "No se pudo abrir " << path << ": " << db.lastError().text() << Qt::endl;
+        return QSqlDatabase();
+    }
+
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    return db;
+}
+
+/**
+ * @brief Inserta filas sintéticas en bloques de una transacción cada uno.
+ *
+ * @param manager Gestor sobre la base de pruebas (con la tabla ya creada).
+ * @param rows Número de filas a generar.
+ */
+static void seedItems(InventoryManager &manager, int rows)
+{
+    static const QStringList tipos = {"Electrónico", "Sensor", "Microcontrolador",
+                                      "Herramienta", "Accesorio", "Instrumento"};
+    const int blockSize = 10000;
+
+    QList<InventoryItem> block;
+    block.reserve(blockSize);
+
+    for (int i = 0; i < rows; i++) {
+        InventoryItem it;
+        it.id = 0;
+        it.nombre = QString("Componente %1").arg(i);
+        it.tipo = tipos.at(i % tipos.size());
+        it.cantidad = QRandomGenerator::global()->bounded(0, 500);
+        it.ubicacion = QString("Cajón %1%2").arg(QChar('A' + (i % 6))).arg(i % 20);
+        it.fechaAdquisicion = QString("2024-%1-%2")
+                                  .arg(1 + i % 12, 2, 10, QChar('0'))
+                                  .arg(1 + i % 28, 2, 10, QChar('0'));
+        block.append(it);
+
+        if (block.size() == blockSize) {
+            manager.addItems(block);
+            block.clear();
+        }
+    }
+    if (!block.isEmpty()) {
+        manager.addItems(block);
+    }
+}
+
+/**
+ * @brief Imprime una línea de latencia media en microsegundos.
+ */
+static void printLatency(const char *path, qint64 calls, qint64 totalNs)
+{
+    const double avgUs = calls > 0 ? double(totalNs) / calls / 1000.0 : 0.0;
+    out() << QString("  %1 %2 llamadas, %3 us/llamada")
+                 .arg(QString(path).leftJustified(28), QString::number(calls).rightJustified(8))
+                 .arg(avgUs, 0, 'f', 2)
+          << Qt::endl;
+}
+
+/**
+ * @brief Mide getItemById y getItemsByIds con y sin índice en memoria.
+ *
+ * Argumentos: número de filas (100000), número de búsquedas (20000)
+ * y tamaño de ráfaga del escáner (32).
+ */
+static int benchLookup(const QStringList &args, const QString &dir)
+{
+    const int rows = args.value(0, "100000").toInt();
+    const int lookups = args.value(1, "20000").toInt();
+    const int burst = qMax(1, args.value(2, "32").toInt());
+
+    QSqlDatabase db = openBenchDatabase(dir + "/lookup.db", "bench_lookup");
+    if (!db.isOpen()) {
+        return 1;
+    }
+
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+
+    QList<int> ids;
+    ids.reserve(lookups);
+    for (int i = 0; i < lookups; i++) {
+        ids.append(QRandomGenerator::global()->bounded(1, rows + 1));
+    }
+
+    out() << "Búsqueda por ID: " << rows << " filas, " << lookups
+          << " búsquedas, ráfagas de " << burst << Qt::endl;
+
+    for (bool indexed : {false, true}) {
+        manager.setIdIndexEnabled(indexed);
+        manager.resetLookupStats();
+
+        for (int id : ids) {
+            manager.getItemById(id);
+        }
+        for (int start = 0; start < ids.size(); start += burst) {
+            manager.getItemsByIds(ids.mid(start, burst));
+        }
+
+        const LookupStats s = manager.lookupStats();
+        if (indexed) {
+            printLatency("getItemById (índice)", s.indexLookups, s.indexNs);
+            printLatency("getItemsByIds (índice)", s.batchLookups, s.batchNs);
+        } else {
+            printLatency("getItemById (SELECT)", s.sqlLookups, s.sqlNs);
+            printLatency("getItemsByIds (IN)", s.batchLookups, s.batchNs);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Generador de carga para la ingesta de escáneres por socket local.
+ *
+ * Lanza varios clientes en hilos propios que envían líneas `<id> <delta>`
+ * tan rápido como el socket lo permite, y mide el caudal sostenido hasta
+ * que el último evento queda confirmado en la base.
+ *
+ * Argumentos: eventos totales (200000), ítems distintos (1000),
+ * clientes concurrentes (4) y ventana de agrupación en ms (50).
+ */
+static int benchScanner(const QStringList &args, const QString &dir)
+{
+    const int events = args.value(0, "200000").toInt();
+    const int items = qMax(1, args.value(1, "1000").toInt());
+    const int clients = qMax(1, args.value(2, "4").toInt());
+    const int windowMs = args.value(3, "50").toInt();
+
+    QSqlDatabase db = openBenchDatabase(dir + "/scanner.db", "bench_scanner");
+    if (!db.isOpen()) {
+        return 1;
+    }
+
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, items);
+
+    ScannerIngest ingest(manager, 65536, windowMs);
+    const QString socketName = QString("inventario_bench_%1").arg(QCoreApplication::applicationPid());
+    if (!ingest.listen(socketName)) {
+        return 1;
+    }
+
+    out() << "Ingesta de escáner: " << events << " eventos, " << items << " ítems, "
+          << clients << " clientes, ventana " << windowMs << " ms" << Qt::endl;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::atomic<int> finished{0};
+    std::vector<std::thread> producers;
+    for (int c = 0; c < clients; c++) {
+        const int share = events / clients + (c < events % clients ? 1 : 0);
+        producers.emplace_back([&, share]() {
+            QLocalSocket socket;
+            socket.connectToServer(socketName);
+            if (socket.waitForConnected(5000)) {
+                QByteArray buffer;
+                for (int i = 0; i < share; i++) {
+                    const int id = QRandomGenerator::global()->bounded(1, items + 1);
+                    int delta = QRandomGenerator::global()->bounded(-3, 6);
+                    if (delta == 0) {
+                        delta = 1;
+                    }
+                    buffer += QByteArray::number(id) + ' ' + QByteArray::number(delta) + '\n';
+
+                    if (buffer.size() >= 16384 || i == share - 1) {
+                        socket.write(buffer);
+                        socket.waitForBytesWritten(-1);
+                        buffer.clear();
+                    }
+                }
+                socket.disconnectFromServer();
+                if (socket.state() != QLocalSocket::UnconnectedState) {
+                    socket.waitForDisconnected(5000);
+                }
+            }
+            finished.fetch_add(1);
+        });
+    }
+
+    // El hilo principal atiende el socket y los vaciados hasta aplicar todo
+    QEventLoop loop;
+    QTimer poll;
+    poll.setInterval(20);
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        const IngestStats s = ingest.stats();
+        if (finished.load() == clients && s.applied + s.malformed >= events) {
+            loop.quit();
+        }
+        if (timer.elapsed() > 120000) {
+            out() << "Tiempo de espera agotado." << Qt::endl;
+            loop.quit();
+        }
+    });
+    poll.start();
+    loop.exec();
+
+    const qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+    for (std::thread &t : producers) {
+        t.join();
+    }
+
+    const IngestStats s = ingest.stats();
+    out() << QString("  tiempo total          %1 ms\n").arg(elapsedMs)
+          << QString("  caudal sostenido      %1 eventos/s\n").arg(qint64(s.applied) * 1000 / elapsedMs)
+          << QString("  lotes confirmados     %1 (%2 fallidos, %3 eventos descartados)\n")
+                 .arg(s.batches).arg(s.failedBatches).arg(s.discarded)
+          << QString("  UPDATE por lote       %1\n").arg(s.batches ? double(s.itemUpdates) / s.batches : 0.0, 0, 'f', 1)
+          << QString("  ms por transacción    %1\n").arg(s.batches ? s.flushNs / 1e6 / s.batches : 0.0, 0, 'f', 2)
+          << QString("  pausas por cola llena %1\n").arg(s.stalls)
+          << QString("  ocupación máxima      %1 / %2\n").arg(s.maxQueueDepth).arg(s.queueCapacity)
+          << QString("  líneas mal formadas   %1").arg(s.malformed)
+          << Qt::endl;
+    return 0;
+}
+
+/**
+ * @brief Mide la búsqueda aproximada sobre nombres con números de parte.
+ *
+ * El índice se llena directamente en memoria (sin SQLite) con nombres del
+ * tipo "Transistor BC54721", y cada consulta es el número de parte de un
+ * ítem al azar con dos caracteres vecinos intercambiados. Informa la
+ * latencia media y el percentil 99, y qué fracción de las consultas trae
+ * el ítem original entre los 10 primeros resultados.
+ *
+ * Argumentos: número de ítems (1000000) y de consultas (2000).
+ */
+static int benchFuzzy(const QStringList &args)
+{
+    static const QStringList familias = {"Transistor", "Resistencia", "Capacitor", "Diodo",
+                                         "Módulo", "Sensor", "Potenciómetro", "Regulador",
+                                         "Conector", "Relé", "Cristal", "Inductor"};
+    const int items = qMax(1, args.value(0, "1000000").toInt());
+    const int queries = qMax(1, args.value(1, "2000").toInt());
+    QRandomGenerator *rng = QRandomGenerator::global();
+
+    QList<InventoryItem> rows;
+    QStringList parts;
+    rows.reserve(items);
+    parts.reserve(items);
+    for (int i = 0; i < items; i++) {
+        QString part;
+        for (int k = rng->bounded(1, 4); k > 0; k--) {
+            part += QChar('A' + rng->bounded(26));
+        }
+        part += QString::number(rng->bounded(100, 100000));
+
+        InventoryItem it;
+        it.id = i + 1;
+        it.nombre = familias.at(rng->bounded(familias.size())) + ' ' + part;
+        it.cantidad = 0;
+        rows.append(it);
+        parts.append(part);
+    }
+
+    FuzzyIndex index;
+    QElapsedTimer timer;
+    timer.start();
+    index.setItems(rows);
+    const qint64 buildMs = timer.elapsed();
+
+    out() << "Búsqueda aproximada: " << items << " ítems, " << queries << " consultas" << Qt::endl;
+
+    std::vector<qint64> latencies;
+    latencies.reserve(queries);
+    int found = 0;
+    for (int q = 0; q < queries; q++) {
+        const int target = rng->bounded(items);
+        QString typo = parts.at(target);
+        const int pos = rng->bounded(int(typo.size()) - 1);
+        std::swap(typo[pos], typo[pos + 1]);
+
+        const QList<FuzzyMatch> matches = index.search(typo, 10);
+        latencies.push_back(index.lastSearchNs());
+        for (const FuzzyMatch &m : matches) {
+            if (m.id == target + 1) {
+                found++;
+                break;
+            }
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    qint64 total = 0;
+    for (qint64 ns : latencies) {
+        total += ns;
+    }
+
+    out() << QString("  construcción del índice  %1 ms\n").arg(buildMs)
+          << QString("  latencia media           %1 ms\n").arg(total / 1e6 / queries, 0, 'f', 3)
+          << QString("  latencia p99             %1 ms\n").arg(latencies[size_t(queries * 0.99)] / 1e6, 0, 'f', 3)
+          << QString("  encontrado en top 10     %1 %").arg(100.0 * found / queries, 0, 'f', 1)
+          << Qt::endl;
+    return 0;
+}
+
+/**
+ * @brief Ejecuta un recorrido e imprime su tiempo y sus reservas de memoria.
+ *
+ * @param path Nombre del camino medido.
+ * @param rows Filas recorridas, para el promedio por fila.
+ * @param run Recorrido a medir.
+ */
+template <typename F>
+static void measureAllocations(const char *path, int rows, F &&run)
+{
+    QElapsedTimer timer;
+    const qint64 before = allocations();
+    timer.start();
+    run();
+    const qint64 ms = timer.elapsed();
+    const qint64 count = allocations() - before;
+
+    if (before < 0) {
+        out() << QString("  %1 %2 ms (conteo de reservas no disponible)")
+                     .arg(QString(path).leftJustified(30)).arg(ms, 6)
+              << Qt::endl;
+        return;
+    }
+    out() << QString("  %1 %2 ms %3 reservas (%4 por fila)")
+                 .arg(QString(path).leftJustified(30)).arg(ms, 6)
+                 .arg(count, 10)
+                 .arg(rows > 0 ? double(count) / rows : 0.0, 0, 'f', 2)
+          << Qt::endl;
+}
+
+/**
+ * @brief Compara la lectura materializada (lista de InventoryItem) con el
+ *        recorrido por vistas (forEachItem), contando reservas de memoria.
+ *
+ * Mide tres usos: recorrer todo convirtiendo a Component, exportar el CSV
+ * y listar el stock bajo. Las reservas solo se cuentan con glibc.
+ *
+ * Argumentos: número de filas (200000).
+ */
+static int benchStream(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "200000").toInt());
+
+    QSqlDatabase db = openBenchDatabase(dir + "/stream.db", "bench_stream");
+    if (!db.isOpen()) {
+        return 1;
+    }
+
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+
+    out() << "Recorrido de filas: " << rows << " filas" << Qt::endl;
+
+    qint64 checksum = 0;
+    measureAllocations("getAllItems + Component", rows, [&] {
+        for (const InventoryItem &it : manager.getAllItems()) {
+            const Component c(it.id, it.nombre, it.tipo, it.cantidad,
+                              it.ubicacion, it.fechaAdquisicion);
+            checksum += c.getName().size() + c.getQuantity();
+        }
+    });
+    measureAllocations("forEachItem", rows, [&] {
+        manager.forEachItem([&checksum](const InventoryRowView &row) {
+            checksum += row.nombre.size() + row.cantidad;
+            return true;
+        });
+    });
+
+    CSVReport report;
+    const QString csvPath = dir + "/stream.csv";
+    measureAllocations("CSV (lista)", rows, [&] {
+        report.generate(manager.getAllItems(), csvPath);
+    });
+    measureAllocations("CSV (forEachItem)", rows, [&] {
+        report.generate(manager, csvPath);
+    });
+
+    const int threshold = 100;
+    measureAllocations("getLowStockItems", rows, [&] {
+        for (const InventoryItem &it : manager.getLowStockItems(threshold)) {
+            checksum += it.cantidad;
+        }
+    });
+    measureAllocations("forEachLowStockItem", rows, [&] {
+        manager.forEachLowStockItem(threshold, [&checksum](const InventoryRowView &row) {
+            checksum += row.cantidad;
+            return true;
+        });
+    });
+
+    // Evita que el compilador descarte los recorridos
+    out() << "  (suma de control " << checksum << ")" << Qt::endl;
+    return 0;
+}
+
+/**
+ * @brief Informe de planes de consulta con tablas de distintos tamaños.
+ *
+ * Para cada tamaño crea una base nueva, activa el diagnóstico de
+ * consultas y ejecuta la carga típica de la aplicación: páginas de la
+ * tabla en cada columna y sentido, búsqueda por texto, búsquedas por ID,
+ * stock bajo, recorrido completo y escrituras masivas. Después imprime
+ * QueryDiagnostics::report(), para comprobar que los índices se siguen
+ * usando a medida que crecen los datos.
+ *
+ * Argumento: tamaños separados por comas (10000,100000).
+ */
+static int benchPlans(const QStringList &args, const QString &dir)
+{
+    const QStringList sizes = args.value(0, "10000,100000").split(',', Qt::SkipEmptyParts);
+
+    for (const QString &size : sizes) {
+        const int rows = qMax(1, size.toInt());
+        const QString connection = "bench_plans_" + QString::number(rows);
+        QSqlDatabase db = openBenchDatabase(dir + "/" + connection + ".db", connection);
+        if (!db.isOpen()) {
+            return 1;
+        }
+
+        InventoryManager manager(db);
+        manager.createTable();
+        seedItems(manager, rows);
+
+        QueryDiagnostics &diagnostics = manager.queryDiagnostics();
+        diagnostics.reset();
+        diagnostics.setEnabled(true);
+
+        // Tabla: primera página y dos más en cada columna y sentido
+        for (int column = 0; column < 6; column++) {
+            for (Qt::SortOrder order : {Qt::AscendingOrder, Qt::DescendingOrder}) {
+                QList<InventoryItem> page = manager.fetchPage(column, order, nullptr, 256);
+                for (int i = 0; i < 2 && !page.isEmpty(); i++) {
+                    const InventoryItem last = page.last();
+                    page = manager.fetchPage(column, order, &last, 256);
+                }
+            }
+        }
+
+        // Búsqueda por texto y por ID
+        for (const QString &text : {"componente 12", "sensor", "cajon b1", "2024-03"}) {
+            manager.searchItems(text);
+        }
+        QList<int> ids;
+        for (int i = 0; i < 64; i++) {
+            ids.append(QRandomGenerator::global()->bounded(1, rows + 1));
+        }
+        for (int id : ids) {
+            manager.getItemById(id);
+        }
+        manager.getItemsByIds(ids);
+
+        // Lecturas completas y escrituras masivas
+        manager.getLowStockItems(10);
+        manager.forEachItem([](const InventoryRowView &) { return true; });
+        manager.adjustQuantities(ids, 1);
+        manager.relocateItems(ids.mid(0, 8), "Cajón Z9");
+        manager.updateQuantity(ids.first(), 5);
+
+        diagnostics.setEnabled(false);
+        out() << "=== " << rows << " filas ===\n" << diagnostics.report() << Qt::endl;
+    }
+    return 0;
+}
+
+/**
+ * @brief Proceso hijo de @ref benchContention: escribe sobre una base compartida.
+ *
+ * Con lote 1 cada movimiento es una transacción (applyQuantityDeltas);
+ * con lote mayor se encolan con queueQuantityDeltas y se confirman
+ * juntos cada @p lote movimientos. Al terminar imprime sus contadores
+ * como clave=valor, una línea, para que los sume el proceso padre.
+ *
+ * Argumentos: ruta de la base, número de escrituras, lote e ítems.
+ */
+static int contentionWorker(const QStringList &args)
+{
+    const QString path = args.value(0);
+    const int writes = args.value(1, "2000").toInt();
+    const int batch = qMax(1, args.value(2, "1").toInt());
+    const int items = qMax(1, args.value(3, "1000").toInt());
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench_contention_worker");
+    db.setDatabaseName(path);
+    if (!db.open()) {
+        out() << "error=" << db.lastError().text() << Qt::endl;
+        return 1;
+    }
+
+    InventoryManager manager(db);
+    qint64 failed = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < writes; i++) {
+        QHash<int, int> delta;
+        delta.insert(QRandomGenerator::global()->bounded(1, items + 1),
+                     QRandomGenerator::global()->bounded(1, 4));
+
+        if (batch == 1) {
+            if (!manager.applyQuantityDeltas(delta)) {
+                failed++;
+            }
+        } else {
+            // Un vaciado con la base bloqueada deja los movimientos en cola
+            manager.queueQuantityDeltas(delta);
+            if ((i + 1) % batch == 0) {
+                manager.flushWrites();
+            }
+        }
+    }
+    // Lo que quede en cola se reintenta hasta confirmarse (o rendirse)
+    bool flushed = manager.flushWrites();
+    for (int attempt = 0; attempt < 20 && !flushed; attempt++) {
+        QThread::msleep(50);
+        flushed = manager.flushWrites();
+    }
+    if (!flushed) {
+        out() << "error=cola sin confirmar" << Qt::endl;
+        return 1;
+    }
+    const qint64 elapsedMs = timer.elapsed();
+
+    const WriteStats s = manager.writeStats();
+    out() << "writes=" << writes << " failed=" << failed << " elapsedMs=" << elapsedMs
+          << " transactions=" << s.transactions << " operations=" << s.operations
+          << " retries=" << s.retries << " failures=" << s.failures
+          << " lockWaitNs=" << s.lockWaitNs << " maxLockWaitNs=" << s.maxLockWaitNs
+          << " transactionNs=" << s.transactionNs << Qt::endl;
+    return 0;
+}
+
+/**
+ * @brief Mide escrituras concurrentes de varios procesos sobre la misma base.
+ *
+ * Simula varias estaciones: lanza @p procesos copias de esta herramienta
+ * (subcomando oculto contention-worker) que escriben a la vez sobre una
+ * base compartida, primero con una transacción por movimiento y luego
+ * agrupando @p lote movimientos por transacción. Informa el caudal total,
+ * los reintentos por base bloqueada, la espera media y máxima por el
+ * bloqueo y las escrituras que no llegaron a confirmarse.
+ *
+ * Argumentos: procesos (4), escrituras por proceso (2000) y lote (50).
+ */
+static int benchContention(const QStringList &args, const QString &dir)
+{
+    const int processes = qMax(1, args.value(0, "4").toInt());
+    const int writes = qMax(1, args.value(1, "2000").toInt());
+    const int batch = qMax(2, args.value(2, "50").toInt());
+    const int items = 1000;
+
+    out() << "Contención de escritura: " << processes << " procesos, " << writes
+          << " escrituras cada uno" << Qt::endl;
+
+    for (int round : {1, batch}) {
+        const QString path = dir + QString("/contention_%1.db").arg(round);
+        {
+            QSqlDatabase db = openBenchDatabase(path, "bench_contention");
+            if (!db.isOpen()) {
+                return 1;
+            }
+            InventoryManager manager(db);
+            manager.createTable();
+            seedItems(manager, items);
+        }
+        QSqlDatabase::removeDatabase("bench_contention");
+
+        QElapsedTimer timer;
+        timer.start();
+
+        std::vector<std::unique_ptr<QProcess>> workers;
+        for (int p = 0; p < processes; p++) {
+            auto worker = std::make_unique<QProcess>();
+            worker->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+            worker->start(QCoreApplication::applicationFilePath(),
+                          {"contention-worker", path, QString::number(writes),
+                           QString::number(round), QString::number(items)});
+            workers.push_back(std::move(worker));
+        }
+
+        QHash<QString, qint64> total;
+        qint64 maxLockWaitNs = 0;
+        for (const auto &worker : workers) {
+            if (!worker->waitForFinished(300000) || worker->exitCode() != 0) {
+                out() << "  un proceso falló: " << worker->readAllStandardOutput() << Qt::endl;
+                continue;
+            }
+            const QStringList fields = QString::fromUtf8(worker->readAllStandardOutput())
+                                           .simplified().split(' ', Qt::SkipEmptyParts);
+            for (const QString &field : fields) {
+                const QString key = field.section('=', 0, 0);
+                const qint64 value = field.section('=', 1).toLongLong();
+                if (key == "maxLockWaitNs") {
+                    maxLockWaitNs = qMax(maxLockWaitNs, value);
+                } else {
+                    total[key] += value;
+                }
+            }
+        }
+        const qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+        const qint64 transactions = total.value("transactions");
+
+        out() << QString("  lote %1\n").arg(round)
+              << QString("    tiempo total          %1 ms\n").arg(elapsedMs)
+              << QString("    caudal                %1 escrituras/s\n").arg(total.value("writes") * 1000 / elapsedMs)
+              << QString("    transacciones         %1\n").arg(transactions)
+              << QString("    reintentos            %1\n").arg(total.value("retries"))
+              << QString("    espera por bloqueo    media %1 ms, máx %2 ms\n")
+                     .arg(transactions ? total.value("lockWaitNs") / 1e6 / transactions : 0.0, 0, 'f', 2)
+                     .arg(maxLockWaitNs / 1e6, 0, 'f', 2)
+              << QString("    ms por transacción    %1\n")
+                     .arg(transactions ? total.value("transactionNs") / 1e6 / transactions : 0.0, 0, 'f', 2)
+              << QString("    intentos abandonados  %1\n").arg(total.value("failures"))
+              << QString("    escrituras perdidas   %1").arg(total.value("failed"))
+              << Qt::endl;
+    }
+    return 0;
+}
+
+/**
+ * @brief Ejecuta las tres tareas de mantenimiento hasta terminarlas e imprime cada porción.
+ */
+static void runMaintenanceRound(DatabaseMaintenance &maintenance, const QString &title)
+{
+    const int before = int(maintenance.history().size());
+    maintenance.runNow(DatabaseMaintenance::Optimize);
+    maintenance.runNow(DatabaseMaintenance::IncrementalVacuum);
+    maintenance.runNow(DatabaseMaintenance::Checkpoint);
+
+    // Termina cuando pasa un segundo sin porciones nuevas
+    QEventLoop loop;
+    QTimer quiet;
+    quiet.setSingleShot(true);
+    quiet.setInterval(1000);
+    QObject::connect(&quiet, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&maintenance, &DatabaseMaintenance::taskFinished, &quiet,
+                     [&quiet]() { quiet.start(); });
+    quiet.start();
+    loop.exec();
+
+    out() << "  " << title << Qt::endl;
+    const QList<MaintenanceRun> runs = maintenance.history().mid(before);
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+    qint64 reclaimed = 0;
+    for (const MaintenanceRun &run : runs) {
+        totalNs += run.durationNs;
+        maxNs = qMax(maxNs, run.durationNs);
+        reclaimed += run.reclaimedBytes;
+        out() << QString("    %1 %2 ms %3 KB  %4%5")
+                     .arg(DatabaseMaintenance::taskName(run.task).leftJustified(20))
+                     .arg(run.durationNs / 1e6, 8, 'f', 2)
+                     .arg(run.reclaimedBytes / 1024, 8)
+                     .arg(run.ok ? "" : "[fallida] ", run.detail)
+              << Qt::endl;
+    }
+    out() << QString("    %1 porciones, %2 ms en total, porción más larga %3 ms, %4 KB recuperados")
+                 .arg(runs.size())
+                 .arg(totalNs / 1e6, 0, 'f', 2)
+                 .arg(maxNs / 1e6, 0, 'f', 2)
+                 .arg(reclaimed / 1024)
+          << Qt::endl;
+}
+
+/**
+ * @brief Mide el mantenimiento en tiempo ocioso tras mucho alta y baja de ítems.
+ *
+ * Llena la base, borra dos de cada tres filas y ejecuta las tareas de
+ * DatabaseMaintenance. La primera ronda pide además la conversión a
+ * auto_vacuum (EnableAutoVacuum, un VACUUM completo) de la base creada
+ * sin él; después se repite la carga y el borrado y la segunda ronda ya
+ * devuelve el espacio por porciones acotadas. Informa la duración y lo recuperado en cada porción.
+ *
+ * Argumentos: número de filas (100000) y presupuesto por porción en ms (50).
+ */
+static int benchMaintenance(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "100000").toInt());
+    const int budgetMs = qMax(1, args.value(1, "50").toInt());
+    const QString path = dir + "/maintenance.db";
+
+    QSqlDatabase db = openBenchDatabase(path, "bench_maintenance");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+
+    auto churn = [&]() {
+        seedItems(manager, rows);
+        QList<int> doomed;
+        QSqlQuery query(db);
+        query.exec("SELECT id FROM inventario WHERE id % 3 != 0");
+        while (query.next()) {
+            doomed.append(query.value(0).toInt());
+        }
+        manager.removeItems(doomed);
+        return doomed.size();
+    };
+
+    DatabaseMaintenance maintenance(path);
+    maintenance.setSliceBudget(budgetMs);
+    maintenance.setIdleDelay(0);
+    maintenance.start();
+
+    out() << "Mantenimiento: " << rows << " filas por carga, porciones de " << budgetMs << " ms" << Qt::endl;
+
+    const int firstDeleted = churn();
+    maintenance.runNow(DatabaseMaintenance::EnableAutoVacuum);
+    runMaintenanceRound(maintenance, QString("ronda 1 (%1 filas borradas)").arg(firstDeleted));
+
+    const int secondDeleted = churn();
+    runMaintenanceRound(maintenance, QString("ronda 2 (%1 filas borradas)").arg(secondDeleted));
+
+    maintenance.stop();
+    return 0;
+}
+
+/**
+ * @brief Mide un respaldo en línea mientras la misma conexión sigue escribiendo.
+ *
+ * Un temporizador aplica un movimiento de stock cada 2 ms sobre la
+ * conexión respaldada, como harían la interfaz o la ingesta. Se compara
+ * la copia por pasos con la copia en un solo paso: cuántas escrituras
+ * entraron durante el respaldo y cuánto tuvo que esperar la más lenta,
+ * además del caudal, los pasos y la verificación de integridad.
+ *
+ * Argumentos: número de filas (200000) y páginas por paso (256).
+ */
+static int benchBackup(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "200000").toInt());
+    const int pagesPerStep = qMax(1, args.value(1, "256").toInt());
+
+    QSqlDatabase db = openBenchDatabase(dir + "/backup.db", "bench_backup");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+
+    out() << "Respaldo en línea: " << rows << " filas" << Qt::endl;
+
+    for (int pages : {pagesPerStep, -1}) {
+        OnlineBackup backup(db);
+
+        qint64 writes = 0;
+        qint64 maxGapNs = 0;
+        QElapsedTimer gap;
+        QTimer writer;
+        writer.setInterval(2);
+        QObject::connect(&writer, &QTimer::timeout, [&]() {
+            // El intervalo entre escrituras muestra cuánto se retuvo el hilo
+            maxGapNs = qMax(maxGapNs, gap.nsecsElapsed());
+            gap.restart();
+            QHash<int, int> delta;
+            delta.insert(QRandomGenerator::global()->bounded(1, rows + 1), 1);
+            manager.applyQuantityDeltas(delta);
+            writes++;
+        });
+
+        QEventLoop loop;
+        BackupStats result;
+        QObject::connect(&backup, &OnlineBackup::finished, &loop, [&](bool, const BackupStats &s) {
+            result = s;
+            loop.quit();
+        });
+
+        gap.start();
+        writer.start();
+        if (!backup.start(dir + "/respaldo.db", pages, 2)) {
+            return 1;
+        }
+        loop.exec();
+        writer.stop();
+
+        out() << QString("  %1\n").arg(pages > 0 ? QString("%1 páginas por paso").arg(pages) : QString("un solo paso"))
+              << QString("    resultado             %1 (integridad: %2)\n")
+                     .arg(result.ok ? "ok" : "fallido", result.integrity)
+              << QString("    tiempo total          %1 ms\n").arg(result.elapsedNs / 1e6, 0, 'f', 1)
+              << QString("    caudal                %1 MB/s\n").arg(result.bytesPerSecond() / (1024.0 * 1024.0), 0, 'f', 1)
+              << QString("    pasos                 %1 (%2 ocupados, %3 reinicios%4)\n")
+                     .arg(result.steps).arg(result.busySteps).arg(result.restarts)
+                     .arg(result.pinned ? ", desde instantánea fija" : "")
+              << QString("    paso más largo        %1 ms\n").arg(result.maxStepNs / 1e6, 0, 'f', 2)
+              << QString("    escrituras durante    %1\n").arg(writes)
+              << QString("    mayor espera escritor %1 ms").arg(maxGapNs / 1e6, 0, 'f', 2)
+              << Qt::endl;
+    }
+    return 0;
+}
+
+/**
+ * @brief Ejecuta @p count escrituras o lecturas individuales y devuelve operaciones por segundo.
+ */
+template <typename F>
+static double opsPerSecond(int count, F &&op)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; i++) {
+        op(i);
+    }
+    return count * 1e9 / qMax<qint64>(1, timer.nsecsElapsed());
+}
+
+/**
+ * @brief Compara el CRUD de a una fila entre la base en archivo y la base en memoria.
+ *
+ * Cada alta, cambio de cantidad, edición y baja es su propia transacción,
+ * como en la interfaz. El modo archivo usa WAL con synchronous=FULL (lo
+ * que usa la aplicación); el modo memoria carga la misma base con
+ * DatabaseManager::restoreFrom y al final se vuelca con
+ * DatabaseManager::saveTo, que es lo que cuesta cada volcado periódico.
+ *
+ * Argumentos: filas iniciales (50000) y operaciones por tipo (5000).
+ */
+static int benchMemory(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "50000").toInt());
+    const int ops = qMax(1, args.value(1, "5000").toInt());
+    const QString seedPath = dir + "/crud.db";
+
+    QSqlDatabase fileDb = openBenchDatabase(seedPath, "bench_crud_archivo");
+    if (!fileDb.isOpen()) {
+        return 1;
+    }
+    QSqlQuery(fileDb).exec("PRAGMA synchronous=FULL");
+    {
+        InventoryManager seeder(fileDb);
+        seeder.createTable();
+        seedItems(seeder, rows);
+    }
+
+    QSqlDatabase memoryDb = QSqlDatabase::addDatabase("QSQLITE", "bench_crud_memoria");
+    memoryDb.setDatabaseName(":memory:");
+    if (!memoryDb.open()) {
+        return 1;
+    }
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+    if (!DatabaseManager::restoreFrom(memoryDb, seedPath)) {
+        return 1;
+    }
+    const qint64 loadNs = loadTimer.nsecsElapsed();
+
+    out() << "CRUD de a una fila: " << rows << " filas iniciales, " << ops << " operaciones por tipo" << Qt::endl;
+    out() << QString("  %1 %2 %3").arg(QString("operación").leftJustified(20),
+                                      QString("archivo op/s").rightJustified(14),
+                                      QString("memoria op/s").rightJustified(14))
+          << Qt::endl;
+
+    auto run = [&](QSqlDatabase db) {
+        InventoryManager manager(db);
+        QList<double> rates;
+        rates << opsPerSecond(ops, [&](int i) {
+            manager.addItem(QString("Nuevo %1").arg(i), "Sensor", i % 50, "Cajón Z1", "2025-01-01");
+        });
+        rates << opsPerSecond(ops, [&](int) {
+            manager.updateQuantity(QRandomGenerator::global()->bounded(1, rows + 1),
+                                   QRandomGenerator::global()->bounded(0, 500));
+        });
+        rates << opsPerSecond(ops, [&](int) {
+            manager.getItemById(QRandomGenerator::global()->bounded(1, rows + 1));
+        });
+        rates << opsPerSecond(ops, [&](int i) {
+            manager.updateItem(1 + i % rows, QString("Editado %1").arg(i), "Herramienta", i % 100,
+                               "Cajón Y2", "2025-02-02");
+        });
+        rates << opsPerSecond(ops, [&](int i) {
+            manager.removeItem(rows + 1 + i);
+        });
+        return rates;
+    };
+
+    const QList<double> memoryRates = run(memoryDb);
+    const QList<double> fileRates = run(fileDb);
+
+    const QStringList names = {"alta", "cambio de cantidad", "lectura por ID", "edición", "baja"};
+    for (int i = 0; i < names.size(); i++) {
+        out() << QString("  %1 %2 %3 (x%4)")
+                     .arg(names.at(i).leftJustified(20))
+                     .arg(fileRates.at(i), 14, 'f', 0)
+                     .arg(memoryRates.at(i), 14, 'f', 0)
+                     .arg(memoryRates.at(i) / qMax(1.0, fileRates.at(i)), 0, 'f', 1)
+              << Qt::endl;
+    }
+
+    QElapsedTimer flushTimer;
+    flushTimer.start();
+    const bool saved = DatabaseManager::saveTo(memoryDb, dir + "/memoria.db");
+    out() << QString("  carga a memoria       %1 ms\n").arg(loadNs / 1e6, 0, 'f', 1)
+          << QString("  volcado a disco       %1 ms%2")
+                 .arg(flushTimer.nsecsElapsed() / 1e6, 0, 'f', 1)
+                 .arg(saved ? "" : " (falló)")
+          << Qt::endl;
+    return 0;
+}
+
+/**
+ * @brief Cliente generador de carga para InventoryServer.
+ *
+ * Mantiene hasta @p profundidad solicitudes encadenadas en vuelo sobre
+ * una sola conexión. Mezcla: 50 % GET, 25 % QTY, 10 % ADD, 5 % UPDATE,
+ * 5 % FIND y 5 % DEL (de ítems que este mismo cliente agregó). Mide la
+ * latencia de cada solicitud desde que se envía hasta su OK o ERR, e
+ * imprime el resultado como clave=valor en una línea.
+ *
+ * Argumentos: host, puerto, solicitudes (20000), profundidad (16) e
+ * ítems existentes (1000).
+ */
+static int benchLoadgen(const QStringList &args)
+{
+    const QString host = args.value(0, "127.0.0.1");
+    const quint16 port = quint16(args.value(1, QString::number(InventoryProtocol::kDefaultPort)).toUInt());
+    const int total = qMax(1, args.value(2, "20000").toInt());
+    const int depth = qMax(1, args.value(3, "16").toInt());
+    const int items = qMax(1, args.value(4, "1000").toInt());
+
+    QTcpSocket socket;
+    socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    socket.connectToHost(host, port);
+    if (!socket.waitForConnected(5000)) {
+        out() << "error=" << socket.errorString() << Qt::endl;
+        return 1;
+    }
+
+    auto *rng = QRandomGenerator::global();
+    QHash<QByteArray, qint64> sentAt;
+    QHash<QByteArray, QByteArray> verbOf;
+    QList<int> added;
+    std::vector<qint64> latencies;
+    latencies.reserve(total);
+    qint64 errors = 0;
+    int sent = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    auto request = [&](int n) {
+        const QByteArray id = QByteArray::number(n);
+        const int pick = rng->bounded(100);
+        const QByteArray item = QByteArray::number(rng->bounded(1, items + 1));
+        QByteArray verb;
+        QByteArrayList fields;
+        if (pick < 50) {
+            verb = "GET";
+            fields << item;
+        } else if (pick < 75) {
+            verb = "QTY";
+            fields << item << QByteArray::number(rng->bounded(0, 500));
+        } else if (pick < 85) {
+            verb = "ADD";
+            fields << "Carga " + id << "Sensor" << "10" << "Cajón C3" << "2025-03-03";
+        } else if (pick < 90) {
+            verb = "UPDATE";
+            fields << item << "Editado " + id << "Herramienta" << "7" << "Cajón D4" << "2025-04-04";
+        } else if (pick < 95) {
+            verb = "FIND";
+            fields << "componente " + QByteArray::number(rng->bounded(100));
+        } else if (!added.isEmpty()) {
+            verb = "DEL";
+            fields << QByteArray::number(added.takeLast());
+        } else {
+            verb = "PING";
+        }
+        sentAt.insert(id, clock.nsecsElapsed());
+        verbOf.insert(id, verb);
+        socket.write(InventoryProtocol::line(id, verb, fields));
+    };
+
+    while (latencies.size() + size_t(errors) < size_t(total)) {
+        while (sent < total && sentAt.size() < depth) {
+            request(sent++);
+        }
+        socket.flush();
+        if (!socket.canReadLine() && !socket.waitForReadyRead(10000)) {
+            out() << "error=sin respuesta del servidor" << Qt::endl;
+            return 1;
+        }
+        while (socket.canReadLine()) {
+            const QByteArrayList parts = InventoryProtocol::fields(socket.readLine());
+            const QByteArray id = parts.value(0);
+            const QByteArray status = parts.value(1);
+            if (status == "ROW" || !sentAt.contains(id)) {
+                continue;
+            }
+            const qint64 ns = clock.nsecsElapsed() - sentAt.take(id);
+            const QByteArray verb = verbOf.take(id);
+            if (status == "OK") {
+                latencies.push_back(ns);
+                if (verb == "ADD") {
+                    added.append(parts.value(2).toInt());
+                }
+            } else {
+                errors++;
+            }
+        }
+    }
+    const qint64 elapsedMs = qMax<qint64>(1, clock.elapsed());
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))];
+    };
+    out() << "requests=" << total << " errors=" << errors << " elapsedMs=" << elapsedMs
+          << " p50Ns=" << percentile(0.50) << " p99Ns=" << percentile(0.99)
+          << " maxNs=" << (latencies.empty() ? 0 : latencies.back()) << Qt::endl;
+    return 0;
+}
+
+/**
+ * @brief Mide InventoryServer en localhost con varios procesos cliente.
+ *
+ * El servidor corre en este proceso sobre una base temporal; cada
+ * cliente es una copia de esta herramienta con el subcomando loadgen.
+ * Informa el caudal total, la latencia vista por los clientes (p50 y el
+ * peor p99) y el informe del servidor: lotes de escritura y latencias
+ * por operación.
+ *
+ * Argumentos: clientes (8), solicitudes por cliente (20000) y
+ * profundidad de encadenamiento (16).
+ */
+static int benchServer(const QStringList &args, const QString &dir)
+{
+    const int clients = qMax(1, args.value(0, "8").toInt());
+    const int requests = qMax(1, args.value(1, "20000").toInt());
+    const int depth = qMax(1, args.value(2, "16").toInt());
+    const int items = 1000;
+
+    QSqlDatabase db = openBenchDatabase(dir + "/server.db", "bench_server");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, items);
+
+    InventoryServer server(manager);
+    if (!server.listen(QHostAddress::LocalHost, 0)) {
+        return 1;
+    }
+
+    out() << "Servidor en localhost:" << server.port() << ", " << clients << " clientes, "
+          << requests << " solicitudes cada uno, profundidad " << depth << Qt::endl;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // El servidor necesita el bucle de eventos mientras los clientes trabajan
+    QEventLoop loop;
+    int running = clients;
+    std::vector<std::unique_ptr<QProcess>> workers;
+    for (int c = 0; c < clients; c++) {
+        auto worker = std::make_unique<QProcess>();
+        worker->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        QObject::connect(worker.get(), &QProcess::finished, &loop, [&]() {
+            if (--running == 0) {
+                loop.quit();
+            }
+        });
+        worker->start(QCoreApplication::applicationFilePath(),
+                      {"loadgen", "127.0.0.1", QString::number(server.port()), QString::number(requests),
+                       QString::number(depth), QString::number(items)});
+        workers.push_back(std::move(worker));
+    }
+    loop.exec();
+    const qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+
+    qint64 done = 0;
+    qint64 errors = 0;
+    qint64 p50Sum = 0;
+    qint64 worstP99 = 0;
+    int reported = 0;
+    for (const auto &worker : workers) {
+        const QStringList fields = QString::fromUtf8(worker->readAllStandardOutput())
+                                       .simplified().split(' ', Qt::SkipEmptyParts);
+        QHash<QString, qint64> values;
+        for (const QString &field : fields) {
+            values.insert(field.section('=', 0, 0), field.section('=', 1).toLongLong());
+        }
+        if (!values.contains("requests")) {
+            out() << "  un cliente falló: " << fields.join(' ') << Qt::endl;
+            continue;
+        }
+        reported++;
+        done += values.value("requests") - values.value("errors");
+        errors += values.value("errors");
+        p50Sum += values.value("p50Ns");
+        worstP99 = qMax(worstP99, values.value("p99Ns"));
+    }
+
+    out() << QString("  tiempo total          %1 ms\n").arg(elapsedMs)
+          << QString("  caudal                %1 solicitudes/s\n").arg(done * 1000 / elapsedMs)
+          << QString("  errores               %1\n").arg(errors)
+          << QString("  latencia cliente      p50 medio %1 us, peor p99 %2 us\n")
+                 .arg(reported ? p50Sum / reported / 1e3 : 0.0, 0, 'f', 1)
+                 .arg(worstP99 / 1e3, 0, 'f', 1)
+          << server.report()
+          << Qt::flush;
+    return 0;
+}
+
+/**
+ * @brief Mide las consultas repartidas entre varias bases de sede.
+ *
+ * Crea una base por sede con las mismas filas sintéticas y las adjunta a
+ * InventoryShards. Para búsqueda, stock bajo y agregados informa el
+ * tiempo visto por quien consulta (en paralelo), el de la sede más lenta
+ * y la suma de todas (lo que costaría consultarlas una tras otra).
+ *
+ * Argumentos: sedes (4) y filas por sede (100000).
+ */
+static int benchShards(const QStringList &args, const QString &dir)
+{
+    const int sites = qMax(1, args.value(0, "4").toInt());
+    const int rows = qMax(1, args.value(1, "100000").toInt());
+    const int rounds = 20;
+
+    InventoryShards shards;
+    for (int s = 0; s < sites; s++) {
+        const QString path = QString("%1/sede%2.db").arg(dir).arg(s);
+        {
+            QSqlDatabase db = openBenchDatabase(path, QString("bench_sede%1").arg(s));
+            if (!db.isOpen()) {
+                return 1;
+            }
+            InventoryManager manager(db);
+            manager.createTable();
+            seedItems(manager, rows);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(QString("bench_sede%1").arg(s));
+        if (!shards.attach(QString("sede%1").arg(s), path)) {
+            return 1;
+        }
+    }
+
+    out() << sites << " sedes de " << rows << " filas, " << rounds << " rondas por consulta, "
+          << QThread::idealThreadCount() << " núcleos" << Qt::endl;
+
+    auto measure = [&](const char *name, const std::function<qint64()> &query) {
+        qint64 wall = 0;
+        qint64 slowest = 0;
+        qint64 sum = 0;
+        qint64 results = 0;
+        for (int r = 0; r < rounds; r++) {
+            results = query();
+            const FanOutStats fan = shards.lastFanOut();
+            wall += fan.wallNs;
+            slowest += fan.slowestNs;
+            sum += fan.sumNs;
+        }
+        out() << QString("  %1 %2 resultados  total %3 ms  sede más lenta %4 ms  suma %5 ms  (x%6)\n")
+                     .arg(QString::fromLatin1(name), -10)
+                     .arg(results, 7)
+                     .arg(wall / rounds / 1e6, 7, 'f', 2)
+                     .arg(slowest / rounds / 1e6, 7, 'f', 2)
+                     .arg(sum / rounds / 1e6, 7, 'f', 2)
+                     .arg(double(sum) / qMax<qint64>(1, wall), 0, 'f', 1);
+    };
+
+    measure("search", [&]() { return qint64(shards.search("componente 1").size()); });
+    measure("lowStock", [&]() { return qint64(shards.lowStock(5).size()); });
+    measure("totals", [&]() {
+        qint64 units = 0;
+        for (const SiteTotals &t : shards.totals(5)) {
+            units += t.units;
+        }
+        return units;
+    });
+    out() << Qt::flush;
+    return 0;
+}
+
+/**
+ * @brief Mide la comparación y fusión de dos bases casi iguales.
+ *
+ * Crea una base, la copia a una segunda separada como otra sede
+ * (InventorySync::splitCopy) y hace divergir a las dos: en la "remota"
+ * cambian cantidades y se agregan filas; en la local se reubican filas y
+ * se agregan otras (con los mismos IDs locales, como pasaría en dos sedes
+ * sin conexión). Compara con varios anchos de hoja, informando resúmenes
+ * intercambiados y filas leídas frente a transferir la tabla entera;
+ * después fusiona y verifica que una nueva comparación ya no encuentre
+ * nada que traer. Los cambios de un solo lado no deben contar como
+ * conflictos: solo las filas tocadas en las dos bases.
+ *
+ * Argumentos: filas (1000000) y diferencias (100).
+ */
+static int benchSync(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "1000000").toInt());
+    const int differences = qMax(4, args.value(1, "100").toInt());
+
+    QSqlDatabase localDb = openBenchDatabase(dir + "/sync_local.db", "bench_sync_local");
+    if (!localDb.isOpen()) {
+        return 1;
+    }
+    InventoryManager local(localDb);
+    local.createTable();
+    seedItems(local, rows);
+
+    QFile::remove(dir + "/sync_remota.db");
+    if (!DatabaseManager::saveTo(localDb, dir + "/sync_remota.db")) {
+        return 1;
+    }
+    QSqlDatabase remoteDb = QSqlDatabase::addDatabase("QSQLITE", "bench_sync_remote");
+    remoteDb.setDatabaseName(dir + "/sync_remota.db");
+    if (!remoteDb.open()) {
+        return 1;
+    }
+    InventoryManager remote(remoteDb);
+    remote.createTable();
+    if (!InventorySync::splitCopy(local, remote)) {
+        return 1;
+    }
+
+    // Divergencias: la mitad cambios remotos de cantidad, un cuarto
+    // reubicaciones locales y un cuarto filas nuevas en cada lado
+    auto *rng = QRandomGenerator::global();
+    QHash<int, int> deltas;
+    while (deltas.size() < differences / 2) {
+        deltas.insert(rng->bounded(1, rows + 1), rng->bounded(1, 50));
+    }
+    remote.applyQuantityDeltas(deltas);
+
+    QList<int> moved;
+    for (int i = 0; i < differences / 4; i++) {
+        moved.append(rng->bounded(1, rows + 1));
+    }
+    local.relocateItems(moved, "Cajón Z9");
+
+    QList<InventoryItem> added;
+    for (int i = 0; i < differences / 4; i++) {
+        added.append({0, QString("Nuevo %1").arg(i), "Sensor", 3, "Cajón N1", "2025-06-01"});
+    }
+    remote.addItems(added);
+    for (InventoryItem &it : added) {
+        it.nombre += " (local)";
+    }
+    local.addItems(added);
+
+    out() << rows << " filas, " << differences << " diferencias" << Qt::endl;
+
+    for (int leafWidth : {64, 256, 1024}) {
+        InventorySync sync(local, remote);
+        sync.setTreeShape(leafWidth, 16);
+        if (!sync.diff()) {
+            return 1;
+        }
+        const SyncStats st = sync.stats();
+        const double fullBytes = st.rowsFetched > 0 ? double(st.rowBytes) / st.rowsFetched * st.remoteRows : 0;
+        out() << QString("  hoja %1: %2 hojas, %3 niveles, árboles %4 ms, descenso %5 ms\n")
+                     .arg(leafWidth, 4)
+                     .arg(st.leaves)
+                     .arg(st.levels)
+                     .arg(st.buildNs / 1e6, 0, 'f', 1)
+                     .arg(st.diffNs / 1e6, 0, 'f', 1)
+              << QString("           %1 resúmenes, %2 hojas distintas, %3 filas leídas, "
+                         "%4 KB frente a %5 KB de la tabla entera\n")
+                     .arg(st.digestsCompared)
+                     .arg(st.differingLeaves)
+                     .arg(st.rowsFetched)
+                     .arg(st.transferBytes() / 1024.0, 0, 'f', 1)
+                     .arg(fullBytes / 1024.0, 0, 'f', 1)
+              << QString("           solo remotas %1, solo locales %2, cambiadas allá %3, "
+                         "cambiadas aquí %4, en ambas %5\n")
+                     .arg(st.onlyRemote)
+                     .arg(st.onlyLocal)
+                     .arg(st.changedRemote)
+                     .arg(st.changedLocal)
+                     .arg(st.changed);
+    }
+
+    InventorySync sync(local, remote);
+    if (!sync.diff() || !sync.merge(InventorySync::TakeRemote)) {
+        out() << "La fusión falló." << Qt::endl;
+        return 1;
+    }
+    const SyncStats merged = sync.stats();
+
+    InventorySync check(local, remote);
+    check.diff();
+    const SyncStats after = check.stats();
+    out() << QString("  fusión: %1 nuevas, %2 reemplazadas en %3 ms; "
+                     "después quedan %4 por traer, %5 cambiadas allá y %6 en ambas\n")
+                 .arg(merged.inserted)
+                 .arg(merged.updated)
+                 .arg(merged.mergeNs / 1e6, 0, 'f', 1)
+                 .arg(after.onlyRemote)
+                 .arg(after.changedRemote)
+                 .arg(after.changed)
+          << Qt::flush;
+    return after.onlyRemote == 0 && after.changedRemote == 0 && after.changed == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Mide el espacio del historial de existencias y sus reconstrucciones.
+ *
+ * Registra los cambios de cantidad en lotes de 1000 (como la ingesta de
+ * escáneres) y después reparte las marcas de tiempo de deltas y fotos a
+ * lo largo de un año, porque los triggers usan la hora real. Informa los
+ * bytes por cambio (dbstat y crecimiento del archivo) y, para varios
+ * instantes, el tiempo de inventoryAt y los deltas aplicados frente a
+ * los que habría que repasar desde el principio. Al final comprueba que
+ * la reconstrucción del presente coincide con la tabla.
+ *
+ * Argumentos: filas (100000) y cambios (200000).
+ */
+static int benchHistory(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "100000").toInt());
+    const int changes = qMax(1, args.value(1, "200000").toInt());
+    const int batch = 1000;
+
+    QSqlDatabase db = openBenchDatabase(dir + "/history.db", "bench_history");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+
+    auto fileBytes = [&db]() {
+        QSqlQuery q(db);
+        q.exec("SELECT page_count * page_size FROM pragma_page_count(), pragma_page_size()");
+        return q.next() ? q.value(0).toLongLong() : 0;
+    };
+
+    const HistoryStats before = manager.historyStats();
+    const qint64 bytesBefore = fileBytes();
+
+    auto *rng = QRandomGenerator::global();
+    QElapsedTimer timer;
+    timer.start();
+    for (int done = 0; done < changes; done += batch) {
+        QHash<int, int> deltas;
+        for (int i = 0; i < batch && done + i < changes; i++) {
+            deltas[rng->bounded(1, rows + 1)] += rng->bounded(-5, 6) | 1;
+        }
+        manager.applyQuantityDeltas(deltas);
+    }
+    const qint64 writeNs = timer.nsecsElapsed();
+
+    const HistoryStats after = manager.historyStats();
+    const qint64 recorded = after.changes - before.changes;
+    out() << rows << " filas, " << recorded << " cambios registrados en " << writeNs / 1000000 << " ms" << Qt::endl;
+    if (after.deltaBytes >= 0) {
+        out() << QString("  deltas: %1 bytes por cambio (dbstat); fotos: %2 con %3 filas, %4 KB\n")
+                     .arg(double(after.deltaBytes - qMax<qint64>(0, before.deltaBytes)) / qMax<qint64>(1, recorded), 0, 'f', 1)
+                     .arg(after.keyframes)
+                     .arg(after.keyframeRows)
+                     .arg(after.keyframeBytes / 1024);
+    }
+    out() << QString("  archivo: %1 bytes por cambio, incluidas las fotos\n")
+                 .arg(double(fileBytes() - bytesBefore) / qMax<qint64>(1, recorded), 0, 'f', 1);
+
+    // Historial sintético de un año: la marca de tiempo crece con seq
+    const qint64 start = QDateTime::currentSecsSinceEpoch() - 365LL * 86400;
+    const qint64 span = 365LL * 86400;
+    const qint64 total = qMax<qint64>(1, after.changes);
+    QSqlQuery spread(db);
+    spread.prepare("UPDATE inventario_historial SET ts = ? + seq * ? / ?");
+    spread.addBindValue(start);
+    spread.addBindValue(span);
+    spread.addBindValue(total);
+    spread.exec();
+    spread.prepare("UPDATE inventario_fotos_indice SET ts = ? + seq * ? / ?");
+    spread.addBindValue(start);
+    spread.addBindValue(span);
+    spread.addBindValue(total);
+    spread.exec();
+
+    for (double fraction : {0.1, 0.5, 0.9, 1.0}) {
+        const qint64 ts = start + qint64(span * fraction);
+        timer.restart();
+        const QList<InventoryItem> items = manager.inventoryAt(QDateTime::fromSecsSinceEpoch(ts));
+        const qint64 ns = timer.nsecsElapsed();
+        const HistoryStats h = manager.historyStats();
+
+        QSqlQuery count(db);
+        count.prepare("SELECT COUNT(*) FROM inventario_historial WHERE ts <= ?");
+        count.addBindValue(ts);
+        const qint64 fromStart = count.exec() && count.next() ? count.value(0).toLongLong() : 0;
+
+        out() << QString("  al %1 %: %2 ítems en %3 ms, %4 deltas aplicados (desde el inicio serían %5)\n")
+                     .arg(int(fraction * 100), 3)
+                     .arg(items.size())
+                     .arg(ns / 1e6, 0, 'f', 1)
+                     .arg(h.lastReplayed)
+                     .arg(fromStart);
+    }
+
+    timer.restart();
+    const int probes = 1000;
+    for (int i = 0; i < probes; i++) {
+        manager.quantityAt(rng->bounded(1, rows + 1),
+                           QDateTime::fromSecsSinceEpoch(start + rng->bounded(span)));
+    }
+    out() << QString("  quantityAt: %1 us por consulta\n").arg(timer.nsecsElapsed() / 1e3 / probes, 0, 'f', 1);
+
+    // El presente reconstruido debe coincidir con la tabla
+    QHash<int, int> now;
+    manager.forEachItem([&now](const InventoryRowView &row) {
+        now.insert(row.id, row.cantidad);
+        return true;
+    });
+    const QList<InventoryItem> present = manager.inventoryAt(QDateTime::currentDateTime().addDays(1));
+    bool matches = present.size() == now.size();
+    for (const InventoryItem &it : present) {
+        matches = matches && now.value(it.id, -1) == it.cantidad;
+    }
+    out() << "  reconstrucción del presente " << (matches ? "coincide" : "NO coincide")
+          << " con la tabla" << Qt::endl;
+    return matches ? 0 : 1;
+}
+
+/**
+ * @brief Mide el pronóstico de agotamiento sobre datos sintéticos y sobre una base.
+ *
+ * Primero carga en memoria items ítems y consumos repartidos en la
+ * ventana de 90 días y cronometra DepletionForecast::compute (el mejor
+ * de cinco), comparando el ritmo de una muestra de ítems con un cálculo
+ * directo en doble precisión. Después registra consumos en una base de
+ * hasta 100000 filas por InventoryManager, reparte sus marcas de tiempo
+ * en la ventana y mide la lectura del historial más el cálculo.
+ *
+ * Argumentos: items (1000000) y consumos (5000000).
+ */
+static int benchForecast(const QStringList &args, const QString &dir)
+{
+    const int items = qMax(1, args.value(0, "1000000").toInt());
+    const int changes = qMax(1, args.value(1, "5000000").toInt());
+    const int window = 90;
+    const double halfLife = 14.0;
+    auto *rng = QRandomGenerator::global();
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const qint64 nowTs = now.toSecsSinceEpoch();
+    std::vector<int> changeId(changes);
+    std::vector<qint64> changeTs(changes);
+    std::vector<int> changeDelta(changes);
+    for (int k = 0; k < changes; k++) {
+        changeId[k] = rng->bounded(1, items + 1);
+        changeTs[k] = nowTs - rng->bounded(qint64(window) * 86400);
+        changeDelta[k] = -rng->bounded(1, 11);
+    }
+
+    DepletionForecast forecast;
+    forecast.setWindow(window);
+    forecast.setHalfLife(halfLife);
+    QElapsedTimer timer;
+    timer.start();
+    forecast.reset(now, items, changes);
+    for (int id = 1; id <= items; id++) {
+        forecast.addItem(id, rng->bounded(0, 500));
+    }
+    for (int k = 0; k < changes; k++) {
+        forecast.addChange(changeId[k], changeTs[k], changeDelta[k]);
+    }
+    const qint64 fillNs = timer.nsecsElapsed();
+
+    std::vector<qint64> runs;
+    for (int i = 0; i < 5; i++) {
+        forecast.compute();
+        runs.push_back(forecast.stats().computeNs);
+    }
+    std::sort(runs.begin(), runs.end());
+    const QList<ForecastRow> soon = forecast.runsOutWithin(7);
+
+    // Referencia directa: exponencial por consumo, en doble precisión
+    const int sample = qMin(items, 1000);
+    std::vector<double> reference(size_t(sample) + 1, 0.0);
+    double weightSum = 0;
+    for (int d = 0; d < window; d++) {
+        weightSum += std::exp2(-(d + 0.5) / halfLife);
+    }
+    for (int k = 0; k < changes; k++) {
+        if (changeId[k] <= sample) {
+            const qint64 age = (nowTs - changeTs[k]) / 86400;
+            reference[size_t(changeId[k])] += -changeDelta[k] * std::exp2(-(age + 0.5) / halfLife) / weightSum;
+        }
+    }
+    double maxError = 0;
+    for (int id = 1; id <= sample; id++) {
+        const double rate = forecast.row(id - 1).perDay;
+        if (reference[size_t(id)] > 0) {
+            maxError = qMax(maxError, std::fabs(rate - reference[size_t(id)]) / reference[size_t(id)]);
+        }
+    }
+
+    out() << items << " ítems, " << forecast.stats().changes << " consumos en memoria (carga " << fillNs / 1000000
+          << " ms)" << Qt::endl;
+    out() << QString("  cálculo: %1 ms el mejor, %2 ms la mediana; %3 ítems se agotan en 7 días\n")
+                 .arg(runs.front() / 1e6, 0, 'f', 1)
+                 .arg(runs[runs.size() / 2] / 1e6, 0, 'f', 1)
+                 .arg(soon.size());
+    out() << QString("  error relativo máximo frente a la referencia: %1\n").arg(maxError, 0, 'g', 3);
+
+    // Con base: los consumos pasan por InventoryManager y quedan en el historial
+    const int rows = qMin(items, 100000);
+    QSqlDatabase db = openBenchDatabase(dir + "/forecast.db", "bench_forecast");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+
+    const int dbChanges = qMin(changes, rows * 10);
+    const int batch = 1000;
+    for (int done = 0; done < dbChanges; done += batch) {
+        QHash<int, int> deltas;
+        for (int i = 0; i < batch && done + i < dbChanges; i++) {
+            deltas[rng->bounded(1, rows + 1)] -= rng->bounded(1, 4);
+        }
+        manager.applyQuantityDeltas(deltas);
+    }
+
+    // Los triggers usan la hora real: se reparten los movimientos en la ventana
+    QSqlQuery spread(db);
+    spread.prepare("UPDATE inventario_historial SET ts = ? - abs(random() % ?) WHERE evento = 0");
+    spread.addBindValue(nowTs);
+    spread.addBindValue(qint64(window) * 86400);
+    spread.exec();
+
+    DepletionForecast fromDb;
+    fromDb.setWindow(window);
+    fromDb.setHalfLife(halfLife);
+    if (!fromDb.load(manager, now)) {
+        return 1;
+    }
+    fromDb.compute();
+    const ForecastStats stats = fromDb.stats();
+    out() << QString("%1 filas en base: %2 consumos leídos en %3 ms, cálculo %4 ms, "
+                     "%5 ítems se agotan en 30 días\n")
+                 .arg(stats.items)
+                 .arg(stats.changes)
+                 .arg(stats.loadNs / 1e6, 0, 'f', 1)
+                 .arg(stats.computeNs / 1e6, 0, 'f', 1)
+                 .arg(fromDb.runsOutWithin(30).size())
+          << Qt::flush;
+    return maxError < 1e-3 && stats.items == rows ? 0 : 1;
+}
+
+/**
+ * @brief Delegado de referencia que resuelve el punto de reorden al pintar.
+ *
+ * Es lo que haría falta sin InventoryModel::StockStatusRole: por cada
+ * celda de cantidad, leer el ID y el tipo de la fila y buscar su punto.
+ */
+class LookupStockDelegate : public QStyledItemDelegate
+{
+public:
+    explicit LookupStockDelegate(const ReorderPoints &points, QObject *parent = nullptr)
+        : QStyledItemDelegate(parent), points(points) {}
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override
+    {
+        QStyleOptionViewItem opt(option);
+        if (index.column() == InventorySchema::Cantidad) {
+            const int id = index.siblingAtColumn(InventorySchema::Id).data().toInt();
+            const QString tipo = index.siblingAtColumn(InventorySchema::Tipo).data().toString();
+            if (index.data().toInt() < points.pointFor(id, tipo)) {
+                opt.palette.setColor(QPalette::Text, Qt::red);
+            }
+        }
+        QStyledItemDelegate::paint(painter, opt, index);
+    }
+
+private:
+    ReorderPoints points;
+};
+
+/**
+ * @brief Mide el tiempo por cuadro al desplazarse por la tabla completa.
+ *
+ * Carga todas las páginas del modelo (como al bajar hasta el final), con
+ * puntos de reorden en la mitad de los tipos y en el 1 % de los ítems, y
+ * pinta la vista con el proxy y el delegado de la aplicación en una
+ * imagen fuera de pantalla: saltos repartidos por toda la tabla y luego
+ * desplazamiento fila a fila. Repite con un delegado que busca el punto
+ * de cada celda al pintar, para comparar. Informa percentiles del tiempo
+ * por cuadro y cuántos pasan de 16,7 ms (60 cuadros por segundo).
+ *
+ * Argumentos: filas (1000000) y cuadros (2000).
+ */
+static int benchScroll(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "1000000").toInt());
+    const int frames = qMax(10, args.value(1, "2000").toInt());
+
+    QSqlDatabase db = openBenchDatabase(dir + "/scroll.db", "bench_scroll");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+    manager.setTypeReorderPoint("Sensor", 100);
+    manager.setTypeReorderPoint("Herramienta", 2);
+    manager.setTypeReorderPoint("Instrumento", 250);
+    QList<int> ids;
+    for (int id = 1; id <= rows; id += 100) {
+        ids.append(id);
+    }
+    manager.setReorderPoints(ids, 400);
+
+    InventoryModel model(manager);
+    QElapsedTimer timer;
+    timer.start();
+    model.reload();
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+    const qint64 loadMs = timer.elapsed();
+
+    InventoryFilterProxy proxy;
+    proxy.setSourceModel(&model);
+
+    int low = 0;
+    for (int r = 0; r < model.rowCount(); r++) {
+        low += model.statusAt(r) != StockStatus::Ok ? 1 : 0;
+    }
+    out() << model.rowCount() << " filas cargadas en " << loadMs << " ms, " << low
+          << " bajo su punto de reorden" << Qt::endl;
+
+    auto run = [&](QStyledItemDelegate *delegate, const char *label) {
+        QTableView view;
+        view.setModel(&proxy);
+        view.setItemDelegate(delegate);
+        view.resize(1000, 600);
+        view.show();
+        QCoreApplication::processEvents();
+
+        QScrollBar *bar = view.verticalScrollBar();
+        QImage image(view.viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+        std::vector<qint64> times;
+        times.reserve(size_t(frames));
+        const int jumps = frames / 2;
+        const int start = bar->maximum() / 2;
+        for (int f = 0; f < frames; f++) {
+            const int value = f < jumps ? int(qint64(bar->maximum()) * f / jumps)
+                                        : qMin(bar->maximum(), start + (f - jumps));
+            timer.restart();
+            bar->setValue(value);
+            view.viewport()->render(&image);
+            times.push_back(timer.nsecsElapsed());
+        }
+
+        std::sort(times.begin(), times.end());
+        auto percentile = [&](double p) {
+            return times[std::min(times.size() - 1, size_t(p * times.size()))] / 1e6;
+        };
+        const qint64 over = std::count_if(times.begin(), times.end(),
+                                          [](qint64 ns) { return ns > 16700000; });
+        out() << QString("  %1: p50 %2 ms, p99 %3 ms, máx %4 ms; %5 de %6 cuadros sobre 16,7 ms\n")
+                     .arg(label)
+                     .arg(percentile(0.50), 0, 'f', 2)
+                     .arg(percentile(0.99), 0, 'f', 2)
+                     .arg(times.back() / 1e6, 0, 'f', 2)
+                     .arg(over)
+                     .arg(frames)
+              << Qt::flush;
+        return over;
+    };
+
+    LowStockDelegate cached;
+    LookupStockDelegate lookup(manager.reorderPoints());
+    const qint64 overCached = run(&cached, "estado precalculado");
+    run(&lookup, "punto buscado al pintar");
+    return overCached * 100 <= frames ? 0 : 1;
+}
+
+/**
+ * @brief Abre una conexión a una base ya creada, como lo hace la aplicación.
+ */
+static QSqlDatabase reopenBenchDatabase(const QString &path, const QString &connection)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+    db.setDatabaseName(path);
+    if (!db.open()) {
+        out() << "No se pudo abrir " << path << ": " << db.lastError().text() << Qt::endl;
+    }
+    return db;
+}
+
+/**
+ * @brief Pinta la tabla fuera de pantalla una vez, como el primer cuadro de la ventana.
+ */
+static void renderFirstFrame(QTableView &view)
+{
+    QImage image(view.viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+    view.viewport()->render(&image);
+}
+
+/**
+ * @brief Compara el arranque síncrono con el diferido sobre una base grande.
+ *
+ * El camino síncrono hace todo antes del primer cuadro: verifica el
+ * esquema, carga la primera página, lee todos los ítems y arma la
+ * búsqueda aproximada y las facetas. El diferido usa StartupLoader:
+ * pinta en cuanto el esquema está listo y la primera página cargada, y
+ * adopta los índices que el cargador armó en segundo plano. Se imprime la
+ * traza de cada uno, el tiempo hasta la primera pintura con datos y hasta
+ * quedar completo, y la mayor demora del bucle de eventos del diferido
+ * (lo que la ventana quedaría sin responder).
+ *
+ * Argumento: número de filas (1000000).
+ */
+static int benchStartup(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "1000000").toInt());
+    const QString path = dir + "/startup.db";
+    {
+        QSqlDatabase db = openBenchDatabase(path, "bench_startup_seed");
+        if (!db.isOpen()) {
+            return 1;
+        }
+        InventoryManager manager(db);
+        manager.createTable();
+        seedItems(manager, rows);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("bench_startup_seed");
+
+    auto summary = [](const char *label) {
+        const qint64 firstPaint = StartupTrace::reachedNs("primera pintura con datos");
+        const qint64 complete = StartupTrace::reachedNs("arranque completo");
+        out() << StartupTrace::report()
+              << QString("%1: primera pintura con datos a los %2 ms, completo a los %3 ms\n\n")
+                     .arg(label)
+                     .arg(firstPaint / 1e6, 0, 'f', 1)
+                     .arg(complete / 1e6, 0, 'f', 1)
+              << Qt::flush;
+        return firstPaint;
+    };
+
+    qint64 syncPaint = 0;
+    {
+        StartupTrace::reset();
+        StartupTrace::mark("main");
+        QSqlDatabase db = reopenBenchDatabase(path, "bench_startup_sync");
+        InventoryManager manager(db);
+        InventoryModel model(manager);
+        QTableView view;
+        view.setModel(&model);
+        view.resize(1000, 600);
+        FuzzyIndex fuzzy;
+        FacetCounts facets;
+        {
+            StartupTrace::Scope phase("esquema");
+            manager.createTable();
+        }
+        {
+            StartupTrace::Scope phase("primera página");
+            model.reload();
+        }
+        {
+            StartupTrace::Scope phase("lectura de todos los ítems");
+            const QList<InventoryItem> items = manager.getAllItems();
+            StartupTrace::Scope indexes("índices de búsqueda y facetas");
+            fuzzy.setItems(items);
+            facets.setItems(items);
+        }
+        view.show();
+        renderFirstFrame(view);
+        StartupTrace::mark("primera pintura con datos");
+        StartupTrace::mark("arranque completo");
+        syncPaint = summary("Síncrono");
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("bench_startup_sync");
+
+    qint64 deferredPaint = 0;
+    {
+        StartupTrace::reset();
+        StartupTrace::mark("main");
+        QSqlDatabase db = reopenBenchDatabase(path, "bench_startup_deferred");
+        InventoryManager manager(db);
+        manager.deferChangeTracking();
+        InventoryModel model(manager);
+        QTableView view;
+        view.setModel(&model);
+        view.resize(1000, 600);
+        view.show();
+        renderFirstFrame(view);
+        StartupTrace::mark("primera pintura de la ventana");
+
+        FuzzyIndex fuzzy;
+        FacetCounts facets;
+        bool failed = false;
+        QEventLoop loop;
+        StartupLoader loader(path);
+        QObject::connect(&loader, &StartupLoader::schemaReady, &loop, [&](bool ok) {
+            if (!ok) {
+                failed = true;
+                loop.quit();
+                return;
+            }
+            {
+                StartupTrace::Scope phase("primera página");
+                model.reload();
+            }
+            renderFirstFrame(view);
+            StartupTrace::mark("primera pintura con datos");
+        });
+        QObject::connect(&loader, &StartupLoader::indexesReady, &loop,
+                         [&](const std::shared_ptr<SearchIndexes> &indexes, qint64 seq) {
+            {
+                StartupTrace::Scope phase("adopción de índices");
+                fuzzy.adopt(indexes->fuzzy);
+                facets.adopt(indexes->facets);
+            }
+            manager.startChangeTracking(seq);
+            StartupTrace::mark("arranque completo");
+            loop.quit();
+        });
+
+        // Mayor demora del bucle de eventos mientras carga en segundo plano
+        qint64 maxGapNs = 0;
+        QElapsedTimer gap;
+        QTimer ticker;
+        ticker.setInterval(5);
+        QObject::connect(&ticker, &QTimer::timeout, [&]() {
+            maxGapNs = qMax(maxGapNs, gap.nsecsElapsed());
+            gap.restart();
+        });
+        gap.start();
+        ticker.start();
+        loader.start();
+        loop.exec();
+        ticker.stop();
+        out() << QString("Mayor demora del bucle de eventos durante el arranque diferido: %1 ms\n")
+                     .arg(maxGapNs / 1e6, 0, 'f', 1)
+              << Qt::flush;
+        if (failed) {
+            out() << "No se pudo verificar el esquema en segundo plano." << Qt::endl;
+            return 1;
+        }
+        deferredPaint = summary("Diferido");
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("bench_startup_deferred");
+
+    out() << QString("Primera pintura con datos: %1 veces antes con el arranque diferido")
+                 .arg(double(syncPaint) / qMax<qint64>(1, deferredPaint), 0, 'f', 1)
+          << Qt::endl;
+    return deferredPaint < syncPaint ? 0 : 1;
+}
+
+/**
+ * @brief Cuenta las filas de la tabla de inventario.
+ */
+static qint64 countItems(QSqlDatabase db)
+{
+    QSqlQuery query(db);
+    return query.exec("SELECT COUNT(*) FROM inventario") && query.next() ? query.value(0).toLongLong() : -1;
+}
+
+/**
+ * @brief Mide la cola de trabajos: hilo principal libre, cancelación y deshacer.
+ *
+ * Primero exporta el CSV en el hilo principal y luego dos veces a la vez
+ * con JobQueue, mientras un temporizador de 5 ms mide la mayor demora del
+ * bucle de eventos (lo que la ventana quedaría congelada). Después encola
+ * una carga de tantas filas como la tabla, la cancela a mitad de camino y
+ * comprueba que no quedó ninguna fila de ella. Por último repite la carga
+ * por lotes (JobMode::Batched). Durante las dos cargas el hilo principal
+ * cambia una cantidad cada 5 ms, como lo haría la ventana, y se informa su
+ * mayor demora y cuántas fallaron. Termina con JobQueue::report().
+ *
+ * Argumento: número de filas (200000).
+ */
+static int benchJobs(const QStringList &args, const QString &dir)
+{
+    const int rows = qMax(1, args.value(0, "200000").toInt());
+
+    QSqlDatabase db = openBenchDatabase(dir + "/jobs.db", "bench_jobs");
+    if (!db.isOpen()) {
+        return 1;
+    }
+    InventoryManager manager(db);
+    manager.createTable();
+    seedItems(manager, rows);
+
+    QElapsedTimer timer;
+    timer.start();
+    CSVReport().generate(manager, dir + "/sincrono.csv");
+    const qint64 syncNs = timer.nsecsElapsed();
+    out() << QString("Exportar %1 filas en el hilo principal: %2 ms (la ventana no responde en todo ese tiempo)\n")
+                 .arg(rows)
+                 .arg(syncNs / 1e6, 0, 'f', 1)
+          << Qt::flush;
+
+    JobQueue jobs(manager, db.databaseName(), 2);
+    QEventLoop loop;
+    int pending = 0;
+    QObject::connect(&jobs, &JobQueue::jobFinished, &loop, [&]() {
+        if (--pending == 0) {
+            loop.quit();
+        }
+    });
+
+    qint64 maxGapNs = 0;
+    QElapsedTimer gap;
+    QTimer ticker;
+    ticker.setInterval(5);
+    QObject::connect(&ticker, &QTimer::timeout, [&]() {
+        maxGapNs = qMax(maxGapNs, gap.nsecsElapsed());
+        gap.restart();
+    });
+
+    auto exportJob = [](const QString &path) {
+        return [path](JobContext &job) {
+            return CSVReport().generate(job.manager(), path, [&job](qint64 written) {
+                job.setProgress(written, 0);
+                return !job.isCanceled();
+            });
+        };
+    };
+    timer.restart();
+    gap.start();
+    ticker.start();
+    pending = 2;
+    jobs.submit("Exportar CSV 1", JobMode::Read, exportJob(dir + "/cola1.csv"));
+    jobs.submit("Exportar CSV 2", JobMode::Read, exportJob(dir + "/cola2.csv"));
+    loop.exec();
+    ticker.stop();
+    out() << QString("Dos exportaciones en la cola: %1 ms en total, mayor demora del hilo principal %2 ms\n")
+                 .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1)
+                 .arg(maxGapNs / 1e6, 0, 'f', 2)
+          << Qt::flush;
+
+    // Carga cancelada a mitad de camino: no debe quedar ninguna de sus filas
+    const qint64 before = countItems(db);
+    qint64 canceledAt = 0;
+    qint64 cancelLatencyNs = 0;
+    int loadId = 0;
+    QObject::connect(&jobs, &JobQueue::jobProgress, &loop, [&](const JobStats &s) {
+        if (s.id == loadId && canceledAt == 0 && s.done * 2 >= s.total) {
+            canceledAt = timer.nsecsElapsed();
+            jobs.cancel(loadId);
+        }
+    });
+    QObject::connect(&jobs, &JobQueue::jobFinished, &loop, [&](const JobStats &s) {
+        if (s.id == loadId && canceledAt > 0) {
+            cancelLatencyNs = timer.nsecsElapsed() - canceledAt;
+        }
+    });
+
+    // Escrituras de la "ventana" mientras corre la carga
+    qint64 maxWriteNs = 0;
+    int writes = 0;
+    int failedWrites = 0;
+    QTimer writer;
+    writer.setInterval(5);
+    QObject::connect(&writer, &QTimer::timeout, [&]() {
+        QElapsedTimer write;
+        write.start();
+        if (!manager.updateQuantity(1, writes % 100)) {
+            failedWrites++;
+        }
+        writes++;
+        maxWriteNs = qMax(maxWriteNs, write.nsecsElapsed());
+    });
+    auto loadJob = [rows](bool batched) {
+        return [rows, batched](JobContext &job) {
+            const int batch = 1000;
+            QList<InventoryItem> block;
+            for (int i = 0; i < rows; i += batch) {
+                if (job.isCanceled()) {
+                    return false;
+                }
+                block.clear();
+                for (int j = i; j < qMin(rows, i + batch); j++) {
+                    InventoryItem it;
+                    it.nombre = QString("Importado %1").arg(j);
+                    it.tipo = "Accesorio";
+                    it.cantidad = j % 100;
+                    it.ubicacion = "Recepción";
+                    it.fechaAdquisicion = "2024-06-01";
+                    block.append(it);
+                }
+                InventoryManager &inventory = job.manager();
+                const bool ok = batched ? job.write([&]() { return inventory.addItems(block); })
+                                        : inventory.addItems(block);
+                if (!ok) {
+                    return false;
+                }
+                job.setProgress(qMin(rows, i + batch), rows);
+            }
+            return true;
+        };
+    };
+    auto reportWrites = [&](const QString &label) {
+        out() << QString("%1: %2 escrituras del hilo principal, %3 fallidas, la más lenta %4 ms\n")
+                     .arg(label)
+                     .arg(writes)
+                     .arg(failedWrites)
+                     .arg(maxWriteNs / 1e6, 0, 'f', 1)
+              << Qt::flush;
+        maxWriteNs = 0;
+        writes = failedWrites = 0;
+    };
+
+    timer.restart();
+    pending = 1;
+    writer.start();
+    loadId = jobs.submit("Carga masiva", JobMode::Write, loadJob(false));
+    loop.exec();
+    writer.stop();
+
+    const JobStats load = jobs.stats(loadId);
+    const qint64 after = countItems(db);
+    out() << QString("Carga cancelada al %1%: estado %2, se detuvo %3 ms después de cancelar, "
+                     "filas antes %4 y después %5\n")
+                 .arg(int(load.fraction() * 100))
+                 .arg(JobQueue::stateName(load.state))
+                 .arg(cancelLatencyNs / 1e6, 0, 'f', 1)
+                 .arg(before)
+                 .arg(after)
+          << Qt::flush;
+    reportWrites("Con la carga en una transacción");
+
+    timer.restart();
+    pending = 1;
+    writer.start();
+    const int batchedId = jobs.submit("Carga masiva por lotes", JobMode::Batched, loadJob(true));
+    loop.exec();
+    writer.stop();
+
+    const JobStats batched = jobs.stats(batchedId);
+    out() << QString("Carga por lotes: estado %1, %2 ms\n")
+                 .arg(JobQueue::stateName(batched.state))
+                 .arg(batched.runNs / 1e6, 0, 'f', 1)
+          << Qt::flush;
+    reportWrites("Con la carga por lotes");
+    out() << "\n" << jobs.report() << Qt::flush;
+
+    return load.state == JobState::Canceled && after == before
+           && batched.state == JobState::Done && countItems(db) == before + rows ? 0 : 1;
+}
+
+/**
+ * @brief Punto de entrada: despacha el subcomando indicado.
+ */
+int main(int argc, char *argv[])
+{
+    // Solo "scroll" y "startup" pintan widgets; sin pantalla se usa la plataforma offscreen
+    std::unique_ptr<QCoreApplication> app;
+    if (argc > 1 && (qstrcmp(argv[1], "scroll") == 0 || qstrcmp(argv[1], "startup") == 0)) {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty("DISPLAY")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        app = std::make_unique<QApplication>(argc, argv);
+    } else {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+
+    QStringList args = app->arguments().mid(1);
+    const QString command = args.isEmpty() ? QString() : args.takeFirst();
+
+    if (command == "contention-worker") {
+        return contentionWorker(args);
+    }
+    if (command == "loadgen") {
+        return benchLoadgen(args);
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out() << "No se pudo crear el directorio temporal." << Qt::endl;
+        return 1;
+    }
+
+    if (command == "lookup") {
+        return benchLookup(args, dir.path());
+    }
+    if (command == "scanner") {
+        return benchScanner(args, dir.path());
+    }
+    if (command == "fuzzy") {
+        return benchFuzzy(args);
+    }
+    if (command == "stream") {
+        return benchStream(args, dir.path());
+    }
+    if (command == "plans") {
+        return benchPlans(args, dir.path());
+    }
+    if (command == "contention") {
+        return benchContention(args, dir.path());
+    }
+    if (command == "maintenance") {
+        return benchMaintenance(args, dir.path());
+    }
+    if (command == "backup") {
+        return benchBackup(args, dir.path());
+    }
+    if (command == "memory") {
+        return benchMemory(args, dir.path());
+    }
+    if (command == "server") {
+        return benchServer(args, dir.path());
+    }
+    if (command == "shards") {
+        return benchShards(args, dir.path());
+    }
+    if (command == "sync") {
+        return benchSync(args, dir.path());
+    }
+    if (command == "history") {
+        return benchHistory(args, dir.path());
+    }
+    if (command == "forecast") {
+        return benchForecast(args, dir.path());
+    }
+    if (command == "scroll") {
+        return benchScroll(args, dir.path());
+    }
+    if (command == "startup") {
+        return benchStartup(args, dir.path());
+    }
+    if (command == "jobs") {
+        return benchJobs(args, dir.path());
+    }
+
+    out() << "Uso: inventario_bench <subcomando> [argumentos]\n"
+          << "  lookup [filas] [consultas] [rafaga]                 Latencia de búsqueda por ID\n"
+          << "  scanner [eventos] [items] [clientes] [ventana_ms]   Caudal de la ingesta de escáneres\n"
+          << "  fuzzy [items] [consultas]                           Latencia de la búsqueda aproximada\n"
+          << "  stream [filas]                                      Reservas de memoria al recorrer filas\n"
+          << "  plans [filas,filas,...]                             Planes de consulta según el tamaño\n"
+          << "  contention [procesos] [escrituras] [lote]           Escrituras concurrentes de varios procesos\n"
+          << "  maintenance [filas] [presupuesto_ms]                Mantenimiento en porciones tras altas y bajas\n"
+          << "  backup [filas] [paginas_por_paso]                   Respaldo en línea con escrituras en curso\n"
+          << "  memory [filas] [operaciones]                        CRUD en archivo frente a base en memoria\n"
+          << "  server [clientes] [solicitudes] [profundidad]       Servidor de red con clientes de carga\n"
+          << "  loadgen <host> <puerto> [solicitudes] [profundidad] Cliente de carga contra un servidor\n"
+          << "  shards [sedes] [filas]                              Consultas repartidas entre sedes\n"
+          << "  sync [filas] [diferencias]                          Comparación y fusión de dos bases\n"
+          << "  history [filas] [cambios]                           Historial de existencias\n"
+          << "  forecast [items] [consumos]                         Pronóstico de agotamiento\n"
+          << "  scroll [filas] [cuadros]                            Tiempo por cuadro al desplazar la tabla\n"
+          << "  startup [filas]                                     Arranque síncrono frente a diferido\n"
+          << "  jobs [filas]                                        Cola de trabajos: respuesta, cancelación y deshacer"
+          << Qt::endl;
+    return command.isEmpty() ? 0 : 1;
+}